@@ -0,0 +1,150 @@
+/**
+ * @file libhack/src/DefinitionIndex.h
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Flat lookup index over a table of loaded definitions.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHACK_SRC_DEFINITIONINDEX_H
+#define LIBHACK_SRC_DEFINITIONINDEX_H
+
+// Standard C++11 Includes
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace libhack {
+
+/**
+ * Read only lookup index built over a table of definitions once it has
+ * been loaded. If the IDs in the table are compact enough the index is a
+ * plain array of pointers offset by the lowest ID so a lookup is a bounds
+ * check and a single load. Otherwise the index is a sorted array of ID and
+ * pointer pairs searched with a binary search, which still avoids the
+ * hashing and node chasing of the map it was built from. The index does
+ * not own the definitions so the table it was built from must outlive it
+ * and must not change without the index being built again.
+ */
+template <class K, class T>
+class DefinitionIndex {
+ public:
+  /// Largest number of array slots allowed per definition for the index
+  /// to be dense
+  static const size_t MAX_DENSE_SLOTS_PER_ENTRY = 4;
+
+  /// Number of array slots that are always allowed for the index to be
+  /// dense regardless of how many definitions the table has
+  static const size_t MIN_DENSE_SLOTS = 1024;
+
+  /**
+   * Create an empty index.
+   */
+  DefinitionIndex() : mBaseID(0) {}
+
+  /**
+   * Build the index from a loaded table, replacing anything already
+   * indexed.
+   * @param data Table of definitions by ID to index
+   */
+  void Build(const std::unordered_map<K, std::shared_ptr<T>>& data) {
+    mDense.clear();
+    mSparse.clear();
+    mBaseID = 0;
+
+    if (data.empty()) {
+      return;
+    }
+
+    int64_t minID = (int64_t)data.begin()->first;
+    int64_t maxID = minID;
+    for (auto& pair : data) {
+      minID = std::min(minID, (int64_t)pair.first);
+      maxID = std::max(maxID, (int64_t)pair.first);
+    }
+
+    uint64_t range = (uint64_t)(maxID - minID) + 1;
+    if (range <= std::max((size_t)MIN_DENSE_SLOTS,
+                          data.size() * (size_t)MAX_DENSE_SLOTS_PER_ENTRY)) {
+      mBaseID = minID;
+      mDense.assign((size_t)range, nullptr);
+      for (auto& pair : data) {
+        mDense[(size_t)((int64_t)pair.first - minID)] = pair.second.get();
+      }
+    } else {
+      mSparse.reserve(data.size());
+      for (auto& pair : data) {
+        mSparse.push_back(std::make_pair(pair.first, pair.second.get()));
+      }
+
+      std::sort(mSparse.begin(), mSparse.end(),
+                [](const std::pair<K, T*>& a, const std::pair<K, T*>& b) {
+                  return a.first < b.first;
+                });
+    }
+  }
+
+  /**
+   * Get a definition by ID.
+   * @param id ID of the definition to retrieve
+   * @return Pointer to the definition or null if it does not exist. The
+   *  definition is still owned by the table the index was built from.
+   */
+  T* Find(K id) const {
+    if (!mDense.empty()) {
+      int64_t offset = (int64_t)id - mBaseID;
+      return offset >= 0 && (uint64_t)offset < (uint64_t)mDense.size()
+                 ? mDense[(size_t)offset]
+                 : nullptr;
+    }
+
+    auto it = std::lower_bound(
+        mSparse.begin(), mSparse.end(), id,
+        [](const std::pair<K, T*>& entry, K key) { return entry.first < key; });
+
+    return it != mSparse.end() && it->first == id ? it->second : nullptr;
+  }
+
+  /**
+   * Check if the index is a direct array lookup.
+   * @return true if the index is dense, false if it is searched
+   */
+  bool IsDense() const { return !mDense.empty(); }
+
+ private:
+  /// Lowest ID in the table when the index is dense
+  int64_t mBaseID;
+
+  /// Definitions by ID offset from mBaseID, empty if the index is sparse
+  std::vector<T*> mDense;
+
+  /// Definitions sorted by ID, empty if the index is dense
+  std::vector<std::pair<K, T*>> mSparse;
+};
+
+}  // namespace libhack
+
+#endif  // LIBHACK_SRC_DEFINITIONINDEX_H
@@ -30,6 +30,13 @@
 #include "Constants.h"
 #include "Log.h"
 
+// Standard C++11 Includes
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
 #ifndef EXOTIC_PLATFORM
 #include "BaseScriptEngine.h"
 #endif  // !EXOTIC_PLATFORM
@@ -115,6 +122,60 @@
 using namespace libcomp;
 using namespace libhack;
 
+namespace {
+
+/// ID of the devil definition table in the shared data store
+const uint32_t SHARED_TABLE_DEVIL = 1;
+
+/// ID of the item definition table in the shared data store
+const uint32_t SHARED_TABLE_ITEM = 2;
+
+/// ID of the skill definition table in the shared data store
+const uint32_t SHARED_TABLE_SKILL = 3;
+
+/**
+ * Save a table of definitions to be put in the shared data store. Each
+ * definition is loaded back into an empty copy first and the table is
+ * not saved unless every copy saves exactly the same data.
+ * @param data Table of definitions by ID
+ * @param records Output parameter to return the saved definitions by ID
+ * @param hash Hash of the saved data, updated with this table
+ * @return true if every definition was saved
+ */
+template <class T>
+bool SaveSharedRecords(
+    const std::unordered_map<uint32_t, std::shared_ptr<T>> &data,
+    std::map<uint32_t, std::string> &records, uint64_t &hash) {
+  for (auto &pair : data) {
+    std::stringstream ss;
+    if (!pair.second->Save(ss)) {
+      return false;
+    }
+
+    std::string saved = ss.str();
+
+    auto copy = std::make_shared<T>();
+    MemoryInStream ms(saved.data(), saved.size());
+    std::stringstream check;
+    if (!copy->Load(ms) || !copy->Save(check) || check.str() != saved) {
+      return false;
+    }
+
+    records[pair.first] = saved;
+  }
+
+  // Hash in ID order so the result does not depend on the map order
+  for (auto &pair : records) {
+    hash = SharedDataStore::Hash((const char *)&pair.first,
+                                 sizeof(pair.first), hash);
+    hash = SharedDataStore::Hash(pair.second.data(), pair.second.size(), hash);
+  }
+
+  return true;
+}
+
+}  // namespace
+
 DefinitionManager::DefinitionManager() {}
 
 DefinitionManager::~DefinitionManager() {}
@@ -194,7 +255,13 @@ std::list<uint16_t> DefinitionManager::GetDevilBoostLotIDs(int32_t count) {
 
 std::shared_ptr<objects::MiDevilData> DefinitionManager::GetDevilData(
     uint32_t id) {
-  return GetRecordByID(id, mDevilData);
+  return mDevilTable.IsAttached() ? mDevilTable.Get(id)
+                                  : GetRecordByID(id, mDevilData);
+}
+
+objects::MiDevilData* DefinitionManager::FindDevilData(uint32_t id) const {
+  return mDevilTable.IsAttached() ? mDevilTable.Find(id)
+                                  : mDevilIndex.Find(id);
 }
 
 const std::shared_ptr<objects::MiDevilData> DefinitionManager::GetDevilData(
@@ -397,7 +464,12 @@ const std::shared_ptr<objects::MiHNPCData> DefinitionManager::GetHNPCData(
 
 const std::shared_ptr<objects::MiItemData> DefinitionManager::GetItemData(
     uint32_t id) {
-  return GetRecordByID(id, mItemData);
+  return mItemTable.IsAttached() ? mItemTable.Get(id)
+                                 : GetRecordByID(id, mItemData);
+}
+
+objects::MiItemData* DefinitionManager::FindItemData(uint32_t id) const {
+  return mItemTable.IsAttached() ? mItemTable.Find(id) : mItemIndex.Find(id);
 }
 
 const std::shared_ptr<objects::MiMissionData> DefinitionManager::GetMissionData(
@@ -479,7 +551,7 @@ const std::shared_ptr<objects::MiItemData> DefinitionManager::GetItemData(
     const libcomp::String &name) {
   auto iter = mCItemNameLookup.find(name);
   if (iter != mCItemNameLookup.end()) {
-    return GetRecordByID(iter->second, mItemData);
+    return GetItemData(iter->second);
   }
 
   return nullptr;
@@ -527,7 +599,13 @@ std::set<int32_t> DefinitionManager::GetSItemTokusei(uint32_t id) {
 
 const std::shared_ptr<objects::MiSkillData> DefinitionManager::GetSkillData(
     uint32_t id) {
-  return GetRecordByID(id, mSkillData);
+  return mSkillTable.IsAttached() ? mSkillTable.Get(id)
+                                  : GetRecordByID(id, mSkillData);
+}
+
+objects::MiSkillData* DefinitionManager::FindSkillData(uint32_t id) const {
+  return mSkillTable.IsAttached() ? mSkillTable.Find(id)
+                                  : mSkillIndex.Find(id);
 }
 
 std::set<uint32_t> DefinitionManager::GetFunctionIDSkills(uint16_t fid) const {
@@ -562,6 +640,10 @@ const std::shared_ptr<objects::MiStatusData> DefinitionManager::GetStatusData(
   return GetRecordByID(id, mStatusData);
 }
 
+objects::MiStatusData* DefinitionManager::FindStatusData(uint32_t id) const {
+  return mStatusIndex.Find(id);
+}
+
 const std::shared_ptr<objects::MiSynthesisData>
 DefinitionManager::GetSynthesisData(uint32_t id) {
   return GetRecordByID(id, mSynthesisData);
@@ -880,6 +962,8 @@ bool DefinitionManager::LoadData<objects::MiDevilData>(DataStore *pDataStore) {
     });
   }
 
+  mDevilIndex.Build(mDevilData);
+
   return success;
 }
 
@@ -1203,6 +1287,8 @@ bool DefinitionManager::LoadData<objects::MiItemData>(DataStore *pDataStore) {
     mItemData[record->GetCommon()->GetID()] = record;
   }
 
+  mItemIndex.Build(mItemData);
+
   return success;
 }
 
@@ -1475,6 +1561,8 @@ bool DefinitionManager::LoadData<objects::MiSkillData>(DataStore *pDataStore) {
     }
   }
 
+  mSkillIndex.Build(mSkillData);
+
   return success;
 }
 
@@ -1487,6 +1575,8 @@ bool DefinitionManager::LoadData<objects::MiStatusData>(DataStore *pDataStore) {
     mStatusData[record->GetCommon()->GetID()] = record;
   }
 
+  mStatusIndex.Build(mStatusData);
+
   return success;
 }
 
@@ -1619,74 +1709,178 @@ bool DefinitionManager::LoadData<objects::MiZoneData>(DataStore *pDataStore) {
 }
 }  // namespace libhack
 
+void DefinitionManager::SetSharedStoreName(const libcomp::String &name) {
+  mSharedStoreName = name;
+}
+
 bool DefinitionManager::LoadAllData(DataStore *pDataStore) {
   LogDefinitionManagerInfoMsg("Loading binary data definitions...\n");
 
+  // Every type is read into and indexed by its own set of members so the
+  // types can be loaded at the same time
+  typedef bool (DefinitionManager::*LoadFunc)(DataStore *);
+  static const std::vector<std::pair<const char *, LoadFunc>> loaders = {
+      {"MiAIData", &DefinitionManager::LoadData<objects::MiAIData>},
+      {"MiBlendData", &DefinitionManager::LoadData<objects::MiBlendData>},
+      {"MiBlendExtData", &DefinitionManager::LoadData<objects::MiBlendExtData>},
+      {"MiCHouraiData", &DefinitionManager::LoadData<objects::MiCHouraiData>},
+      {"MiCItemData", &DefinitionManager::LoadData<objects::MiCItemData>},
+      {"MiCultureItemData",
+       &DefinitionManager::LoadData<objects::MiCultureItemData>},
+      {"MiDevilData", &DefinitionManager::LoadData<objects::MiDevilData>},
+      {"MiDevilBookData",
+       &DefinitionManager::LoadData<objects::MiDevilBookData>},
+      {"MiDevilBoostData",
+       &DefinitionManager::LoadData<objects::MiDevilBoostData>},
+      {"MiDevilBoostExtraData",
+       &DefinitionManager::LoadData<objects::MiDevilBoostExtraData>},
+      {"MiDevilBoostItemData",
+       &DefinitionManager::LoadData<objects::MiDevilBoostItemData>},
+      {"MiDevilBoostLotData",
+       &DefinitionManager::LoadData<objects::MiDevilBoostLotData>},
+      {"MiDevilEquipmentData",
+       &DefinitionManager::LoadData<objects::MiDevilEquipmentData>},
+      {"MiDevilEquipmentItemData",
+       &DefinitionManager::LoadData<objects::MiDevilEquipmentItemData>},
+      {"MiDevilFusionData",
+       &DefinitionManager::LoadData<objects::MiDevilFusionData>},
+      {"MiDevilLVUpRateData",
+       &DefinitionManager::LoadData<objects::MiDevilLVUpRateData>},
+      {"MiDisassemblyData",
+       &DefinitionManager::LoadData<objects::MiDisassemblyData>},
+      {"MiDisassemblyTriggerData",
+       &DefinitionManager::LoadData<objects::MiDisassemblyTriggerData>},
+      {"MiDynamicMapData",
+       &DefinitionManager::LoadData<objects::MiDynamicMapData>},
+      {"MiEnchantData", &DefinitionManager::LoadData<objects::MiEnchantData>},
+      {"MiEquipmentSetData",
+       &DefinitionManager::LoadData<objects::MiEquipmentSetData>},
+      {"MiExchangeData", &DefinitionManager::LoadData<objects::MiExchangeData>},
+      {"MiExpertData", &DefinitionManager::LoadData<objects::MiExpertData>},
+      {"MiGuardianAssistData",
+       &DefinitionManager::LoadData<objects::MiGuardianAssistData>},
+      {"MiGuardianLevelData",
+       &DefinitionManager::LoadData<objects::MiGuardianLevelData>},
+      {"MiGuardianSpecialData",
+       &DefinitionManager::LoadData<objects::MiGuardianSpecialData>},
+      {"MiGuardianUnlockData",
+       &DefinitionManager::LoadData<objects::MiGuardianUnlockData>},
+      {"MiHNPCData", &DefinitionManager::LoadData<objects::MiHNPCData>},
+      {"MiItemData", &DefinitionManager::LoadData<objects::MiItemData>},
+      {"MiMissionData", &DefinitionManager::LoadData<objects::MiMissionData>},
+      {"MiMitamaReunionBonusData",
+       &DefinitionManager::LoadData<objects::MiMitamaReunionBonusData>},
+      {"MiMitamaReunionSetBonusData",
+       &DefinitionManager::LoadData<objects::MiMitamaReunionSetBonusData>},
+      {"MiMitamaUnionBonusData",
+       &DefinitionManager::LoadData<objects::MiMitamaUnionBonusData>},
+      {"MiModificationData",
+       &DefinitionManager::LoadData<objects::MiModificationData>},
+      {"MiModificationExtEffectData",
+       &DefinitionManager::LoadData<objects::MiModificationExtEffectData>},
+      {"MiModificationExtRecipeData",
+       &DefinitionManager::LoadData<objects::MiModificationExtRecipeData>},
+      {"MiModificationTriggerData",
+       &DefinitionManager::LoadData<objects::MiModificationTriggerData>},
+      {"MiModifiedEffectData",
+       &DefinitionManager::LoadData<objects::MiModifiedEffectData>},
+      {"MiNPCBarterData",
+       &DefinitionManager::LoadData<objects::MiNPCBarterData>},
+      {"MiNPCBarterConditionData",
+       &DefinitionManager::LoadData<objects::MiNPCBarterConditionData>},
+      {"MiNPCBarterGroupData",
+       &DefinitionManager::LoadData<objects::MiNPCBarterGroupData>},
+      {"MiONPCData", &DefinitionManager::LoadData<objects::MiONPCData>},
+      {"MiQuestBonusCodeData",
+       &DefinitionManager::LoadData<objects::MiQuestBonusCodeData>},
+      {"MiQuestData", &DefinitionManager::LoadData<objects::MiQuestData>},
+      {"MiShopProductData",
+       &DefinitionManager::LoadData<objects::MiShopProductData>},
+      {"MiSItemData", &DefinitionManager::LoadData<objects::MiSItemData>},
+      {"MiSkillData", &DefinitionManager::LoadData<objects::MiSkillData>},
+      {"MiStatusData", &DefinitionManager::LoadData<objects::MiStatusData>},
+      {"MiSynthesisData",
+       &DefinitionManager::LoadData<objects::MiSynthesisData>},
+      {"MiTankData", &DefinitionManager::LoadData<objects::MiTankData>},
+      {"MiTimeLimitData",
+       &DefinitionManager::LoadData<objects::MiTimeLimitData>},
+      {"MiTitleData", &DefinitionManager::LoadData<objects::MiTitleData>},
+      {"MiTriUnionSpecialData",
+       &DefinitionManager::LoadData<objects::MiTriUnionSpecialData>},
+      {"MiUltimateBattleBaseData",
+       &DefinitionManager::LoadData<objects::MiUltimateBattleBaseData>},
+      {"MiUraFieldTowerData",
+       &DefinitionManager::LoadData<objects::MiUraFieldTowerData>},
+      {"MiWarpPointData",
+       &DefinitionManager::LoadData<objects::MiWarpPointData>},
+      {"MiZoneData", &DefinitionManager::LoadData<objects::MiZoneData>},
+  };
+
+  std::vector<char> results(loaders.size(), 0);
+  std::vector<uint64_t> times(loaders.size(), 0);
+  std::atomic<size_t> next(0);
+
+  auto start = std::chrono::steady_clock::now();
+
+  size_t threadCount = (size_t)std::thread::hardware_concurrency();
+  if (threadCount == 0) {
+    threadCount = 1;
+  } else if (threadCount > loaders.size()) {
+    threadCount = loaders.size();
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < threadCount; i++) {
+    threads.push_back(std::thread([&]() {
+      size_t idx;
+      while ((idx = next++) < loaders.size()) {
+        auto loadStart = std::chrono::steady_clock::now();
+
+        results[idx] = (this->*loaders[idx].second)(pDataStore) ? 1 : 0;
+
+        times[idx] = (uint64_t)std::chrono::duration_cast<
+                         std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - loadStart)
+                         .count();
+      }
+    }));
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t elapsed =
+      (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+
   bool success = true;
-  success &= LoadData<objects::MiAIData>(pDataStore);
-  success &= LoadData<objects::MiBlendData>(pDataStore);
-  success &= LoadData<objects::MiBlendExtData>(pDataStore);
-  success &= LoadData<objects::MiCHouraiData>(pDataStore);
-  success &= LoadData<objects::MiCItemData>(pDataStore);
-  success &= LoadData<objects::MiCultureItemData>(pDataStore);
-  success &= LoadData<objects::MiDevilData>(pDataStore);
-  success &= LoadData<objects::MiDevilBookData>(pDataStore);
-  success &= LoadData<objects::MiDevilBoostData>(pDataStore);
-  success &= LoadData<objects::MiDevilBoostExtraData>(pDataStore);
-  success &= LoadData<objects::MiDevilBoostItemData>(pDataStore);
-  success &= LoadData<objects::MiDevilBoostLotData>(pDataStore);
-  success &= LoadData<objects::MiDevilEquipmentData>(pDataStore);
-  success &= LoadData<objects::MiDevilEquipmentItemData>(pDataStore);
-  success &= LoadData<objects::MiDevilFusionData>(pDataStore);
-  success &= LoadData<objects::MiDevilLVUpRateData>(pDataStore);
-  success &= LoadData<objects::MiDisassemblyData>(pDataStore);
-  success &= LoadData<objects::MiDisassemblyTriggerData>(pDataStore);
-  success &= LoadData<objects::MiDynamicMapData>(pDataStore);
-  success &= LoadData<objects::MiEnchantData>(pDataStore);
-  success &= LoadData<objects::MiEquipmentSetData>(pDataStore);
-  success &= LoadData<objects::MiExchangeData>(pDataStore);
-  success &= LoadData<objects::MiExpertData>(pDataStore);
-  success &= LoadData<objects::MiGuardianAssistData>(pDataStore);
-  success &= LoadData<objects::MiGuardianLevelData>(pDataStore);
-  success &= LoadData<objects::MiGuardianSpecialData>(pDataStore);
-  success &= LoadData<objects::MiGuardianUnlockData>(pDataStore);
-  success &= LoadData<objects::MiHNPCData>(pDataStore);
-  success &= LoadData<objects::MiItemData>(pDataStore);
-  success &= LoadData<objects::MiMissionData>(pDataStore);
-  success &= LoadData<objects::MiMitamaReunionBonusData>(pDataStore);
-  success &= LoadData<objects::MiMitamaReunionSetBonusData>(pDataStore);
-  success &= LoadData<objects::MiMitamaUnionBonusData>(pDataStore);
-  success &= LoadData<objects::MiModificationData>(pDataStore);
-  success &= LoadData<objects::MiModificationExtEffectData>(pDataStore);
-  success &= LoadData<objects::MiModificationExtRecipeData>(pDataStore);
-  success &= LoadData<objects::MiModificationTriggerData>(pDataStore);
-  success &= LoadData<objects::MiModifiedEffectData>(pDataStore);
-  success &= LoadData<objects::MiNPCBarterData>(pDataStore);
-  success &= LoadData<objects::MiNPCBarterConditionData>(pDataStore);
-  success &= LoadData<objects::MiNPCBarterGroupData>(pDataStore);
-  success &= LoadData<objects::MiONPCData>(pDataStore);
-  success &= LoadData<objects::MiQuestBonusCodeData>(pDataStore);
-  success &= LoadData<objects::MiQuestData>(pDataStore);
-  success &= LoadData<objects::MiShopProductData>(pDataStore);
-  success &= LoadData<objects::MiSItemData>(pDataStore);
-  success &= LoadData<objects::MiSkillData>(pDataStore);
-  success &= LoadData<objects::MiStatusData>(pDataStore);
-  success &= LoadData<objects::MiSynthesisData>(pDataStore);
-  success &= LoadData<objects::MiTankData>(pDataStore);
-  success &= LoadData<objects::MiTimeLimitData>(pDataStore);
-  success &= LoadData<objects::MiTitleData>(pDataStore);
-  success &= LoadData<objects::MiTriUnionSpecialData>(pDataStore);
-  success &= LoadData<objects::MiUltimateBattleBaseData>(pDataStore);
-  success &= LoadData<objects::MiUraFieldTowerData>(pDataStore);
-  success &= LoadData<objects::MiWarpPointData>(pDataStore);
-  success &= LoadData<objects::MiZoneData>(pDataStore);
+  for (size_t i = 0; i < loaders.size(); i++) {
+    success &= results[i] != 0;
+
+    LogDefinitionManagerInfo([&]() {
+      return libcomp::String("Loaded %1 in %2 ms.\n")
+          .Arg(loaders[i].first)
+          .Arg(times[i]);
+    });
+  }
 
   if (success) {
-    LogDefinitionManagerInfoMsg("Definition loading complete.\n");
+    LogDefinitionManagerInfo([&]() {
+      return libcomp::String(
+                 "Definition loading complete in %1 ms using %2 thread(s).\n")
+          .Arg(elapsed)
+          .Arg(threadCount);
+    });
   } else {
     LogDefinitionManagerCriticalMsg("Definition loading failed.\n");
   }
 
+  if (success && !mSharedStoreName.IsEmpty()) {
+    AttachSharedStore();
+  }
+
   return success;
 }
 
@@ -1788,23 +1982,104 @@ std::shared_ptr<objects::QmpFile> DefinitionManager::LoadQmpFile(
     return nullptr;
   }
 
-  std::stringstream ss(std::string(data.begin(), data.end()));
+  MemoryInStream ms(data.data(), data.size());
 
   uint32_t magic;
-  ss.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  ms.read(reinterpret_cast<char *>(&magic), sizeof(magic));
 
   if (magic != QMP_FORMAT_MAGIC) {
     return nullptr;
   }
 
   auto file = std::make_shared<objects::QmpFile>();
-  if (!file->Load(ss)) {
+  if (!file->Load(ms)) {
     return nullptr;
   }
 
   return file;
 }
 
+bool DefinitionManager::AttachSharedStore() {
+  auto start = std::chrono::steady_clock::now();
+
+  SharedDataStore::Tables tables;
+  uint64_t hash = SharedDataStore::Hash(nullptr, 0);
+  if (!SaveSharedRecords(mDevilData, tables[SHARED_TABLE_DEVIL], hash) ||
+      !SaveSharedRecords(mItemData, tables[SHARED_TABLE_ITEM], hash) ||
+      !SaveSharedRecords(mSkillData, tables[SHARED_TABLE_SKILL], hash)) {
+    LogDefinitionManagerWarningMsg(
+        "Definitions could not be saved to the shared data store and will "
+        "be held in memory instead.\n");
+
+    return false;
+  }
+
+  // Use the store another server built from the same definitions if there
+  // is one, otherwise build it for every server after this one
+  bool created = false;
+  if (!mSharedStore.Open(mSharedStoreName, hash)) {
+    // If another server built it at the same time, use its copy
+    created = mSharedStore.Create(mSharedStoreName, hash, tables);
+    if (!created && !mSharedStore.Open(mSharedStoreName, hash)) {
+      LogDefinitionManagerWarning([&]() {
+        return libcomp::String(
+                   "Failed to open or create shared data store %1, "
+                   "definitions will be held in memory instead.\n")
+            .Arg(mSharedStoreName);
+      });
+
+      return false;
+    }
+  }
+
+  tables.clear();
+
+  if (!mDevilTable.Attach(mSharedStore, SHARED_TABLE_DEVIL) ||
+      !mItemTable.Attach(mSharedStore, SHARED_TABLE_ITEM) ||
+      !mSkillTable.Attach(mSharedStore, SHARED_TABLE_SKILL)) {
+    mDevilTable.Detach();
+    mItemTable.Detach();
+    mSkillTable.Detach();
+    mSharedStore.Close();
+
+    LogDefinitionManagerWarning([&]() {
+      return libcomp::String(
+                 "Shared data store %1 is missing definition tables, "
+                 "definitions will be held in memory instead.\n")
+          .Arg(mSharedStoreName);
+    });
+
+    return false;
+  }
+
+  // Definitions are only built from the store when requested from now on
+  size_t count = mDevilData.size() + mItemData.size() + mSkillData.size();
+
+  mDevilData.clear();
+  mItemData.clear();
+  mSkillData.clear();
+
+  mDevilIndex.Build(mDevilData);
+  mItemIndex.Build(mItemData);
+  mSkillIndex.Build(mSkillData);
+
+  uint64_t elapsed =
+      (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+
+  LogDefinitionManagerInfo([&]() {
+    return libcomp::String("%1 shared data store %2 with %3 definitions in %4 "
+                           "ms.\n")
+        .Arg(created ? "Created" : "Opened")
+        .Arg(mSharedStoreName)
+        .Arg(count)
+        .Arg(elapsed);
+  });
+
+  return true;
+}
+
 bool DefinitionManager::LoadBinaryDataHeader(libcomp::ObjectInStream &ois,
                                              const libcomp::String &binaryFile,
                                              uint16_t tablesExpected,
@@ -34,6 +34,12 @@
 #include "MiCorrectTbl.h"
 #include "Object.h"
 
+// libhack Includes
+#include "DefinitionIndex.h"
+#include "MemoryStream.h"
+#include "SharedDataStore.h"
+#include "SharedDefinitionTable.h"
+
 // Standard C++11 Includes
 #include <set>
 #include <unordered_map>
@@ -220,6 +226,16 @@ class DefinitionManager {
    */
   std::shared_ptr<objects::MiDevilData> GetDevilData(uint32_t id);
 
+  /**
+   * Get the devil definition corresponding to an ID without taking a
+   * reference to it. The definition is owned by the manager and must not
+   * be modified or kept past the life of the manager.
+   * @param id Devil ID to retrieve
+   * @return Pointer to the matching devil definition, null if it does
+   *  not exist
+   */
+  objects::MiDevilData* FindDevilData(uint32_t id) const;
+
   /**
    * Get a devil definition corresponding to a name
    * @param name Devil name to retrieve
@@ -456,6 +472,16 @@ class DefinitionManager {
    */
   const std::shared_ptr<objects::MiItemData> GetItemData(uint32_t id);
 
+  /**
+   * Get the item definition corresponding to an ID without taking a
+   * reference to it. The definition is owned by the manager and must not
+   * be modified or kept past the life of the manager.
+   * @param id Item ID to retrieve
+   * @return Pointer to the matching item definition, null if it does
+   *  not exist
+   */
+  objects::MiItemData* FindItemData(uint32_t id) const;
+
   /**
    * Get the item definition corresponding to a name
    * @param name Item name to retrieve
@@ -640,6 +666,16 @@ class DefinitionManager {
    */
   const std::shared_ptr<objects::MiSkillData> GetSkillData(uint32_t id);
 
+  /**
+   * Get the skill definition corresponding to an ID without taking a
+   * reference to it. The definition is owned by the manager and must not
+   * be modified or kept past the life of the manager.
+   * @param id Skill ID to retrieve
+   * @return Pointer to the matching skill definition, null if it does
+   *  not exist
+   */
+  objects::MiSkillData* FindSkillData(uint32_t id) const;
+
   /**
    * Get all skill definition IDs that are mapped to the supplied function ID
    * @param fid Skill function ID
@@ -671,6 +707,16 @@ class DefinitionManager {
    */
   const std::shared_ptr<objects::MiStatusData> GetStatusData(uint32_t id);
 
+  /**
+   * Get the status definition corresponding to an ID without taking a
+   * reference to it. The definition is owned by the manager and must not
+   * be modified or kept past the life of the manager.
+   * @param id Status ID to retrieve
+   * @return Pointer to the matching status definition, null if it does
+   *  not exist
+   */
+  objects::MiStatusData* FindStatusData(uint32_t id) const;
+
   /**
    * Get the synthesis definition corresponding to an ID
    * @param id Synthesis ID to retrieve
@@ -811,12 +857,26 @@ class DefinitionManager {
   GetAllTokuseiData();
 
   /**
-   * Load all binary data definitions
+   * Load all binary data definitions. Each type is loaded and indexed on
+   * its own so the types are spread across a set of threads and the time
+   * each one took is logged once they are all done.
    * @param pDataStore Pointer to the datastore to load binary files from
    * @return true on success, false on failure
    */
   bool LoadAllData(libcomp::DataStore* pDataStore);
 
+  /**
+   * Set the name of the shared data store the devil, item and skill
+   * definitions are held in once loaded. The first server on the host to
+   * load them builds the store and every other server loading the same
+   * definitions uses it as well. Each server then only builds the
+   * definitions it actually requests from the store. Must be set before
+   * any data is loaded.
+   * @param name Name of the store, unique per host, or empty to hold the
+   *  definitions in memory
+   */
+  void SetSharedStoreName(const libcomp::String& name);
+
   /**
    * Load the binary data definitions of the specified type
    * @param pDataStore Pointer to the datastore to load binary file from
@@ -885,8 +945,9 @@ class DefinitionManager {
       return false;
     }
 
-    std::stringstream ss(std::string(data.begin(), data.end()));
-    libcomp::ObjectInStream ois(ss);
+    // Read straight from the decrypted data instead of copying it again
+    MemoryInStream ms(data.data(), data.size());
+    libcomp::ObjectInStream ois(ms);
 
     uint16_t entryCount, tableCount;
     if (!LoadBinaryDataHeader(ois, binaryFile, tablesExpected, entryCount,
@@ -922,6 +983,15 @@ class DefinitionManager {
     return success;
   }
 
+  /**
+   * Save the devil, item and skill definitions to the shared data store,
+   * or open the store if another server already has, and read them from
+   * it from then on instead of holding them in memory.
+   * @return true if the definitions are now read from the store, false if
+   *  they are still held in memory
+   */
+  bool AttachSharedStore();
+
   /**
    * Load the data header containing the number of entries and
    * tables that make up the format of the rest of the file
@@ -972,6 +1042,14 @@ class DefinitionManager {
   }
 
  private:
+  /// Name of the shared data store, empty if definitions are only held
+  /// in memory
+  libcomp::String mSharedStoreName;
+
+  /// Shared data store the devil, item and skill definitions are read
+  /// from if it is open
+  SharedDataStore mSharedStore;
+
   /// Map of client-side AI definitions by ID
   std::unordered_map<uint32_t, std::shared_ptr<objects::MiAIData>> mAIData;
 
@@ -1017,6 +1095,13 @@ class DefinitionManager {
   std::unordered_map<uint32_t, std::shared_ptr<objects::MiDevilData>>
       mDevilData;
 
+  /// Flat index of devil definitions by ID built from mDevilData
+  DefinitionIndex<uint32_t, objects::MiDevilData> mDevilIndex;
+
+  /// Devil definitions read from the shared data store, used instead of
+  /// mDevilData when attached
+  SharedDefinitionTable<objects::MiDevilData> mDevilTable;
+
   /// Map of devil equipment definitions by skill ID
   std::unordered_map<uint32_t, std::shared_ptr<objects::MiDevilEquipmentData>>
       mDevilEquipmentData;
@@ -1112,6 +1197,13 @@ class DefinitionManager {
   /// Map of item definitions by ID
   std::unordered_map<uint32_t, std::shared_ptr<objects::MiItemData>> mItemData;
 
+  /// Flat index of item definitions by ID built from mItemData
+  DefinitionIndex<uint32_t, objects::MiItemData> mItemIndex;
+
+  /// Item definitions read from the shared data store, used instead of
+  /// mItemData when attached
+  SharedDefinitionTable<objects::MiItemData> mItemTable;
+
   /// Map of mission definitions by ID
   std::unordered_map<uint32_t, std::shared_ptr<objects::MiMissionData>>
       mMissionData;
@@ -1200,6 +1292,13 @@ class DefinitionManager {
   std::unordered_map<uint32_t, std::shared_ptr<objects::MiSkillData>>
       mSkillData;
 
+  /// Flat index of skill definitions by ID built from mSkillData
+  DefinitionIndex<uint32_t, objects::MiSkillData> mSkillIndex;
+
+  /// Skill definitions read from the shared data store, used instead of
+  /// mSkillData when attached
+  SharedDefinitionTable<objects::MiSkillData> mSkillTable;
+
   /// Map of skill function IDs to skill IDs
   std::unordered_map<uint16_t, std::set<uint32_t>> mFunctionIDSkills;
 
@@ -1217,6 +1316,9 @@ class DefinitionManager {
   std::unordered_map<uint32_t, std::shared_ptr<objects::MiStatusData>>
       mStatusData;
 
+  /// Flat index of status definitions by ID built from mStatusData
+  DefinitionIndex<uint32_t, objects::MiStatusData> mStatusIndex;
+
   /// Map of synthesis definitions by ID
   std::unordered_map<uint32_t, std::shared_ptr<objects::MiSynthesisData>>
       mSynthesisData;
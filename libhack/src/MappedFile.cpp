@@ -0,0 +1,141 @@
+/**
+ * @file libhack/src/MappedFile.cpp
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Read only memory mapping of a file.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+using namespace libhack;
+
+#ifdef _WIN32
+MappedFile::MappedFile() : mData(nullptr), mSize(0), mMapping(nullptr) {}
+#else
+MappedFile::MappedFile() : mData(nullptr), mSize(0) {}
+#endif  // _WIN32
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const libcomp::String& path) {
+  Close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.C(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+  // The mapping keeps the file open on its own
+  CloseHandle(file);
+
+  if (!mapping) {
+    return false;
+  }
+
+  void* pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!pView) {
+    CloseHandle(mapping);
+    return false;
+  }
+
+  mMapping = mapping;
+  mData = static_cast<const char*>(pView);
+  mSize = (size_t)size.QuadPart;
+#else
+  int fd = open(path.C(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+
+  void* pView = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  // The mapping keeps the file open on its own
+  close(fd);
+
+  if (pView == MAP_FAILED) {
+    return false;
+  }
+
+  mData = static_cast<const char*>(pView);
+  mSize = (size_t)st.st_size;
+#endif  // _WIN32
+
+  return true;
+}
+
+void MappedFile::Close() {
+  if (!mData) {
+    return;
+  }
+
+#ifdef _WIN32
+  UnmapViewOfFile(mData);
+  CloseHandle((HANDLE)mMapping);
+  mMapping = nullptr;
+#else
+  munmap(const_cast<char*>(mData), mSize);
+#endif  // _WIN32
+
+  mData = nullptr;
+  mSize = 0;
+}
+
+bool MappedFile::IsOpen() const { return mData != nullptr; }
+
+const char* MappedFile::GetData() const { return mData; }
+
+size_t MappedFile::GetSize() const { return mSize; }
+
+bool MappedFile::Replace(const libcomp::String& source,
+                         const libcomp::String& target) {
+#ifdef _WIN32
+  return MoveFileExA(source.C(), target.C(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return rename(source.C(), target.C()) == 0;
+#endif  // _WIN32
+}
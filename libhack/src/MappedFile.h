@@ -0,0 +1,115 @@
+/**
+ * @file libhack/src/MappedFile.h
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Read only memory mapping of a file.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHACK_SRC_MAPPEDFILE_H
+#define LIBHACK_SRC_MAPPEDFILE_H
+
+// libcomp Includes
+#include "CString.h"
+
+// Standard C++11 Includes
+#include <stddef.h>
+
+namespace libhack {
+
+/**
+ * Maps a whole file into memory read only so it can be read without
+ * copying it into a buffer first. The file must not be modified while it
+ * is mapped; write a new file and move it into place with Replace instead.
+ */
+class MappedFile {
+ public:
+  /**
+   * Create an empty mapping.
+   */
+  MappedFile();
+
+  /**
+   * Unmap the file if it is mapped.
+   */
+  ~MappedFile();
+
+  /**
+   * Map a file, unmapping any file that was already mapped.
+   * @param path Path to the file on disk
+   * @return true if the file was mapped, false if it does not exist, is
+   *  empty or could not be mapped
+   */
+  bool Open(const libcomp::String& path);
+
+  /**
+   * Unmap the file if it is mapped.
+   */
+  void Close();
+
+  /**
+   * Check if a file is mapped.
+   * @return true if a file is mapped
+   */
+  bool IsOpen() const;
+
+  /**
+   * Get the mapped contents of the file.
+   * @return Pointer to the first byte of the file or null if no file is
+   *  mapped
+   */
+  const char* GetData() const;
+
+  /**
+   * Get the size of the mapped file.
+   * @return Size of the file in bytes
+   */
+  size_t GetSize() const;
+
+  /**
+   * Move a file into place, replacing the target if it already exists.
+   * Unlike std::rename this also replaces an existing file on Windows.
+   * @param source Path to the file to move
+   * @param target Path to move the file to
+   * @return true if the file was moved, false otherwise
+   */
+  static bool Replace(const libcomp::String& source,
+                      const libcomp::String& target);
+
+ private:
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /// Pointer to the mapped contents of the file
+  const char* mData;
+
+  /// Size of the mapped file in bytes
+  size_t mSize;
+
+#ifdef _WIN32
+  /// Handle to the file mapping object
+  void* mMapping;
+#endif  // _WIN32
+};
+
+}  // namespace libhack
+
+#endif  // LIBHACK_SRC_MAPPEDFILE_H
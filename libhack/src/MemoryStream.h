@@ -0,0 +1,130 @@
+/**
+ * @file libhack/src/MemoryStream.h
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Input stream that reads directly from an existing buffer.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHACK_SRC_MEMORYSTREAM_H
+#define LIBHACK_SRC_MEMORYSTREAM_H
+
+// Standard C++11 Includes
+#include <stddef.h>
+
+#include <istream>
+#include <streambuf>
+
+namespace libhack {
+
+/**
+ * Stream buffer over a block of memory owned by someone else. Nothing is
+ * copied so the memory must outlive the buffer and must not change while
+ * it is being read.
+ */
+class MemoryStreamBuffer : public std::streambuf {
+ public:
+  /**
+   * Create a buffer over a block of memory.
+   * @param pData Pointer to the first byte to read
+   * @param size Number of bytes that can be read
+   */
+  MemoryStreamBuffer(const char* pData, size_t size) {
+    char* pBegin = const_cast<char*>(pData);
+    setg(pBegin, pBegin, pBegin + size);
+  }
+
+ protected:
+  /**
+   * Move the read position relative to the start, current position or
+   * end of the buffer.
+   * @param off Offset to move by
+   * @param dir Position the offset is relative to
+   * @param which Which sequence to move, only input is supported
+   * @return New position or -1 if it is out of range
+   */
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which = std::ios_base::in) override {
+    if (!(which & std::ios_base::in)) {
+      return pos_type(off_type(-1));
+    }
+
+    char* pTarget = nullptr;
+    switch (dir) {
+      case std::ios_base::beg:
+        pTarget = eback() + off;
+        break;
+      case std::ios_base::cur:
+        pTarget = gptr() + off;
+        break;
+      case std::ios_base::end:
+        pTarget = egptr() + off;
+        break;
+      default:
+        return pos_type(off_type(-1));
+    }
+
+    if (pTarget < eback() || pTarget > egptr()) {
+      return pos_type(off_type(-1));
+    }
+
+    setg(eback(), pTarget, egptr());
+
+    return pos_type(pTarget - eback());
+  }
+
+  /**
+   * Move the read position to an absolute position.
+   * @param pos Position to move to
+   * @param which Which sequence to move, only input is supported
+   * @return New position or -1 if it is out of range
+   */
+  pos_type seekpos(pos_type pos,
+                   std::ios_base::openmode which = std::ios_base::in) override {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+};
+
+/**
+ * Input stream that reads directly from a block of memory without copying
+ * it. Used to deserialize data that has already been read or decrypted
+ * into memory.
+ */
+class MemoryInStream : public std::istream {
+ public:
+  /**
+   * Create a stream over a block of memory.
+   * @param pData Pointer to the first byte to read
+   * @param size Number of bytes that can be read
+   */
+  MemoryInStream(const char* pData, size_t size)
+      : std::istream(nullptr), mBuffer(pData, size) {
+    rdbuf(&mBuffer);
+  }
+
+ private:
+  /// Buffer the stream reads from
+  MemoryStreamBuffer mBuffer;
+};
+
+}  // namespace libhack
+
+#endif  // LIBHACK_SRC_MEMORYSTREAM_H
@@ -0,0 +1,353 @@
+/**
+ * @file libhack/src/MetricsRegistry.cpp
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief In-process registry of latency histograms, counters and gauges.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricsRegistry.h"
+
+// Standard C++11 Includes
+#include <algorithm>
+
+using namespace libhack;
+
+/// Number of bits of precision kept for each power of two. Each power of two
+/// is split into 2^SUB_BUCKET_BITS linear buckets.
+static const uint32_t SUB_BUCKET_BITS = 4;
+
+/// Number of linear buckets each power of two is split into
+static const uint32_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+
+/// Values are clamped to fit in this many bits (about 12 days in
+/// microseconds)
+static const uint32_t MAX_VALUE_BITS = 40;
+
+/// Total number of buckets in each histogram
+static const uint32_t BUCKET_COUNT =
+    (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+/// Next unique registry ID
+static std::atomic<uint64_t> gNextRegistryID(1);
+
+namespace {
+
+/// Shard last used by the current thread, cached to skip the registry
+/// lookup on every record
+struct CachedShard {
+  /// ID of the registry the shard belongs to
+  uint64_t RegistryID;
+
+  /// Shard pointer, owned by the registry
+  void* Shard;
+};
+
+thread_local CachedShard tCachedShard = {0, nullptr};
+
+/**
+ * Add to an atomic value only ever written to by the current thread. This
+ * avoids the cost of an atomic read-modify-write while still letting other
+ * threads read the value safely.
+ * @param value Value to add to
+ * @param add Amount to add
+ */
+inline void SingleWriterAdd(std::atomic<uint64_t>& value, uint64_t add) {
+  value.store(value.load(std::memory_order_relaxed) + add,
+              std::memory_order_relaxed);
+}
+
+}  // namespace
+
+MetricsRegistry::Histogram::Histogram()
+    : Counts(BUCKET_COUNT), Sum(0), Max(0) {}
+
+MetricsRegistry::MetricsRegistry() : mID(gNextRegistryID++), mGaugeSequence(0) {}
+
+MetricsRegistry::~MetricsRegistry() {}
+
+void MetricsRegistry::RecordLatency(const std::string& metric, uint64_t value) {
+  Shard* shard = GetShard();
+
+  Histogram* histogram = nullptr;
+
+  auto it = shard->Histograms.find(metric);
+  if (it != shard->Histograms.end()) {
+    histogram = it->second.get();
+  } else {
+    histogram = new Histogram;
+
+    std::lock_guard<std::mutex> lock(shard->Lock);
+    shard->Histograms[metric] = std::unique_ptr<Histogram>(histogram);
+  }
+
+  SingleWriterAdd(histogram->Counts[GetBucket(value)], 1);
+  SingleWriterAdd(histogram->Sum, value);
+
+  if (value > histogram->Max.load(std::memory_order_relaxed)) {
+    histogram->Max.store(value, std::memory_order_relaxed);
+  }
+}
+
+void MetricsRegistry::AddCounter(const std::string& metric, uint64_t value) {
+  Shard* shard = GetShard();
+
+  auto it = shard->Counters.find(metric);
+  if (it != shard->Counters.end()) {
+    SingleWriterAdd(*it->second, value);
+  } else {
+    std::lock_guard<std::mutex> lock(shard->Lock);
+    shard->Counters[metric] = std::unique_ptr<std::atomic<uint64_t>>(
+        new std::atomic<uint64_t>(value));
+  }
+}
+
+void MetricsRegistry::SetGauge(const std::string& metric, uint64_t value) {
+  Shard* shard = GetShard();
+
+  Gauge* gauge = nullptr;
+
+  auto it = shard->Gauges.find(metric);
+  if (it != shard->Gauges.end()) {
+    gauge = it->second.get();
+  } else {
+    gauge = new Gauge;
+    gauge->Value = 0;
+    gauge->Sequence = 0;
+
+    std::lock_guard<std::mutex> lock(shard->Lock);
+    shard->Gauges[metric] = std::unique_ptr<Gauge>(gauge);
+  }
+
+  gauge->Value.store(value, std::memory_order_relaxed);
+  gauge->Sequence.store(++mGaugeSequence, std::memory_order_release);
+}
+
+MetricsRegistry::Snapshot MetricsRegistry::GetTotals() {
+  std::map<std::string, MergedHistogram> histograms;
+
+  Snapshot snapshot;
+  Merge(histograms, snapshot.Counters, snapshot.Gauges);
+
+  for (auto& pair : histograms) {
+    snapshot.Histograms[pair.first] =
+        Summarize(pair.second.Counts, pair.second.Sum, pair.second.Max);
+  }
+
+  return snapshot;
+}
+
+MetricsRegistry::Snapshot MetricsRegistry::GetInterval() {
+  std::map<std::string, MergedHistogram> histograms;
+  std::map<std::string, uint64_t> counters;
+
+  Snapshot snapshot;
+  Merge(histograms, counters, snapshot.Gauges);
+
+  std::lock_guard<std::mutex> lock(mIntervalLock);
+
+  for (auto& pair : histograms) {
+    auto& current = pair.second;
+
+    std::vector<uint64_t> counts = current.Counts;
+    uint64_t sum = current.Sum;
+
+    auto lastIter = mLastHistograms.find(pair.first);
+    if (lastIter != mLastHistograms.end()) {
+      auto& last = lastIter->second;
+      for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] -= std::min(counts[i], last.Counts[i]);
+      }
+
+      sum -= std::min(sum, last.Sum);
+    }
+
+    // The exact max is only known since the registry was created so use
+    // the highest bucket recorded to this interval instead
+    uint64_t max = 0;
+    for (uint32_t i = BUCKET_COUNT; i > 0; i--) {
+      if (counts[i - 1]) {
+        max = std::min(GetBucketMax(i - 1), current.Max);
+        break;
+      }
+    }
+
+    auto summary = Summarize(counts, sum, max);
+    if (summary.Count) {
+      snapshot.Histograms[pair.first] = summary;
+    }
+  }
+
+  for (auto& pair : counters) {
+    uint64_t last = mLastCounters[pair.first];
+    if (pair.second > last) {
+      snapshot.Counters[pair.first] = pair.second - last;
+    }
+  }
+
+  mLastHistograms.swap(histograms);
+  mLastCounters.swap(counters);
+
+  return snapshot;
+}
+
+MetricsRegistry::Shard* MetricsRegistry::GetShard() {
+  if (tCachedShard.RegistryID == mID) {
+    return static_cast<Shard*>(tCachedShard.Shard);
+  }
+
+  Shard* shard = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mShardLock);
+
+    auto& threadShard = mShards[std::this_thread::get_id()];
+    if (!threadShard) {
+      threadShard = std::unique_ptr<Shard>(new Shard);
+    }
+
+    shard = threadShard.get();
+  }
+
+  tCachedShard.RegistryID = mID;
+  tCachedShard.Shard = shard;
+
+  return shard;
+}
+
+void MetricsRegistry::Merge(std::map<std::string, MergedHistogram>& histograms,
+                            std::map<std::string, uint64_t>& counters,
+                            std::map<std::string, uint64_t>& gauges) {
+  std::map<std::string, uint64_t> gaugeSequences;
+
+  std::lock_guard<std::mutex> lock(mShardLock);
+  for (auto& shardPair : mShards) {
+    Shard* shard = shardPair.second.get();
+
+    std::lock_guard<std::mutex> shardLock(shard->Lock);
+    for (auto& pair : shard->Histograms) {
+      auto& merged = histograms[pair.first];
+      if (merged.Counts.size() == 0) {
+        merged.Counts.resize(BUCKET_COUNT, 0);
+        merged.Sum = 0;
+        merged.Max = 0;
+      }
+
+      Histogram* histogram = pair.second.get();
+      for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        merged.Counts[i] +=
+            histogram->Counts[i].load(std::memory_order_relaxed);
+      }
+
+      merged.Sum += histogram->Sum.load(std::memory_order_relaxed);
+      merged.Max = std::max(merged.Max,
+                            histogram->Max.load(std::memory_order_relaxed));
+    }
+
+    for (auto& pair : shard->Counters) {
+      counters[pair.first] += pair.second->load(std::memory_order_relaxed);
+    }
+
+    for (auto& pair : shard->Gauges) {
+      // Keep whichever thread set the gauge last
+      uint64_t sequence = pair.second->Sequence.load(std::memory_order_acquire);
+      auto seqIter = gaugeSequences.find(pair.first);
+      if (seqIter == gaugeSequences.end() || seqIter->second < sequence) {
+        gaugeSequences[pair.first] = sequence;
+        gauges[pair.first] =
+            pair.second->Value.load(std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+MetricsRegistry::HistogramSummary MetricsRegistry::Summarize(
+    const std::vector<uint64_t>& counts, uint64_t sum, uint64_t max) {
+  HistogramSummary summary;
+  summary.Count = 0;
+  summary.Sum = sum;
+  summary.P50 = 0;
+  summary.P99 = 0;
+  summary.Max = max;
+
+  for (uint64_t count : counts) {
+    summary.Count += count;
+  }
+
+  if (!summary.Count) {
+    return summary;
+  }
+
+  // Rank (1 based) of the values at each percentile
+  uint64_t p50Rank = std::max<uint64_t>(1, (summary.Count * 50 + 99) / 100);
+  uint64_t p99Rank = std::max<uint64_t>(1, (summary.Count * 99 + 99) / 100);
+
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < (uint32_t)counts.size(); i++) {
+    if (!counts[i]) {
+      continue;
+    }
+
+    uint64_t previous = seen;
+    seen += counts[i];
+
+    uint64_t value = std::min(GetBucketMax(i), max);
+    if (previous < p50Rank && seen >= p50Rank) {
+      summary.P50 = value;
+    }
+
+    if (previous < p99Rank && seen >= p99Rank) {
+      summary.P99 = value;
+      break;
+    }
+  }
+
+  return summary;
+}
+
+uint32_t MetricsRegistry::GetBucket(uint64_t value) {
+  const uint64_t maxValue = (1ULL << MAX_VALUE_BITS) - 1;
+  value = std::min(value, maxValue);
+
+  if (value < SUB_BUCKET_COUNT) {
+    return (uint32_t)value;
+  }
+
+  // Position of the highest bit set
+  uint32_t highBit = 0;
+  for (uint64_t v = value; v > 1; v >>= 1) {
+    highBit++;
+  }
+
+  uint32_t shift = highBit - SUB_BUCKET_BITS;
+  return (shift + 1) * SUB_BUCKET_COUNT +
+         (uint32_t)((value >> shift) - SUB_BUCKET_COUNT);
+}
+
+uint64_t MetricsRegistry::GetBucketMax(uint32_t bucket) {
+  if (bucket < SUB_BUCKET_COUNT) {
+    return bucket;
+  }
+
+  uint32_t shift = bucket / SUB_BUCKET_COUNT - 1;
+  uint64_t sub = (uint64_t)(bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT);
+
+  return ((sub + 1) << shift) - 1;
+}
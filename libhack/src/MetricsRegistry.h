@@ -0,0 +1,250 @@
+/**
+ * @file libhack/src/MetricsRegistry.h
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief In-process registry of latency histograms, counters and gauges.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHACK_SRC_METRICSREGISTRY_H
+#define LIBHACK_SRC_METRICSREGISTRY_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace libhack {
+
+/**
+ * Registry of named metrics recorded by the server. Latencies are recorded
+ * into log-linear (HDR-style) histograms with roughly 6% precision, counters
+ * are summed and gauges keep the last value set. Each thread records into
+ * its own shard so recording never contends with other threads; shards are
+ * only locked when a thread records a metric name for the first time or
+ * while a snapshot merges them together.
+ */
+class MetricsRegistry {
+ public:
+  /// Summary of the values recorded in a latency histogram
+  struct HistogramSummary {
+    /// Number of values recorded
+    uint64_t Count;
+
+    /// Sum of every value recorded
+    uint64_t Sum;
+
+    /// Median value recorded
+    uint64_t P50;
+
+    /// 99th percentile value recorded
+    uint64_t P99;
+
+    /// Largest value recorded
+    uint64_t Max;
+  };
+
+  /// Merged view of every metric in the registry
+  struct Snapshot {
+    /// Latency histogram summaries by metric name
+    std::map<std::string, HistogramSummary> Histograms;
+
+    /// Counter values by metric name
+    std::map<std::string, uint64_t> Counters;
+
+    /// Gauge values by metric name
+    std::map<std::string, uint64_t> Gauges;
+  };
+
+  /**
+   * Create an empty registry.
+   */
+  MetricsRegistry();
+
+  /**
+   * Clean up the registry.
+   */
+  ~MetricsRegistry();
+
+  /**
+   * Record a latency (or any other distribution) value.
+   * @param metric Name of the metric
+   * @param value Value to record, such as a duration in microseconds
+   */
+  void RecordLatency(const std::string& metric, uint64_t value);
+
+  /**
+   * Add to a counter.
+   * @param metric Name of the metric
+   * @param value Amount to add to the counter
+   */
+  void AddCounter(const std::string& metric, uint64_t value = 1);
+
+  /**
+   * Set the current value of a gauge.
+   * @param metric Name of the metric
+   * @param value Value to set
+   */
+  void SetGauge(const std::string& metric, uint64_t value);
+
+  /**
+   * Get a snapshot of everything recorded since the registry was created.
+   * @return Snapshot of every metric
+   */
+  Snapshot GetTotals();
+
+  /**
+   * Get a snapshot of everything recorded since the last time this was
+   * called. Metrics with no new values recorded are not included. Gauges
+   * are always included with their current value.
+   * @return Snapshot of every metric that changed
+   */
+  Snapshot GetInterval();
+
+ private:
+  /// Latency histogram written to by one thread
+  struct Histogram {
+    /**
+     * Create an empty histogram.
+     */
+    Histogram();
+
+    /// Number of values recorded in each bucket
+    std::vector<std::atomic<uint64_t>> Counts;
+
+    /// Sum of every value recorded
+    std::atomic<uint64_t> Sum;
+
+    /// Largest value recorded
+    std::atomic<uint64_t> Max;
+  };
+
+  /// Gauge written to by one thread
+  struct Gauge {
+    /// Last value set
+    std::atomic<uint64_t> Value;
+
+    /// Order the value was set in across every thread
+    std::atomic<uint64_t> Sequence;
+  };
+
+  /// Metrics recorded by a single thread. Only the owning thread records
+  /// values or adds metrics; other threads only read values.
+  struct Shard {
+    /// Lock held while adding new metrics or reading the shard from
+    /// another thread
+    std::mutex Lock;
+
+    /// Latency histograms by metric name
+    std::unordered_map<std::string, std::unique_ptr<Histogram>> Histograms;
+
+    /// Counters by metric name
+    std::unordered_map<std::string, std::unique_ptr<std::atomic<uint64_t>>>
+        Counters;
+
+    /// Gauges by metric name
+    std::unordered_map<std::string, std::unique_ptr<Gauge>> Gauges;
+  };
+
+  /// Merged bucket counts, sum and max of a histogram
+  struct MergedHistogram {
+    /// Number of values recorded in each bucket
+    std::vector<uint64_t> Counts;
+
+    /// Sum of every value recorded
+    uint64_t Sum;
+
+    /// Largest value recorded
+    uint64_t Max;
+  };
+
+  /**
+   * Get the shard for the calling thread, creating it if needed.
+   * @return Pointer to the shard for the calling thread
+   */
+  Shard* GetShard();
+
+  /**
+   * Merge every shard together.
+   * @param histograms Output map of merged histograms by metric name
+   * @param counters Output map of counter totals by metric name
+   * @param gauges Output map of the last value set for each gauge
+   */
+  void Merge(std::map<std::string, MergedHistogram>& histograms,
+             std::map<std::string, uint64_t>& counters,
+             std::map<std::string, uint64_t>& gauges);
+
+  /**
+   * Summarize merged histogram buckets.
+   * @param counts Number of values recorded in each bucket
+   * @param sum Sum of every value recorded
+   * @param max Largest value recorded
+   * @return Summary of the histogram
+   */
+  static HistogramSummary Summarize(const std::vector<uint64_t>& counts,
+                                    uint64_t sum, uint64_t max);
+
+  /**
+   * Get the histogram bucket a value is counted in.
+   * @param value Value to get the bucket for
+   * @return Index of the bucket
+   */
+  static uint32_t GetBucket(uint64_t value);
+
+  /**
+   * Get the largest value counted in a histogram bucket.
+   * @param bucket Index of the bucket
+   * @return Largest value counted in the bucket
+   */
+  static uint64_t GetBucketMax(uint32_t bucket);
+
+  /// Unique ID of the registry used to identify it in thread local storage
+  uint64_t mID;
+
+  /// Shards by the thread that owns them
+  std::unordered_map<std::thread::id, std::unique_ptr<Shard>> mShards;
+
+  /// Merged histograms as of the last call to GetInterval
+  std::map<std::string, MergedHistogram> mLastHistograms;
+
+  /// Counter totals as of the last call to GetInterval
+  std::map<std::string, uint64_t> mLastCounters;
+
+  /// Next sequence number to assign when a gauge is set
+  std::atomic<uint64_t> mGaugeSequence;
+
+  /// Lock for the shard map
+  std::mutex mShardLock;
+
+  /// Lock for the values recorded by GetInterval
+  std::mutex mIntervalLock;
+};
+
+}  // namespace libhack
+
+#endif  // LIBHACK_SRC_METRICSREGISTRY_H
@@ -0,0 +1,159 @@
+/**
+ * @file libhack/src/MetricsWebHandler.cpp
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Web handler that exposes server metrics in the Prometheus text
+ *  format.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricsWebHandler.h"
+
+#ifndef EXOTIC_PLATFORM
+
+// libhack Includes
+#include "MetricsRegistry.h"
+#include "Server.h"
+
+// Standard C++11 Includes
+#include <cctype>
+#include <set>
+#include <sstream>
+
+using namespace libhack;
+
+MetricsWebHandler::MetricsWebHandler(Server* pServer,
+                                     const std::string& prefix)
+    : mServer(pServer), mPrefix(prefix) {}
+
+MetricsWebHandler::~MetricsWebHandler() {}
+
+bool MetricsWebHandler::handleGet(CivetServer* pServer,
+                                  struct mg_connection* pConnection) {
+  (void)pServer;
+
+  // Let the server record anything it only samples on request
+  mServer->UpdateMetrics();
+
+  auto snapshot = mServer->GetMetrics()->GetTotals();
+
+  std::stringstream ss;
+
+  // Metrics recorded with labels, such as "AIActive{zone=\"1\"}", share one
+  // family so the type of each family is only written once
+  std::set<std::string> families;
+
+  for (auto& pair : snapshot.Histograms) {
+    std::string labels;
+    auto name = GetMetricName(pair.first, labels) + "_us";
+    auto& summary = pair.second;
+
+    // Quantiles are added to any labels already recorded
+    std::string quantile = labels.empty()
+                               ? std::string("{")
+                               : labels.substr(0, labels.size() - 1) + ",";
+
+    if (families.insert(name).second) {
+      ss << "# TYPE " << name << " summary\n";
+      ss << "# TYPE " << name << "_max gauge\n";
+    }
+
+    ss << name << quantile << "quantile=\"0.5\"} " << summary.P50 << "\n";
+    ss << name << quantile << "quantile=\"0.99\"} " << summary.P99 << "\n";
+    ss << name << "_sum" << labels << " " << summary.Sum << "\n";
+    ss << name << "_count" << labels << " " << summary.Count << "\n";
+    ss << name << "_max" << labels << " " << summary.Max << "\n";
+  }
+
+  for (auto& pair : snapshot.Counters) {
+    std::string labels;
+    auto name = GetMetricName(pair.first, labels) + "_total";
+
+    if (families.insert(name).second) {
+      ss << "# TYPE " << name << " counter\n";
+    }
+
+    ss << name << labels << " " << pair.second << "\n";
+  }
+
+  for (auto& pair : snapshot.Gauges) {
+    std::string labels;
+    auto name = GetMetricName(pair.first, labels);
+
+    if (families.insert(name).second) {
+      ss << "# TYPE " << name << " gauge\n";
+    }
+
+    ss << name << labels << " " << pair.second << "\n";
+  }
+
+  auto body = ss.str();
+
+  mg_printf(pConnection,
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Content-Length: %u\r\n"
+            "Connection: close\r\n"
+            "\r\n",
+            (uint32_t)body.size());
+  mg_write(pConnection, body.c_str(), body.size());
+
+  return true;
+}
+
+std::string MetricsWebHandler::GetMetricName(const std::string& metric,
+                                             std::string& labels) const {
+  std::string name = mPrefix;
+
+  // Labels are passed through as they were recorded
+  auto labelStart = metric.find('{');
+  labels = labelStart != std::string::npos ? metric.substr(labelStart)
+                                           : std::string();
+
+  // Split words on spaces, punctuation and lower to upper case changes so
+  // "UpdateActiveZoneStates" becomes "update_active_zone_states"
+  bool separate = !name.empty();
+  char previous = 0;
+  for (char c : metric.substr(0, labelStart)) {
+    if (!std::isalnum((unsigned char)c)) {
+      separate = !name.empty();
+    } else {
+      if (std::isupper((unsigned char)c) &&
+          (std::islower((unsigned char)previous) ||
+           std::isdigit((unsigned char)previous))) {
+        separate = true;
+      }
+
+      if (separate) {
+        name += '_';
+        separate = false;
+      }
+
+      name += (char)std::tolower((unsigned char)c);
+    }
+
+    previous = c;
+  }
+
+  return name;
+}
+
+#endif  // !EXOTIC_PLATFORM
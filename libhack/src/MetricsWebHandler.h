@@ -0,0 +1,100 @@
+/**
+ * @file libhack/src/MetricsWebHandler.h
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Web handler that exposes server metrics in the Prometheus text
+ *  format.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHACK_SRC_METRICSWEBHANDLER_H
+#define LIBHACK_SRC_METRICSWEBHANDLER_H
+
+#ifndef EXOTIC_PLATFORM
+
+// Civet Includes
+#include <CivetServer.h>
+
+// Standard C++11 Includes
+#include <string>
+
+namespace libhack {
+
+class Server;
+
+/**
+ * Web handler that writes every metric recorded to a server's metrics
+ * registry in the Prometheus text exposition format. Latency histograms
+ * are written as summaries with the median and 99th percentile since the
+ * server started, counters get a "_total" suffix and gauges are written
+ * as-is. Metric names are converted to snake case and prefixed with the
+ * name of the server type.
+ */
+class MetricsWebHandler : public CivetHandler {
+ public:
+  /**
+   * Create the handler.
+   * @param pServer Server to expose the metrics of. Must stay valid until
+   *  the web server using the handler has been stopped.
+   * @param prefix Prefix to add to every metric name, such as
+   *  "comphack_channel"
+   */
+  MetricsWebHandler(Server* pServer, const std::string& prefix);
+
+  /**
+   * Clean up the handler.
+   */
+  virtual ~MetricsWebHandler();
+
+  /**
+   * Write the current value of every metric.
+   * @param pServer Web server the request was received by
+   * @param pConnection Connection the request was received on
+   * @return true if the request was handled
+   */
+  virtual bool handleGet(CivetServer* pServer,
+                         struct mg_connection* pConnection);
+
+ private:
+  /**
+   * Convert a metric name recorded by the server into a Prometheus metric
+   * name with the handler's prefix.
+   * @param metric Metric name as recorded, such as "AIActive" or
+   *  "AIActive{zone=\"1\"}"
+   * @param labels Output parameter set to the labels recorded with the
+   *  metric, such as "{zone=\"1\"}", or empty if there are none
+   * @return Prometheus metric name, such as "comphack_channel_ai_active"
+   */
+  std::string GetMetricName(const std::string& metric,
+                            std::string& labels) const;
+
+  /// Server to expose the metrics of
+  Server* mServer;
+
+  /// Prefix added to every metric name
+  std::string mPrefix;
+};
+
+}  // namespace libhack
+
+#endif  // !EXOTIC_PLATFORM
+
+#endif  // LIBHACK_SRC_METRICSWEBHANDLER_H
@@ -32,6 +32,7 @@
 #include <Log.h>
 
 // libhack Includes
+#include <MetricsWebHandler.h>
 #include <ScriptEngine.h>
 #include <ServerConstants.h>
 
@@ -43,15 +44,76 @@ using namespace libhack;
 Server::Server(const char* szProgram,
                std::shared_ptr<objects::ServerConfig> config,
                std::shared_ptr<libcomp::ServerCommandLineParser> commandLine)
-    : libcomp::BaseServer(szProgram, config, commandLine) {}
+    : libcomp::BaseServer(szProgram, config, commandLine),
+      mMetrics(std::make_shared<MetricsRegistry>()),
+      mMetricsServer(nullptr),
+      mMetricsHandler(nullptr) {}
 
-Server::~Server() {}
+Server::~Server() { StopMetricsServer(); }
 
 std::shared_ptr<libcomp::BaseScriptEngine> Server::CreateScriptEngine(
     bool useRawPrint) const {
   return std::make_shared<ScriptEngine>(useRawPrint);
 }
 
+std::shared_ptr<MetricsRegistry> Server::GetMetrics() const {
+  return mMetrics;
+}
+
+bool Server::StartMetricsServer(uint16_t port, const std::string& prefix) {
+  if (!port || mMetricsServer) {
+    return true;
+  }
+
+  // Only listen on localhost, the metrics are not meant to be public
+  std::vector<std::string> options;
+  options.push_back("listening_ports");
+  options.push_back(libcomp::String("127.0.0.1:%1").Arg(port).ToUtf8());
+  options.push_back("num_threads");
+  options.push_back("1");
+
+  auto pHandler = new MetricsWebHandler(this, prefix);
+
+  try {
+    mMetricsServer = new CivetServer(options);
+    mMetricsServer->addHandler("/metrics", pHandler);
+  } catch (const CivetException& e) {
+    LogServerError([&]() {
+      return libcomp::String(
+                 "The metrics web server failed to start on port %1 with the "
+                 "following message: %2\n")
+          .Arg(port)
+          .Arg(e.what());
+    });
+
+    delete mMetricsServer;
+    mMetricsServer = nullptr;
+    delete pHandler;
+
+    return false;
+  }
+
+  mMetricsHandler = pHandler;
+
+  LogServerInfo([&]() {
+    return libcomp::String("Metrics available at http://127.0.0.1:%1/metrics\n")
+        .Arg(port);
+  });
+
+  return true;
+}
+
+void Server::StopMetricsServer() {
+  // Stop the web server first so no request is still using the handler
+  delete mMetricsServer;
+  mMetricsServer = nullptr;
+
+  delete mMetricsHandler;
+  mMetricsHandler = nullptr;
+}
+
+void Server::UpdateMetrics() {}
+
 bool Server::InitializeConstants(const libcomp::String& constantsPath) {
   if (!libhack::ServerConstants::Initialize(constantsPath)) {
     LogServerCritical([&]() {
@@ -31,12 +31,17 @@
 
 // libhack Includes
 #include <Constants.h>
+#include <MetricsRegistry.h>
 
 // libcomp Includes
 #include <BaseServer.h>
 
+class CivetServer;
+
 namespace libhack {
 
+class MetricsWebHandler;
+
 /**
  * Base class for all servers that run workers to handle
  * incoming messages in the message queue.  Each of these
@@ -68,6 +73,37 @@ class Server : public libcomp::BaseServer {
   std::shared_ptr<libcomp::BaseScriptEngine> CreateScriptEngine(
       bool useRawPrint = false) const override;
 
+  /**
+   * Get the registry performance metrics are recorded to.
+   * @return Pointer to the server's metrics registry
+   */
+  std::shared_ptr<MetricsRegistry> GetMetrics() const;
+
+  /**
+   * Start a web server bound to localhost that exposes the server's
+   * metrics at "/metrics" in the Prometheus text format.
+   * @param port Port to listen on. If this is zero, no web server is
+   *  started.
+   * @param prefix Prefix to add to every metric name, such as
+   *  "comphack_channel"
+   * @return true if the web server was started or is not needed, false
+   *  if it failed to start
+   */
+  bool StartMetricsServer(uint16_t port, const std::string& prefix);
+
+  /**
+   * Stop the metrics web server if it is running. This must be called
+   * before the server is destroyed so requests stop calling into it.
+   */
+  void StopMetricsServer();
+
+  /**
+   * Record any metrics that are only sampled when requested, such as
+   * connection counts. Called by the metrics web server before every
+   * request is answered so this must be safe to call from any thread.
+   */
+  virtual void UpdateMetrics();
+
  protected:
   /**
    * Initialize the server constants.
@@ -85,6 +121,16 @@ class Server : public libcomp::BaseServer {
   bool ProcessDataLoadObject(
       const libcomp::String& name,
       std::shared_ptr<libcomp::PersistentObject>& record) override;
+
+ private:
+  /// Registry performance metrics are recorded to
+  std::shared_ptr<MetricsRegistry> mMetrics;
+
+  /// Web server exposing the metrics or null if it is not running
+  CivetServer* mMetricsServer;
+
+  /// Handler for requests to the metrics web server
+  MetricsWebHandler* mMetricsHandler;
 };
 
 }  // namespace libhack
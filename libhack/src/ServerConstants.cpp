@@ -1855,6 +1855,8 @@ bool ServerConstants::Initialize(const String& filePath) {
       LoadInteger(constants["GM_CMD_LVL_MAP"], sConstants.GM_CMD_LVL_MAP);
   success &=
       LoadInteger(constants["GM_CMD_LVL_ONLINE"], sConstants.GM_CMD_LVL_ONLINE);
+  success &= LoadInteger(constants["GM_CMD_LVL_PACKETS"],
+                         sConstants.GM_CMD_LVL_PACKETS);
   success &= LoadInteger(constants["GM_CMD_LVL_PENALTY_RESET"],
                          sConstants.GM_CMD_LVL_PENALTY_RESET);
   success &=
@@ -1863,6 +1865,8 @@ bool ServerConstants::Initialize(const String& filePath) {
                          sConstants.GM_CMD_LVL_POSITION);
   success &=
       LoadInteger(constants["GM_CMD_LVL_POST"], sConstants.GM_CMD_LVL_POST);
+  success &=
+      LoadInteger(constants["GM_CMD_LVL_RELOAD"], sConstants.GM_CMD_LVL_RELOAD);
   success &= LoadInteger(constants["GM_CMD_LVL_REPORTED"],
                          sConstants.GM_CMD_LVL_REPORTED);
   success &= LoadInteger(constants["GM_CMD_LVL_RESOLVE"],
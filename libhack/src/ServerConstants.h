@@ -741,6 +741,8 @@ class ServerConstants {
     uint32_t GM_CMD_LVL_MAP;
     /// Required user level for the @online GM command.
     uint32_t GM_CMD_LVL_ONLINE;
+    /// Required user level for the @packets GM command.
+    uint32_t GM_CMD_LVL_PACKETS;
     /// Required user level for the @penalty GM command.
     uint32_t GM_CMD_LVL_PENALTY_RESET;
     /// Required user level for the @plugin GM command.
@@ -749,6 +751,8 @@ class ServerConstants {
     uint32_t GM_CMD_LVL_POSITION;
     /// Required user level for the @post GM command.
     uint32_t GM_CMD_LVL_POST;
+    /// Required user level for the @reload GM command.
+    uint32_t GM_CMD_LVL_RELOAD;
     /// Required user level for the @reported GM command.
     uint32_t GM_CMD_LVL_REPORTED;
     /// Required user level for the @resolve GM command.
@@ -29,6 +29,7 @@
 #ifndef EXOTIC_PLATFORM
 
 // libhack Includes
+#include "MemoryStream.h"
 #include "ScriptEngine.h"
 
 // libcomp Includes
@@ -83,6 +84,11 @@
 // Standard C Includes
 #include <cmath>
 
+// Standard C++11 Includes
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
 using namespace libcomp;
 using namespace libhack;
 
@@ -521,6 +527,1030 @@ bool ServerDataManager::LoadData(DataStore* pDataStore,
   return !failure;
 }
 
+namespace {
+
+/// Identifies a server data snapshot ("SDMS")
+const uint32_t SNAPSHOT_MAGIC = 0x534D4453;
+
+/// Snapshot format version, increment if the format or the content hash
+/// calculation ever changes
+const uint32_t SNAPSHOT_VERSION = 2;
+
+/// Snapshot flag set if server side definitions were loaded
+const uint8_t SNAPSHOT_DEFINITIONS = 0x01;
+
+/// Snapshot flag set if the data passed VerifyDataIntegrity
+const uint8_t SNAPSHOT_VERIFIED = 0x02;
+
+/// Largest single object a snapshot is allowed to contain
+const uint32_t SNAPSHOT_MAX_OBJECT_SIZE = 0x4000000;
+
+/// Types of server side definitions stored in a snapshot
+enum class SnapshotDefinition_t : uint8_t {
+  ENCHANT_SET = 1,
+  ENCHANT_SPECIAL = 2,
+  SITEM = 3,
+  SSTATUS = 4,
+  TOKUSEI = 5,
+};
+
+/**
+ * Calculate a 64-bit FNV-1a hash of a file's contents.
+ * @param data Contents of the file
+ * @return Hash of the contents
+ */
+uint64_t HashFileData(const std::vector<char>& data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : data) {
+    hash ^= (uint8_t)c;
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+template <typename T>
+void WriteValue(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadValue(std::istream& in, T& value) {
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return in.good();
+}
+
+void WriteString(std::ostream& out, const libcomp::String& value) {
+  std::string str(value.C());
+  WriteValue(out, (uint32_t)str.size());
+  out.write(str.data(), (std::streamsize)str.size());
+}
+
+bool ReadString(std::istream& in, libcomp::String& value) {
+  uint32_t size;
+  if (!ReadValue(in, size) || size > SNAPSHOT_MAX_OBJECT_SIZE) {
+    return false;
+  }
+
+  std::string str(size, '\0');
+  if (size && !in.read(&str[0], (std::streamsize)size)) {
+    return false;
+  }
+
+  value = libcomp::String(str);
+
+  return true;
+}
+
+/**
+ * Write an object prefixed by its size. The object is read back into an
+ * empty copy first and nothing is written unless the copy saves exactly
+ * the same data.
+ */
+bool WriteObject(std::ostream& out, const std::shared_ptr<libcomp::Object>& obj,
+                 const std::shared_ptr<libcomp::Object>& copy) {
+  std::stringstream ss;
+  if (!obj || !copy || !obj->Save(ss)) {
+    return false;
+  }
+
+  std::string data = ss.str();
+  if (data.size() > SNAPSHOT_MAX_OBJECT_SIZE) {
+    return false;
+  }
+
+  MemoryInStream ms(data.data(), data.size());
+  std::stringstream check;
+  if (!copy->Load(ms) || !copy->Save(check) || check.str() != data) {
+    return false;
+  }
+
+  WriteValue(out, (uint32_t)data.size());
+  out.write(data.data(), (std::streamsize)data.size());
+
+  return out.good();
+}
+
+bool ReadObject(std::istream& in, const std::shared_ptr<libcomp::Object>& obj) {
+  uint32_t size;
+  if (!obj || !ReadValue(in, size) || size > SNAPSHOT_MAX_OBJECT_SIZE) {
+    return false;
+  }
+
+  std::vector<char> data(size);
+  if (size && !in.read(data.data(), (std::streamsize)size)) {
+    return false;
+  }
+
+  MemoryInStream ms(data.data(), data.size());
+
+  return obj->Load(ms);
+}
+
+template <class K, class T>
+bool WriteObjectMap(std::ostream& out,
+                    const std::unordered_map<K, std::shared_ptr<T>>& data) {
+  WriteValue(out, (uint32_t)data.size());
+  for (auto& pair : data) {
+    WriteValue(out, pair.first);
+    if (!WriteObject(out, pair.second, std::make_shared<T>())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template <class K, class T>
+bool ReadObjectMap(std::istream& in,
+                   std::unordered_map<K, std::shared_ptr<T>>& data) {
+  uint32_t count;
+  if (!ReadValue(in, count)) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    K key;
+    auto obj = std::make_shared<T>();
+    if (!ReadValue(in, key) || !ReadObject(in, obj)) {
+      return false;
+    }
+
+    data[key] = obj;
+  }
+
+  return true;
+}
+
+template <class K>
+void WriteIDSetMap(std::ostream& out,
+                   const std::unordered_map<K, std::set<uint32_t>>& data) {
+  WriteValue(out, (uint32_t)data.size());
+  for (auto& pair : data) {
+    WriteValue(out, pair.first);
+    WriteValue(out, (uint32_t)pair.second.size());
+    for (uint32_t id : pair.second) {
+      WriteValue(out, id);
+    }
+  }
+}
+
+template <class K>
+bool ReadIDSetMap(std::istream& in,
+                  std::unordered_map<K, std::set<uint32_t>>& data) {
+  uint32_t count;
+  if (!ReadValue(in, count)) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    K key;
+    uint32_t idCount;
+    if (!ReadValue(in, key) || !ReadValue(in, idCount)) {
+      return false;
+    }
+
+    auto& ids = data[key];
+    for (uint32_t k = 0; k < idCount; k++) {
+      uint32_t id;
+      if (!ReadValue(in, id)) {
+        return false;
+      }
+
+      ids.insert(id);
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
+uint64_t ServerDataManager::GetContentHash(
+    DataStore* pDataStore, DefinitionManager* definitionManager) {
+  // 64-bit FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  auto add = [&hash](const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+
+  std::list<libcomp::String> roots = {"/data", "/zones", "/events", "/shops",
+                                      "/scripts"};
+  if (definitionManager) {
+    // What is kept or skipped depends on the binary data as well
+    roots.push_front("/BinaryData");
+  }
+
+  for (auto& root : roots) {
+    std::list<libcomp::String> files;
+    std::list<libcomp::String> dirs;
+    std::list<libcomp::String> symLinks;
+
+    (void)pDataStore->GetListing(root, files, dirs, symLinks, true, true);
+
+    std::vector<std::string> paths;
+    for (auto& path : files) {
+      paths.push_back(path.C());
+    }
+
+    std::sort(paths.begin(), paths.end());
+
+    for (auto& path : paths) {
+      std::vector<char> data = pDataStore->ReadFile(path);
+
+      uint64_t size = (uint64_t)data.size();
+      add(path.c_str(), path.size() + 1);
+      add(&size, sizeof(size));
+      add(data.data(), data.size());
+    }
+  }
+
+  return hash;
+}
+
+bool ServerDataManager::LoadSnapshot(std::istream& in, uint64_t contentHash,
+                                     DefinitionManager* definitionManager,
+                                     bool requireVerified) {
+  uint32_t magic = 0, version = 0;
+  uint64_t hash = 0;
+  uint8_t flags = 0;
+
+  in.read((char*)&magic, sizeof(magic));
+  in.read((char*)&version, sizeof(version));
+  in.read((char*)&hash, sizeof(hash));
+  in.read((char*)&flags, sizeof(flags));
+  if (!in.good() || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+    LogServerDataManagerDebugMsg(
+        "Server data snapshot is missing or from another version.\n");
+
+    return false;
+  } else if (hash != contentHash ||
+             ((flags & SNAPSHOT_DEFINITIONS) != 0) !=
+                 (definitionManager != nullptr)) {
+    LogServerDataManagerDebugMsg(
+        "Server data has changed since the snapshot was saved.\n");
+
+    return false;
+  } else if (requireVerified && (flags & SNAPSHOT_VERIFIED) == 0) {
+    LogServerDataManagerDebugMsg(
+        "Server data snapshot was saved without being verified.\n");
+
+    return false;
+  }
+
+  // Read everything into a separate manager so nothing changes here unless
+  // the whole snapshot can be read
+  ServerDataManager loaded;
+
+  bool success = true;
+
+  uint32_t count = 0;
+  success &= ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    uint32_t id = 0, dynamicMapID = 0;
+    auto zone = std::make_shared<objects::ServerZone>();
+    success = ReadValue(in, id) && ReadValue(in, dynamicMapID) &&
+              ReadObject(in, zone);
+    if (success) {
+      loaded.mZoneData[id][dynamicMapID] = zone;
+    }
+  }
+
+  success = success && ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    uint32_t zoneID = 0, dynamicMapID = 0;
+    success = ReadValue(in, zoneID) && ReadValue(in, dynamicMapID);
+    if (success) {
+      loaded.mFieldZoneIDs.push_back(
+          std::pair<uint32_t, uint32_t>(zoneID, dynamicMapID));
+    }
+  }
+
+  success = success && ReadObjectMap(in, loaded.mZoneInstanceData);
+
+  success = success && ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    uint32_t id = 0;
+    libcomp::String typeName;
+    success = ReadValue(in, id) && ReadString(in, typeName);
+
+    auto variant =
+        success ? objects::ServerZoneInstanceVariant::InheritedConstruction(
+                      typeName)
+                : nullptr;
+    success = variant && ReadObject(in, variant);
+    if (success) {
+      loaded.mZoneInstanceVariantData[id] = variant;
+      loaded.mTypeNames[variant.get()] = typeName;
+    }
+  }
+
+  success = success && ReadIDSetMap(in, loaded.mStandardPvPVariantIDs) &&
+            ReadObjectMap(in, loaded.mZonePartialData) &&
+            ReadIDSetMap(in, loaded.mZonePartialMap);
+
+  success = success && ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    libcomp::String id, typeName;
+    success = ReadString(in, id) && ReadString(in, typeName);
+
+    auto event =
+        success ? objects::Event::InheritedConstruction(typeName) : nullptr;
+    success = event && ReadObject(in, event);
+    if (success) {
+      loaded.mEventData[id.C()] = event;
+      loaded.mTypeNames[event.get()] = typeName;
+    }
+  }
+
+  success = success && ReadObjectMap(in, loaded.mShopData);
+
+  success = success && ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    uint32_t id = 0;
+    success = ReadValue(in, id);
+    if (success) {
+      loaded.mCompShopIDs.push_back(id);
+    }
+  }
+
+  success = success && ReadObjectMap(in, loaded.mAILogicGroups) &&
+            ReadObjectMap(in, loaded.mDemonFamiliarityTypeData) &&
+            ReadObjectMap(in, loaded.mDemonPresentData) &&
+            ReadObjectMap(in, loaded.mDemonQuestRewardData) &&
+            ReadObjectMap(in, loaded.mDropSetData) &&
+            ReadObjectMap(in, loaded.mFusionMistakeData);
+
+  success = success && ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    uint32_t giftBoxID = 0, id = 0;
+    success = ReadValue(in, giftBoxID) && ReadValue(in, id);
+    if (success) {
+      loaded.mGiftDropSetLookup[giftBoxID] = id;
+    }
+  }
+
+  success = success && ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    uint8_t ai = 0;
+    auto script = std::make_shared<ServerScript>();
+    success = ReadValue(in, ai) && ReadString(in, script->Name) &&
+              ReadString(in, script->Path) && ReadString(in, script->Source) &&
+              ReadString(in, script->Type);
+    if (success) {
+      if (ai) {
+        loaded.mAIScripts[script->Name.C()] = script;
+      } else {
+        loaded.mScripts[script->Name.C()] = script;
+      }
+    }
+  }
+
+  success = success && ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    uint8_t type = 0;
+    success = ReadValue(in, type);
+
+    std::shared_ptr<libcomp::Object> obj;
+    switch ((SnapshotDefinition_t)type) {
+      case SnapshotDefinition_t::ENCHANT_SET:
+        obj = std::make_shared<objects::EnchantSetData>();
+        break;
+      case SnapshotDefinition_t::ENCHANT_SPECIAL:
+        obj = std::make_shared<objects::EnchantSpecialData>();
+        break;
+      case SnapshotDefinition_t::SITEM:
+        obj = std::make_shared<objects::MiSItemData>();
+        break;
+      case SnapshotDefinition_t::SSTATUS:
+        obj = std::make_shared<objects::MiSStatusData>();
+        break;
+      case SnapshotDefinition_t::TOKUSEI:
+        obj = std::make_shared<objects::Tokusei>();
+        break;
+      default:
+        break;
+    }
+
+    success = success && obj && ReadObject(in, obj);
+    if (success) {
+      loaded.mServerSideDefinitions.push_back(obj);
+    }
+  }
+
+  success = success && ReadValue(in, count);
+  for (uint32_t i = 0; success && i < count; i++) {
+    libcomp::String path;
+    ServerDataFile file;
+    uint32_t zoneCount = 0, partialCount = 0, eventCount = 0, shopCount = 0;
+    success = ReadString(in, path) && ReadValue(in, file.Hash) &&
+              ReadValue(in, zoneCount);
+    for (uint32_t k = 0; success && k < zoneCount; k++) {
+      uint32_t id = 0, dynamicMapID = 0;
+      success = ReadValue(in, id) && ReadValue(in, dynamicMapID);
+      file.ZoneIDs.push_back(std::pair<uint32_t, uint32_t>(id, dynamicMapID));
+    }
+
+    success = success && ReadValue(in, partialCount);
+    for (uint32_t k = 0; success && k < partialCount; k++) {
+      uint32_t id = 0;
+      success = ReadValue(in, id);
+      file.ZonePartialIDs.push_back(id);
+    }
+
+    success = success && ReadValue(in, eventCount);
+    for (uint32_t k = 0; success && k < eventCount; k++) {
+      libcomp::String id;
+      success = ReadString(in, id);
+      file.EventIDs.push_back(id.C());
+    }
+
+    success = success && ReadValue(in, shopCount);
+    for (uint32_t k = 0; success && k < shopCount; k++) {
+      uint32_t id = 0;
+      success = ReadValue(in, id);
+      file.ShopIDs.push_back(id);
+    }
+
+    if (success) {
+      loaded.mFiles[path.C()] = file;
+    }
+  }
+
+  magic = 0;
+  if (!success || !ReadValue(in, magic) || magic != SNAPSHOT_MAGIC) {
+    LogServerDataManagerWarningMsg(
+        "Failed to read server data snapshot, loading all server data.\n");
+
+    return false;
+  }
+
+  if (definitionManager) {
+    for (auto& obj : loaded.mServerSideDefinitions) {
+      bool registered = false;
+      if (auto eSet = std::dynamic_pointer_cast<objects::EnchantSetData>(obj)) {
+        registered = definitionManager->RegisterServerSideDefinition(eSet);
+      } else if (auto eSpecial =
+                     std::dynamic_pointer_cast<objects::EnchantSpecialData>(
+                         obj)) {
+        registered = definitionManager->RegisterServerSideDefinition(eSpecial);
+      } else if (auto sItem =
+                     std::dynamic_pointer_cast<objects::MiSItemData>(obj)) {
+        registered = definitionManager->RegisterServerSideDefinition(sItem);
+      } else if (auto sStatus =
+                     std::dynamic_pointer_cast<objects::MiSStatusData>(obj)) {
+        registered = definitionManager->RegisterServerSideDefinition(sStatus);
+      } else if (auto tokusei =
+                     std::dynamic_pointer_cast<objects::Tokusei>(obj)) {
+        registered = definitionManager->RegisterServerSideDefinition(tokusei);
+      }
+
+      if (!registered) {
+        LogServerDataManagerErrorMsg(
+            "Failed to register server side definition from the server data "
+            "snapshot.\n");
+
+        return false;
+      }
+    }
+  }
+
+  mZoneData.swap(loaded.mZoneData);
+  mFieldZoneIDs.swap(loaded.mFieldZoneIDs);
+  mZoneInstanceData.swap(loaded.mZoneInstanceData);
+  mZoneInstanceVariantData.swap(loaded.mZoneInstanceVariantData);
+  mStandardPvPVariantIDs.swap(loaded.mStandardPvPVariantIDs);
+  mZonePartialData.swap(loaded.mZonePartialData);
+  mZonePartialMap.swap(loaded.mZonePartialMap);
+  mEventData.swap(loaded.mEventData);
+  mShopData.swap(loaded.mShopData);
+  mCompShopIDs.swap(loaded.mCompShopIDs);
+  mAILogicGroups.swap(loaded.mAILogicGroups);
+  mDemonFamiliarityTypeData.swap(loaded.mDemonFamiliarityTypeData);
+  mDemonPresentData.swap(loaded.mDemonPresentData);
+  mDemonQuestRewardData.swap(loaded.mDemonQuestRewardData);
+  mDropSetData.swap(loaded.mDropSetData);
+  mFusionMistakeData.swap(loaded.mFusionMistakeData);
+  mGiftDropSetLookup.swap(loaded.mGiftDropSetLookup);
+  mScripts.swap(loaded.mScripts);
+  mAIScripts.swap(loaded.mAIScripts);
+  mServerSideDefinitions.swap(loaded.mServerSideDefinitions);
+  mTypeNames.swap(loaded.mTypeNames);
+  mFiles.swap(loaded.mFiles);
+
+  LogServerDataManagerInfo([&]() {
+    return libcomp::String(
+               "Loaded server data snapshot with %1 zone(s), %2 event(s) and "
+               "%3 script(s).\n")
+        .Arg(mZoneData.size())
+        .Arg(mEventData.size())
+        .Arg(mScripts.size() + mAIScripts.size());
+  });
+
+  return true;
+}
+
+bool ServerDataManager::SaveSnapshot(std::ostream& out, uint64_t contentHash,
+                                     DefinitionManager* definitionManager,
+                                     bool verified) {
+  auto failed = [](const char* section) {
+    LogServerDataManagerWarning([&]() {
+      return libcomp::String(
+                 "Server data snapshot could not save the %1 definitions.\n")
+          .Arg(section);
+    });
+
+    return false;
+  };
+
+  uint8_t flags = (uint8_t)((definitionManager ? SNAPSHOT_DEFINITIONS : 0) |
+                            (verified ? SNAPSHOT_VERIFIED : 0));
+
+  WriteValue(out, SNAPSHOT_MAGIC);
+  WriteValue(out, SNAPSHOT_VERSION);
+  WriteValue(out, contentHash);
+  WriteValue(out, flags);
+
+  uint32_t count = 0;
+  for (auto& pair : mZoneData) {
+    count += (uint32_t)pair.second.size();
+  }
+
+  WriteValue(out, count);
+  for (auto& pair : mZoneData) {
+    for (auto& dPair : pair.second) {
+      WriteValue(out, pair.first);
+      WriteValue(out, dPair.first);
+      if (!WriteObject(out, dPair.second,
+                       std::make_shared<objects::ServerZone>())) {
+        return failed("zone");
+      }
+    }
+  }
+
+  WriteValue(out, (uint32_t)mFieldZoneIDs.size());
+  for (auto& pair : mFieldZoneIDs) {
+    WriteValue(out, pair.first);
+    WriteValue(out, pair.second);
+  }
+
+  if (!WriteObjectMap(out, mZoneInstanceData)) {
+    return failed("zone instance");
+  }
+
+  WriteValue(out, (uint32_t)mZoneInstanceVariantData.size());
+  for (auto& pair : mZoneInstanceVariantData) {
+    auto it = mTypeNames.find(pair.second.get());
+    if (it == mTypeNames.end()) {
+      return failed("zone instance variant");
+    }
+
+    WriteValue(out, pair.first);
+    WriteString(out, it->second);
+    if (!WriteObject(
+            out, pair.second,
+            objects::ServerZoneInstanceVariant::InheritedConstruction(
+                it->second))) {
+      return failed("zone instance variant");
+    }
+  }
+
+  WriteIDSetMap(out, mStandardPvPVariantIDs);
+
+  if (!WriteObjectMap(out, mZonePartialData)) {
+    return failed("zone partial");
+  }
+
+  WriteIDSetMap(out, mZonePartialMap);
+
+  WriteValue(out, (uint32_t)mEventData.size());
+  for (auto& pair : mEventData) {
+    auto it = mTypeNames.find(pair.second.get());
+    if (it == mTypeNames.end()) {
+      return failed("event");
+    }
+
+    WriteString(out, libcomp::String(pair.first));
+    WriteString(out, it->second);
+    if (!WriteObject(out, pair.second,
+                     objects::Event::InheritedConstruction(it->second))) {
+      return failed("event");
+    }
+  }
+
+  if (!WriteObjectMap(out, mShopData)) {
+    return failed("shop");
+  }
+
+  WriteValue(out, (uint32_t)mCompShopIDs.size());
+  for (uint32_t id : mCompShopIDs) {
+    WriteValue(out, id);
+  }
+
+  if (!WriteObjectMap(out, mAILogicGroups)) {
+    return failed("AI logic group");
+  } else if (!WriteObjectMap(out, mDemonFamiliarityTypeData)) {
+    return failed("demon familiarity type");
+  } else if (!WriteObjectMap(out, mDemonPresentData)) {
+    return failed("demon present");
+  } else if (!WriteObjectMap(out, mDemonQuestRewardData)) {
+    return failed("demon quest reward");
+  } else if (!WriteObjectMap(out, mDropSetData)) {
+    return failed("drop set");
+  } else if (!WriteObjectMap(out, mFusionMistakeData)) {
+    return failed("fusion mistake");
+  }
+
+  WriteValue(out, (uint32_t)mGiftDropSetLookup.size());
+  for (auto& pair : mGiftDropSetLookup) {
+    WriteValue(out, pair.first);
+    WriteValue(out, pair.second);
+  }
+
+  WriteValue(out, (uint32_t)(mScripts.size() + mAIScripts.size()));
+  for (auto scripts : {&mScripts, &mAIScripts}) {
+    uint8_t ai = scripts == &mAIScripts ? 1 : 0;
+    for (auto& pair : *scripts) {
+      WriteValue(out, ai);
+      WriteString(out, pair.second->Name);
+      WriteString(out, pair.second->Path);
+      WriteString(out, pair.second->Source);
+      WriteString(out, pair.second->Type);
+    }
+  }
+
+  WriteValue(out, (uint32_t)mServerSideDefinitions.size());
+  for (auto& obj : mServerSideDefinitions) {
+    SnapshotDefinition_t type;
+    std::shared_ptr<libcomp::Object> copy;
+    if (std::dynamic_pointer_cast<objects::EnchantSetData>(obj)) {
+      type = SnapshotDefinition_t::ENCHANT_SET;
+      copy = std::make_shared<objects::EnchantSetData>();
+    } else if (std::dynamic_pointer_cast<objects::EnchantSpecialData>(obj)) {
+      type = SnapshotDefinition_t::ENCHANT_SPECIAL;
+      copy = std::make_shared<objects::EnchantSpecialData>();
+    } else if (std::dynamic_pointer_cast<objects::MiSItemData>(obj)) {
+      type = SnapshotDefinition_t::SITEM;
+      copy = std::make_shared<objects::MiSItemData>();
+    } else if (std::dynamic_pointer_cast<objects::MiSStatusData>(obj)) {
+      type = SnapshotDefinition_t::SSTATUS;
+      copy = std::make_shared<objects::MiSStatusData>();
+    } else if (std::dynamic_pointer_cast<objects::Tokusei>(obj)) {
+      type = SnapshotDefinition_t::TOKUSEI;
+      copy = std::make_shared<objects::Tokusei>();
+    } else {
+      return failed("server side");
+    }
+
+    WriteValue(out, (uint8_t)type);
+    if (!WriteObject(out, obj, copy)) {
+      return failed("server side");
+    }
+  }
+
+  WriteValue(out, (uint32_t)mFiles.size());
+  for (auto& pair : mFiles) {
+    auto& file = pair.second;
+
+    WriteString(out, libcomp::String(pair.first));
+    WriteValue(out, file.Hash);
+
+    WriteValue(out, (uint32_t)file.ZoneIDs.size());
+    for (auto& zPair : file.ZoneIDs) {
+      WriteValue(out, zPair.first);
+      WriteValue(out, zPair.second);
+    }
+
+    WriteValue(out, (uint32_t)file.ZonePartialIDs.size());
+    for (uint32_t id : file.ZonePartialIDs) {
+      WriteValue(out, id);
+    }
+
+    WriteValue(out, (uint32_t)file.EventIDs.size());
+    for (auto& id : file.EventIDs) {
+      WriteString(out, libcomp::String(id));
+    }
+
+    WriteValue(out, (uint32_t)file.ShopIDs.size());
+    for (uint32_t id : file.ShopIDs) {
+      WriteValue(out, id);
+    }
+  }
+
+  WriteValue(out, SNAPSHOT_MAGIC);
+
+  return out.good();
+}
+
+bool ServerDataManager::Reload(DataStore* pDataStore,
+                               DefinitionManager* definitionManager,
+                               ServerDataManager*& reloaded,
+                               std::list<libcomp::String>& changedFiles,
+                               std::list<libcomp::String>& skippedFiles) const {
+  reloaded = nullptr;
+
+  // Data directories that are loaded again as a whole when any file in
+  // them changes and ones that can only be loaded at startup
+  static const std::set<std::string> reloadCategories = {
+      "ailogicgroup",   "demonfamiliaritytype", "demonpresent",
+      "demonquestreward", "dropset",            "fusionmistake",
+      "zoneinstance",   "zoneinstancevariant"};
+  static const std::set<std::string> startupCategories = {
+      "enchantset", "enchantspecial", "sitemextended", "sstatus", "tokusei"};
+
+  // Find every loaded file that changed or was removed along with any new
+  // file that would be loaded
+  std::map<std::string, bool> changes;
+  std::set<std::string> seen;
+  for (auto root : {"/data", "/events", "/scripts", "/shops", "/zones"}) {
+    std::list<libcomp::String> files;
+    std::list<libcomp::String> dirs;
+    std::list<libcomp::String> symLinks;
+
+    (void)pDataStore->GetListing(root, files, dirs, symLinks, true, true);
+
+    for (auto& path : files) {
+      if (!path.Matches("^.*\\.(xml|nut)$")) {
+        continue;
+      }
+
+      std::string p(path.C());
+      seen.insert(p);
+
+      // Empty files are not loaded so they are never tracked either
+      auto data = pDataStore->ReadFile(path);
+      auto it = mFiles.find(p);
+      if (it == mFiles.end() ? !data.empty()
+                             : it->second.Hash != HashFileData(data)) {
+        changes[p] = true;
+      }
+    }
+  }
+
+  for (auto& pair : mFiles) {
+    if (!pair.first.empty() && seen.find(pair.first) == seen.end()) {
+      changes[pair.first] = false;
+    }
+  }
+
+  std::map<std::string, bool> zoneFiles, partialFiles, eventFiles, shopFiles;
+  std::set<std::string> categories;
+  for (auto& pair : changes) {
+    const std::string& path = pair.first;
+
+    if (path.compare(0, 15, "/zones/partial/") == 0) {
+      partialFiles[path] = pair.second;
+    } else if (path.compare(0, 7, "/zones/") == 0) {
+      // Only files directly in the zone directory are zones
+      if (path.find('/', 7) == std::string::npos) {
+        zoneFiles[path] = pair.second;
+      }
+    } else if (path.compare(0, 8, "/events/") == 0) {
+      eventFiles[path] = pair.second;
+    } else if (path.compare(0, 7, "/shops/") == 0) {
+      shopFiles[path] = pair.second;
+    } else if (path.compare(0, 9, "/scripts/") == 0) {
+      skippedFiles.push_back(path);
+    } else if (path.compare(0, 6, "/data/") == 0) {
+      // Category is the directory or file name directly under /data
+      size_t end = path.find('/', 6);
+      bool inDir = end != std::string::npos;
+      std::string category =
+          path.substr(6, inDir ? end - 6 : path.size() - 10);
+
+      if (!definitionManager && category != "zoneinstance" &&
+          category != "zoneinstancevariant") {
+        // Not loaded without definitions
+        continue;
+      } else if (!inDir) {
+        // A single category file is only loaded if the directory is empty
+        std::string dirPrefix = "/data/" + category + "/";
+        auto it = mFiles.lower_bound(dirPrefix);
+        if (it != mFiles.end() &&
+            it->first.compare(0, dirPrefix.size(), dirPrefix) == 0) {
+          continue;
+        }
+      }
+
+      if (reloadCategories.find(category) != reloadCategories.end()) {
+        categories.insert(category);
+        changedFiles.push_back(path);
+      } else if (startupCategories.find(category) !=
+                 startupCategories.end()) {
+        skippedFiles.push_back(path);
+      }
+    }
+  }
+
+  if (zoneFiles.empty() && partialFiles.empty() && eventFiles.empty() &&
+      shopFiles.empty() && categories.empty()) {
+    return true;
+  }
+
+  // Start from everything already loaded and replace what changed
+  ServerDataManager* pNew = new ServerDataManager(*this);
+
+  for (auto fileSet : {&zoneFiles, &partialFiles, &eventFiles, &shopFiles}) {
+    for (auto& pair : *fileSet) {
+      auto it = pNew->mFiles.find(pair.first);
+      if (it == pNew->mFiles.end()) {
+        continue;
+      }
+
+      auto& file = it->second;
+      for (auto& zPair : file.ZoneIDs) {
+        auto zIter = pNew->mZoneData.find(zPair.first);
+        if (zIter != pNew->mZoneData.end()) {
+          zIter->second.erase(zPair.second);
+          if (zIter->second.empty()) {
+            pNew->mZoneData.erase(zIter);
+          }
+        }
+
+        pNew->mFieldZoneIDs.remove(zPair);
+      }
+
+      for (uint32_t id : file.ZonePartialIDs) {
+        pNew->mZonePartialData.erase(id);
+        for (auto pIter = pNew->mZonePartialMap.begin();
+             pIter != pNew->mZonePartialMap.end();) {
+          pIter->second.erase(id);
+          if (pIter->second.empty()) {
+            pIter = pNew->mZonePartialMap.erase(pIter);
+          } else {
+            pIter++;
+          }
+        }
+      }
+
+      for (auto& id : file.EventIDs) {
+        auto eIter = pNew->mEventData.find(id);
+        if (eIter != pNew->mEventData.end()) {
+          pNew->mTypeNames.erase(eIter->second.get());
+          pNew->mEventData.erase(eIter);
+        }
+      }
+
+      for (uint32_t id : file.ShopIDs) {
+        pNew->mShopData.erase(id);
+        pNew->mCompShopIDs.remove(id);
+      }
+
+      pNew->mFiles.erase(it);
+    }
+  }
+
+  bool success = true;
+  for (auto& pair : zoneFiles) {
+    success = success && (!pair.second ||
+                          pNew->LoadObjectsFromFile<objects::ServerZone>(
+                              pDataStore, pair.first, definitionManager));
+    changedFiles.push_back(pair.first);
+  }
+
+  for (auto& pair : partialFiles) {
+    success = success && (!pair.second ||
+                          pNew->LoadObjectsFromFile<objects::ServerZonePartial>(
+                              pDataStore, pair.first, definitionManager));
+    changedFiles.push_back(pair.first);
+  }
+
+  for (auto& pair : eventFiles) {
+    success = success && (!pair.second ||
+                          pNew->LoadObjectsFromFile<objects::Event>(
+                              pDataStore, pair.first, definitionManager));
+    changedFiles.push_back(pair.first);
+  }
+
+  for (auto& pair : shopFiles) {
+    success = success && (!pair.second ||
+                          pNew->LoadObjectsFromFile<objects::ServerShop>(
+                              pDataStore, pair.first, definitionManager));
+    changedFiles.push_back(pair.first);
+  }
+
+  for (auto& category : categories) {
+    if (!success) {
+      break;
+    }
+
+    // Forget every file in the category so removed ones are not kept
+    auto path = libcomp::String("/data/%1").Arg(category);
+    std::string dirPrefix = std::string(path.C()) + "/";
+    std::string filePath = std::string(path.C()) + ".xml";
+    for (auto it = pNew->mFiles.begin(); it != pNew->mFiles.end();) {
+      if (it->first.compare(0, dirPrefix.size(), dirPrefix) == 0 ||
+          it->first == filePath) {
+        it = pNew->mFiles.erase(it);
+      } else {
+        it++;
+      }
+    }
+
+    if (category == "ailogicgroup") {
+      pNew->mAILogicGroups.clear();
+      success = pNew->LoadObjects<objects::AILogicGroup>(
+          pDataStore, path, definitionManager, true, true);
+    } else if (category == "demonfamiliaritytype") {
+      pNew->mDemonFamiliarityTypeData.clear();
+      success = pNew->LoadObjects<objects::DemonFamiliarityType>(
+          pDataStore, path, definitionManager, true, true);
+    } else if (category == "demonpresent") {
+      pNew->mDemonPresentData.clear();
+      success = pNew->LoadObjects<objects::DemonPresent>(
+          pDataStore, path, definitionManager, true, true);
+    } else if (category == "demonquestreward") {
+      pNew->mDemonQuestRewardData.clear();
+      success = pNew->LoadObjects<objects::DemonQuestReward>(
+          pDataStore, path, definitionManager, true, true);
+    } else if (category == "dropset") {
+      pNew->mDropSetData.clear();
+      pNew->mGiftDropSetLookup.clear();
+      pNew->mRedefineDropSetData.clear();
+      pNew->mPendingMergeDrops.clear();
+      success = pNew->LoadObjects<objects::DropSet>(
+          pDataStore, path, definitionManager, true, true);
+      if (success) {
+        pNew->ApplyPendingDrops();
+      }
+    } else if (category == "fusionmistake") {
+      pNew->mFusionMistakeData.clear();
+      success = pNew->LoadObjects<objects::FusionMistake>(
+          pDataStore, path, definitionManager, true, true);
+    } else if (category == "zoneinstance") {
+      pNew->mZoneInstanceData.clear();
+      success = pNew->LoadObjects<objects::ServerZoneInstance>(
+          pDataStore, path, definitionManager, true, true);
+    } else if (category == "zoneinstancevariant") {
+      for (auto& vPair : pNew->mZoneInstanceVariantData) {
+        pNew->mTypeNames.erase(vPair.second.get());
+      }
+
+      pNew->mZoneInstanceVariantData.clear();
+      pNew->mStandardPvPVariantIDs.clear();
+      success = pNew->LoadObjects<objects::ServerZoneInstanceVariant>(
+          pDataStore, path, definitionManager, true, true);
+    }
+  }
+
+  if (!success) {
+    delete pNew;
+
+    return false;
+  }
+
+  reloaded = pNew;
+
+  return true;
+}
+
+bool ServerDataManager::ZoneDataChanged(
+    ServerDataManager* previous, uint32_t id, uint32_t dynamicMapID,
+    const std::set<uint32_t>& extraPartialIDs) {
+  if (GetZoneData(id, dynamicMapID) !=
+      previous->GetZoneData(id, dynamicMapID)) {
+    return true;
+  }
+
+  // A partial added, removed or changed on either side changes the zone
+  std::set<uint32_t> partialIDs = extraPartialIDs;
+  for (auto manager : {this, previous}) {
+    auto it = manager->mZonePartialMap.find(dynamicMapID);
+    if (it != manager->mZonePartialMap.end()) {
+      partialIDs.insert(it->second.begin(), it->second.end());
+    }
+  }
+
+  for (uint32_t partialID : partialIDs) {
+    if (GetZonePartialData(partialID) !=
+        previous->GetZonePartialData(partialID)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ServerDataManager::TrackFile(const libcomp::String& path,
+                                  const std::vector<char>& data) {
+  mLoadingFile = path.C();
+
+  if (data.empty()) {
+    // Nothing is loaded from the file so there is nothing to track
+    mFiles.erase(mLoadingFile);
+    return;
+  }
+
+  ServerDataFile file;
+  file.Hash = HashFileData(data);
+
+  mFiles[mLoadingFile] = file;
+}
+
 bool ServerDataManager::VerifyDataIntegrity(
     DefinitionManager* definitionManager) {
   bool valid = VerifyEventIntegrity();
@@ -1355,6 +2385,7 @@ bool ServerDataManager::LoadScripts(
   for (auto path : files) {
     if (path.Matches("^.*\\.nut$")) {
       std::vector<char> data = pDataStore->ReadFile(path);
+      TrackFile(path, data);
       if (!handler(*this, path, std::string(data.begin(), data.end()))) {
         LogServerDataManagerError([&]() {
           return String("Failed to load script file: %1\n").Arg(path);
@@ -1501,6 +2532,8 @@ bool ServerDataManager::LoadObject<objects::ServerZone>(
   }
 
   mZoneData[id][dynamicMapID] = zone;
+  mFiles[mLoadingFile].ZoneIDs.push_back(
+      std::pair<uint32_t, uint32_t>(id, dynamicMapID));
 
   if (isField) {
     mFieldZoneIDs.push_back(std::pair<uint32_t, uint32_t>(id, dynamicMapID));
@@ -1637,6 +2670,7 @@ bool ServerDataManager::LoadObject<objects::ServerZonePartial>(
   }
 
   mZonePartialData[id] = prt;
+  mFiles[mLoadingFile].ZonePartialIDs.push_back(id);
 
   for (auto sgPair : prt->GetSpawnGroups()) {
     auto sg = sgPair.second;
@@ -1723,6 +2757,8 @@ bool ServerDataManager::LoadObject<objects::Event>(
   }
 
   mEventData[id] = event;
+  mTypeNames[event.get()] = objNode->Attribute("name");
+  mFiles[mLoadingFile].EventIDs.push_back(id);
 
   if (event->GetEventType() == objects::Event::EventType_t::PERFORM_ACTIONS) {
     auto e = std::dynamic_pointer_cast<objects::EventPerformActions>(event);
@@ -1915,6 +2951,7 @@ bool ServerDataManager::LoadObject<objects::ServerZoneInstanceVariant>(
   }
 
   mZoneInstanceVariantData[id] = variant;
+  mTypeNames[variant.get()] = objNode->Attribute("name");
 
   return true;
 }
@@ -1948,6 +2985,7 @@ bool ServerDataManager::LoadObject<objects::ServerShop>(
   }
 
   mShopData[id] = shop;
+  mFiles[mLoadingFile].ShopIDs.push_back(id);
 
   if (shop->GetType() == objects::ServerShop::Type_t::COMP_SHOP) {
     mCompShopIDs.push_back(id);
@@ -2120,8 +3158,14 @@ bool ServerDataManager::LoadObject<objects::EnchantSetData>(
     return false;
   }
 
-  return definitionManager &&
-         definitionManager->RegisterServerSideDefinition(eSet);
+  if (!definitionManager ||
+      !definitionManager->RegisterServerSideDefinition(eSet)) {
+    return false;
+  }
+
+  mServerSideDefinitions.push_back(eSet);
+
+  return true;
 }
 
 template <>
@@ -2134,8 +3178,14 @@ bool ServerDataManager::LoadObject<objects::EnchantSpecialData>(
     return false;
   }
 
-  return definitionManager &&
-         definitionManager->RegisterServerSideDefinition(eSpecial);
+  if (!definitionManager ||
+      !definitionManager->RegisterServerSideDefinition(eSpecial)) {
+    return false;
+  }
+
+  mServerSideDefinitions.push_back(eSpecial);
+
+  return true;
 }
 
 template <>
@@ -2205,8 +3255,14 @@ bool ServerDataManager::LoadObject<objects::MiSItemData>(
     return false;
   }
 
-  return definitionManager &&
-         definitionManager->RegisterServerSideDefinition(sItem);
+  if (!definitionManager ||
+      !definitionManager->RegisterServerSideDefinition(sItem)) {
+    return false;
+  }
+
+  mServerSideDefinitions.push_back(sItem);
+
+  return true;
 }
 
 template <>
@@ -2219,8 +3275,14 @@ bool ServerDataManager::LoadObject<objects::MiSStatusData>(
     return false;
   }
 
-  return definitionManager &&
-         definitionManager->RegisterServerSideDefinition(sStatus);
+  if (!definitionManager ||
+      !definitionManager->RegisterServerSideDefinition(sStatus)) {
+    return false;
+  }
+
+  mServerSideDefinitions.push_back(sStatus);
+
+  return true;
 }
 
 template <>
@@ -2232,8 +3294,14 @@ bool ServerDataManager::LoadObject<objects::Tokusei>(
     return false;
   }
 
-  return definitionManager &&
-         definitionManager->RegisterServerSideDefinition(tokusei);
+  if (!definitionManager ||
+      !definitionManager->RegisterServerSideDefinition(tokusei)) {
+    return false;
+  }
+
+  mServerSideDefinitions.push_back(tokusei);
+
+  return true;
 }
 }  // namespace libhack
 
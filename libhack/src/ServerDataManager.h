@@ -53,9 +53,15 @@
 #include "PopIgnore.h"
 
 // Standard C++11 Includes
+#include <iostream>
+#include <map>
 #include <set>
 #include <unordered_map>
 
+namespace libcomp {
+class Object;
+}  // namespace libcomp
+
 namespace objects {
 class Action;
 class AILogicGroup;
@@ -89,6 +95,27 @@ struct ServerScript {
   bool Instantiated = false;
 };
 
+/**
+ * Server data file loaded by the manager, tracked so a reload only has
+ * to load the files that changed again.
+ */
+struct ServerDataFile {
+  /// Hash of the file contents when it was loaded
+  uint64_t Hash = 0;
+
+  /// Zone ID and dynamic map ID pairs of zones loaded from the file
+  std::list<std::pair<uint32_t, uint32_t>> ZoneIDs;
+
+  /// IDs of zone partials loaded from the file
+  std::list<uint32_t> ZonePartialIDs;
+
+  /// IDs of events loaded from the file
+  std::list<std::string> EventIDs;
+
+  /// IDs of shops loaded from the file
+  std::list<uint32_t> ShopIDs;
+};
+
 /**
  * Manager class responsible for loading server specific files such as
  * zones and script files.
@@ -289,6 +316,93 @@ class ServerDataManager {
   bool LoadData(libcomp::DataStore* pDataStore,
                 DefinitionManager* definitionManager);
 
+  /**
+   * Calculate a hash of every file server data definitions are loaded
+   * from along with the binary data they are checked against. A snapshot
+   * is only used if it was saved from files with the same hash.
+   * @param pDataStore Pointer to the datastore to hash files from
+   * @param definitionManager Pointer to the definition manager that will
+   *  be loaded with any server side definitions or null if they are not
+   *  loaded
+   * @return Hash of the server data files
+   */
+  static uint64_t GetContentHash(libcomp::DataStore* pDataStore,
+                                 DefinitionManager* definitionManager);
+
+  /**
+   * Load all server data definitions from a snapshot saved by SaveSnapshot
+   * instead of parsing and validating every file again. Nothing is loaded
+   * unless the whole snapshot is read successfully so a full load with
+   * LoadData can be done if this fails.
+   * @param in Stream to read the snapshot from
+   * @param contentHash Hash of the current server data files from
+   *  GetContentHash
+   * @param definitionManager Pointer to the definition manager to register
+   *  server side definitions with or null if they are not loaded
+   * @param requireVerified If true the snapshot is only used if it was
+   *  saved after VerifyDataIntegrity passed
+   * @return true if the snapshot was loaded, false if it does not exist,
+   *  is out of date or could not be read
+   */
+  bool LoadSnapshot(std::istream& in, uint64_t contentHash,
+                    DefinitionManager* definitionManager,
+                    bool requireVerified);
+
+  /**
+   * Save every loaded server data definition to a snapshot that can be
+   * loaded by LoadSnapshot. Each object is read back while saving and the
+   * snapshot fails if any does not come back the same.
+   * @param out Stream to write the snapshot to
+   * @param contentHash Hash of the server data files from GetContentHash
+   * @param definitionManager Pointer to the definition manager server side
+   *  definitions were registered with or null if they were not loaded
+   * @param verified true if VerifyDataIntegrity passed on the data
+   * @return true if the snapshot was written, false if it failed
+   */
+  bool SaveSnapshot(std::ostream& out, uint64_t contentHash,
+                    DefinitionManager* definitionManager, bool verified);
+
+  /**
+   * Build a new manager from this one with every server data file that has
+   * changed since it was loaded loaded again. Zone, zone partial, event and
+   * shop files are loaded again one file at a time and everything else
+   * loaded from an unchanged file is shared with this manager. Other data
+   * directories are loaded again as a whole if any file in them changed.
+   * Server side definitions and scripts are registered with other parts
+   * of the server at startup so changes to them are skipped and require a
+   * restart. This manager is only read from so this can be called while
+   * the server is running.
+   * @param pDataStore Pointer to the datastore to load files from
+   * @param definitionManager Pointer to the definition manager the data
+   *  was loaded with
+   * @param reloaded Output pointer to the new manager, owned by the caller,
+   *  or null if no file that can be reloaded has changed
+   * @param changedFiles Output list of files that were loaded again
+   * @param skippedFiles Output list of changed files that require a
+   *  restart to be loaded
+   * @return true on success, false if a changed file failed to load
+   */
+  bool Reload(libcomp::DataStore* pDataStore,
+              DefinitionManager* definitionManager,
+              ServerDataManager*& reloaded,
+              std::list<libcomp::String>& changedFiles,
+              std::list<libcomp::String>& skippedFiles) const;
+
+  /**
+   * Check if a zone definition built with partials applied from this
+   * manager would differ from one built from the manager it was reloaded
+   * from.
+   * @param previous Pointer to the manager this one was reloaded from
+   * @param id Definition ID of the zone
+   * @param dynamicMapID Dynamic map ID of the zone
+   * @param extraPartialIDs IDs of non-auto applied partials the zone was
+   *  built with
+   * @return true if the zone or any partial it uses changed
+   */
+  bool ZoneDataChanged(ServerDataManager* previous, uint32_t id,
+                       uint32_t dynamicMapID,
+                       const std::set<uint32_t>& extraPartialIDs);
+
   /**
    * Verify all loaded server data definitions for non-critical errors.
    * Checks include invalid event ID and item/shop product type references.
@@ -475,6 +589,8 @@ class ServerDataManager {
 
     std::vector<char> data = pDataStore->ReadFile(filePath);
 
+    TrackFile(filePath, data);
+
     if (data.empty()) {
       LogServerDataManagerWarning([&]() {
         return libcomp::String("File does not exist or is empty: %1\n")
@@ -537,6 +653,14 @@ class ServerDataManager {
                          const libcomp::String&)>
           handler);
 
+  /**
+   * Start tracking a file being loaded so it can be checked for changes
+   * and any objects loaded from it are recorded against it.
+   * @param path Path to the file in the datastore
+   * @param data Contents of the file
+   */
+  void TrackFile(const libcomp::String& path, const std::vector<char>& data);
+
   /**
    * Store a successfully loaded (non-AI) script
    * @param path Path to the script file
@@ -663,6 +787,21 @@ class ServerDataManager {
 
   /// Map of AI scripts by name
   std::unordered_map<std::string, std::shared_ptr<ServerScript>> mAIScripts;
+
+  /// Server side definitions registered with the definition manager in the
+  /// order they were loaded, kept so they can be saved to a snapshot
+  std::list<std::shared_ptr<libcomp::Object>> mServerSideDefinitions;
+
+  /// Map of objects constructed by XML type name to the type name they
+  /// were loaded as, used to construct them again from a snapshot
+  std::unordered_map<const libcomp::Object*, libcomp::String> mTypeNames;
+
+  /// Map of every file loaded by path, ordered so the files in a
+  /// directory can be found together
+  std::map<std::string, ServerDataFile> mFiles;
+
+  /// Path of the file currently being loaded
+  std::string mLoadingFile;
 };
 
 }  // namespace libhack
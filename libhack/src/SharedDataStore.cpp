@@ -0,0 +1,503 @@
+/**
+ * @file libhack/src/SharedDataStore.cpp
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Read only store of immutable data shared between the servers on
+ *  a host through named shared memory.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SharedDataStore.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+using namespace libhack;
+
+namespace {
+
+/// Identifies a finished shared data store ("HSDS")
+const uint32_t STORE_MAGIC = 0x53445348;
+
+/// Shared data store format version
+const uint32_t STORE_VERSION = 1;
+
+/// Alignment of every record in a store so records holding arrays of
+/// fixed size values can be read in place
+const size_t RECORD_ALIGNMENT = 8;
+
+/// Number of times to check if a store another server is building is
+/// finished before giving up on it
+const int STORE_READY_ATTEMPTS = 100;
+
+/// Time to wait between checks if a store is finished
+const std::chrono::milliseconds STORE_READY_INTERVAL(50);
+
+/// Header at the start of a store. The magic is written last so a store
+/// is never used before it is finished.
+struct StoreHeader {
+  /// STORE_MAGIC once the store is finished, 0 while it is being built
+  uint32_t Magic;
+
+  /// Format version of the store
+  uint32_t Version;
+
+  /// Hash of the data the store was built from
+  uint64_t ContentHash;
+
+  /// Size of the whole store in bytes
+  uint64_t Size;
+
+  /// Number of tables following the header
+  uint32_t TableCount;
+
+  /// Unused, keeps the tables aligned
+  uint32_t Reserved;
+};
+
+/// Table directory entry following the header
+struct StoreTable {
+  /// ID of the table
+  uint32_t TableID;
+
+  /// Number of records in the table
+  uint32_t EntryCount;
+
+  /// Offset of the table's entries from the start of the store
+  uint64_t EntriesOffset;
+};
+
+/**
+ * Round the size of a record up to the record alignment.
+ * @param size Size of the record in bytes
+ * @return Size of the record including padding
+ */
+size_t AlignRecord(size_t size) {
+  return (size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+}
+
+/**
+ * Get the name of the shared memory for a store.
+ * @param name Name of the store
+ * @return Name of the shared memory object
+ */
+std::string GetSharedName(const libcomp::String& name) {
+#ifdef _WIN32
+  return std::string("Local\\") + name.Replace("\\", "_").C();
+#else
+  return std::string("/") + name.Replace("/", "_").C();
+#endif  // _WIN32
+}
+
+/**
+ * Wait for the builder of a store to finish it.
+ * @param pData Start of the mapped store
+ * @return true if the store is finished, false if it never was
+ */
+bool WaitReady(const char* pData) {
+  auto pMagic = reinterpret_cast<const volatile uint32_t*>(pData);
+  for (int i = 0; i < STORE_READY_ATTEMPTS; i++) {
+    if (*pMagic == STORE_MAGIC) {
+      // Make sure everything written before the magic is visible too
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      return true;
+    }
+
+    std::this_thread::sleep_for(STORE_READY_INTERVAL);
+  }
+
+  return false;
+}
+
+}  // namespace
+
+SharedDataStore::Table::Table()
+    : mBase(nullptr), mEntries(nullptr), mCount(0) {}
+
+uint32_t SharedDataStore::Table::Count() const { return mCount; }
+
+bool SharedDataStore::Table::Find(uint32_t id, size_t& index) const {
+  auto end = mEntries + mCount;
+  auto it = std::lower_bound(
+      mEntries, end, id,
+      [](const Entry& entry, uint32_t key) { return entry.ID < key; });
+  if (it == end || it->ID != id) {
+    return false;
+  }
+
+  index = (size_t)(it - mEntries);
+
+  return true;
+}
+
+bool SharedDataStore::Table::Get(size_t index, const char*& pData,
+                                 size_t& size) const {
+  if (index >= (size_t)mCount) {
+    return false;
+  }
+
+  pData = mBase + mEntries[index].Offset;
+  size = (size_t)mEntries[index].Size;
+
+  return true;
+}
+
+#ifdef _WIN32
+SharedDataStore::SharedDataStore()
+    : mData(nullptr), mSize(0), mMapping(nullptr) {}
+#else
+SharedDataStore::SharedDataStore() : mData(nullptr), mSize(0) {}
+#endif  // _WIN32
+
+SharedDataStore::~SharedDataStore() { Close(); }
+
+bool SharedDataStore::Open(const libcomp::String& name, uint64_t contentHash) {
+  Close();
+
+  auto sharedName = GetSharedName(name);
+
+  const char* pData = nullptr;
+  size_t size = 0;
+
+#ifdef _WIN32
+  HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, sharedName.c_str());
+  if (!mapping) {
+    return false;
+  }
+
+  void* pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  MEMORY_BASIC_INFORMATION info;
+  if (!pView || !VirtualQuery(pView, &info, sizeof(info))) {
+    if (pView) {
+      UnmapViewOfFile(pView);
+    }
+
+    CloseHandle(mapping);
+    return false;
+  }
+
+  pData = static_cast<const char*>(pView);
+  size = (size_t)info.RegionSize;
+
+  if (size < sizeof(StoreHeader) || !WaitReady(pData)) {
+    UnmapViewOfFile(pView);
+    CloseHandle(mapping);
+    return false;
+  }
+#else
+  int fd = shm_open(sharedName.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  // The builder sizes the memory right after creating it so wait for that
+  // as well as for it to be finished
+  struct stat st;
+  for (int i = 0; i < STORE_READY_ATTEMPTS; i++) {
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(StoreHeader)) {
+      size = (size_t)st.st_size;
+      break;
+    }
+
+    std::this_thread::sleep_for(STORE_READY_INTERVAL);
+  }
+
+  void* pView =
+      size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+  // The mapping keeps the memory open on its own
+  close(fd);
+
+  if (pView == MAP_FAILED) {
+    // The builder stopped before sizing the store
+    Remove(name);
+    return false;
+  }
+
+  pData = static_cast<const char*>(pView);
+
+  if (!WaitReady(pData)) {
+    // The builder stopped before finishing the store
+    munmap(pView, size);
+    Remove(name);
+    return false;
+  }
+#endif  // _WIN32
+
+  StoreHeader header;
+  memcpy(&header, pData, sizeof(header));
+  if (header.Version != STORE_VERSION || header.ContentHash != contentHash ||
+      !Validate(pData, size)) {
+#ifdef _WIN32
+    UnmapViewOfFile(pView);
+    CloseHandle(mapping);
+#else
+    munmap(pView, size);
+#endif  // _WIN32
+
+    // Built from other data, make way for a new store
+    Remove(name);
+    return false;
+  }
+
+  mData = pData;
+  mSize = size;
+
+#ifdef _WIN32
+  mMapping = mapping;
+#endif  // _WIN32
+
+  return true;
+}
+
+bool SharedDataStore::Create(const libcomp::String& name, uint64_t contentHash,
+                             const Tables& tables) {
+  Close();
+
+  // Lay out the header, the table directory, the entries of every table
+  // and then the records themselves
+  size_t entryCount = 0;
+  size_t dataSize = 0;
+  for (auto& tPair : tables) {
+    entryCount += tPair.second.size();
+    for (auto& rPair : tPair.second) {
+      if (rPair.second.size() >
+          (size_t)std::numeric_limits<uint32_t>::max()) {
+        return false;
+      }
+
+      dataSize += AlignRecord(rPair.second.size());
+    }
+  }
+
+  size_t entriesOffset =
+      sizeof(StoreHeader) + tables.size() * sizeof(StoreTable);
+  size_t dataOffset = entriesOffset + entryCount * sizeof(Entry);
+  size_t size = dataOffset + dataSize;
+
+  auto sharedName = GetSharedName(name);
+
+  char* pData = nullptr;
+
+#ifdef _WIN32
+  HANDLE mapping = CreateFileMappingA(
+      INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32),
+      (DWORD)((uint64_t)size & 0xFFFFFFFF), sharedName.c_str());
+  if (!mapping) {
+    return false;
+  } else if (GetLastError() == ERROR_ALREADY_EXISTS) {
+    // Another server is building or has built the store
+    CloseHandle(mapping);
+    return false;
+  }
+
+  void* pView = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+  if (!pView) {
+    CloseHandle(mapping);
+    return false;
+  }
+#else
+  // Only one server can create the store, any other fails here
+  int fd = shm_open(sharedName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return false;
+  }
+
+  if (ftruncate(fd, (off_t)size) != 0) {
+    close(fd);
+    Remove(name);
+    return false;
+  }
+
+  void* pView =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  // The mapping keeps the memory open on its own
+  close(fd);
+
+  if (pView == MAP_FAILED) {
+    Remove(name);
+    return false;
+  }
+#endif  // _WIN32
+
+  pData = static_cast<char*>(pView);
+
+  StoreHeader header;
+  header.Magic = 0;
+  header.Version = STORE_VERSION;
+  header.ContentHash = contentHash;
+  header.Size = (uint64_t)size;
+  header.TableCount = (uint32_t)tables.size();
+  header.Reserved = 0;
+  memcpy(pData, &header, sizeof(header));
+
+  size_t tableOffset = sizeof(StoreHeader);
+  for (auto& tPair : tables) {
+    StoreTable table;
+    table.TableID = tPair.first;
+    table.EntryCount = (uint32_t)tPair.second.size();
+    table.EntriesOffset = (uint64_t)entriesOffset;
+    memcpy(pData + tableOffset, &table, sizeof(table));
+    tableOffset += sizeof(StoreTable);
+
+    // Records are already sorted by ID
+    for (auto& rPair : tPair.second) {
+      Entry entry;
+      entry.ID = rPair.first;
+      entry.Size = (uint32_t)rPair.second.size();
+      entry.Offset = (uint64_t)dataOffset;
+      memcpy(pData + entriesOffset, &entry, sizeof(entry));
+      entriesOffset += sizeof(Entry);
+
+      if (!rPair.second.empty()) {
+        memcpy(pData + dataOffset, rPair.second.data(), rPair.second.size());
+        dataOffset += AlignRecord(rPair.second.size());
+      }
+    }
+  }
+
+  // Publish the store only once everything else is written
+  std::atomic_thread_fence(std::memory_order_release);
+  reinterpret_cast<volatile uint32_t*>(pData)[0] = STORE_MAGIC;
+
+#ifdef _WIN32
+  DWORD oldProtect;
+  VirtualProtect(pView, size, PAGE_READONLY, &oldProtect);
+
+  mMapping = mapping;
+#else
+  mprotect(pView, size, PROT_READ);
+#endif  // _WIN32
+
+  mData = pData;
+  mSize = size;
+
+  return true;
+}
+
+void SharedDataStore::Close() {
+  if (!mData) {
+    return;
+  }
+
+#ifdef _WIN32
+  UnmapViewOfFile(mData);
+  CloseHandle((HANDLE)mMapping);
+  mMapping = nullptr;
+#else
+  munmap(const_cast<char*>(mData), mSize);
+#endif  // _WIN32
+
+  mData = nullptr;
+  mSize = 0;
+}
+
+bool SharedDataStore::IsOpen() const { return mData != nullptr; }
+
+bool SharedDataStore::GetTable(uint32_t tableID, Table& table) const {
+  if (!mData) {
+    return false;
+  }
+
+  StoreHeader header;
+  memcpy(&header, mData, sizeof(header));
+
+  auto pTables = reinterpret_cast<const StoreTable*>(mData + sizeof(header));
+  for (uint32_t i = 0; i < header.TableCount; i++) {
+    if (pTables[i].TableID == tableID) {
+      table.mBase = mData;
+      table.mEntries =
+          reinterpret_cast<const Entry*>(mData + pTables[i].EntriesOffset);
+      table.mCount = pTables[i].EntryCount;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint64_t SharedDataStore::Hash(const char* pData, size_t size, uint64_t hash) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= (uint8_t)pData[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+bool SharedDataStore::Validate(const char* pData, size_t size) {
+  StoreHeader header;
+  memcpy(&header, pData, sizeof(header));
+  if (header.Size > (uint64_t)size ||
+      (uint64_t)sizeof(header) +
+              (uint64_t)header.TableCount * sizeof(StoreTable) >
+          header.Size) {
+    return false;
+  }
+
+  auto pTables = reinterpret_cast<const StoreTable*>(pData + sizeof(header));
+  for (uint32_t i = 0; i < header.TableCount; i++) {
+    const StoreTable& table = pTables[i];
+    if (table.EntriesOffset % alignof(Entry) != 0 ||
+        table.EntriesOffset +
+                (uint64_t)table.EntryCount * sizeof(Entry) >
+            header.Size) {
+      return false;
+    }
+
+    auto pEntries = reinterpret_cast<const Entry*>(pData + table.EntriesOffset);
+    for (uint32_t j = 0; j < table.EntryCount; j++) {
+      if ((j > 0 && pEntries[j - 1].ID >= pEntries[j].ID) ||
+          pEntries[j].Offset % RECORD_ALIGNMENT != 0 ||
+          pEntries[j].Offset + (uint64_t)pEntries[j].Size > header.Size) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void SharedDataStore::Remove(const libcomp::String& name) {
+#ifdef _WIN32
+  // Named shared memory is removed once the last server closes it
+  (void)name;
+#else
+  shm_unlink(GetSharedName(name).c_str());
+#endif  // _WIN32
+}
@@ -0,0 +1,218 @@
+/**
+ * @file libhack/src/SharedDataStore.h
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Read only store of immutable data shared between the servers on
+ *  a host through named shared memory.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHACK_SRC_SHAREDDATASTORE_H
+#define LIBHACK_SRC_SHAREDDATASTORE_H
+
+// libcomp Includes
+#include "CString.h"
+
+// Standard C++11 Includes
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+namespace libhack {
+
+/**
+ * Read only tables of binary records by ID held in named shared memory.
+ * The first server on a host to need the data builds the store and every
+ * other server opens the same memory instead of holding its own copy, so
+ * the pages are only held once per host. The store is position
+ * independent: every record is found by its offset from the start of the
+ * memory. Nothing is written to disk and the memory is only accessible to
+ * the user the servers run as. A store is never modified once built; if
+ * the data changes a new store replaces it and servers already using the
+ * old one keep their mapping until they exit.
+ */
+class SharedDataStore {
+ private:
+  /// Record entry in a table, sorted by ID
+  struct Entry {
+    /// ID of the record
+    uint32_t ID;
+
+    /// Size of the record in bytes
+    uint32_t Size;
+
+    /// Offset of the record from the start of the store
+    uint64_t Offset;
+  };
+
+ public:
+  /**
+   * View of one table in an open store. The view is only valid while the
+   * store it was retrieved from is open.
+   */
+  class Table {
+   public:
+    /**
+     * Create an empty table view.
+     */
+    Table();
+
+    /**
+     * Get the number of records in the table.
+     * @return Number of records in the table
+     */
+    uint32_t Count() const;
+
+    /**
+     * Find the index of a record in the table.
+     * @param id ID of the record
+     * @param index Output parameter to return the index of the record
+     * @return true if the record exists, false if it does not
+     */
+    bool Find(uint32_t id, size_t& index) const;
+
+    /**
+     * Get a record by index.
+     * @param index Index of the record from 0 to Count() - 1
+     * @param pData Output parameter to return a pointer to the record,
+     *  valid until the store is closed. Records are aligned to 8 bytes.
+     * @param size Output parameter to return the size of the record
+     * @return true if the record exists, false if the index is invalid
+     */
+    bool Get(size_t index, const char*& pData, size_t& size) const;
+
+   private:
+    friend class SharedDataStore;
+
+    /// Start of the store the table is in
+    const char* mBase;
+
+    /// Entries of the table, sorted by ID
+    const Entry* mEntries;
+
+    /// Number of entries in the table
+    uint32_t mCount;
+  };
+
+  /// Records to build a store from by ID, by table ID
+  typedef std::map<uint32_t, std::map<uint32_t, std::string>> Tables;
+
+  /**
+   * Create a store that is not open.
+   */
+  SharedDataStore();
+
+  /**
+   * Close the store if it is open.
+   */
+  ~SharedDataStore();
+
+  /**
+   * Open a store built by this or another server. If a store with the
+   * name exists but was built from different data, or its builder never
+   * finished it, it is removed so a new one can be created.
+   * @param name Name of the store, unique per host
+   * @param contentHash Hash of the data the store must have been built
+   *  from
+   * @return true if the store was opened, false if it does not exist or
+   *  does not match
+   */
+  bool Open(const libcomp::String& name, uint64_t contentHash);
+
+  /**
+   * Build a new store and open it. This fails if a store with the same
+   * name already exists, such as when another server is building it at
+   * the same time.
+   * @param name Name of the store, unique per host
+   * @param contentHash Hash of the data the store is built from
+   * @param tables Records to put in the store
+   * @return true if the store was built and opened
+   */
+  bool Create(const libcomp::String& name, uint64_t contentHash,
+              const Tables& tables);
+
+  /**
+   * Close the store if it is open. Views of its tables and records must
+   * no longer be used.
+   */
+  void Close();
+
+  /**
+   * Check if the store is open.
+   * @return true if the store is open
+   */
+  bool IsOpen() const;
+
+  /**
+   * Get a view of a table in the store.
+   * @param tableID ID of the table
+   * @param table Output parameter to return the table view
+   * @return true if the store is open and contains the table
+   */
+  bool GetTable(uint32_t tableID, Table& table) const;
+
+  /**
+   * Calculate a 64-bit FNV-1a hash of a block of memory.
+   * @param pData Pointer to the data to hash
+   * @param size Size of the data in bytes
+   * @param hash Hash to continue from when hashing several blocks
+   * @return Hash of the data
+   */
+  static uint64_t Hash(const char* pData, size_t size,
+                       uint64_t hash = 14695981039346656037ULL);
+
+ private:
+  SharedDataStore(const SharedDataStore&) = delete;
+  SharedDataStore& operator=(const SharedDataStore&) = delete;
+
+  /**
+   * Check that every table and record of a mapped store lies within it.
+   * @param pData Start of the store
+   * @param size Size of the mapped memory in bytes
+   * @return true if the store is intact
+   */
+  static bool Validate(const char* pData, size_t size);
+
+  /**
+   * Remove the shared memory of a store so the next server to need it
+   * builds a new one. Servers that have it open are not affected.
+   * @param name Name of the store
+   */
+  static void Remove(const libcomp::String& name);
+
+  /// Pointer to the mapped store
+  const char* mData;
+
+  /// Size of the mapped store in bytes
+  size_t mSize;
+
+#ifdef _WIN32
+  /// Handle to the shared memory, which only exists while a server has
+  /// it open
+  void* mMapping;
+#endif  // _WIN32
+};
+
+}  // namespace libhack
+
+#endif  // LIBHACK_SRC_SHAREDDATASTORE_H
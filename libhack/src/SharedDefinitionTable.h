@@ -0,0 +1,182 @@
+/**
+ * @file libhack/src/SharedDefinitionTable.h
+ * @ingroup libhack
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Table of definitions read on demand from a shared data store.
+ *
+ * This file is part of the COMP_hack Library (libhack).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHACK_SRC_SHAREDDEFINITIONTABLE_H
+#define LIBHACK_SRC_SHAREDDEFINITIONTABLE_H
+
+// libhack Includes
+#include "MemoryStream.h"
+#include "SharedDataStore.h"
+
+// Standard C++11 Includes
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace libhack {
+
+/**
+ * View of a table of definitions held in a shared data store. The store
+ * only holds the saved form of each definition so the table builds the
+ * definition object the first time it is requested and keeps it from
+ * then on. Only the definitions a server actually uses take up memory in
+ * it while the rest stay in the pages shared by every server on the host.
+ * Lookups of definitions that have already been built do not lock and
+ * the table can be used from multiple threads at once.
+ */
+template <class T>
+class SharedDefinitionTable {
+ public:
+  /**
+   * Create a table that is not attached to a store.
+   */
+  SharedDefinitionTable() {}
+
+  /**
+   * Attach the table to a table in a store, dropping any definitions
+   * built from a previous one.
+   * @param store Store to read the definitions from, which must stay open
+   *  for as long as the table is used
+   * @param tableID ID of the table in the store
+   * @return true if the store contains the table
+   */
+  bool Attach(const SharedDataStore& store, uint32_t tableID) {
+    SharedDataStore::Table table;
+    if (!store.GetTable(tableID, table)) {
+      return false;
+    }
+
+    mTable = table;
+    mSlots.reset(new std::atomic<T*>[table.Count()]);
+    for (uint32_t i = 0; i < table.Count(); i++) {
+      mSlots[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    mObjects.clear();
+    mObjects.resize((size_t)table.Count());
+
+    return true;
+  }
+
+  /**
+   * Detach the table from its store, dropping every definition built
+   * from it.
+   */
+  void Detach() {
+    mSlots.reset();
+    mObjects.clear();
+    mTable = SharedDataStore::Table();
+  }
+
+  /**
+   * Check if the table is attached to a store.
+   * @return true if the table is attached
+   */
+  bool IsAttached() const { return mSlots != nullptr; }
+
+  /**
+   * Get a definition by ID.
+   * @param id ID of the definition to retrieve
+   * @return Pointer to the definition or null if it does not exist. The
+   *  definition is owned by the table.
+   */
+  T* Find(uint32_t id) const {
+    size_t idx;
+    if (!mTable.Find(id, idx)) {
+      return nullptr;
+    }
+
+    T* pObject = mSlots[idx].load(std::memory_order_acquire);
+    return pObject ? pObject : Build(idx).get();
+  }
+
+  /**
+   * Get a definition by ID.
+   * @param id ID of the definition to retrieve
+   * @return Pointer to the definition or null if it does not exist
+   */
+  std::shared_ptr<T> Get(uint32_t id) const {
+    size_t idx;
+    if (!mTable.Find(id, idx)) {
+      return nullptr;
+    }
+
+    // Published objects are never replaced so reading them is safe once
+    // their slot is set
+    return mSlots[idx].load(std::memory_order_acquire) ? mObjects[idx]
+                                                       : Build(idx);
+  }
+
+ private:
+  /**
+   * Build the definition at an index in the table from its saved form
+   * unless another thread already has.
+   * @param idx Index of the definition in the table
+   * @return Pointer to the definition or null if it could not be loaded
+   */
+  std::shared_ptr<T> Build(size_t idx) const {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!mObjects[idx]) {
+      const char* pData;
+      size_t size;
+      if (!mTable.Get(idx, pData, size)) {
+        return nullptr;
+      }
+
+      auto obj = std::make_shared<T>();
+
+      MemoryInStream ms(pData, size);
+      if (!obj->Load(ms)) {
+        return nullptr;
+      }
+
+      mObjects[idx] = obj;
+      mSlots[idx].store(obj.get(), std::memory_order_release);
+    }
+
+    return mObjects[idx];
+  }
+
+  /// Table in the store the definitions are read from
+  SharedDataStore::Table mTable;
+
+  /// Pointer to each definition built so far by index in the table, null
+  /// if it has not been built yet
+  std::unique_ptr<std::atomic<T*>[]> mSlots;
+
+  /// Definitions built so far by index in the table. Never resized once
+  /// attached so entries can be read while others are being built.
+  mutable std::vector<std::shared_ptr<T>> mObjects;
+
+  /// Lock held while building a definition
+  mutable std::mutex mLock;
+};
+
+}  // namespace libhack
+
+#endif  // LIBHACK_SRC_SHAREDDEFINITIONTABLE_H
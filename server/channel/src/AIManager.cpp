@@ -69,6 +69,11 @@
 #include "SkillManager.h"
 #include "TokuseiManager.h"
 #include "ZoneManager.h"
+#include "ZoneWorkerPool.h"
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <limits>
 
 #define FOLLOW_DISTANCE_MAX (MAX_ENTITY_DRAW_DISTANCE * 0.66f)
 #define FOLLOW_DISTANCE_FAR (MAX_ENTITY_DRAW_DISTANCE * 0.25f)
@@ -79,6 +84,8 @@ using namespace channel;
 std::unordered_map<std::string, std::shared_ptr<libhack::ScriptEngine>>
     AIManager::sPreparedScripts;
 
+std::recursive_mutex AIManager::sScriptLock;
+
 namespace libcomp {
 template <>
 BaseScriptEngine& BaseScriptEngine::Using<AIManager>() {
@@ -210,6 +217,8 @@ bool AIManager::Prepare(const std::shared_ptr<ActiveEntityState>& eState,
 
   std::shared_ptr<libhack::ScriptEngine> aiEngine;
   if (!finalAIType.IsEmpty()) {
+    std::lock_guard<std::recursive_mutex> lock(sScriptLock);
+
     auto it = sPreparedScripts.find(finalAIType.C());
     if (it == sPreparedScripts.end()) {
       auto script = serverDataManager->GetAIScript(finalAIType);
@@ -269,24 +278,92 @@ bool AIManager::Prepare(const std::shared_ptr<ActiveEntityState>& eState,
 
 void AIManager::UpdateActiveStates(const std::shared_ptr<Zone>& zone,
                                    uint64_t now, bool isNight) {
+  auto worldSharedConfig = mServer.lock()->GetWorldSharedConfig();
+  float activeRadius = worldSharedConfig->GetAIActiveRadius();
+  float sleepRadius = worldSharedConfig->GetAISleepRadius();
+  uint64_t reducedInterval =
+      (uint64_t)worldSharedConfig->GetAIReducedInterval() * 1000ULL;
+
+  // Get the distance to the closest character for every entity near
+  // enough to one to matter
+  std::unordered_map<int32_t, float> watched;
+  if (activeRadius > 0.f) {
+    float radius =
+        reducedInterval && sleepRadius > 0.f ? sleepRadius : activeRadius;
+    radius = std::max(radius, activeRadius);
+
+    for (auto client : zone->GetConnectionList()) {
+      auto cState = client->GetClientState()->GetCharacterState();
+      cState->RefreshCurrentPosition(now);
+
+      float x = cState->GetCurrentX();
+      float y = cState->GetCurrentY();
+      for (auto entity : zone->GetActiveEntitiesNear(x, y, radius)) {
+        entity->RefreshCurrentPosition(now);
+
+        float dist = entity->GetDistance(x, y);
+        auto wIter = watched.find(entity->GetEntityID());
+        if (wIter == watched.end()) {
+          watched[entity->GetEntityID()] = dist;
+        } else if (dist < wIter->second) {
+          wIter->second = dist;
+        }
+      }
+    }
+  }
+
+  uint32_t activeCount = 0;
+  uint32_t reducedCount = 0;
+  uint32_t dormantCount = 0;
+
   std::list<std::shared_ptr<ActiveEntityState>> updated;
   for (auto eState : zone->GetEnemiesAndAllies()) {
+    auto aiState = eState->GetAIState();
+    if (activeRadius > 0.f && aiState && CanRest(eState)) {
+      auto wIter = watched.find(eState->GetEntityID());
+      float dist = wIter != watched.end()
+                       ? wIter->second
+                       : std::numeric_limits<float>::infinity();
+      if (dist > activeRadius) {
+        if (!reducedInterval || (sleepRadius > 0.f && dist > sleepRadius)) {
+          // Nobody is close enough to notice, sleep until someone is
+          dormantCount++;
+          continue;
+        }
+
+        reducedCount++;
+        if (aiState->GetNextReducedUpdate() > now) {
+          continue;
+        }
+
+        aiState->SetNextReducedUpdate(now + reducedInterval);
+      } else {
+        activeCount++;
+        aiState->SetNextReducedUpdate(0);
+      }
+    } else if (aiState) {
+      activeCount++;
+      aiState->SetNextReducedUpdate(0);
+    }
+
     if (UpdateState(eState, now, isNight)) {
       updated.push_back(eState);
     }
   }
 
+  zone->SetAIUpdateCounts(activeCount, reducedCount, dormantCount);
+
   // Update enemy states first
   if (updated.size() > 0) {
-    auto zConnections = zone->GetConnectionList();
-    RelativeTimeMap timeMap;
+    auto zoneManager = mServer.lock()->GetZoneManager();
     for (auto entity : updated) {
       // Update the clients with what the entity is doing
 
       // Check if the entity's position or rotation has updated
       if (now == entity->GetOriginTicks()) {
+        libcomp::Packet p;
+        RelativeTimeMap timeMap;
         if (entity->IsMoving()) {
-          libcomp::Packet p;
           p.WritePacketCode(ChannelToClientPacketCode_t::PACKET_MOVE);
           p.WriteS32Little(entity->GetEntityID());
           p.WriteFloat(entity->GetDestinationX());
@@ -297,35 +374,34 @@ void AIManager::UpdateActiveStates(const std::shared_ptr<Zone>& zone,
 
           timeMap[p.Size()] = now;
           timeMap[p.Size() + 4] = entity->GetDestinationTicks();
-          ChannelClientConnection::SendRelativeTimePacket(zConnections, p,
-                                                          timeMap, true);
         } else if (entity->IsRotating()) {
-          libcomp::Packet p;
           p.WritePacketCode(ChannelToClientPacketCode_t::PACKET_ROTATE);
           p.WriteS32Little(entity->GetEntityID());
           p.WriteFloat(entity->GetDestinationRotation());
 
           timeMap[p.Size()] = now;
           timeMap[p.Size() + 4] = entity->GetDestinationTicks();
-          ChannelClientConnection::SendRelativeTimePacket(zConnections, p,
-                                                          timeMap, true);
         } else {
           // The movement was actually a stop
-
-          libcomp::Packet p;
           p.WritePacketCode(ChannelToClientPacketCode_t::PACKET_STOP_MOVEMENT);
           p.WriteS32Little(entity->GetEntityID());
           p.WriteFloat(entity->GetDestinationX());
           p.WriteFloat(entity->GetDestinationY());
 
           timeMap[p.Size()] = entity->GetDestinationTicks();
-          ChannelClientConnection::SendRelativeTimePacket(zConnections, p,
-                                                          timeMap, true);
         }
+
+        // Clients the entity is not shown to will be sent its current
+        // movement once it comes into range instead
+        auto zConnections = zoneManager->GetInterestedConnections(
+            zone, {entity->GetEntityID()},
+            (uint32_t)(p.Size() + timeMap.size() * 4));
+        ChannelClientConnection::SendRelativeTimePacket(zConnections, p,
+                                                        timeMap, true);
       }
     }
 
-    ChannelClientConnection::FlushAllOutgoing(zConnections);
+    ChannelClientConnection::FlushAllOutgoing(zone->GetConnectionList());
   }
 }
 
@@ -358,6 +434,8 @@ void AIManager::CombatSkillHit(
             .Arg(fOverride);
       });
 
+      std::lock_guard<std::recursive_mutex> lock(sScriptLock);
+
       Sqrat::Function f(Sqrat::RootTable(aiState->GetScript()->GetVM()),
                         fOverride.IsEmpty() ? "combatSkillHit" : fOverride.C());
 
@@ -415,6 +493,8 @@ void AIManager::CombatSkillComplete(
           .Arg(fOverride);
     });
 
+    std::lock_guard<std::recursive_mutex> lock(sScriptLock);
+
     Sqrat::Function f(
         Sqrat::RootTable(aiState->GetScript()->GetVM()),
         fOverride.IsEmpty() ? "combatSkillComplete" : fOverride.C());
@@ -544,9 +624,12 @@ bool AIManager::QueueUseSkillCommand(
     auto ctx = std::make_shared<SkillExecutionContext>();
     ctx->IgnoreAvailable = true;
 
-    return server->GetSkillManager()->ActivateSkill(
-        eState, skillID, targetEntityID, targetEntityID, ACTIVATION_TARGET,
-        ctx);
+    auto skillManager = server->GetSkillManager();
+    return RunSkillWork([skillManager, eState, skillID, targetEntityID, ctx]() {
+      return skillManager->ActivateSkill(eState, skillID, targetEntityID,
+                                         targetEntityID, ACTIVATION_TARGET,
+                                         ctx);
+    });
   }
 
   auto skillCmd =
@@ -564,6 +647,8 @@ void AIManager::QueueScriptCommand(const std::shared_ptr<AIState>& aiState,
     bool functionExists = true;
     auto script = aiState->GetScript();
     if (script) {
+      std::lock_guard<std::recursive_mutex> lock(sScriptLock);
+
       Sqrat::Function f(Sqrat::RootTable(script->GetVM()), functionName.C());
       if (f.IsNull()) {
         LogAIManagerError([functionName]() {
@@ -603,11 +688,14 @@ bool AIManager::StartEvent(const std::shared_ptr<ActiveEntityState>& eState,
 
     auto eventManager = mServer.lock()->GetEventManager();
 
-    EventOptions options;
-    options.AutoOnly = true;
+    // Events can affect anything so they run like skills do
+    return RunSkillWork([eventManager, eventID, eState]() {
+      EventOptions options;
+      options.AutoOnly = true;
 
-    return eventManager->HandleEvent(nullptr, eventID, eState->GetEntityID(),
-                                     eState->GetZone(), options);
+      return eventManager->HandleEvent(nullptr, eventID, eState->GetEntityID(),
+                                       eState->GetZone(), options);
+    });
   }
 
   return false;
@@ -673,7 +761,10 @@ void AIManager::UpdateAggro(const std::shared_ptr<ActiveEntityState>& eState,
       p.WriteS32Little(eState->GetEntityID());
       p.WriteS32Little(aiState->GetTargetEntityID());
 
-      ChannelClientConnection::BroadcastPacket(zone->GetConnectionList(), p);
+      auto zConnections =
+          mServer.lock()->GetZoneManager()->GetInterestedConnections(
+              zone, {eState->GetEntityID()}, p.Size());
+      ChannelClientConnection::BroadcastPacket(zConnections, p);
     }
   }
 }
@@ -921,6 +1012,20 @@ bool AIManager::Circle(const std::shared_ptr<ActiveEntityState>& eState,
   return false;
 }
 
+bool AIManager::CanRest(const std::shared_ptr<ActiveEntityState>& eState) {
+  auto aiState = eState->GetAIState();
+  if ((!aiState->IsIdle() && !aiState->IsWandering()) ||
+      aiState->ActionOverridesKeyExists("idle")) {
+    // Scripted idle actions could affect more than the entity itself
+    return false;
+  }
+
+  // Anything with a target, opponents or pending despawn must keep
+  // updating to resolve it
+  return aiState->GetTargetEntityID() <= 0 && !aiState->GetDespawnTimeout() &&
+         eState->GetOpponentIDs().size() == 0;
+}
+
 bool AIManager::UpdateState(const std::shared_ptr<ActiveEntityState>& eState,
                             uint64_t now, bool isNight) {
   eState->RefreshCurrentPosition(now);
@@ -1048,8 +1153,7 @@ bool AIManager::UpdateState(const std::shared_ptr<ActiveEntityState>& eState,
       }
 
       if (cancelActivatedSkill) {
-        mServer.lock()->GetSkillManager()->CancelSkill(
-            eState, activated->GetActivationID());
+        CancelSkill(eState, activated);
       }
     }
 
@@ -1263,7 +1367,7 @@ bool AIManager::UpdateState(const std::shared_ptr<ActiveEntityState>& eState,
                     .Arg(cmdSkill->GetTargetEntityID());
               });
 
-              skillManager->CancelSkill(eState, activated->GetActivationID());
+              CancelSkill(eState, activated);
             }
 
             // Not valid
@@ -1286,18 +1390,25 @@ bool AIManager::UpdateState(const std::shared_ptr<ActiveEntityState>& eState,
 
         if (activated) {
           // Execute the skill
-          if (!skillManager->ExecuteSkill(eState, activated->GetActivationID(),
-                                          activated->GetTargetObjectID()) &&
-              eState->GetActivatedAbility() == activated) {
-            if (!CanRetrySkill(eState, activated)) {
+          RunSkillWork([this, skillManager, eState, activated]() {
+            if (!skillManager->ExecuteSkill(eState,
+                                            activated->GetActivationID(),
+                                            activated->GetTargetObjectID()) &&
+                eState->GetActivatedAbility() == activated &&
+                !CanRetrySkill(eState, activated)) {
               skillManager->CancelSkill(eState, activated->GetActivationID());
             }
-          }
+
+            return true;
+          });
         } else {
           // Activate the skill
-          skillManager->ActivateSkill(
-              eState, cmdSkill->GetSkillID(), cmdSkill->GetTargetEntityID(),
-              cmdSkill->GetTargetEntityID(), ACTIVATION_TARGET);
+          uint32_t skillID = cmdSkill->GetSkillID();
+          int32_t targetID = cmdSkill->GetTargetEntityID();
+          RunSkillWork([skillManager, eState, skillID, targetID]() {
+            return skillManager->ActivateSkill(eState, skillID, targetID,
+                                               targetID, ACTIVATION_TARGET);
+          });
         }
 
         aiState->PopCommand(cmdSkill);
@@ -1398,7 +1509,12 @@ bool AIManager::UpdateEnemyState(
   float deaggroDist = aiState->GetDeaggroDistance(isNight);
   if (deaggroDist && targetDist >= deaggroDist) {
     // De-aggro on that one target and find a new one
-    server->GetCharacterManager()->AddRemoveOpponent(false, eState, target);
+    auto characterManager = server->GetCharacterManager();
+    auto oldTarget = target;
+    RunSkillWork([characterManager, eState, oldTarget]() {
+      characterManager->AddRemoveOpponent(false, eState, oldTarget);
+      return true;
+    });
 
     target = Retarget(eState, now, isNight);
     targetChanged = true;
@@ -1408,8 +1524,7 @@ bool AIManager::UpdateEnemyState(
   if (!target) {
     // No target could be found, stop combat and quit
     if (activated) {
-      server->GetSkillManager()->CancelSkill(eState,
-                                             activated->GetActivationID());
+      CancelSkill(eState, activated);
     }
 
     return false;
@@ -1461,8 +1576,7 @@ bool AIManager::UpdateEnemyState(
                eState->GetDistance(zone->GetActiveEntity(
                    aiState->GetFollowEntityID())) > FOLLOW_DISTANCE_MAX) {
       // Cancel to pursue follow target
-      server->GetSkillManager()->CancelSkill(eState,
-                                             activated->GetActivationID());
+      CancelSkill(eState, activated);
       return false;
     } else if (activated->GetSkillData()->GetBasic()->GetActivationType() ==
                    SkillActivationType_t::ON_HIT &&
@@ -1484,8 +1598,7 @@ bool AIManager::UpdateEnemyState(
     }
 
     if (cancelAndReset) {
-      server->GetSkillManager()->CancelSkill(eState,
-                                             activated->GetActivationID());
+      CancelSkill(eState, activated);
       activated = nullptr;
     }
   }
@@ -1498,7 +1611,9 @@ bool AIManager::UpdateEnemyState(
     if (activationTarget > 0 && targetEntityID != (int32_t)activationTarget &&
         eState->GetEntityID() != (int32_t)activationTarget) {
       // Target changed
-      skillManager->TargetSkill(eState, targetEntityID);
+      RunSkillWork([skillManager, eState, targetEntityID]() {
+        return skillManager->TargetSkill(eState, targetEntityID);
+      });
       return false;
     }
 
@@ -1514,7 +1629,7 @@ bool AIManager::UpdateEnemyState(
       if (skillActivationWait) {
         return false;
       } else {
-        skillManager->CancelSkill(eState, activated->GetActivationID());
+        CancelSkill(eState, activated);
       }
     } else if (CanRetrySkill(eState, activated)) {
       auto logicGroup = aiState->GetLogicGroup();
@@ -2049,6 +2164,8 @@ std::shared_ptr<ActiveEntityState> AIManager::Retarget(
   int32_t newTarget = currentTarget;
   if (possibleTargets.size() > 0) {
     if (aiState->ActionOverridesKeyExists("target") && aiState->GetScript()) {
+      std::lock_guard<std::recursive_mutex> lock(sScriptLock);
+
       Sqrat::Function f(Sqrat::RootTable(aiState->GetScript()->GetVM()),
                         aiState->GetActionOverrides("target").C());
 
@@ -2264,6 +2381,24 @@ bool AIManager::SkillIsValid(
   return true;
 }
 
+bool AIManager::RunSkillWork(const std::function<bool()>& work) {
+  if (ZoneWorkerPool::Defer([work]() { work(); })) {
+    // Assume it goes ahead once every zone has finished updating
+    return true;
+  }
+
+  return work();
+}
+
+void AIManager::CancelSkill(
+    const std::shared_ptr<ActiveEntityState>& eState,
+    const std::shared_ptr<objects::ActivatedAbility>& activated) {
+  auto skillManager = mServer.lock()->GetSkillManager();
+  RunSkillWork([skillManager, eState, activated]() {
+    return skillManager->CancelSkill(eState, activated->GetActivationID());
+  });
+}
+
 bool AIManager::CanRetrySkill(
     const std::shared_ptr<ActiveEntityState>& eState,
     const std::shared_ptr<objects::ActivatedAbility>& activated) {
@@ -2305,6 +2440,8 @@ bool AIManager::PrepareSkillUsage(
   if (aiState->ActionOverridesKeyExists("prepareSkill")) {
     libcomp::String fOverride = aiState->GetActionOverrides("prepareSkill");
 
+    std::lock_guard<std::recursive_mutex> lock(sScriptLock);
+
     Sqrat::Function f(Sqrat::RootTable(aiState->GetScript()->GetVM()),
                       fOverride.IsEmpty() ? "prepareSkill" : fOverride.C());
 
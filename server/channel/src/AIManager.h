@@ -32,6 +32,10 @@
 #include "ActiveEntityState.h"
 #include "ClientState.h"
 
+// Standard C++11 Includes
+#include <functional>
+#include <mutex>
+
 namespace libhack {
 class ScriptEngine;
 }
@@ -281,6 +285,15 @@ class AIManager {
               float y, bool interrupt = false, float distance = 800.f);
 
  private:
+  /**
+   * Check if an AI controlled entity is doing nothing that requires it to
+   * be updated every tick, making it eligible to be updated less often or
+   * put to sleep when no players are nearby.
+   * @param eState Pointer to the entity state to check
+   * @return true if the entity can be updated less often
+   */
+  bool CanRest(const std::shared_ptr<ActiveEntityState>& eState);
+
   /**
    * Update the state of an entity, processing AI and performing other
    * related actions.
@@ -376,6 +389,25 @@ class AIManager {
    */
   bool SkillIsValid(const std::shared_ptr<objects::MiSkillData>& skillData);
 
+  /**
+   * Run work that uses skills or events for an AI controlled entity. These
+   * affect far more than the entity's own zone so while zones are being
+   * updated in parallel the work is deferred until every zone has finished.
+   * Otherwise it is run immediately.
+   * @param work Work to run, returning true on success
+   * @return Result of the work or true if it was deferred
+   */
+  bool RunSkillWork(const std::function<bool()>& work);
+
+  /**
+   * Cancel a skill an AI controlled entity has activated through
+   * RunSkillWork.
+   * @param eState Pointer to the entity state
+   * @param activated Pointer to the skill's activation state
+   */
+  void CancelSkill(const std::shared_ptr<ActiveEntityState>& eState,
+                   const std::shared_ptr<objects::ActivatedAbility>& activated);
+
   /**
    * Determine if a skill that has already attempted activation can
    * be used again
@@ -416,6 +448,8 @@ class AIManager {
       return false;
     }
 
+    std::lock_guard<std::recursive_mutex> lock(sScriptLock);
+
     Sqrat::Function f(Sqrat::RootTable(script->GetVM()), functionName.C());
 
     auto scriptResult = !f.IsNull() ? f.Evaluate<T>(eState, this, now) : 0;
@@ -493,6 +527,11 @@ class AIManager {
   static std::unordered_map<std::string, std::shared_ptr<libhack::ScriptEngine>>
       sPreparedScripts;
 
+  /// Lock held while running AI scripts. Prepared scripts are shared by
+  /// every entity of the same AI type, in any zone, and a script VM can
+  /// only run on one thread at a time.
+  static std::recursive_mutex sScriptLock;
+
   /// Pointer to the channel server.
   std::weak_ptr<ChannelServer> mServer;
 };
@@ -69,10 +69,12 @@
 // channel Includes
 #include "ChannelServer.h"
 #include "ChannelSyncManager.h"
+#include "CharacterLoader.h"
 #include "CharacterManager.h"
 #include "EventManager.h"
 #include "ManagerConnection.h"
 #include "MatchManager.h"
+#include "PerformanceTimer.h"
 #include "TokuseiManager.h"
 #include "ZoneManager.h"
 
@@ -136,6 +138,17 @@ void AccountManager::HandleLoginResponse(
   packets::ChannelToClient_Login reply;
 
   if (InitializeCharacter(character, state)) {
+    // Everything loaded now matches the database so anything unchanged by
+    // logout does not need to be saved again
+    std::list<std::shared_ptr<libcomp::PersistentObject>> always;
+    std::list<std::shared_ptr<libcomp::PersistentObject>> tracked;
+    GetLogoutObjects(state, character.Get(), always, tracked);
+
+    auto saveTracker = state->GetSaveTracker();
+    for (auto obj : tracked) {
+      saveTracker->Mark(obj);
+    }
+
     auto characterManager = server->GetCharacterManager();
     auto definitionManager = server->GetDefinitionManager();
     auto demon = character->GetActiveDemon().Get();
@@ -626,6 +639,9 @@ bool AccountManager::InitializeCharacter(
   auto definitionManager = server->GetDefinitionManager();
   auto db = server->GetWorldDatabase();
 
+  PerformanceTimer loadTimer(server.get());
+  loadTimer.Start();
+
   if (character.IsNull() || !character.Get(db) ||
       !character->LoadCoreStats(db)) {
     LogAccountManagerError([&]() {
@@ -685,6 +701,19 @@ bool AccountManager::InitializeCharacter(
 
   state->SetAccountWorldData(worldData);
 
+  // Load everything the character owns up front so the references below
+  // resolve from memory instead of each being a separate query
+  CharacterLoader loader(db);
+  loader.Load(character.Get(), worldData);
+
+  LogAccountManagerDebug([&]() {
+    return libcomp::String(
+               "Bulk loaded %1 object(s) in %2 queries for character: %3\n")
+        .Arg(loader.GetObjectCount())
+        .Arg(loader.GetQueryCount())
+        .Arg(character->GetUUID().ToString());
+  });
+
   // Keep track of any login updates
   auto dbUpdates = libcomp::DatabaseChangeSet::Create(account);
 
@@ -848,8 +877,7 @@ bool AccountManager::InitializeCharacter(
     }
 
     // Load all items together
-    auto allBoxItems =
-        objects::Item::LoadItemListByItemBox(db, itemBox.GetUUID());
+    auto allBoxItems = loader.GetItems(itemBox.GetUUID());
 
     // Check to make sure all items in slots in the ItemBox are valid
     std::set<size_t> openSlots;
@@ -973,8 +1001,7 @@ bool AccountManager::InitializeCharacter(
   }
 
   // Character status effects (recover first)
-  auto allStatusEffects = objects::StatusEffect::LoadStatusEffectListByEntity(
-      db, character->GetUUID());
+  auto allStatusEffects = loader.GetStatusEffects(character->GetUUID());
   for (auto effect : allStatusEffects) {
     bool exists = false;
     for (auto effect2 : character->GetStatusEffects()) {
@@ -1085,8 +1112,7 @@ bool AccountManager::InitializeCharacter(
       state->SetObjectID(demon->GetUUID(), server->GetNextObjectID());
 
       // Demon status effects (recover first)
-      allStatusEffects = objects::StatusEffect::LoadStatusEffectListByEntity(
-          db, demon->GetUUID());
+      allStatusEffects = loader.GetStatusEffects(demon->GetUUID());
       for (auto effect : allStatusEffects) {
         bool exists = false;
         for (auto effect2 : demon->GetStatusEffects()) {
@@ -1202,8 +1228,7 @@ bool AccountManager::InitializeCharacter(
   }
 
   // Quests (recover first)
-  auto quests =
-      objects::Quest::LoadQuestListByCharacter(db, character->GetUUID());
+  auto quests = loader.GetQuests();
   for (auto quest : quests) {
     bool exists = false;
     for (auto qPair : character->GetQuests()) {
@@ -1317,7 +1342,13 @@ bool AccountManager::InitializeCharacter(
     }
   }
 
-  return db->ProcessChangeSet(dbUpdates);
+  if (!db->ProcessChangeSet(dbUpdates)) {
+    return false;
+  }
+
+  loadTimer.Stop("Character Load");
+
+  return true;
 }
 
 bool AccountManager::InitializeNewCharacter(
@@ -1637,13 +1668,101 @@ bool AccountManager::LogoutCharacter(channel::ClientState* state) {
 
   auto dbChanges = libcomp::DatabaseChangeSet::Create(character->GetAccount());
 
+  std::list<std::shared_ptr<libcomp::PersistentObject>> always;
+  std::list<std::shared_ptr<libcomp::PersistentObject>> tracked;
+  GetLogoutObjects(state, character, always, tracked);
+
+  for (auto obj : always) {
+    dbChanges->Update(obj);
+  }
+
+  // Skip anything that has not changed since it was loaded or last saved
+  auto saveTracker = state->GetSaveTracker();
+
+  std::list<std::pair<libobjgen::UUID, uint64_t>> saved;
+  for (auto obj : tracked) {
+    uint64_t hash = 0;
+    if (saveTracker->IsChanged(obj, hash)) {
+      dbChanges->Update(obj);
+      saved.push_back(std::make_pair(obj->GetUUID(), hash));
+    }
+  }
+
+  LogAccountManagerDebug([&]() {
+    return libcomp::String(
+               "Saving %1 of %2 object(s) on logout for character: %3\n")
+        .Arg(always.size() + saved.size())
+        .Arg(always.size() + tracked.size())
+        .Arg(character ? character->GetUUID().ToString() : "");
+  });
+
+  // Save all records at once
+  auto server = mServer.lock();
+  if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    return false;
+  }
+
+  for (auto& pair : saved) {
+    saveTracker->Mark(pair.first, pair.second);
+  }
+
+  // Record how many rows logout wrote and how many it skipped
+  PerformanceTimer perf(server.get());
+  perf.Count("LogoutObjectsSaved", (uint64_t)(always.size() + saved.size()));
+  perf.Count("LogoutObjectsSkipped", (uint64_t)(tracked.size() - saved.size()));
+
+  return true;
+}
+
+size_t AccountManager::CheckpointCharacter(channel::ClientState* state) {
+  // Skip clients that are not fully logged in or should not be saved
+  auto character = state->GetCharacterState()->GetEntity();
+  if (!character || !state->GetLogoutSave()) {
+    return 0;
+  }
+
+  std::list<std::shared_ptr<libcomp::PersistentObject>> always;
+  std::list<std::shared_ptr<libcomp::PersistentObject>> tracked;
+  GetLogoutObjects(state, character, always, tracked);
+
+  // Objects saved on every logout are only checkpointed when changed too
+  tracked.splice(tracked.end(), always);
+
+  auto saveTracker = state->GetSaveTracker();
+  auto dbChanges = libcomp::DatabaseChangeSet::Create(character->GetAccount());
+
+  size_t saved = 0;
+  for (auto obj : tracked) {
+    uint64_t hash = 0;
+    if (saveTracker->IsChanged(obj, hash)) {
+      dbChanges->Update(obj);
+      saved++;
+    }
+  }
+
+  // The objects are marked with the state that was written once the
+  // persistence worker commits them. If the save fails the client is
+  // disconnected and the tracker is cleared so logout saves everything
+  // again.
+  if (saved == 0 || !mServer.lock()->QueueWorldChangeSet(dbChanges)) {
+    return 0;
+  }
+
+  return saved;
+}
+
+void AccountManager::GetLogoutObjects(
+    channel::ClientState* state,
+    const std::shared_ptr<objects::Character>& character,
+    std::list<std::shared_ptr<libcomp::PersistentObject>>& always,
+    std::list<std::shared_ptr<libcomp::PersistentObject>>& tracked) {
   std::list<std::shared_ptr<objects::ItemBox>> allBoxes;
   if (character) {
-    dbChanges->Update(character->GetCoreStats().Get());
-    dbChanges->Update(character->GetProgress().Get());
-    dbChanges->Update(character->GetFriendSettings().Get());
-    dbChanges->Update(character->GetDemonQuest().Get());
-    dbChanges->Update(character->GetCultureData().Get());
+    always.push_back(character->GetCoreStats().Get());
+    always.push_back(character->GetProgress().Get());
+    always.push_back(character->GetFriendSettings().Get());
+    always.push_back(character->GetDemonQuest().Get());
+    always.push_back(character->GetCultureData().Get());
 
     for (auto itemBox : character->GetItemBoxes()) {
       allBoxes.push_back(itemBox.Get());
@@ -1662,20 +1781,22 @@ bool AccountManager::LogoutCharacter(channel::ClientState* state) {
     if (!itemBox) continue;
 
     for (auto item : itemBox->GetItems()) {
-      dbChanges->Update(item.Get());
+      tracked.push_back(item.Get());
     }
 
-    dbChanges->Update(itemBox);
+    tracked.push_back(itemBox);
   }
 
+  std::shared_ptr<objects::DemonBox> comp;
   std::list<std::shared_ptr<objects::DemonBox>> demonBoxes;
   if (character) {
     // Save expertises
     for (auto expertise : character->GetExpertises()) {
-      dbChanges->Update(expertise.Get());
+      tracked.push_back(expertise.Get());
     }
 
-    demonBoxes.push_back(character->GetCOMP().Get());
+    comp = character->GetCOMP().Get();
+    demonBoxes.push_back(comp);
   }
 
   // Save demon boxes, demons and stats
@@ -1688,22 +1809,25 @@ bool AccountManager::LogoutCharacter(channel::ClientState* state) {
   for (auto box : demonBoxes) {
     if (!box) continue;
 
+    // Demons in the COMP can change in combat without being saved
+    auto& demonObjects = box == comp ? always : tracked;
+
     for (auto demon : box->GetDemons()) {
       if (demon.IsNull()) continue;
 
       for (auto iSkill : demon->GetInheritedSkills()) {
-        dbChanges->Update(iSkill.Get());
+        tracked.push_back(iSkill.Get());
       }
 
-      dbChanges->Update(demon->GetCoreStats().Get());
-      dbChanges->Update(demon.Get());
+      demonObjects.push_back(demon->GetCoreStats().Get());
+      demonObjects.push_back(demon.Get());
     }
 
-    dbChanges->Update(box);
+    tracked.push_back(box);
   }
 
   // Save world data
-  dbChanges->Update(accountWorldData);
+  always.push_back(accountWorldData);
 
   // Do not save status effects as those handled uniquely elsewhere
 
@@ -1712,19 +1836,20 @@ bool AccountManager::LogoutCharacter(channel::ClientState* state) {
   if (character) {
     // Save hotbars
     for (auto hotbar : character->GetHotbars()) {
-      dbChanges->Update(hotbar.Get());
+      tracked.push_back(hotbar.Get());
     }
 
     // Save quests
     for (auto qPair : character->GetQuests()) {
-      dbChanges->Update(qPair.second.Get());
+      tracked.push_back(qPair.second.Get());
     }
 
-    dbChanges->Update(character);
+    always.push_back(character);
   }
 
-  // Save all records at once
-  return mServer.lock()->GetWorldDatabase()->ProcessChangeSet(dbChanges);
+  // Drop anything that is not set or not loaded
+  always.remove(nullptr);
+  tracked.remove(nullptr);
 }
 
 void AccountManager::WipeMember(tinyxml2::XMLElement* pElement,
@@ -195,6 +195,15 @@ class AccountManager {
    */
   libcomp::String DumpAccount(channel::ClientState* state);
 
+  /**
+   * Queue a save of every object that would be saved on logout that has
+   * changed since it was last saved, so little is lost if the channel
+   * stops unexpectedly and logout has less to save.
+   * @param state Pointer to the client state the character belongs to
+   * @return Number of objects queued to be saved
+   */
+  size_t CheckpointCharacter(channel::ClientState* state);
+
  private:
   /**
    * Delete a <member> from an object in the XML DOM.
@@ -239,6 +248,23 @@ class AccountManager {
    */
   bool LogoutCharacter(channel::ClientState* state);
 
+  /**
+   * Gather the character data persisted when a client logs out.
+   * @param state Pointer to the client state the character
+   *  belongs to
+   * @param character Pointer to the character being saved
+   * @param always Output list of objects that are saved every time since
+   *  they can change without being saved right away and there are only a
+   *  handful of them
+   * @param tracked Output list of objects that are only saved if they have
+   *  changed since they were loaded or last saved
+   */
+  void GetLogoutObjects(
+      channel::ClientState* state,
+      const std::shared_ptr<objects::Character>& character,
+      std::list<std::shared_ptr<libcomp::PersistentObject>>& always,
+      std::list<std::shared_ptr<libcomp::PersistentObject>>& tracked);
+
   /// Map of all character logins active on the world by world CID
   std::unordered_map<int32_t, std::shared_ptr<objects::CharacterLogin>>
       mActiveLogins;
@@ -1090,7 +1090,8 @@ bool ActionManager::AddRemoveItems(ActionContext& ctx) {
         auto postItems = objects::PostItem::LoadPostItemListByAccount(
             lobbyDB, state->GetAccountUID());
 
-        auto dbChanges = libcomp::DatabaseChangeSet::Create();
+        auto dbChanges =
+            libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
         for (auto pair : adds) {
           for (uint32_t i = 0; i < pair.second; i++) {
             if ((postItems.size() + pair.second) >= MAX_POST_ITEM_COUNT) {
@@ -1533,7 +1534,7 @@ bool ActionManager::UpdateCOMP(ActionContext& ctx) {
 
     characterManager->SendDemonBoxData(ctx.Client, comp->GetBoxID(), slots);
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   }
 
   if (add.size() > 0) {
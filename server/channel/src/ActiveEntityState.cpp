@@ -189,6 +189,10 @@ void ActiveEntityState::Move(float xPos, float yPos, uint64_t now) {
     SetDestinationX(xPos);
     SetDestinationY(yPos);
     SetDestinationTicks((uint64_t)(now + addMicro));
+
+    if (mCurrentZone) {
+      mCurrentZone->UpdateSpatialIndex(GetEntityID());
+    }
   }
 }
 
@@ -216,6 +220,10 @@ void ActiveEntityState::Stop(uint64_t now) {
   SetOriginY(GetCurrentY());
   SetOriginRotation(GetCurrentRotation());
   SetOriginTicks(now);
+
+  if (mCurrentZone) {
+    mCurrentZone->UpdateSpatialIndex(GetEntityID());
+  }
 }
 
 bool ActiveEntityState::IsAlive() const { return mAlive; }
@@ -925,7 +933,7 @@ std::set<uint32_t> ActiveEntityState::AddStatusEffects(
 
       std::set<uint32_t> inverseEffects;
       for (auto pair : mStatusEffects) {
-        auto exDef = definitionManager->GetStatusData(pair.first);
+        auto exDef = definitionManager->FindStatusData(pair.first);
         auto exBasic = exDef->GetBasic();
         if (exBasic->GetGroupID() == basic->GetGroupID()) {
           if (basic->GetGroupRank() >= exBasic->GetGroupRank()) {
@@ -1012,7 +1020,7 @@ std::set<uint32_t> ActiveEntityState::AddStatusEffects(
 
           // Application logic 2 effects have their expirations reset
           // any time they are re-applied (barring "set" durations)
-          auto exDef = definitionManager->GetStatusData(exEffect->GetEffect());
+          auto exDef = definitionManager->FindStatusData(exEffect->GetEffect());
           if (exDef->GetBasic()->GetApplicationLogic() == 2) {
             resetTime = true;
           }
@@ -1128,12 +1136,7 @@ std::set<uint32_t> ActiveEntityState::AddStatusEffects(
 
       if (mEffectsActive) {
         // Remove any times associated to the status being removed
-        for (auto& pair : mNextEffectTimes) {
-          // Skip system times
-          if (pair.first > 3) {
-            pair.second.erase(rEffectType);
-          }
-        }
+        SetNextEffectTime(rEffectType, 0);
 
         // Then optionally queue its removal
         if (queueChanges) {
@@ -1726,12 +1729,7 @@ void ActiveEntityState::ActivateStatusEffect(
   bool timeOnly = mode == 1;
   if (timeOnly) {
     // Remove the current expiration
-    for (auto& pair : mNextEffectTimes) {
-      // Skip system times
-      if (pair.first > 3) {
-        pair.second.erase(effectType);
-      }
-    }
+    SetNextEffectTime(effectType, 0);
   } else if (mode == 2) {
     // Check for registration and quit if found
     for (auto& pair : mNextEffectTimes) {
@@ -1882,20 +1880,25 @@ void ActiveEntityState::ResetAIIgnored() {
 void ActiveEntityState::SetNextEffectTime(uint32_t effectType, uint32_t time) {
   // Only erase if a non-system effect
   if (effectType) {
-    for (auto& pair : mNextEffectTimes) {
+    for (auto it = mNextEffectTimes.begin(); it != mNextEffectTimes.end();) {
       // Skip non-system times
-      if (pair.first <= 3) continue;
-
-      if (pair.second.find(effectType) != pair.second.end()) {
-        if (time == 0) {
-          pair.second.erase(effectType);
-          if (pair.second.size() == 0) {
-            mNextEffectTimes.erase(pair.first);
-          }
-        }
+      if (it->first <= 3 || it->second.find(effectType) == it->second.end()) {
+        it++;
+        continue;
+      }
 
+      if (time != 0) {
+        // Already registered
         return;
       }
+
+      // Remove the effect from every time it is registered at
+      it->second.erase(effectType);
+      if (it->second.size() == 0) {
+        it = mNextEffectTimes.erase(it);
+      } else {
+        it++;
+      }
     }
   }
 
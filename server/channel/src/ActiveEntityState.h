@@ -890,7 +890,9 @@ class ActiveEntityState : public objects::ActiveEntityStateObject {
    * event map. The zone itself must be updated using RegisterNextEffectTime
    * after each effect is set using this function.
    * @param effectType Effect type ID to register an event for
-   * @param time Absolute system time to register for the event
+   * @param time Absolute system time to register for the event or 0 to
+   *  remove every time registered for the effect. A time left with no
+   *  effects is removed as well so it is not registered with the zone.
    */
   void SetNextEffectTime(uint32_t effectType, uint32_t time);
 
@@ -0,0 +1,180 @@
+/**
+ * @file server/channel/src/ChangeSetCoalescer.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Collapses redundant updates in a batch of database change sets.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ChangeSetCoalescer.h"
+
+// libcomp Includes
+#include <DatabaseChangeSet.h>
+#include <PersistentObject.h>
+
+// Standard C++11 Includes
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace channel;
+
+ChangeSetCoalescer::Result ChangeSetCoalescer::Coalesce(
+    const std::list<std::shared_ptr<libcomp::DatabaseChangeSet>>& batch,
+    std::list<std::shared_ptr<libcomp::DatabaseChangeSet>>& coalesced) {
+  Result result;
+  result.Updates = 0;
+  result.ChangeSets = 0;
+
+  std::list<std::shared_ptr<libcomp::DatabaseChangeSet>> stretch;
+  for (auto& changes : batch) {
+    if (std::dynamic_pointer_cast<libcomp::DBStandardChangeSet>(changes)) {
+      stretch.push_back(changes);
+      continue;
+    }
+
+    // Nothing is collapsed across anything other than a standard change
+    // set as it may depend on what has already been written
+    CoalesceStretch(stretch, coalesced, result);
+    stretch.clear();
+
+    coalesced.push_back(changes);
+  }
+
+  CoalesceStretch(stretch, coalesced, result);
+
+  return result;
+}
+
+void ChangeSetCoalescer::CoalesceStretch(
+    const std::list<std::shared_ptr<libcomp::DatabaseChangeSet>>& stretch,
+    std::list<std::shared_ptr<libcomp::DatabaseChangeSet>>& coalesced,
+    Result& result) {
+  if (stretch.size() < 2) {
+    coalesced.insert(coalesced.end(), stretch.begin(), stretch.end());
+    return;
+  }
+
+  std::vector<std::shared_ptr<libcomp::DBStandardChangeSet>> sets;
+  sets.reserve(stretch.size());
+
+  for (auto& changes : stretch) {
+    sets.push_back(
+        std::dynamic_pointer_cast<libcomp::DBStandardChangeSet>(changes));
+  }
+
+  // Objects inserted or deleted anywhere in the stretch are never collapsed
+  // so the order of the insert or delete and the updates around it is kept
+  std::unordered_set<libobjgen::UUID> pinned;
+
+  // Index of the last change set that updates each object by the
+  // transaction (account) UUID of the change set
+  std::unordered_map<libobjgen::UUID,
+                     std::unordered_map<libobjgen::UUID, size_t>>
+      lastUpdates;
+
+  // Only change sets with nothing but updates can take over an earlier
+  // update. An insert or delete can fail and roll back the whole change
+  // set, which would lose the earlier update along with it.
+  std::vector<bool> updateOnly(sets.size());
+
+  for (size_t i = 0; i < sets.size(); i++) {
+    auto& changes = sets[i];
+
+    updateOnly[i] =
+        changes->GetInserts().size() == 0 && changes->GetDeletes().size() == 0;
+
+    for (auto& obj : changes->GetInserts()) {
+      if (obj) {
+        pinned.insert(obj->GetUUID());
+      }
+    }
+
+    for (auto& obj : changes->GetDeletes()) {
+      if (obj) {
+        pinned.insert(obj->GetUUID());
+      }
+    }
+
+    auto& last = lastUpdates[changes->GetTransactionUUID()];
+    for (auto& obj : changes->GetUpdates()) {
+      if (obj) {
+        last[obj->GetUUID()] = i;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < sets.size(); i++) {
+    auto& changes = sets[i];
+    auto& last = lastUpdates[changes->GetTransactionUUID()];
+
+    std::list<std::shared_ptr<libcomp::PersistentObject>> updates;
+    std::unordered_set<libobjgen::UUID> written;
+    uint64_t removed = 0;
+
+    for (auto& obj : changes->GetUpdates()) {
+      if (obj && !pinned.count(obj->GetUUID())) {
+        // Skip the update if a later change set with only updates writes
+        // the object again or this one already does
+        auto uuid = obj->GetUUID();
+        bool later = last[uuid] != i && updateOnly[last[uuid]];
+        if (later || !written.insert(uuid).second) {
+          removed++;
+          continue;
+        }
+      }
+
+      updates.push_back(obj);
+    }
+
+    if (!removed) {
+      coalesced.push_back(changes);
+      continue;
+    }
+
+    result.Updates += removed;
+
+    auto inserts = changes->GetInserts();
+    auto deletes = changes->GetDeletes();
+    if (inserts.size() == 0 && updates.size() == 0 && deletes.size() == 0) {
+      // Everything in the change set is written later
+      result.ChangeSets++;
+      continue;
+    }
+
+    auto replacement =
+        libcomp::DatabaseChangeSet::Create(changes->GetTransactionUUID());
+
+    for (auto& obj : inserts) {
+      replacement->Insert(obj);
+    }
+
+    for (auto& obj : updates) {
+      replacement->Update(obj);
+    }
+
+    for (auto& obj : deletes) {
+      replacement->Delete(obj);
+    }
+
+    coalesced.push_back(replacement);
+  }
+}
@@ -0,0 +1,95 @@
+/**
+ * @file server/channel/src/ChangeSetCoalescer.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Collapses redundant updates in a batch of database change sets.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_CHANGESETCOALESCER_H
+#define SERVER_CHANNEL_SRC_CHANGESETCOALESCER_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <list>
+#include <memory>
+
+namespace libcomp {
+class DatabaseChangeSet;
+}  // namespace libcomp
+
+namespace channel {
+
+/**
+ * Collapses updates to the same object within a batch of change sets
+ * before they are handed to a database transaction queue. A standard
+ * update writes the object as it is when the change set is processed, so
+ * when the same object is updated by several change sets in the batch
+ * only the last update needs to be written. Updates are only collapsed
+ * between change sets for the same account so failures are still reported
+ * for the right account, and only into a later change set that has
+ * nothing but updates so an insert or delete rolling it back cannot take
+ * the earlier update with it. Objects inserted or deleted anywhere in a
+ * stretch of the batch are left alone, and operational change sets, which
+ * can hold explicit updates that depend on the values already saved, end a
+ * stretch so nothing is collapsed across them.
+ */
+class ChangeSetCoalescer {
+ public:
+  /// Number of writes removed by coalescing a batch
+  struct Result {
+    /// Number of object updates removed
+    uint64_t Updates;
+
+    /// Number of change sets removed entirely because every update in
+    /// them was written by a later change set
+    uint64_t ChangeSets;
+  };
+
+  /**
+   * Coalesce a batch of change sets. Change sets that are not changed are
+   * passed through as is and the order of the batch is kept.
+   * @param batch List of change sets in the order they were queued
+   * @param coalesced Output list of change sets to queue instead
+   * @return Number of updates and change sets removed
+   */
+  static Result Coalesce(
+      const std::list<std::shared_ptr<libcomp::DatabaseChangeSet>>& batch,
+      std::list<std::shared_ptr<libcomp::DatabaseChangeSet>>& coalesced);
+
+ private:
+  /**
+   * Coalesce a stretch of standard change sets with no operational change
+   * sets between them.
+   * @param stretch List of change sets in the order they were queued
+   * @param coalesced Output list to append the change sets to queue to
+   * @param result Result to add the number of removed writes to
+   */
+  static void CoalesceStretch(
+      const std::list<std::shared_ptr<libcomp::DatabaseChangeSet>>& stretch,
+      std::list<std::shared_ptr<libcomp::DatabaseChangeSet>>& coalesced,
+      Result& result);
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_CHANGESETCOALESCER_H
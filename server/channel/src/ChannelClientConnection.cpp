@@ -28,16 +28,39 @@
 
 #include "ChannelServer.h"
 
+// libcomp Includes
+#include <MessagePacket.h>
+
+// Standard C++11 Includes
+#include <iterator>
+
 using namespace channel;
 
+/// Length of each window packets are counted in to calculate the rate
+/// packets are received from a client (10 seconds)
+static const uint64_t PACKET_RATE_WINDOW = 10000000ULL;
+
 ChannelClientConnection::ChannelClientConnection(
     asio::ip::tcp::socket& socket,
     const std::shared_ptr<libcomp::Crypto::DiffieHellman>& diffieHellman)
     : libhack::ChannelConnection(socket, diffieHellman),
       mClientState(std::shared_ptr<ClientState>(new ClientState)),
-      mTimeout(0) {}
+      mTimeout(0),
+      mPacketCount(0),
+      mPacketBytes(0),
+      mPacketWindowStart(0),
+      mPacketWindowCount(0),
+      mLastPacketWindowCount(0),
+      mWorkerIndex(0),
+      mWorkerMoving(false),
+      mWorkerMoveDeferred(false),
+      mDeferredWorkerIndex(0) {}
 
-ChannelClientConnection::~ChannelClientConnection() {}
+ChannelClientConnection::~ChannelClientConnection() {
+  for (auto pMessage : mHeldPackets) {
+    delete pMessage;
+  }
+}
 
 ClientState* ChannelClientConnection::GetClientState() const {
   return mClientState.get();
@@ -55,6 +78,133 @@ void ChannelClientConnection::Kill() {
   Close();
 }
 
+void ChannelClientConnection::RecordPacket(uint64_t now, uint32_t size) {
+  mPacketCount++;
+  mPacketBytes += size;
+
+  uint64_t windowStart = mPacketWindowStart.load(std::memory_order_relaxed);
+  if (now >= windowStart + PACKET_RATE_WINDOW) {
+    // Start a new window, dropping the last one if no packets were received
+    // for an entire window since
+    mLastPacketWindowCount = now < windowStart + PACKET_RATE_WINDOW * 2
+                                 ? mPacketWindowCount.load()
+                                 : 0;
+    mPacketWindowCount = 0;
+    mPacketWindowStart = now;
+  }
+
+  mPacketWindowCount++;
+}
+
+uint64_t ChannelClientConnection::GetPacketCount() const {
+  return mPacketCount;
+}
+
+uint64_t ChannelClientConnection::GetPacketBytes() const {
+  return mPacketBytes;
+}
+
+float ChannelClientConnection::GetPacketRate(uint64_t now) const {
+  uint64_t windowStart = mPacketWindowStart;
+
+  uint32_t count = 0;
+  if (now < windowStart + PACKET_RATE_WINDOW) {
+    count = mLastPacketWindowCount;
+  } else if (now < windowStart + PACKET_RATE_WINDOW * 2) {
+    // The current window has ended but has not been replaced yet
+    count = mPacketWindowCount;
+  }
+
+  return (float)count / (float)(PACKET_RATE_WINDOW / 1000000ULL);
+}
+
+size_t ChannelClientConnection::GetWorkerIndex() const { return mWorkerIndex; }
+
+void ChannelClientConnection::SetWorkerIndex(size_t index) {
+  mWorkerIndex = index;
+}
+
+bool ChannelClientConnection::GetSettledWorkerIndex(size_t& index) {
+  std::lock_guard<std::mutex> lock(mWorkerLock);
+  if (mWorkerMoving) {
+    return false;
+  }
+
+  index = mWorkerIndex;
+
+  return true;
+}
+
+bool ChannelClientConnection::BeginWorkerMove(size_t index) {
+  std::lock_guard<std::mutex> lock(mWorkerLock);
+  if (index == mWorkerIndex) {
+    // Already there or headed there so drop any later move deferred
+    mWorkerMoveDeferred = false;
+
+    return false;
+  } else if (mWorkerMoving || !mHeldPackets.empty()) {
+    // Moving now would let packets held by the last move be handled after
+    // ones the next worker receives so wait until they are handled
+    mWorkerMoveDeferred = true;
+    mDeferredWorkerIndex = index;
+
+    return false;
+  }
+
+  mWorkerMoving = true;
+  mWorkerIndex = index;
+
+  return true;
+}
+
+bool ChannelClientConnection::EndWorkerMove() {
+  std::lock_guard<std::mutex> lock(mWorkerLock);
+  mWorkerMoving = false;
+
+  return mHeldPackets.size() > 0;
+}
+
+bool ChannelClientConnection::HoldPacket(
+    size_t worker, const libcomp::Message::Packet* pMessage) {
+  std::lock_guard<std::mutex> lock(mWorkerLock);
+
+  // Packets still queued on the old worker are handled as normal
+  if (worker != mWorkerIndex || (!mWorkerMoving && mHeldPackets.empty())) {
+    return false;
+  }
+
+  libcomp::ReadOnlyPacket copy(pMessage->GetPacket());
+  mHeldPackets.push_back(new libcomp::Message::Packet(
+      pMessage->GetConnection(), pMessage->GetCommandCode(), copy));
+
+  return true;
+}
+
+libcomp::Message::Packet* ChannelClientConnection::GetHeldPacket() {
+  std::lock_guard<std::mutex> lock(mWorkerLock);
+  return mHeldPackets.empty() ? nullptr : mHeldPackets.front();
+}
+
+void ChannelClientConnection::PopHeldPacket() {
+  std::lock_guard<std::mutex> lock(mWorkerLock);
+  if (!mHeldPackets.empty()) {
+    delete mHeldPackets.front();
+    mHeldPackets.pop_front();
+  }
+}
+
+bool ChannelClientConnection::TakeDeferredWorkerMove(size_t& index) {
+  std::lock_guard<std::mutex> lock(mWorkerLock);
+  if (!mWorkerMoveDeferred) {
+    return false;
+  }
+
+  mWorkerMoveDeferred = false;
+  index = mDeferredWorkerIndex;
+
+  return true;
+}
+
 void ChannelClientConnection::BroadcastPacket(
     const std::list<std::shared_ptr<ChannelClientConnection>>& clients,
     libcomp::Packet& packet, bool queue) {
@@ -94,19 +244,35 @@ void ChannelClientConnection::FlushAllOutgoing(
 void ChannelClientConnection::SendRelativeTimePacket(
     const std::list<std::shared_ptr<ChannelClientConnection>>& clients,
     libcomp::Packet& packet, const RelativeTimeMap& timeMap, bool queue) {
-  for (auto client : clients) {
-    libcomp::Packet pCopy(packet);
+  if (clients.size() == 0) {
+    return;
+  }
 
+  // Patch the time fields directly into the encoded packet for each client.
+  // Every client but the last needs its own copy as the send queue takes
+  // ownership of the packet, the last one takes the original.
+  auto last = std::prev(clients.end());
+  for (auto it = clients.begin(); it != clients.end(); it++) {
+    auto client = *it;
     auto state = client->GetClientState();
     for (auto tPair : timeMap) {
-      pCopy.Seek(tPair.first);
-      pCopy.WriteFloat(state->ToClientTime(tPair.second));
+      packet.Seek(tPair.first);
+      packet.WriteFloat(state->ToClientTime(tPair.second));
     }
 
-    if (queue) {
-      client->QueuePacket(pCopy);
+    if (it == last) {
+      if (queue) {
+        client->QueuePacket(packet);
+      } else {
+        client->SendPacket(packet);
+      }
     } else {
-      client->SendPacket(pCopy);
+      libcomp::Packet pCopy(packet);
+      if (queue) {
+        client->QueuePacket(pCopy);
+      } else {
+        client->SendPacket(pCopy);
+      }
     }
   }
 }
@@ -33,6 +33,17 @@
 // libcomp Includes
 #include <ChannelConnection.h>
 
+// Standard C++11 Includes
+#include <atomic>
+#include <list>
+#include <mutex>
+
+namespace libcomp {
+namespace Message {
+class Packet;
+}  // namespace Message
+}  // namespace libcomp
+
 namespace channel {
 
 typedef std::unordered_map<uint32_t, uint64_t> RelativeTimeMap;
@@ -83,6 +94,104 @@ class ChannelClientConnection : public libhack::ChannelConnection {
    */
   void Kill();
 
+  /**
+   * Count a packet received from the client. Only called by the worker
+   * the connection is assigned to.
+   * @param now Current server time
+   * @param size Size of the packet in bytes
+   */
+  void RecordPacket(uint64_t now, uint32_t size);
+
+  /**
+   * Get the number of packets received from the client.
+   * @return Number of packets received
+   */
+  uint64_t GetPacketCount() const;
+
+  /**
+   * Get the number of packet bytes received from the client.
+   * @return Number of packet bytes received
+   */
+  uint64_t GetPacketBytes() const;
+
+  /**
+   * Get the rate packets were received from the client over the last
+   * complete sample window.
+   * @param now Current server time
+   * @return Packets received per second
+   */
+  float GetPacketRate(uint64_t now) const;
+
+  /**
+   * Get the index of the worker that handles packets from the client.
+   * @return Index of the worker
+   */
+  size_t GetWorkerIndex() const;
+
+  /**
+   * Set the index of the worker that handles packets from the client.
+   * Only used when the connection is first assigned a worker.
+   * @param index Index of the worker
+   */
+  void SetWorkerIndex(size_t index);
+
+  /**
+   * Get the index of the worker that handles packets from the client if
+   * the client is not being moved between workers.
+   * @param index Output parameter set to the index of the worker
+   * @return true if the client is not being moved and the index was set
+   */
+  bool GetSettledWorkerIndex(size_t& index);
+
+  /**
+   * Start moving the client to another worker. Until EndWorkerMove is
+   * called, packets received by the new worker are held. If the client is
+   * already being moved or packets held by the last move have not all been
+   * handled yet, the move is deferred until TakeDeferredWorkerMove.
+   * @param index Index of the worker to move to
+   * @return true if the move started, false if it was deferred or the
+   *  client is already on or moving to the worker
+   */
+  bool BeginWorkerMove(size_t index);
+
+  /**
+   * Finish moving the client to another worker once the old worker has
+   * handled everything queued before the move.
+   * @return true if packets were held during the move and need to be
+   *  handled by the new worker
+   */
+  bool EndWorkerMove();
+
+  /**
+   * Hold a packet received by the client's worker while the client is
+   * being moved to it or while earlier packets are still held. The
+   * packet is copied so the original message can be cleaned up.
+   * @param worker Index of the worker that received the packet
+   * @param pMessage Packet message received
+   * @return true if the packet was held and should not be handled now
+   */
+  bool HoldPacket(size_t worker, const libcomp::Message::Packet* pMessage);
+
+  /**
+   * Get the oldest held packet. The packet stays held, so newer packets
+   * keep being held and the client is not moved again, until it is
+   * removed with PopHeldPacket.
+   * @return Pointer to the packet message or null if none are held
+   */
+  libcomp::Message::Packet* GetHeldPacket();
+
+  /**
+   * Remove and delete the oldest held packet once it has been handled.
+   */
+  void PopHeldPacket();
+
+  /**
+   * Take the worker a move was deferred to by BeginWorkerMove, if any.
+   * @param index Output parameter set to the index of the worker
+   * @return true if a move was deferred and the index was set
+   */
+  bool TakeDeferredWorkerMove(size_t& index);
+
   /**
    * Broadcast the supplied packet to each client connection in the list.
    * @param clients List of client connections to send the packet to
@@ -114,6 +223,9 @@ class ChannelClientConnection : public libhack::ChannelConnection {
   /**
    * Send (or queue) a packet to a list of client connections. Server
    * tick times are converted to relative client times before sending.
+   * The packet is only encoded once and only the time fields are
+   * rewritten per client. The supplied packet is handed off to the last
+   * client and should not be used afterwards.
    * @param clients List of client connections to send the packet to
    * @param packet Packet to send to the supplied clients
    * @param timeMap Map of packet positions to server times to transform
@@ -131,6 +243,39 @@ class ChannelClientConnection : public libhack::ChannelConnection {
   /// Server timestamp used to disconnect the client should it pass
   /// without refreshing beforehand.
   uint64_t mTimeout;
+
+  /// Number of packets received from the client
+  std::atomic<uint64_t> mPacketCount;
+
+  /// Number of packet bytes received from the client
+  std::atomic<uint64_t> mPacketBytes;
+
+  /// Server time the current packet rate sample window started at
+  std::atomic<uint64_t> mPacketWindowStart;
+
+  /// Number of packets received in the current sample window
+  std::atomic<uint32_t> mPacketWindowCount;
+
+  /// Number of packets received in the last complete sample window
+  std::atomic<uint32_t> mLastPacketWindowCount;
+
+  /// Index of the worker that handles packets from the client
+  std::atomic<size_t> mWorkerIndex;
+
+  /// true while the client is being moved to another worker
+  bool mWorkerMoving;
+
+  /// Packets held by the new worker while the client is being moved
+  std::list<libcomp::Message::Packet*> mHeldPackets;
+
+  /// true if a move was requested before the last one finished
+  bool mWorkerMoveDeferred;
+
+  /// Index of the worker the deferred move is to
+  size_t mDeferredWorkerIndex;
+
+  /// Lock for moving the client between workers and the held packets
+  std::mutex mWorkerLock;
 };
 
 static inline ClientState* state(
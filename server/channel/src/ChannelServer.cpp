@@ -31,6 +31,8 @@
 #include <DefinitionManager.h>
 #include <Log.h>
 #include <ManagerSystem.h>
+#include <MappedFile.h>
+#include <MemoryStream.h>
 #include <MessageTick.h>
 #include <PacketCodes.h>
 #include <ScriptEngine.h>
@@ -47,8 +49,10 @@
 #include "ActionManager.h"
 #include "ChannelClientConnection.h"
 #include "ChannelSyncManager.h"
+#include "CharacterCheckpointer.h"
 #include "CharacterManager.h"
 #include "ChatManager.h"
+#include "ClientWorkerRouter.h"
 #include "EventManager.h"
 #include "FusionManager.h"
 #include "ManagerClientPacket.h"
@@ -56,12 +60,28 @@
 #include "MatchManager.h"
 #include "Packets.h"
 #include "PerformanceTimer.h"
+#include "PersistenceWorker.h"
+#include "SaveTracker.h"
+#include "ServerDataReloader.h"
 #include "SkillManager.h"
+#include "TickRecorder.h"
 #include "TokuseiManager.h"
 #include "ZoneManager.h"
 
+// Standard C Includes
+#include <cstdio>
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <fstream>
+#include <random>
+
 using namespace channel;
 
+/// Number of low bits of a ServerTime ignored when placing scheduled work
+/// into the timing wheel, making each slot cover roughly one millisecond
+static const uint8_t SCHEDULE_RESOLUTION_BITS = 10;
+
 namespace libcomp {
 template <>
 BaseScriptEngine& BaseScriptEngine::Using<ChannelServer>() {
@@ -106,6 +126,7 @@ ChannelServer::ChannelServer(
     const char* szProgram, std::shared_ptr<objects::ServerConfig> config,
     std::shared_ptr<libcomp::ServerCommandLineParser> commandLine)
     : libhack::Server(szProgram, config, commandLine),
+      mScheduledWork(GetServerTime(), SCHEDULE_RESOLUTION_BITS),
       mAccountManager(0),
       mActionManager(0),
       mAIManager(0),
@@ -118,10 +139,16 @@ ChannelServer::ChannelServer(
       mZoneManager(0),
       mDefinitionManager(0),
       mServerDataManager(0),
+      mPersistenceWorker(0),
+      mTickRecorder(0),
+      mCheckpointer(0),
+      mServerDataReloader(0),
+      mClientRouter(0),
       mRecalcTimeDependents(false),
       mMaxEntityID(0),
       mMaxObjectID(0),
       mTicksPending(0),
+      mNextMetricsReport(0),
       mTickRunning(true) {}
 
 bool ChannelServer::Initialize() {
@@ -145,20 +172,68 @@ bool ChannelServer::Initialize() {
   auto conf = std::dynamic_pointer_cast<objects::ChannelConfig>(mConfig);
 
   mDefinitionManager = new libhack::DefinitionManager();
+  mDefinitionManager->SetSharedStoreName(conf->GetSharedDataStoreName());
   if (!mDefinitionManager->LoadAllData(GetDataStore())) {
     return false;
   }
 
-  mServerDataManager = new libhack::ServerDataManager();
-  if (!mServerDataManager->LoadData(GetDataStore(), mDefinitionManager)) {
-    return false;
+  auto serverDataManager = new libhack::ServerDataManager();
+  mServerDataManager = serverDataManager;
+
+  // Load the server data from the snapshot if it was saved from the same
+  // files, otherwise load it all and save a new snapshot
+  libcomp::String snapshotPath = conf->GetServerDataSnapshotPath();
+  uint64_t contentHash = 0;
+  bool snapshotLoaded = false;
+  if (!snapshotPath.IsEmpty()) {
+    contentHash = libhack::ServerDataManager::GetContentHash(
+        GetDataStore(), mDefinitionManager);
+
+    // Map the snapshot so it is read without copying it into memory first
+    libhack::MappedFile snapshot;
+    if (snapshot.Open(snapshotPath)) {
+      libhack::MemoryInStream in(snapshot.GetData(), snapshot.GetSize());
+      snapshotLoaded = serverDataManager->LoadSnapshot(
+          in, contentHash, mDefinitionManager, conf->GetVerifyServerData());
+    }
   }
 
-  if (conf->GetVerifyServerData()) {
-    LogGeneralDebugMsg("Verifying server data integrity...\n");
-    if (!mServerDataManager->VerifyDataIntegrity(mDefinitionManager)) {
+  if (!snapshotLoaded) {
+    if (!serverDataManager->LoadData(GetDataStore(), mDefinitionManager)) {
       return false;
     }
+
+    if (conf->GetVerifyServerData()) {
+      LogGeneralDebugMsg("Verifying server data integrity...\n");
+      if (!serverDataManager->VerifyDataIntegrity(mDefinitionManager)) {
+        return false;
+      }
+    }
+
+    if (!snapshotPath.IsEmpty()) {
+      // Write to a temporary file and rename it into place so another
+      // channel never maps a partially written snapshot
+      std::random_device rd;
+      auto tempPath =
+          libcomp::String("%1.%2.tmp").Arg(snapshotPath).Arg((uint32_t)rd());
+
+      std::ofstream out(tempPath.C(),
+                        std::ios::out | std::ios::binary | std::ios::trunc);
+
+      bool saved = out.good() && serverDataManager->SaveSnapshot(
+                                     out, contentHash, mDefinitionManager,
+                                     conf->GetVerifyServerData());
+      out.close();
+
+      if (!saved || !libhack::MappedFile::Replace(tempPath, snapshotPath)) {
+        LogGeneralWarning([&]() {
+          return libcomp::String("Failed to save server data snapshot: %1\n")
+              .Arg(snapshotPath);
+        });
+
+        std::remove(tempPath.C());
+      }
+    }
   }
 
   mManagerConnection = std::make_shared<ManagerConnection>(self);
@@ -731,6 +806,10 @@ bool ChannelServer::Initialize() {
     worker->AddManager(mManagerConnection);
   }
 
+  // Client connections are sharded across the generic workers
+  mClientRouter = new ClientWorkerRouter(mWorkers, clientPacketManager,
+                                         conf->GetZoneWorkerAffinity());
+
   auto channelPtr = std::dynamic_pointer_cast<ChannelServer>(self);
   mAccountManager = new AccountManager(channelPtr);
   mActionManager = new ActionManager(channelPtr);
@@ -750,6 +829,23 @@ bool ChannelServer::Initialize() {
 
   mZoneManager = new ZoneManager(channelPtr);
 
+  mPersistenceWorker =
+      new PersistenceWorker(channelPtr, conf->GetDatabaseBatchSize(),
+                            conf->GetDatabaseBatchLatency());
+
+  if (conf->GetTickBudget()) {
+    mTickRecorder = new TickRecorder(conf->GetTickRecorderSize(),
+                                     (uint64_t)conf->GetTickBudget() * 1000ULL,
+                                     conf->GetTickRecorderPath());
+  }
+
+  if (conf->GetCheckpointInterval()) {
+    mCheckpointer =
+        new CharacterCheckpointer(channelPtr, conf->GetCheckpointInterval());
+  }
+
+  mServerDataReloader = new ServerDataReloader(channelPtr);
+
   // Now connect to the world server.
   auto worldConnection =
       std::make_shared<libcomp::InternalConnection>(mService);
@@ -769,12 +865,16 @@ bool ChannelServer::Initialize() {
     return false;
   }
 
-  return true;
+  return StartMetricsServer(conf->GetMetricsPort(), "comphack_channel");
 }
 
 void ChannelServer::Shutdown() {
   mTickRunning = false;
 
+  if (mPersistenceWorker) {
+    mPersistenceWorker->Shutdown();
+  }
+
   BaseServer::Shutdown();
 }
 
@@ -793,6 +893,21 @@ ChannelServer::~ChannelServer() {
     mTickThread.join();
   }
 
+  std::list<libcomp::Message::Execute*> unscheduled;
+  {
+    std::lock_guard<std::mutex> lock(mScheduleLock);
+    mScheduledWork.Clear(unscheduled);
+  }
+
+  for (auto msg : unscheduled) {
+    delete msg;
+  }
+
+  delete mPersistenceWorker;
+  delete mTickRecorder;
+  delete mCheckpointer;
+  delete mServerDataReloader;
+  delete mClientRouter;
   delete mAccountManager;
   delete mActionManager;
   delete mAIManager;
@@ -806,7 +921,7 @@ ChannelServer::~ChannelServer() {
   delete mTokuseiManager;
   delete mZoneManager;
   delete mDefinitionManager;
-  delete mServerDataManager;
+  delete mServerDataManager.load();
 }
 
 ServerTime ChannelServer::GetServerTime() { return sGetServerTime(); }
@@ -922,6 +1037,95 @@ void ChannelServer::SetLobbyDatabase(
   mLobbyDatabase = database;
 }
 
+bool ChannelServer::QueueWorldChangeSet(
+    const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+    const std::list<libobjgen::UUID>& otherAccounts) {
+  // Anything written for a client is not known to be saved until the
+  // persistence worker commits it
+  auto trackers = GetChangeSetSaveTrackers(changes, otherAccounts);
+  if (!trackers.empty()) {
+    for (auto& obj : SaveTracker::GetWrites(changes)) {
+      for (auto& tracker : trackers) {
+        tracker->BeginWrite(obj->GetUUID());
+      }
+    }
+  }
+
+  return mPersistenceWorker->QueueWorldChangeSet(changes, trackers);
+}
+
+bool ChannelServer::ProcessWorldChangeSet(
+    const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+    const std::list<libobjgen::UUID>& otherAccounts) {
+  if (!mWorldDatabase->ProcessChangeSet(changes)) {
+    return false;
+  }
+
+  auto trackers = GetChangeSetSaveTrackers(changes, otherAccounts);
+  if (!trackers.empty()) {
+    for (auto& obj : SaveTracker::GetWrites(changes)) {
+      for (auto& tracker : trackers) {
+        tracker->Mark(obj);
+      }
+    }
+  }
+
+  return true;
+}
+
+std::list<std::shared_ptr<SaveTracker>>
+ChannelServer::GetChangeSetSaveTrackers(
+    const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+    const std::list<libobjgen::UUID>& otherAccounts) {
+  std::list<std::shared_ptr<SaveTracker>> trackers;
+  if (!changes) {
+    return trackers;
+  }
+
+  std::list<libobjgen::UUID> accountUUIDs = otherAccounts;
+  accountUUIDs.push_front(changes->GetTransactionUUID());
+  for (auto& accountUUID : accountUUIDs) {
+    auto tracker = GetAccountSaveTracker(accountUUID);
+    if (tracker && std::find(trackers.begin(), trackers.end(), tracker) ==
+                       trackers.end()) {
+      trackers.push_back(tracker);
+    }
+  }
+
+  return trackers;
+}
+
+std::shared_ptr<SaveTracker> ChannelServer::GetAccountSaveTracker(
+    const libobjgen::UUID& accountUUID) {
+  if (accountUUID.IsNull()) {
+    return nullptr;
+  }
+
+  auto account = std::dynamic_pointer_cast<objects::Account>(
+      libcomp::PersistentObject::GetObjectByUUID(accountUUID));
+  if (!account) {
+    return nullptr;
+  }
+
+  auto client = mManagerConnection->GetClientConnection(account->GetUsername());
+  return client ? client->GetClientState()->GetSaveTracker() : nullptr;
+}
+
+bool ChannelServer::QueueLobbyChangeSet(
+    const std::shared_ptr<libcomp::DatabaseChangeSet>& changes) {
+  return mPersistenceWorker->QueueLobbyChangeSet(changes);
+}
+
+PersistenceWorker* ChannelServer::GetPersistenceWorker() const {
+  return mPersistenceWorker;
+}
+
+TickRecorder* ChannelServer::GetTickRecorder() const { return mTickRecorder; }
+
+ClientWorkerRouter* ChannelServer::GetClientWorkerRouter() const {
+  return mClientRouter;
+}
+
 bool ChannelServer::RegisterServer(uint8_t channelID) {
   if (nullptr == mWorldDatabase) {
     return false;
@@ -1005,6 +1209,15 @@ libhack::ServerDataManager* ChannelServer::GetServerDataManager() const {
   return mServerDataManager;
 }
 
+libhack::ServerDataManager* ChannelServer::SwapServerDataManager(
+    libhack::ServerDataManager* serverDataManager) {
+  return mServerDataManager.exchange(serverDataManager);
+}
+
+ServerDataReloader* ChannelServer::GetServerDataReloader() const {
+  return mServerDataReloader;
+}
+
 ChannelSyncManager* ChannelServer::GetChannelSyncManager() const {
   return mSyncManager;
 }
@@ -1029,10 +1242,37 @@ int64_t ChannelServer::GetNextObjectID() {
   return ++mMaxObjectID;
 }
 
+bool ChannelServer::CancelScheduledWork(uint64_t handle) {
+  libcomp::Message::Execute* msg = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mScheduleLock);
+    if (!mScheduledWork.Cancel(handle, msg)) {
+      return false;
+    }
+  }
+
+  delete msg;
+
+  return true;
+}
+
+size_t ChannelServer::GetScheduledWorkCount() {
+  std::lock_guard<std::mutex> lock(mScheduleLock);
+  return mScheduledWork.Count();
+}
+
 void ChannelServer::Tick() {
+  ServerTime queuedTime = 0;
+  uint8_t ticksPending = 0;
   {
     std::lock_guard<std::mutex> lock(mTickLock);
     mTicksPending--;
+    ticksPending = mTicksPending;
+
+    if (mTickQueueTimes.size() > 0) {
+      queuedTime = mTickQueueTimes.front();
+      mTickQueueTimes.pop_front();
+    }
   }
 
   ServerTime tickTime = GetServerTime();
@@ -1044,78 +1284,130 @@ void ChannelServer::Tick() {
   // Performance timer for a tick task.
   PerformanceTimer perf(this);
 
+  TickRecorder::TickRecord* tickRecord =
+      mTickRecorder ? mTickRecorder->BeginTick(tickTime) : nullptr;
+  if (tickRecord) {
+    tickRecord->TicksPending = ticksPending;
+  }
+
+  // Time spent waiting behind other work in the queue worker
+  if (queuedTime && tickTime > queuedTime) {
+    perf.Record("TickQueueLag", tickTime - queuedTime);
+
+    if (tickRecord) {
+      tickRecord->QueueLag = tickTime - queuedTime;
+    }
+  }
+
+  perf.Report("TicksPending", ticksPending);
+  perf.Report("ClientConnections",
+              (uint64_t)mManagerConnection->GetConnectionCount());
+
+  // Swap in reloaded server data before any zone is updated this tick
+  if (mServerDataReloader) {
+    perf.Start();
+    if (mServerDataReloader->Tick()) {
+      perf.Stop("ServerDataReload");
+    }
+  }
+
+  // Update reloaded zones that were waiting for their players to leave
+  mZoneManager->ApplyPendingZoneDefinitions();
+
   // Update the active zone states
   perf.Start();
   mZoneManager->UpdateActiveZoneStates();
   perf.Stop("UpdateActiveZoneStates");
 
-  // Process queued world database changes
+  // Retrieve accounts with queued database changes that failed to save
+  // since the last tick
   perf.Start();
-  auto worldFailures = mWorldDatabase->ProcessTransactionQueue();
-  perf.Stop("WorldDatabaseTransactions");
+  auto failures = mPersistenceWorker->TakeFailures();
+  ServerTime dbTime = perf.Stop("DatabaseTransactions");
 
-  // Process queued lobby database changes
-  perf.Start();
-  auto lobbyFailures = mLobbyDatabase->ProcessTransactionQueue();
-  perf.Stop("LobbyDatabaseTransactions");
+  size_t dbQueueDepth = mPersistenceWorker->GetQueueDepth();
+  perf.Report("DatabaseQueueDepth", (uint64_t)dbQueueDepth);
+  perf.Report("DatabaseQueueLag", mPersistenceWorker->GetQueueLag());
+  perf.Report("InterestFilteredPackets",
+              mZoneManager->GetFilteredPacketCount());
+  perf.Report("InterestFilteredBytes", mZoneManager->GetFilteredByteCount());
 
-  if (worldFailures.size() > 0 || lobbyFailures.size() > 0) {
+  if (failures.size() > 0) {
     // Disconnect any clients associated to failed account updates
-    for (auto failures : {worldFailures, lobbyFailures}) {
-      for (auto failedUUID : failures) {
-        auto account = std::dynamic_pointer_cast<objects::Account>(
-            libcomp::PersistentObject::GetObjectByUUID(failedUUID));
-
-        if (nullptr != account) {
-          auto username = account->GetUsername();
-          auto client = mManagerConnection->GetClientConnection(username);
-          if (nullptr != client) {
-            LogGeneralError([&]() {
-              return libcomp::String(
-                         "Queued updates for client failed to save for "
-                         "account: %1\n")
-                  .Arg(username);
-            });
-
-            client->Close();
-          }
+    for (auto failedUUID : failures) {
+      auto account = std::dynamic_pointer_cast<objects::Account>(
+          libcomp::PersistentObject::GetObjectByUUID(failedUUID));
+
+      if (nullptr != account) {
+        auto username = account->GetUsername();
+        auto client = mManagerConnection->GetClientConnection(username);
+        if (nullptr != client) {
+          LogGeneralError([&]() {
+            return libcomp::String(
+                       "Queued updates for client failed to save for "
+                       "account: %1\n")
+                .Arg(username);
+          });
+
+          // Anything checkpointed may not have saved so make sure it is
+          // all saved again on logout
+          client->GetClientState()->GetSaveTracker()->Clear();
+
+          client->Close();
         }
       }
     }
   }
 
+  // Save changed character data for the online clients that are due
+  if (mCheckpointer) {
+    perf.Start();
+
+    size_t characters = 0;
+    size_t objects = mCheckpointer->Tick(tickTime, characters);
+    perf.Stop("Checkpoint");
+
+    if (characters) {
+      perf.Count("CheckpointCharacters", (uint64_t)characters);
+      perf.Count("CheckpointObjects", (uint64_t)objects);
+    }
+  }
+
   perf.Start();
-  std::map<ServerTime, std::list<libcomp::Message::Execute*>> schedule;
+  std::list<libcomp::Message::Execute*> schedule;
+  size_t scheduleDepth = 0;
   {
-    std::lock_guard<std::mutex> lock(mLock);
+    std::lock_guard<std::mutex> lock(mScheduleLock);
 
     // Retrieve all work scheduled for the current time or before
-    for (auto it = mScheduledWork.begin(); it != mScheduledWork.end(); it++) {
-      if (it->first <= tickTime) {
-        schedule[it->first] = it->second;
-      } else {
-        break;
-      }
-    }
-
-    // Clear all scheduled work retrieved from the member map
-    for (auto it = schedule.begin(); it != schedule.end(); it++) {
-      mScheduledWork.erase(it->first);
-    }
+    mScheduledWork.Advance(tickTime, schedule);
+    scheduleDepth = mScheduledWork.Count();
   }
 
   // Queue any work that has been scheduled
   if (schedule.size() > 0) {
     auto queue = mQueueWorker.GetMessageQueue();
-    for (auto it = schedule.begin(); it != schedule.end(); it++) {
-      for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++) {
-        queue->Enqueue(*it2);
-      }
+    for (auto msg : schedule) {
+      queue->Enqueue(msg);
     }
   }
-  perf.Stop("ScheduleWork");
+  ServerTime scheduleTime = perf.Stop("ScheduleWork");
+  perf.Report("ScheduleWorkDepth", (uint64_t)scheduleDepth);
+
+  ServerTime tickDuration = tickPerf.Stop("Tick");
 
-  tickPerf.Stop("Tick");
+  if (tickRecord) {
+    tickRecord->DatabaseQueueDepth = (uint64_t)dbQueueDepth;
+    tickRecord->ScheduleWorkDepth = (uint64_t)scheduleDepth;
+    tickRecord->Phases[(size_t)TickRecorder::Phase::DATABASE_TRANSACTIONS] =
+        dbTime;
+    tickRecord->Phases[(size_t)TickRecorder::Phase::SCHEDULE_WORK] =
+        scheduleTime;
+
+    mTickRecorder->EndTick(tickDuration);
+  }
+
+  ReportMetrics(tickTime);
 }
 
 void ChannelServer::StartGameTick() {
@@ -1130,6 +1422,9 @@ void ChannelServer::StartGameTick() {
         const static int TICK_DELTA = 100;
         auto tickDelta = std::chrono::milliseconds(TICK_DELTA);
 
+        // Performance timer to count missed ticks.
+        PerformanceTimer perf(this);
+
         int32_t ticksMissed = 0;
         int32_t tickCounter = 0;
         while (*pTickRunning) {
@@ -1145,9 +1440,11 @@ void ChannelServer::StartGameTick() {
                 // given point guarantees the queueing mechanism is
                 // not to blame for missed ticks.
                 queue->Enqueue(new libcomp::Message::Tick);
+                mTickQueueTimes.push_back(GetServerTime());
                 mTicksPending++;
               } else {
                 ticksMissed++;
+                perf.Count("TicksMissed");
               }
             }
 
@@ -1209,6 +1506,53 @@ int32_t ChannelServer::GetPAttributeDeadline() {
   return deadline;
 }
 
+void ChannelServer::ReportMetrics(ServerTime now) {
+  auto conf = std::dynamic_pointer_cast<objects::ChannelConfig>(GetConfig());
+  if (!conf->GetPerfMonitorEnabled() || now < mNextMetricsReport) {
+    return;
+  }
+
+  bool first = mNextMetricsReport == 0;
+
+  uint16_t interval = conf->GetPerfMonitorInterval();
+  mNextMetricsReport = now + (ServerTime)(interval ? interval : 1) * 1000000ULL;
+
+  // Always take the snapshot so the first report only covers one interval
+  auto snapshot = GetMetrics()->GetInterval();
+  if (first) {
+    return;
+  }
+
+  for (auto& pair : snapshot.Histograms) {
+    auto& summary = pair.second;
+    LogGeneralDebug([&]() {
+      return libcomp::String(
+                 "PERF: %1 p50 %2 us, p99 %3 us, max %4 us (%5 samples)\n")
+          .Arg(libcomp::String(pair.first))
+          .Arg(summary.P50)
+          .Arg(summary.P99)
+          .Arg(summary.Max)
+          .Arg(summary.Count);
+    });
+  }
+
+  for (auto& pair : snapshot.Counters) {
+    LogGeneralDebug([&]() {
+      return libcomp::String("PERF: %1 increased by %2\n")
+          .Arg(libcomp::String(pair.first))
+          .Arg(pair.second);
+    });
+  }
+
+  for (auto& pair : snapshot.Gauges) {
+    LogGeneralDebug([&]() {
+      return libcomp::String("PERF: %1 at %2\n")
+          .Arg(libcomp::String(pair.first))
+          .Arg(pair.second);
+    });
+  }
+}
+
 uint32_t ChannelServer::GetTimeUntilMidnight() {
   auto clock = GetWorldClockTime();
 
@@ -1240,6 +1584,9 @@ void ChannelServer::ScheduleRecurringActions() {
       (int)(next ? next : DAY_SEC),
       [](ChannelServer* pServer) { pServer->HandleDemonQuestReset(); }, this);
 
+  // Start saving queued database changes
+  mPersistenceWorker->Start();
+
   // Start the tick handler
   StartGameTick();
 
@@ -1313,6 +1660,7 @@ void ChannelServer::HandleClockEvents() {
 void ChannelServer::HandleDemonQuestReset() {
   uint32_t now = (uint32_t)time(0);
   auto dbChanges = libcomp::DatabaseChangeSet::Create();
+  std::list<libobjgen::UUID> accountUIDs;
   bool updated = false;
 
   // Get all currently logged in characters and reset their demon quests
@@ -1325,12 +1673,14 @@ void ChannelServer::HandleDemonQuestReset() {
         return libcomp::String("Resetting demon quests for account: %1\n")
             .Arg(state->GetAccountUID().ToString());
       });
+
+      accountUIDs.push_back(state->GetAccountUID());
     }
 
     updated = true;
   }
 
-  if (updated && !GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+  if (updated && !ProcessWorldChangeSet(dbChanges, accountUIDs)) {
     LogGeneralErrorMsg(
         "Failed to save daily demon quest resets on one or more "
         "character(s)\n");
@@ -1347,12 +1697,15 @@ std::shared_ptr<libcomp::TcpConnection> ChannelServer::CreateConnection(
     asio::ip::tcp::socket& socket) {
   static int connectionID = 0;
 
+  int id = connectionID++;
+
   auto connection = std::make_shared<channel::ChannelClientConnection>(
       socket, LoadDiffieHellman(GetDiffieHellman()->GetPrime()));
   connection->SetServerConfig(mConfig);
-  connection->SetName(libcomp::String("client:%1").Arg(connectionID++));
+  connection->SetName(libcomp::String("client:%1").Arg(id));
 
-  if (AssignMessageQueue(connection)) {
+  // Every packet from the client is handled by the same worker
+  if (mClientRouter->Assign(connection, (uint64_t)id)) {
     // Make sure this is called after connecting.
     connection->ConnectionSuccess();
 
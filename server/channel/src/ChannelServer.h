@@ -40,13 +40,21 @@
 #include <RegisteredWorld.h>
 
 // channel Includes
+#include "TimerWheel.h"
 #include "WorldClock.h"
 
+// Standard C++11 Includes
+#include <atomic>
+
 namespace libhack {
 class DefinitionManager;
 class ServerDataManager;
 }  // namespace libhack
 
+namespace libcomp {
+class DatabaseChangeSet;
+}  // namespace libcomp
+
 namespace objects {
 class Character;
 class WorldSharedConfig;
@@ -61,12 +69,18 @@ class AccountManager;
 class ActionManager;
 class AIManager;
 class ChannelSyncManager;
+class CharacterCheckpointer;
 class CharacterManager;
 class ChatManager;
+class ClientWorkerRouter;
 class EventManager;
 class FusionManager;
 class MatchManager;
+class PersistenceWorker;
+class SaveTracker;
+class ServerDataReloader;
 class SkillManager;
+class TickRecorder;
 class TokuseiManager;
 class ZoneManager;
 
@@ -203,6 +217,63 @@ class ChannelServer : public libhack::Server {
    */
   void SetLobbyDatabase(const std::shared_ptr<libcomp::Database>& database);
 
+  /**
+   * Queue changes to be saved to the world database by the persistence
+   * worker instead of right away. The changes belong to the account set as
+   * their transaction UUID and any other accounts supplied. The save
+   * tracker of each of these accounts that is connected is updated once
+   * the changes are committed.
+   * @param changes Pointer to the changes to save
+   * @param otherAccounts UUIDs of other accounts whose objects are also
+   *  written by the changes
+   * @return true if the changes were queued, false if they were not
+   */
+  bool QueueWorldChangeSet(
+      const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+      const std::list<libobjgen::UUID>& otherAccounts = {});
+
+  /**
+   * Save changes to the world database right away. The changes belong to
+   * the account set as their transaction UUID and any other accounts
+   * supplied. The save tracker of each of these accounts that is connected
+   * is updated with the state that was saved.
+   * @param changes Pointer to the changes to save
+   * @param otherAccounts UUIDs of other accounts whose objects are also
+   *  written by the changes
+   * @return true if the changes were saved, false if they were not
+   */
+  bool ProcessWorldChangeSet(
+      const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+      const std::list<libobjgen::UUID>& otherAccounts = {});
+
+  /**
+   * Queue changes to be saved to the lobby database by the persistence
+   * worker instead of right away.
+   * @param changes Pointer to the changes to save
+   * @return true if the changes were queued, false if they were not
+   */
+  bool QueueLobbyChangeSet(
+      const std::shared_ptr<libcomp::DatabaseChangeSet>& changes);
+
+  /**
+   * Get a pointer to the worker saving queued database changes.
+   * @return Pointer to the PersistenceWorker
+   */
+  PersistenceWorker* GetPersistenceWorker() const;
+
+  /**
+   * Get a pointer to the tick flight recorder.
+   * @return Pointer to the TickRecorder or null if TickBudget is not set
+   */
+  TickRecorder* GetTickRecorder() const;
+
+  /**
+   * Get a pointer to the router that assigns client connections to the
+   * workers that handle their packets.
+   * @return Pointer to the ClientWorkerRouter
+   */
+  ClientWorkerRouter* GetClientWorkerRouter() const;
+
   /**
    * Register the channel with the lobby database.
    * @param channelID Channel ID from the world to register with
@@ -288,6 +359,21 @@ class ChannelServer : public libhack::Server {
    */
   libhack::ServerDataManager* GetServerDataManager() const;
 
+  /**
+   * Replace the server data manager with one that has been reloaded. The
+   * replaced manager is not freed as other threads may still be using it.
+   * @param serverDataManager Pointer to the new ServerDataManager
+   * @return Pointer to the replaced ServerDataManager
+   */
+  libhack::ServerDataManager* SwapServerDataManager(
+      libhack::ServerDataManager* serverDataManager);
+
+  /**
+   * Get a pointer to the server data reloader.
+   * @return Pointer to the ServerDataReloader
+   */
+  ServerDataReloader* GetServerDataReloader() const;
+
   /**
    * Get a pointer to the data sync manager.
    * @return Pointer to the ChannelSyncManager
@@ -415,16 +501,74 @@ class ChannelServer : public libhack::Server {
    */
   template <typename Function, typename... Args>
   bool ScheduleWork(ServerTime timestamp, Function&& f, Args&&... args) {
+    return ScheduleCancellableWork(timestamp, std::forward<Function>(f),
+                                   std::forward<Args>(args)...) != 0;
+  }
+
+  /**
+   * Schedule code work to be queued by the next server tick that occurs
+   * following the specified time and return a handle that can be used to
+   * cancel it before then.
+   * @param timestamp ServerTime timestamp that needs to pass for the
+   *  specified work to be processed
+   * @param f Function (lambda) to execute
+   * @param args Arguments to pass to the function when it is executed
+   * @return Handle to the scheduled work to use with CancelScheduledWork
+   */
+  template <typename Function, typename... Args>
+  uint64_t ScheduleCancellableWork(ServerTime timestamp, Function&& f,
+                                   Args&&... args) {
     auto msg = new libcomp::Message::ExecuteImpl<Args...>(
         std::forward<Function>(f), std::forward<Args>(args)...);
 
-    std::lock_guard<std::mutex> lock(mLock);
-    mScheduledWork[timestamp].push_back(msg);
-
-    return true;
+    std::lock_guard<std::mutex> lock(mScheduleLock);
+    return mScheduledWork.Schedule(timestamp, msg);
   }
 
+  /**
+   * Cancel work scheduled via ScheduleCancellableWork that has not been
+   * queued yet.
+   * @param handle Handle returned when the work was scheduled
+   * @return true if the work was cancelled, false if it was already
+   *  queued or does not exist
+   */
+  bool CancelScheduledWork(uint64_t handle);
+
+  /**
+   * Get the number of scheduled work entries that have not been queued yet.
+   * @return Number of scheduled work entries waiting on their time
+   */
+  size_t GetScheduledWorkCount();
+
  protected:
+  /**
+   * Get the save tracker of the client logged in to an account.
+   * @param accountUUID UUID of the account
+   * @return Pointer to the client's save tracker or null if the account
+   *  is not logged in to this channel
+   */
+  std::shared_ptr<SaveTracker> GetAccountSaveTracker(
+      const libobjgen::UUID& accountUUID);
+
+  /**
+   * Get the save trackers of the connected clients a world change set
+   * belongs to.
+   * @param changes Pointer to the changes being saved
+   * @param otherAccounts UUIDs of accounts other than the transaction
+   *  account the changes belong to
+   * @return List of save trackers, one per connected account
+   */
+  std::list<std::shared_ptr<SaveTracker>> GetChangeSetSaveTrackers(
+      const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+      const std::list<libobjgen::UUID>& otherAccounts);
+
+  /**
+   * Log a summary of the performance metrics recorded since the last
+   * summary if the report interval has passed.
+   * @param now Current server time
+   */
+  void ReportMetrics(ServerTime now);
+
   /**
    * Get the number of seconds until midnight of the next day. Useful
    * for scheduling timed events.
@@ -464,9 +608,9 @@ class ChannelServer : public libhack::Server {
    */
   void RecalcNextWorldEventTime();
 
-  /// Timestamp ordered map of prepared Execute messages and timestamps
-  /// associated to when they should be queued following a server tick
-  std::map<ServerTime, std::list<libcomp::Message::Execute*>> mScheduledWork;
+  /// Timing wheel of prepared Execute messages keyed on the ServerTime
+  /// timestamp when they should be queued following a server tick
+  TimerWheel<libcomp::Message::Execute*> mScheduledWork;
 
   /// Map of world clock times to the type of event that will
   /// occur at that time. Types include:
@@ -530,8 +674,25 @@ class ChannelServer : public libhack::Server {
   /// Pointer to the Definition Manager.
   libhack::DefinitionManager* mDefinitionManager;
 
-  /// Pointer to the Server Data Manager.
-  libhack::ServerDataManager* mServerDataManager;
+  /// Pointer to the Server Data Manager, replaced when the server data is
+  /// reloaded.
+  std::atomic<libhack::ServerDataManager*> mServerDataManager;
+
+  /// Pointer to the worker saving queued database changes.
+  PersistenceWorker* mPersistenceWorker;
+
+  /// Pointer to the tick flight recorder or null if it is disabled.
+  TickRecorder* mTickRecorder;
+
+  /// Pointer to the periodic character checkpoint or null if it is
+  /// disabled.
+  CharacterCheckpointer* mCheckpointer;
+
+  /// Pointer to the reloader for changed server data.
+  ServerDataReloader* mServerDataReloader;
+
+  /// Pointer to the router assigning client connections to workers.
+  ClientWorkerRouter* mClientRouter;
 
   /// Data sync manager for the server.
   ChannelSyncManager* mSyncManager;
@@ -566,12 +727,22 @@ class ChannelServer : public libhack::Server {
   /// Thread that queues up tick messages after a delay.
   std::thread mTickThread;
 
+  /// Server times each pending tick message was queued at, used to
+  /// measure how long ticks wait behind other work
+  std::list<ServerTime> mTickQueueTimes;
+
+  /// Server time the next performance metrics summary will be logged at
+  ServerTime mNextMetricsReport;
+
   /// Server lock for shared resources
   std::mutex mLock;
 
   /// Server lock for server time calculation
   std::mutex mTimeLock;
 
+  /// Server lock for scheduled work
+  std::mutex mScheduleLock;
+
   /// Server lock for setting the tick pending indicator
   std::mutex mTickLock;
 
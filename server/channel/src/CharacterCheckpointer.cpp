@@ -0,0 +1,118 @@
+/**
+ * @file server/channel/src/CharacterCheckpointer.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Periodically saves changed character data of online players.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CharacterCheckpointer.h"
+
+// channel Includes
+#include "AccountManager.h"
+#include "ChannelClientConnection.h"
+#include "ChannelServer.h"
+#include "ClientWorkerRouter.h"
+#include "ManagerConnection.h"
+
+using namespace channel;
+
+CharacterCheckpointer::CharacterCheckpointer(
+    const std::weak_ptr<ChannelServer>& server, uint16_t interval)
+    : mServer(server),
+      mInterval((ServerTime)(interval ? interval : 1) * 1000000ULL),
+      mRoundStart(0),
+      mRoundSize(0),
+      mRoundDone(0),
+      mCounts(std::make_shared<Counts>()) {}
+
+CharacterCheckpointer::~CharacterCheckpointer() {}
+
+size_t CharacterCheckpointer::Tick(ServerTime now, size_t& characters) {
+  // Report the checkpoints the client workers finished since last tick
+  characters += mCounts->Characters.exchange(0);
+  size_t queued = mCounts->Objects.exchange(0);
+
+  auto server = mServer.lock();
+  if (!server) {
+    return queued;
+  }
+
+  if (mPending.empty()) {
+    // Wait for the interval to pass before starting the next round
+    if (mRoundStart && now < mRoundStart + mInterval) {
+      return queued;
+    }
+
+    mRoundStart = now;
+    mRoundDone = 0;
+
+    for (auto client : server->GetManagerConnection()->GetAllConnections()) {
+      mPending.push_back(client);
+    }
+
+    mRoundSize = mPending.size();
+  }
+
+  // Work through the same fraction of the round as the fraction of the
+  // interval that has passed, always handling at least one client
+  ServerTime elapsed = now - mRoundStart;
+  size_t due = elapsed >= mInterval
+                   ? mRoundSize
+                   : (size_t)((mRoundSize * elapsed) / mInterval) + 1;
+
+  auto accountManager = server->GetAccountManager();
+  auto router = server->GetClientWorkerRouter();
+  auto counts = mCounts;
+
+  // Clients being moved between workers are retried on a later tick
+  std::list<std::weak_ptr<ChannelClientConnection>> retry;
+  while (mRoundDone < due && !mPending.empty()) {
+    auto client = mPending.front().lock();
+    mPending.pop_front();
+
+    // Clients that disconnected since the round started already saved
+    if (!client) {
+      mRoundDone++;
+      continue;
+    }
+
+    // The character data is only safe to read on the worker that handles
+    // the client's packets since they change it without locking
+    bool scheduled = router->QueueClientWork(
+        client, [accountManager,
+                 counts](std::shared_ptr<ChannelClientConnection> _client) {
+          counts->Objects +=
+              accountManager->CheckpointCharacter(_client->GetClientState());
+          counts->Characters++;
+        });
+
+    if (scheduled) {
+      mRoundDone++;
+    } else {
+      retry.push_back(client);
+    }
+  }
+
+  mPending.splice(mPending.begin(), retry);
+
+  return queued;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file server/channel/src/CharacterCheckpointer.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Periodically saves changed character data of online players.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_CHARACTERCHECKPOINTER_H
+#define SERVER_CHANNEL_SRC_CHARACTERCHECKPOINTER_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <atomic>
+#include <list>
+#include <memory>
+
+namespace channel {
+
+class ChannelClientConnection;
+class ChannelServer;
+
+#ifndef ServerTime
+typedef uint64_t ServerTime;
+#endif  // ServerTime
+
+/**
+ * Write-behind checkpoint of the character data of online players. Every
+ * interval a new round starts with every client connected at the time and
+ * the round is worked through a few clients per tick so the saves are
+ * spread evenly across the interval instead of happening all at once.
+ * Only objects that have changed since they were last saved are queued
+ * and they are committed by the persistence worker like any other change
+ * set. Only the tick thread uses the checkpointer but each character is
+ * checkpointed on the worker that handles its client's packets, since
+ * those change the character data without locking.
+ */
+class CharacterCheckpointer {
+ public:
+  /**
+   * Create the checkpointer.
+   * @param server Pointer back to the channel server this belongs to
+   * @param interval Number of seconds each round of saves is spread over
+   */
+  CharacterCheckpointer(const std::weak_ptr<ChannelServer>& server,
+                        uint16_t interval);
+
+  /**
+   * Clean up the checkpointer.
+   */
+  ~CharacterCheckpointer();
+
+  /**
+   * Queue checkpoints for the clients in the current round that are due
+   * by the current time, starting a new round if the last one is done and
+   * the interval has passed.
+   * @param now Current server time
+   * @param characters Output parameter incremented by the number of
+   *  characters checkpointed by the client workers since the last tick
+   * @return Number of objects the client workers queued to be saved
+   *  since the last tick
+   */
+  size_t Tick(ServerTime now, size_t& characters);
+
+ private:
+  /**
+   * Checkpoint totals updated by the client workers.
+   */
+  struct Counts {
+    /// Number of characters checkpointed
+    std::atomic<size_t> Characters{0};
+
+    /// Number of objects queued to be saved
+    std::atomic<size_t> Objects{0};
+  };
+
+  /// Pointer to the channel server
+  std::weak_ptr<ChannelServer> mServer;
+
+  /// Clients in the current round that have not been checkpointed yet
+  std::list<std::weak_ptr<ChannelClientConnection>> mPending;
+
+  /// Number of microseconds each round is spread over
+  ServerTime mInterval;
+
+  /// Server time the current round started at, 0 before the first round
+  ServerTime mRoundStart;
+
+  /// Number of clients in the current round
+  size_t mRoundSize;
+
+  /// Number of clients in the current round already handled
+  size_t mRoundDone;
+
+  /// Totals shared with checkpoints still queued on the client workers
+  std::shared_ptr<Counts> mCounts;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_CHARACTERCHECKPOINTER_H
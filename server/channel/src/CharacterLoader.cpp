@@ -0,0 +1,186 @@
+/**
+ * @file server/channel/src/CharacterLoader.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Bulk loader for the objects owned by a character on login.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CharacterLoader.h"
+
+// Standard C++11 Includes
+#include <unordered_set>
+
+// libcomp Includes
+#include <Database.h>
+
+// object Includes
+#include <AccountWorldData.h>
+#include <Character.h>
+#include <Demon.h>
+#include <DemonBox.h>
+#include <Expertise.h>
+#include <Hotbar.h>
+#include <InheritedSkill.h>
+#include <Item.h>
+#include <ItemBox.h>
+#include <Quest.h>
+#include <StatusEffect.h>
+
+using namespace channel;
+
+CharacterLoader::CharacterLoader(const std::shared_ptr<libcomp::Database>& db)
+    : mDB(db), mQueryCount(0) {}
+
+CharacterLoader::~CharacterLoader() {}
+
+void CharacterLoader::Load(
+    const std::shared_ptr<objects::Character>& character,
+    const std::shared_ptr<objects::AccountWorldData>& worldData) {
+  mObjects.clear();
+  mItems.clear();
+  mStatusEffects.clear();
+  mQuests.clear();
+  mQueryCount = 0;
+
+  auto account = character->GetAccount();
+  auto characterUUID = character->GetUUID();
+
+  // Load every item box on the account at once. This includes the
+  // inventories of the account's other characters which are only held
+  // until the loader is cleaned up.
+  Hold(objects::ItemBox::LoadItemBoxListByAccount(mDB, account));
+  mQueryCount++;
+
+  std::list<libcomp::ObjectReference<objects::ItemBox>> itemBoxes;
+  for (auto itemBox : character->GetItemBoxes()) {
+    itemBoxes.push_back(itemBox);
+  }
+
+  for (auto itemBox : worldData->GetItemBoxes()) {
+    itemBoxes.push_back(itemBox);
+  }
+
+  std::unordered_set<libobjgen::UUID> seen;
+  for (auto itemBox : itemBoxes) {
+    if (itemBox.IsNull() || !seen.insert(itemBox.GetUUID()).second) {
+      continue;
+    }
+
+    auto items = objects::Item::LoadItemListByItemBox(mDB, itemBox.GetUUID());
+    mQueryCount++;
+
+    Hold(items);
+    mItems[itemBox.GetUUID()] = items;
+  }
+
+  Hold(objects::Expertise::LoadExpertiseListByCharacter(mDB, characterUUID));
+  Hold(objects::Hotbar::LoadHotbarListByCharacter(mDB, characterUUID));
+  mQueryCount += 2;
+
+  mQuests = objects::Quest::LoadQuestListByCharacter(mDB, characterUUID);
+  mQueryCount++;
+
+  Hold(mQuests);
+
+  auto effects =
+      objects::StatusEffect::LoadStatusEffectListByEntity(mDB, characterUUID);
+  mQueryCount++;
+
+  Hold(effects);
+  mStatusEffects[characterUUID] = effects;
+
+  // Load every demon box on the account then the demons in the boxes the
+  // character can access one box at a time.
+  Hold(objects::DemonBox::LoadDemonBoxListByAccount(mDB, account));
+  mQueryCount++;
+
+  std::list<libcomp::ObjectReference<objects::DemonBox>> demonBoxes;
+  demonBoxes.push_back(character->GetCOMP());
+  for (auto box : worldData->GetDemonBoxes()) {
+    demonBoxes.push_back(box);
+  }
+
+  seen.clear();
+  for (auto box : demonBoxes) {
+    if (box.IsNull() || !seen.insert(box.GetUUID()).second) {
+      continue;
+    }
+
+    Hold(objects::Demon::LoadDemonListByDemonBox(mDB, box.GetUUID()));
+    mQueryCount++;
+
+    // The COMP is not always on the account so make sure the box itself
+    // is loaded before walking its demons.
+    if (!box.Get(mDB)) {
+      continue;
+    }
+
+    for (auto demon : box->GetDemons()) {
+      if (demon.IsNull() || !demon.Get(mDB)) {
+        continue;
+      }
+
+      // Skills are usually inherited one at a time so only load them
+      // together when there is more than one.
+      if (demon->InheritedSkillsCount() > 1) {
+        Hold(objects::InheritedSkill::LoadInheritedSkillListByDemon(
+            mDB, demon->GetUUID()));
+        mQueryCount++;
+      }
+
+      effects = objects::StatusEffect::LoadStatusEffectListByEntity(
+          mDB, demon->GetUUID());
+      mQueryCount++;
+
+      Hold(effects);
+      mStatusEffects[demon->GetUUID()] = effects;
+    }
+  }
+}
+
+std::list<std::shared_ptr<objects::Item>> CharacterLoader::GetItems(
+    const libobjgen::UUID& itemBox) const {
+  auto it = mItems.find(itemBox);
+  if (it != mItems.end()) {
+    return it->second;
+  }
+
+  return objects::Item::LoadItemListByItemBox(mDB, itemBox);
+}
+
+std::list<std::shared_ptr<objects::StatusEffect>>
+CharacterLoader::GetStatusEffects(const libobjgen::UUID& entity) const {
+  auto it = mStatusEffects.find(entity);
+  if (it != mStatusEffects.end()) {
+    return it->second;
+  }
+
+  return objects::StatusEffect::LoadStatusEffectListByEntity(mDB, entity);
+}
+
+std::list<std::shared_ptr<objects::Quest>> CharacterLoader::GetQuests() const {
+  return mQuests;
+}
+
+size_t CharacterLoader::GetQueryCount() const { return mQueryCount; }
+
+size_t CharacterLoader::GetObjectCount() const { return mObjects.size(); }
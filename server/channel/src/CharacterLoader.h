@@ -0,0 +1,161 @@
+/**
+ * @file server/channel/src/CharacterLoader.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Bulk loader for the objects owned by a character on login.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_CHARACTERLOADER_H
+#define SERVER_CHANNEL_SRC_CHARACTERLOADER_H
+
+// Standard C++11 Includes
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+// libobjgen Includes
+#include <UUID.h>
+
+namespace libcomp {
+class Database;
+class PersistentObject;
+}  // namespace libcomp
+
+namespace objects {
+class AccountWorldData;
+class Character;
+class Item;
+class Quest;
+class StatusEffect;
+}  // namespace objects
+
+namespace channel {
+
+/**
+ * Loads the objects owned by a character and their account world data in
+ * a few set based queries keyed by the account, character and box UUIDs
+ * instead of one query per object reference. Every object loaded is
+ * registered with the persistent object cache and held by the loader so
+ * the object references walked while validating the character afterwards
+ * resolve from memory. The loader should be kept alive until the
+ * character has been fully initialized.
+ */
+class CharacterLoader {
+ public:
+  /**
+   * Create a new loader.
+   * @param db Pointer to the world database to load from
+   */
+  CharacterLoader(const std::shared_ptr<libcomp::Database>& db);
+
+  /**
+   * Clean up the loader and release the objects it holds.
+   */
+  ~CharacterLoader();
+
+  /**
+   * Load the item boxes, items, expertises, hotbars, quests, demon boxes,
+   * demons, inherited skills and status effects of a character. Objects
+   * that do not exist or fail to load are skipped here and reported by
+   * the normal reference loads that follow.
+   * @param character Pointer to the character, which must already have
+   *  been loaded
+   * @param worldData Pointer to the account world data of the character
+   */
+  void Load(const std::shared_ptr<objects::Character>& character,
+            const std::shared_ptr<objects::AccountWorldData>& worldData);
+
+  /**
+   * Get every item stored in the database for an item box, including
+   * orphaned items not assigned to a slot. Boxes that were not part of
+   * the last load are loaded from the database.
+   * @param itemBox UUID of the item box
+   * @return List of items in the box
+   */
+  std::list<std::shared_ptr<objects::Item>> GetItems(
+      const libobjgen::UUID& itemBox) const;
+
+  /**
+   * Get every status effect stored in the database for the character or
+   * one of their demons, including orphaned effects. Entities that were
+   * not part of the last load are loaded from the database.
+   * @param entity UUID of the character or demon
+   * @return List of status effects on the entity
+   */
+  std::list<std::shared_ptr<objects::StatusEffect>> GetStatusEffects(
+      const libobjgen::UUID& entity) const;
+
+  /**
+   * Get every quest stored in the database for the character.
+   * @return List of quests on the character
+   */
+  std::list<std::shared_ptr<objects::Quest>> GetQuests() const;
+
+  /**
+   * Get the number of database queries used by the last load.
+   * @return Number of database queries
+   */
+  size_t GetQueryCount() const;
+
+  /**
+   * Get the number of objects loaded by the last load.
+   * @return Number of objects loaded
+   */
+  size_t GetObjectCount() const;
+
+ private:
+  /**
+   * Hold a list of loaded objects until the loader is cleaned up.
+   * @param objs List of objects to hold
+   */
+  template <class T>
+  void Hold(const std::list<std::shared_ptr<T>>& objs) {
+    for (auto& obj : objs) {
+      mObjects.push_back(obj);
+    }
+  }
+
+  /// Pointer to the world database
+  std::shared_ptr<libcomp::Database> mDB;
+
+  /// Every object loaded, held so the persistent object cache keeps them
+  std::list<std::shared_ptr<libcomp::PersistentObject>> mObjects;
+
+  /// Items loaded by item box UUID
+  std::unordered_map<libobjgen::UUID, std::list<std::shared_ptr<objects::Item>>>
+      mItems;
+
+  /// Status effects loaded by entity UUID
+  std::unordered_map<libobjgen::UUID,
+                     std::list<std::shared_ptr<objects::StatusEffect>>>
+      mStatusEffects;
+
+  /// Quests loaded for the character
+  std::list<std::shared_ptr<objects::Quest>> mQuests;
+
+  /// Number of database queries used by the last load
+  size_t mQueryCount;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_CHARACTERLOADER_H
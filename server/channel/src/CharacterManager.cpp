@@ -996,7 +996,7 @@ void CharacterManager::ReviveCharacter(
     for (size_t i = 0; i < 50; i++) {
       auto item = inventory->GetItems(i).Get();
       auto itemData =
-          item ? definitionManager->GetItemData(item->GetType()) : nullptr;
+          item ? definitionManager->FindItemData(item->GetType()) : nullptr;
       if (itemData && itemData->GetBasic()->GetBaseID() == baseItemID) {
         if (item->GetType() != baseItemID) {
           // Variant found, go with this
@@ -1417,7 +1417,7 @@ void CharacterManager::SummonDemon(
     double extend = tokuseiManager->GetAspectSum(
         cState, TokuseiAspectType::SUMMON_SYNC_EXTEND);
     if (extend > 0.0) {
-      auto effectDef = definitionManager->GetStatusData(syncStatusType);
+      auto effectDef = definitionManager->FindStatusData(syncStatusType);
       if (effectDef) {
         effect.Duration = (uint32_t)((1.0 + (double)extend / 100.0) *
                                      effectDef->GetCancel()->GetDuration());
@@ -2159,7 +2159,7 @@ bool CharacterManager::AddRemoveItems(
   dbChanges->Update(itemBox);
 
   if (queueChanges) {
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   }
 
   return true;
@@ -2411,7 +2411,9 @@ bool CharacterManager::UpdateItems(
     return true;
   }
 
-  auto changes = _changes ? _changes : libcomp::DatabaseChangeSet::Create();
+  auto changes = _changes ? _changes
+                           : libcomp::DatabaseChangeSet::Create(
+                                 state->GetAccountUID());
   bool queueChanges = !_changes;
   std::list<uint16_t> updatedSlots;
 
@@ -2450,8 +2452,7 @@ bool CharacterManager::UpdateItems(
   changes->Update(inventory);
 
   // Process all changes as a transaction
-  auto worldDB = mServer.lock()->GetWorldDatabase();
-  if (queueChanges && !worldDB->ProcessChangeSet(changes)) {
+  if (queueChanges && !mServer.lock()->ProcessWorldChangeSet(changes)) {
     return false;
   }
 
@@ -2614,12 +2615,13 @@ bool CharacterManager::CultureItemPickup(
       cData->SetActive(false);
       cData->SetItem(NULLUUID);
 
-      auto dbChanges = libcomp::DatabaseChangeSet::Create();
+      auto dbChanges =
+          libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
       dbChanges->Update(inventory);
       dbChanges->Update(cItem);
       dbChanges->Update(cData);
 
-      if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+      if (!server->ProcessWorldChangeSet(dbChanges)) {
         client->Kill();
         return false;
       }
@@ -3211,7 +3213,10 @@ bool CharacterManager::UpdateDurability(
         }
       }
 
-      server->GetWorldDatabase()->QueueUpdate(item, state->GetAccountUID());
+      auto dbChanges =
+          libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+      dbChanges->Update(item);
+      server->QueueWorldChangeSet(dbChanges);
 
       updated = true;
     }
@@ -3426,7 +3431,7 @@ std::shared_ptr<objects::Demon> CharacterManager::ContractDemon(
   dbChanges->Update(comp);
 
   auto server = mServer.lock();
-  server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+  server->QueueWorldChangeSet(dbChanges);
 
   return d;
 }
@@ -3692,7 +3697,7 @@ bool CharacterManager::ReunionDemon(
       dbChanges->Update(demon);
       dbChanges->Update(cs);
 
-      server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+      server->QueueWorldChangeSet(dbChanges);
     }
   }
 
@@ -3930,7 +3935,7 @@ bool CharacterManager::DoMitamaReunion(
     changes->Update(demon);
 
     if (immediatelyProcessChanges) {
-      if (server->GetWorldDatabase()->ProcessChangeSet(changes)) {
+      if (server->ProcessWorldChangeSet(changes)) {
         int8_t slot = demon->GetBoxSlot();
         auto box = std::dynamic_pointer_cast<objects::DemonBox>(
             libcomp::PersistentObject::GetObjectByUUID(demon->GetDemonBox()));
@@ -4081,7 +4086,10 @@ void CharacterManager::UpdateFamiliarity(
         server->GetZoneManager()->BroadcastPacket(client, p);
       }
 
-      server->GetWorldDatabase()->QueueUpdate(demon, state->GetAccountUID());
+      auto dbChanges =
+          libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+      dbChanges->Update(demon);
+      server->QueueWorldChangeSet(dbChanges);
     }
   }
 }
@@ -4139,7 +4147,9 @@ int32_t CharacterManager::UpdateSoulPoints(
 
     client->SendPacket(p);
 
-    server->GetWorldDatabase()->QueueUpdate(demon, state->GetAccountUID());
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+    dbChanges->Update(demon);
+    server->QueueWorldChangeSet(dbChanges);
   }
 
   return points;
@@ -4212,7 +4222,7 @@ bool CharacterManager::UpdateCoinTotal(
   expl->SetFrom<int64_t>("Coins", newAmount, oldAmount);
   opChangeset->AddOperation(expl);
 
-  if (mServer.lock()->GetWorldDatabase()->ProcessChangeSet(opChangeset)) {
+  if (mServer.lock()->ProcessWorldChangeSet(opChangeset)) {
     SendCoinTotal(client, true);
     return true;
   } else {
@@ -4453,7 +4463,7 @@ bool CharacterManager::UpdateEventCounter(
   }
 
   auto server = mServer.lock();
-  if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+  if (!server->ProcessWorldChangeSet(dbChanges)) {
     return false;
   }
 
@@ -4733,7 +4743,7 @@ bool CharacterManager::UpdateExperience(
 
   client->FlushOutgoing();
 
-  server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+  server->QueueWorldChangeSet(dbChanges);
 
   return true;
 }
@@ -4889,7 +4899,7 @@ void CharacterManager::UpdateExpertisePoints(
         dbChanges->Update(character);
         dbChanges->Insert(expertise);
 
-        server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+        server->QueueWorldChangeSet(dbChanges);
       } else {
         continue;
       }
@@ -4977,7 +4987,7 @@ void CharacterManager::UpdateExpertisePoints(
     client->SendPacket(reply);
   }
 
-  server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+  server->QueueWorldChangeSet(dbChanges);
 
   if (rankChanged) {
     // Expertises can be used as multipliers and conditions, always recalc
@@ -5136,7 +5146,7 @@ bool CharacterManager::LearnSkill(
 
     client->SendPacket(p);
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   } else {
     // Check if the skill has already been learned
     auto cState = state->GetCharacterState();
@@ -5812,7 +5822,7 @@ void CharacterManager::NotifyItemDistribution(
 
   client->FlushOutgoing();
 
-  mServer.lock()->GetLobbyDatabase()->QueueChangeSet(dbChanges);
+  mServer.lock()->QueueLobbyChangeSet(dbChanges);
 }
 
 bool CharacterManager::UpdateStatusEffects(
@@ -5826,7 +5836,7 @@ bool CharacterManager::UpdateStatusEffects(
 
   uint32_t now = (uint32_t)std::time(0);
   for (auto effect : demon->GetStatusEffects()) {
-    auto se = definitionManager->GetStatusData(effect->GetEffect());
+    auto se = definitionManager->FindStatusData(effect->GetEffect());
 
     auto cancel = se->GetCancel();
     switch (cancel->GetDurationType()) {
@@ -5857,9 +5867,9 @@ bool CharacterManager::UpdateStatusEffects(
     }
 
     if (queueSave) {
-      return server->GetWorldDatabase()->QueueChangeSet(changes);
+      return server->QueueWorldChangeSet(changes);
     } else {
-      return server->GetWorldDatabase()->ProcessChangeSet(changes);
+      return server->ProcessWorldChangeSet(changes);
     }
   }
 
@@ -5946,11 +5956,11 @@ bool CharacterManager::UpdateStatusEffects(
     changes->Update(dState->GetEntity());
   }
 
-  auto db = mServer.lock()->GetWorldDatabase();
+  auto server = mServer.lock();
   if (queueSave) {
-    return db->QueueChangeSet(changes);
+    return server->QueueWorldChangeSet(changes);
   } else {
-    return db->ProcessChangeSet(changes);
+    return server->ProcessWorldChangeSet(changes);
   }
 }
 
@@ -6081,7 +6091,7 @@ void CharacterManager::CancelStatusEffects(
       dbChanges->Delete(effect);
     }
 
-    mServer.lock()->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    mServer.lock()->QueueWorldChangeSet(dbChanges);
   }
 }
 
@@ -6186,7 +6196,7 @@ bool CharacterManager::AddRemoveOpponent(
     return true;
   }
 
-  std::list<libcomp::Packet> packets;
+  std::list<std::pair<int32_t, libcomp::Packet>> packets;
   if (add) {
     // If one isn't alive, stop here
     if (!eState1->IsAlive() || !eState2->IsAlive()) {
@@ -6252,7 +6262,7 @@ bool CharacterManager::AddRemoveOpponent(
       p.WritePacketCode(ChannelToClientPacketCode_t::PACKET_BATTLE_STARTED);
       p.WriteS32Little(entity->GetEntityID());
       p.WriteFloat(entity->GetMovementSpeed());
-      packets.push_back(p);
+      packets.push_back(std::make_pair(entity->GetEntityID(), p));
     }
   } else {
     int32_t e1ID = eState1->GetEntityID();
@@ -6297,7 +6307,7 @@ bool CharacterManager::AddRemoveOpponent(
             p.WriteS32Little(entity->GetEntityID());
             p.WriteFloat(entity->GetMovementSpeed());
 
-            packets.push_back(p);
+            packets.push_back(std::make_pair(entity->GetEntityID(), p));
           }
         }
       }
@@ -6309,8 +6319,7 @@ bool CharacterManager::AddRemoveOpponent(
   }
 
   if (packets.size() > 0) {
-    auto zoneConnections = zone->GetConnectionList();
-    ChannelClientConnection::BroadcastPackets(zoneConnections, packets);
+    mServer.lock()->GetZoneManager()->BroadcastEntityPackets(zone, packets);
   }
 
   return true;
@@ -6653,7 +6662,7 @@ bool CharacterManager::DigitalizeEnd(
 
       SendDemonBoxData(client, 0, {demon->GetBoxSlot()});
 
-      server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+      server->QueueWorldChangeSet(dbChanges);
     }
   }
 
@@ -76,6 +76,10 @@
 #include <cmath>
 #include <cstdlib>
 
+// Standard C++11 Includes
+#include <functional>
+#include <map>
+
 // channel Includes
 #include "AccountManager.h"
 #include "ChannelServer.h"
@@ -85,6 +89,7 @@
 #include "EventManager.h"
 #include "ManagerConnection.h"
 #include "MatchManager.h"
+#include "ServerDataReloader.h"
 #include "SkillManager.h"
 #include "TokuseiManager.h"
 #include "ZoneManager.h"
@@ -128,11 +133,13 @@ ChatManager::ChatManager(const std::weak_ptr<ChannelServer>& server)
   mGMands["lnc"] = &ChatManager::GMCommand_LNC;
   mGMands["map"] = &ChatManager::GMCommand_Map;
   mGMands["online"] = &ChatManager::GMCommand_Online;
+  mGMands["packets"] = &ChatManager::GMCommand_Packets;
   mGMands["penalty"] = &ChatManager::GMCommand_PenaltyReset;
   mGMands["plugin"] = &ChatManager::GMCommand_Plugin;
   mGMands["pos"] = &ChatManager::GMCommand_Position;
   mGMands["post"] = &ChatManager::GMCommand_Post;
   mGMands["quest"] = &ChatManager::GMCommand_Quest;
+  mGMands["reload"] = &ChatManager::GMCommand_Reload;
   mGMands["reported"] = &ChatManager::GMCommand_Reported;
   mGMands["resolve"] = &ChatManager::GMCommand_Resolve;
   mGMands["reunion"] = &ChatManager::GMCommand_Reunion;
@@ -1110,8 +1117,10 @@ bool ChatManager::GMCommand_DemonForce(
                                "Target must have a demon summoned.");
       } else {
         targetDemon->SetForceStack((size_t)(stackSlot - 1), forceStackID);
-        server->GetWorldDatabase()->QueueUpdate(targetDemon,
-                                                targetState->GetAccountUID());
+        auto dbChanges =
+            libcomp::DatabaseChangeSet::Create(targetState->GetAccountUID());
+        dbChanges->Update(targetDemon);
+        server->QueueWorldChangeSet(dbChanges);
         targetDState->UpdateDemonState(definitionManager);
         server->GetTokuseiManager()->Recalculate(
             targetState->GetCharacterState(), true,
@@ -1158,11 +1167,12 @@ bool ChatManager::GMCommand_DemonRequest(
     uint32_t zoneID = login ? login->GetZoneID() : 0;
     auto eventManager = server->GetEventManager();
     uint32_t now = (uint32_t)time(0);
-    auto dbChanges = libcomp::DatabaseChangeSet::Create();
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(
+        targetCharacter->GetAccount().GetUUID());
 
     eventManager->ResetDemonQuests(
         targetCharacter, zoneID ? targetClient : nullptr, now, dbChanges);
-    if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges)) {
       LogGeneralErrorMsg(
           "Failed to process Demon Request reset requested by GM command.\n");
       return SendChatMessage(
@@ -1209,11 +1219,12 @@ bool ChatManager::GMCommand_DemonRequestStreak(
   if (targetCharacter) {
     auto server = mServer.lock();
     auto progress = targetCharacter->GetProgress().Get();
-    auto dbChanges = libcomp::DatabaseChangeSet::Create();
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(
+        targetCharacter->GetAccount().GetUUID());
     progress->SetDemonQuestSequence(completionStreak);
     dbChanges->Update(progress);
 
-    if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges)) {
       LogGeneralErrorMsg(
           "Failed to save Demon Request completion streak requested by GM "
           "command.\n");
@@ -1442,7 +1453,9 @@ bool ChatManager::GMCommand_Enchant(
 
   server->GetCharacterManager()->RecalculateTokuseiAndStats(cState, client);
 
-  server->GetWorldDatabase()->QueueUpdate(item, state->GetAccountUID());
+  auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+  dbChanges->Update(item);
+  server->QueueWorldChangeSet(dbChanges);
 
   return true;
 }
@@ -2166,6 +2179,11 @@ bool ChatManager::GMCommand_Help(
       {"online",
        {"@online [NAME]", "Print how many players are online or check if the",
         "character with a specific NAME is online."}},
+      {"packets",
+       {"@packets [CLIENTS] [COUNT]",
+        "Print the COUNT packet codes with the most handler time",
+        "or the clients sending the most packets if CLIENTS is",
+        "set to 'clients'."}},
       {"penalty",
        {"@penalty [NAME]",
         "Remove all PvP penalties on the character NAME or to",
@@ -2187,6 +2205,10 @@ bool ChatManager::GMCommand_Help(
        {"@quest ID PHASE",
         "Sets the phase of the quest given by the ID to the phase",
         "PHASE. A phase of -1 is complete and -2 is a reset."}},
+      {"reload",
+       {"@reload", "Reloads any server data files that have changed",
+        "without restarting the channel. Server side definitions",
+        "and scripts still require a restart."}},
       {"reported",
        {"@reported [COUNT|PLAYERNAME]",
         "Get a set of unresolved reported player records of a",
@@ -2799,6 +2821,87 @@ bool ChatManager::GMCommand_Online(
   return true;
 }
 
+bool ChatManager::GMCommand_Packets(
+    const std::shared_ptr<channel::ChannelClientConnection>& client,
+    const std::list<libcomp::String>& args) {
+  if (!HaveUserLevel(client, SVR_CONST.GM_CMD_LVL_PACKETS)) {
+    return true;
+  }
+
+  std::list<libcomp::String> argsCopy = args;
+
+  auto server = mServer.lock();
+
+  bool clients = argsCopy.size() > 0 && argsCopy.front().ToLower() == "clients";
+  if (clients) {
+    argsCopy.pop_front();
+  }
+
+  uint8_t count = 5;
+  GetIntegerArg(count, argsCopy);
+
+  // Cap at 10 lines
+  if (count == 0 || count > 10) {
+    count = 10;
+  }
+
+  if (clients) {
+    ServerTime now = ChannelServer::GetServerTime();
+    auto topClients =
+        server->GetManagerConnection()->GetTopPacketClients(now, count);
+    for (auto topClient : topClients) {
+      auto cState = topClient->GetClientState()->GetCharacterState();
+      auto character = cState ? cState->GetEntity() : nullptr;
+
+      SendChatMessage(
+          client, ChatType_t::CHAT_SELF,
+          libcomp::String("%1: %2 packets/s (%3 packets, %4 bytes total)")
+              .Arg(character ? character->GetName() : "[Unknown]")
+              .Arg(topClient->GetPacketRate(now))
+              .Arg(topClient->GetPacketCount())
+              .Arg(topClient->GetPacketBytes()));
+    }
+
+    return true;
+  }
+
+  auto snapshot = server->GetMetrics()->GetTotals();
+
+  // Order the command codes by the total time spent handling them
+  std::multimap<uint64_t, std::string, std::greater<uint64_t>> sorted;
+  for (auto& pair : snapshot.Histograms) {
+    if (pair.first.compare(0, 7, "Packet ") == 0) {
+      sorted.insert(std::make_pair(pair.second.Sum, pair.first));
+    }
+  }
+
+  if (sorted.size() == 0) {
+    return SendChatMessage(client, ChatType_t::CHAT_SELF,
+                           "No packet metrics have been recorded. Either "
+                           "PerfMonitorEnabled or MetricsPort must be set.");
+  }
+
+  for (auto& pair : sorted) {
+    if (count-- == 0) {
+      break;
+    }
+
+    auto& summary = snapshot.Histograms[pair.second];
+    SendChatMessage(
+        client, ChatType_t::CHAT_SELF,
+        libcomp::String("0x%1: %2 packets, %3 bytes, p50 %4 us, p99 %5 us, "
+                        "max %6 us")
+            .Arg(libcomp::String(pair.second.substr(7)).ToUpper())
+            .Arg(summary.Count)
+            .Arg(snapshot.Counters[pair.second + " Bytes"])
+            .Arg(summary.P50)
+            .Arg(summary.P99)
+            .Arg(summary.Max));
+  }
+
+  return true;
+}
+
 bool ChatManager::GMCommand_PenaltyReset(
     const std::shared_ptr<channel::ChannelClientConnection>& client,
     const std::list<libcomp::String>& args) {
@@ -2998,6 +3101,26 @@ bool ChatManager::GMCommand_Post(
   return true;
 }
 
+bool ChatManager::GMCommand_Reload(
+    const std::shared_ptr<channel::ChannelClientConnection>& client,
+    const std::list<libcomp::String>& args) {
+  if (!HaveUserLevel(client, SVR_CONST.GM_CMD_LVL_RELOAD)) {
+    return true;
+  }
+
+  (void)args;
+
+  auto reloader = mServer.lock()->GetServerDataReloader();
+  if (!reloader->Start()) {
+    return SendChatMessage(client, ChatType_t::CHAT_SELF,
+                           "A server data reload is already running.");
+  }
+
+  return SendChatMessage(client, ChatType_t::CHAT_SELF,
+                         "Server data reload started. Check the server log "
+                         "for the result.");
+}
+
 bool ChatManager::GMCommand_Reported(
     const std::shared_ptr<channel::ChannelClientConnection>& client,
     const std::list<libcomp::String>& args) {
@@ -3492,7 +3615,9 @@ bool ChatManager::GMCommand_SlotAdd(
           client, itemBox, {(uint16_t)item->GetBoxSlot()});
     }
 
-    server->GetWorldDatabase()->QueueUpdate(item, state->GetAccountUID());
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+    dbChanges->Update(item);
+    server->QueueWorldChangeSet(dbChanges);
   }
 
   return true;
@@ -3695,7 +3820,9 @@ bool ChatManager::GMCommand_Spirit(
 
   server->GetCharacterManager()->RecalculateTokuseiAndStats(cState, client);
 
-  server->GetWorldDatabase()->QueueUpdate(item, state->GetAccountUID());
+  auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+  dbChanges->Update(item);
+  server->QueueWorldChangeSet(dbChanges);
 
   return true;
 }
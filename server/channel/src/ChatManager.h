@@ -484,6 +484,17 @@ class ChatManager {
       const std::shared_ptr<channel::ChannelClientConnection>& client,
       const std::list<libcomp::String>& args);
 
+  /**
+   * GM command to print the client packet command codes that have taken
+   * the most handler time or the clients sending the most packets.
+   * @param client Pointer to the client that sent the command
+   * @param args List of arguments for the command
+   * @return true if the command was handled properly, else false
+   */
+  bool GMCommand_Packets(
+      const std::shared_ptr<channel::ChannelClientConnection>& client,
+      const std::list<libcomp::String>& args);
+
   /**
    * GM command to reset a specific player's PvP penalties.
    * @param client Pointer to the client that sent the command
@@ -535,6 +546,16 @@ class ChatManager {
       const std::shared_ptr<channel::ChannelClientConnection>& client,
       const std::list<libcomp::String>& args);
 
+  /**
+   * GM command to reload any server data files that have changed.
+   * @param client Pointer to the client that sent the command
+   * @param args List of arguments for the command
+   * @return true if the command was handled properly, else false
+   */
+  bool GMCommand_Reload(
+      const std::shared_ptr<channel::ChannelClientConnection>& client,
+      const std::list<libcomp::String>& args);
+
   /**
    * GM command to get reported players that have not been resolved
    * yet.
@@ -83,6 +83,7 @@ ClientState::ClientState()
     : objects::ClientStateObject(),
       mCharacterState(std::shared_ptr<CharacterState>(new CharacterState)),
       mDemonState(std::shared_ptr<DemonState>(new DemonState)),
+      mSaveTracker(std::make_shared<SaveTracker>()),
       mStartTime(ChannelServer::GetServerTime()),
       mNextLocalObjectID(1) {}
 
@@ -109,6 +110,10 @@ std::shared_ptr<CharacterState> ClientState::GetCharacterState() {
 
 std::shared_ptr<DemonState> ClientState::GetDemonState() { return mDemonState; }
 
+std::shared_ptr<SaveTracker> ClientState::GetSaveTracker() {
+  return mSaveTracker;
+}
+
 std::shared_ptr<ActiveEntityState> ClientState::GetEntityState(int32_t entityID,
                                                                bool readyOnly) {
   std::list<std::shared_ptr<ActiveEntityState>> states = {mCharacterState,
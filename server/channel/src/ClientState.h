@@ -31,6 +31,7 @@
 #include "ActiveEntityState.h"
 #include "CharacterState.h"
 #include "DemonState.h"
+#include "SaveTracker.h"
 
 // objects Includes
 #include <Character.h>
@@ -91,6 +92,13 @@ class ClientState : public objects::ClientStateObject {
    */
   std::shared_ptr<DemonState> GetDemonState();
 
+  /**
+   * Get the tracker of the state each character object was last saved
+   * in, used to skip unchanged objects when saving on logout.
+   * @return Pointer to the SaveTracker
+   */
+  std::shared_ptr<SaveTracker> GetSaveTracker();
+
   /**
    * Get the entity state associated to an entity ID for this client.
    * @param entityID Entity ID associated to this client to retrieve
@@ -392,6 +400,10 @@ class ClientState : public objects::ClientStateObject {
   /// be set to an empty Demon pointer when one is not summoned
   std::shared_ptr<DemonState> mDemonState;
 
+  /// Last saved state of the character objects saved on logout, shared
+  /// with the persistence worker while queued writes are committed
+  std::shared_ptr<SaveTracker> mSaveTracker;
+
   /// Map of UUIDs to game client object IDs
   std::unordered_map<libcomp::String, int64_t> mObjectIDs;
 
@@ -0,0 +1,171 @@
+/**
+ * @file server/channel/src/ClientWorkerRouter.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Routes client connections to the workers that handle their packets.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ClientWorkerRouter.h"
+
+// libcomp Includes
+#include <MessageExecute.h>
+#include <MessagePacket.h>
+#include <Worker.h>
+
+// channel Includes
+#include "ChannelClientConnection.h"
+#include "ManagerClientPacket.h"
+
+using namespace channel;
+
+const size_t ClientWorkerRouter::NO_WORKER = (size_t)-1;
+
+/// Index of the worker the current thread belongs to
+static thread_local size_t gCurrentWorker = ClientWorkerRouter::NO_WORKER;
+
+ClientWorkerRouter::ClientWorkerRouter(
+    const std::list<std::shared_ptr<libcomp::Worker>>& workers,
+    const std::shared_ptr<ManagerClientPacket>& packetManager,
+    bool zoneAffinity)
+    : mPacketManager(packetManager), mZoneAffinity(zoneAffinity) {
+  for (auto worker : workers) {
+    auto queue = worker->GetMessageQueue();
+
+    // The first thing each worker does is learn its own index so held
+    // packets can tell which worker is handling them
+    queue->Enqueue(new libcomp::Message::ExecuteImpl<size_t>(
+        [](size_t index) { gCurrentWorker = index; }, mQueues.size()));
+
+    mQueues.push_back(queue);
+  }
+}
+
+ClientWorkerRouter::~ClientWorkerRouter() {}
+
+bool ClientWorkerRouter::Assign(
+    const std::shared_ptr<ChannelClientConnection>& client,
+    uint64_t connectionID) {
+  if (mQueues.size() == 0) {
+    return false;
+  }
+
+  size_t index = (size_t)(connectionID % (uint64_t)mQueues.size());
+
+  client->SetWorkerIndex(index);
+  client->SetMessageQueue(mQueues[index]);
+
+  return true;
+}
+
+void ClientWorkerRouter::AssignToZone(
+    const std::shared_ptr<ChannelClientConnection>& client, uint32_t zoneID) {
+  if (!mZoneAffinity || mQueues.size() < 2) {
+    return;
+  }
+
+  MoveToWorker(client, (size_t)(zoneID % (uint32_t)mQueues.size()));
+}
+
+void ClientWorkerRouter::MoveToWorker(
+    const std::shared_ptr<ChannelClientConnection>& client, size_t index) {
+  size_t previous = client->GetWorkerIndex();
+  if (!client->BeginWorkerMove(index)) {
+    return;
+  }
+
+  // New packets go to the new worker from here on and are held there
+  // until the old worker reaches this message, at which point everything
+  // the client sent before the move has been handled
+  client->SetMessageQueue(mQueues[index]);
+
+  mQueues[previous]->Enqueue(new libcomp::Message::ExecuteImpl<
+                             ClientWorkerRouter*,
+                             std::shared_ptr<ChannelClientConnection>>(
+      [](ClientWorkerRouter* pRouter,
+         std::shared_ptr<ChannelClientConnection> _client) {
+        pRouter->FinishMove(_client);
+      },
+      this, client));
+}
+
+bool ClientWorkerRouter::QueueClientWork(
+    const std::shared_ptr<ChannelClientConnection>& client,
+    const std::function<void(std::shared_ptr<ChannelClientConnection>)>&
+        work) {
+  // While a client is being moved the old and new worker can both be
+  // handling it so wait until it has settled
+  size_t index = NO_WORKER;
+  if (!client->GetSettledWorkerIndex(index) || index >= mQueues.size()) {
+    return false;
+  }
+
+  mQueues[index]->Enqueue(
+      new libcomp::Message::ExecuteImpl<
+          std::shared_ptr<ChannelClientConnection>>(work, client));
+
+  return true;
+}
+
+void ClientWorkerRouter::QueueAllWorkers(const std::function<void()>& work) {
+  for (auto queue : mQueues) {
+    queue->Enqueue(new libcomp::Message::ExecuteImpl<>(work));
+  }
+}
+
+size_t ClientWorkerRouter::GetCurrentWorker() { return gCurrentWorker; }
+
+void ClientWorkerRouter::FinishMove(
+    const std::shared_ptr<ChannelClientConnection>& client) {
+  if (!client->EndWorkerMove()) {
+    // Nothing was held so any move requested meanwhile can start now
+    size_t index;
+    if (client->TakeDeferredWorkerMove(index)) {
+      MoveToWorker(client, index);
+    }
+  } else {
+    mQueues[client->GetWorkerIndex()]->Enqueue(
+        new libcomp::Message::ExecuteImpl<
+            ClientWorkerRouter*, std::shared_ptr<ChannelClientConnection>>(
+            [](ClientWorkerRouter* pRouter,
+               std::shared_ptr<ChannelClientConnection> _client) {
+              pRouter->HandleHeldPackets(_client);
+            },
+            this, client));
+  }
+}
+
+void ClientWorkerRouter::HandleHeldPackets(
+    const std::shared_ptr<ChannelClientConnection>& client) {
+  // Only this worker holds packets for the client and each one stays held
+  // until it has been handled, so packets received meanwhile are held
+  // behind it and any move requested by a handler is deferred
+  libcomp::Message::Packet* pMessage;
+  while ((pMessage = client->GetHeldPacket()) != nullptr) {
+    mPacketManager->HandlePacket(pMessage);
+    client->PopHeldPacket();
+  }
+
+  size_t index;
+  if (client->TakeDeferredWorkerMove(index)) {
+    MoveToWorker(client, index);
+  }
+}
@@ -0,0 +1,172 @@
+/**
+ * @file server/channel/src/ClientWorkerRouter.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Routes client connections to the workers that handle their packets.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_CLIENTWORKERROUTER_H
+#define SERVER_CHANNEL_SRC_CLIENTWORKERROUTER_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+// libcomp Includes
+#include <MessageQueue.h>
+
+namespace libcomp {
+class Worker;
+
+namespace Message {
+class Message;
+}  // namespace Message
+}  // namespace libcomp
+
+namespace channel {
+
+class ChannelClientConnection;
+class ManagerClientPacket;
+
+/**
+ * Routes client connections to the generic workers. Each connection is
+ * sharded onto one worker by its connection ID so every packet from a
+ * client is handled in order by the same thread. With zone affinity
+ * enabled a client is moved to the worker that owns its zone whenever it
+ * enters a new one, so clients in the same zone are handled by the same
+ * thread and contend less on the zone and entity locks. A move hands the
+ * client off in order: packets already queued on the old worker are
+ * handled there first and packets the new worker receives in the meantime
+ * are held until the old worker is done with the client.
+ */
+class ClientWorkerRouter {
+ public:
+  /// Worker index returned for threads that are not client workers
+  static const size_t NO_WORKER;
+
+  /**
+   * Create the router and tag each worker thread with its index.
+   * @param workers List of workers client packets are handled by
+   * @param packetManager Pointer to the client packet manager used to
+   *  handle packets held during a move
+   * @param zoneAffinity true if clients should be moved to the worker
+   *  that owns their zone
+   */
+  ClientWorkerRouter(const std::list<std::shared_ptr<libcomp::Worker>>& workers,
+                     const std::shared_ptr<ManagerClientPacket>& packetManager,
+                     bool zoneAffinity);
+
+  /**
+   * Clean up the router.
+   */
+  ~ClientWorkerRouter();
+
+  /**
+   * Assign a new connection to the worker for its connection ID.
+   * @param client Pointer to the new connection
+   * @param connectionID Unique ID of the connection
+   * @return true if the connection was assigned, false if there are no
+   *  workers
+   */
+  bool Assign(const std::shared_ptr<ChannelClientConnection>& client,
+              uint64_t connectionID);
+
+  /**
+   * Move a client to the worker that owns a zone if zone affinity is
+   * enabled. If the client is still being moved from an earlier zone it
+   * stays where it is until it enters another zone.
+   * @param client Pointer to the client connection
+   * @param zoneID Unique ID of the zone the client entered
+   */
+  void AssignToZone(const std::shared_ptr<ChannelClientConnection>& client,
+                    uint32_t zoneID);
+
+  /**
+   * Queue work for a client on the worker that handles its packets so it
+   * never runs at the same time as the client's packet handlers.
+   * @param client Pointer to the client connection
+   * @param work Work to run with the client on its worker
+   * @return true if the work was queued, false if the client is being
+   *  moved between workers or there are no workers
+   */
+  bool QueueClientWork(
+      const std::shared_ptr<ChannelClientConnection>& client,
+      const std::function<void(std::shared_ptr<ChannelClientConnection>)>&
+          work);
+
+  /**
+   * Queue work on every worker. Once a worker runs it, everything the
+   * worker was handling when it was queued has finished.
+   * @param work Work to run on each worker
+   */
+  void QueueAllWorkers(const std::function<void()>& work);
+
+  /**
+   * Get the index of the worker the calling thread belongs to.
+   * @return Index of the worker or NO_WORKER if the thread is not a
+   *  client worker
+   */
+  static size_t GetCurrentWorker();
+
+ private:
+  /// Message queue type of the workers
+  typedef libcomp::MessageQueue<libcomp::Message::Message*> WorkerQueue;
+
+  /**
+   * Start moving a client to another worker or defer the move until the
+   * client's current move and held packets have been handled.
+   * @param client Pointer to the client connection
+   * @param index Index of the worker to move to
+   */
+  void MoveToWorker(const std::shared_ptr<ChannelClientConnection>& client,
+                    size_t index);
+
+  /**
+   * Called on the old worker once it has handled everything queued for a
+   * client before the client was moved.
+   * @param client Pointer to the client connection
+   */
+  void FinishMove(const std::shared_ptr<ChannelClientConnection>& client);
+
+  /**
+   * Called on the new worker to handle the packets held during a move.
+   * @param client Pointer to the client connection
+   */
+  void HandleHeldPackets(const std::shared_ptr<ChannelClientConnection>& client);
+
+  /// Message queue of each worker by index
+  std::vector<std::shared_ptr<WorkerQueue>> mQueues;
+
+  /// Client packet manager used to handle packets held during a move
+  std::shared_ptr<ManagerClientPacket> mPacketManager;
+
+  /// true if clients are moved to the worker that owns their zone
+  bool mZoneAffinity;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_CLIENTWORKERROUTER_H
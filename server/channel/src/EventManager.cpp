@@ -721,7 +721,7 @@ bool EventManager::UpdateQuest(
     dbChanges->Update(quest);
   }
 
-  server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+  server->QueueWorldChangeSet(dbChanges);
 
   if (sendUpdate) {
     UpdateQuestTargetEnemies(client);
@@ -782,7 +782,10 @@ void EventManager::UpdateQuestKillCount(
     }
 
     if (countUpdates.size() > 0) {
-      server->GetWorldDatabase()->QueueUpdate(quest, state->GetAccountUID());
+      auto dbChanges =
+          libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+      dbChanges->Update(quest);
+      server->QueueWorldChangeSet(dbChanges);
     }
   }
 
@@ -3466,7 +3469,7 @@ int8_t EventManager::EndDemonQuest(
 
   UpdateQuestTargetEnemies(client);
 
-  server->GetWorldDatabase()->ProcessChangeSet(dbChanges);
+  server->ProcessWorldChangeSet(dbChanges);
 
   // If the quest is active, notify the player
   if (!dQuest->GetUUID().IsNull() && failCode != 3) {
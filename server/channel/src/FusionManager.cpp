@@ -140,7 +140,7 @@ bool FusionManager::HandleTriFusion(
                                 costItemType, resultDemon, changes);
 
   if (soloFusion) {
-    if (!server->GetWorldDatabase()->ProcessChangeSet(changes)) {
+    if (!server->ProcessWorldChangeSet(changes)) {
       LogFusionManagerError([&]() {
         return libcomp::String(
                    "Solo Trifusion database changes failed to save for account "
@@ -166,7 +166,7 @@ bool FusionManager::HandleTriFusion(
 
     if (!tfSession) {
       // Weird but not an error
-      server->GetWorldDatabase()->ProcessChangeSet(changes);
+      server->ProcessWorldChangeSet(changes);
 
       return true;
     }
@@ -302,7 +302,7 @@ bool FusionManager::HandleTriFusion(
         }
       }
 
-      if (!server->GetWorldDatabase()->ProcessChangeSet(changes)) {
+      if (!server->ProcessWorldChangeSet(changes)) {
         LogFusionManagerError([&]() {
           return libcomp::String(
                      "TriFusion items failed to save for account '%1'. "
@@ -1741,7 +1741,7 @@ int8_t FusionManager::ProcessFusion(
     }
 
     if (queueChanges) {
-      server->GetWorldDatabase()->QueueChangeSet(changes);
+      server->QueueWorldChangeSet(changes);
     }
 
     return 1;
@@ -1944,7 +1944,7 @@ int8_t FusionManager::ProcessFusion(
   }
 
   if (queueChanges) {
-    server->GetWorldDatabase()->QueueChangeSet(changes);
+    server->QueueWorldChangeSet(changes);
   }
 
   // Update demon quest if active
@@ -28,19 +28,82 @@
 
 // channel Includes
 #include <ChannelClientConnection.h>
+#include "ChannelServer.h"
+#include "ClientWorkerRouter.h"
 
 // libcomp Includes
 #include <Log.h>
+#include <MessagePacket.h>
 #include <PacketCodes.h>
 
+// object Includes
+#include <ChannelConfig.h>
+
+// Standard C++11 Includes
+#include <cstdio>
+
 using namespace channel;
 
 ManagerClientPacket::ManagerClientPacket(
     std::weak_ptr<libcomp::BaseServer> server)
-    : libcomp::ManagerPacket(server) {}
+    : libcomp::ManagerPacket(server) {
+  auto channelServer = std::dynamic_pointer_cast<ChannelServer>(server.lock());
+  auto config = std::dynamic_pointer_cast<objects::ChannelConfig>(
+      channelServer->GetConfig());
+  if (config->GetPerfMonitorEnabled() || config->GetMetricsPort() != 0) {
+    mMetrics = channelServer->GetMetrics();
+  }
+}
 
 ManagerClientPacket::~ManagerClientPacket() {}
 
+bool ManagerClientPacket::ProcessMessage(
+    const libcomp::Message::Message* pMessage) {
+  auto packetMessage = dynamic_cast<const libcomp::Message::Packet*>(pMessage);
+  if (!packetMessage) {
+    return libcomp::ManagerPacket::ProcessMessage(pMessage);
+  }
+
+  // Hold the packet if the client is still being moved to this worker
+  auto client = std::dynamic_pointer_cast<ChannelClientConnection>(
+      packetMessage->GetConnection());
+  size_t worker = ClientWorkerRouter::GetCurrentWorker();
+  if (client && client->HoldPacket(worker, packetMessage)) {
+    return true;
+  }
+
+  return HandlePacket(packetMessage);
+}
+
+bool ManagerClientPacket::HandlePacket(
+    const libcomp::Message::Packet* pMessage) {
+  ServerTime start = ChannelServer::GetServerTime();
+
+  bool result = libcomp::ManagerPacket::ProcessMessage(pMessage);
+
+  ServerTime now = ChannelServer::GetServerTime();
+  uint32_t size = pMessage->GetPacket().Size();
+
+  auto client = std::dynamic_pointer_cast<ChannelClientConnection>(
+      pMessage->GetConnection());
+  if (client) {
+    client->RecordPacket(now, size);
+  }
+
+  if (mMetrics) {
+    // Metric names use the command code in hex, such as "Packet 001c"
+    char szMetric[16];
+    std::snprintf(szMetric, sizeof(szMetric), "Packet %04x",
+                  (uint32_t)pMessage->GetCommandCode());
+
+    std::string metric(szMetric);
+    mMetrics->RecordLatency(metric, now - start);
+    mMetrics->AddCounter(metric + " Bytes", size);
+  }
+
+  return result;
+}
+
 bool ManagerClientPacket::ValidateConnectionState(
     const std::shared_ptr<libcomp::TcpConnection>& connection,
     libcomp::CommandCode_t commandCode) const {
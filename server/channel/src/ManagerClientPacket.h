@@ -30,6 +30,15 @@
 // libcomp Includes
 #include <ManagerPacket.h>
 
+// libhack Includes
+#include <MetricsRegistry.h>
+
+namespace libcomp {
+namespace Message {
+class Packet;
+}  // namespace Message
+}  // namespace libcomp
+
 namespace channel {
 
 /**
@@ -48,10 +57,33 @@ class ManagerClientPacket : public libcomp::ManagerPacket {
    */
   virtual ~ManagerClientPacket();
 
+  /**
+   * Process a client packet, counting it against the client connection
+   * and recording the handler latency and size per command code if
+   * performance metrics are enabled. Packets received while the client is
+   * being moved to this worker are held to be handled in order later.
+   * @param pMessage Message to process
+   * @return true if the message was handled, false if it was not
+   */
+  virtual bool ProcessMessage(const libcomp::Message::Message* pMessage);
+
+  /**
+   * Handle a client packet right away, counting it against the client
+   * connection and recording its metrics.
+   * @param pMessage Packet message to handle
+   * @return true if the message was handled, false if it was not
+   */
+  bool HandlePacket(const libcomp::Message::Packet* pMessage);
+
  protected:
   virtual bool ValidateConnectionState(
       const std::shared_ptr<libcomp::TcpConnection>& connection,
       libcomp::CommandCode_t commandCode) const;
+
+ private:
+  /// Registry packet metrics are recorded to or null if performance
+  /// metrics are disabled
+  std::shared_ptr<libhack::MetricsRegistry> mMetrics;
 };
 
 }  // namespace channel
@@ -43,6 +43,10 @@
 #include "ChannelServer.h"
 #include "ClientState.h"
 
+// Standard C++11 Includes
+#include <functional>
+#include <map>
+
 using namespace channel;
 
 std::list<libcomp::Message::MessageType> ManagerConnection::sSupportedTypes = {
@@ -213,6 +217,32 @@ ManagerConnection::GetAllConnections() {
   return clients;
 }
 
+size_t ManagerConnection::GetConnectionCount() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mClientConnections.size();
+}
+
+std::list<std::shared_ptr<ChannelClientConnection>>
+ManagerConnection::GetTopPacketClients(uint64_t now, size_t count) {
+  std::multimap<float, std::shared_ptr<ChannelClientConnection>,
+                std::greater<float>>
+      sorted;
+  for (auto client : GetAllConnections()) {
+    sorted.insert(std::make_pair(client->GetPacketRate(now), client));
+  }
+
+  std::list<std::shared_ptr<ChannelClientConnection>> clients;
+  for (auto& pair : sorted) {
+    if (clients.size() >= count) {
+      break;
+    }
+
+    clients.push_back(pair.second);
+  }
+
+  return clients;
+}
+
 const std::shared_ptr<ChannelClientConnection>
 ManagerConnection::GetEntityClient(int32_t id, bool worldID) {
   auto state = ClientState::GetEntityClientState(id, worldID);
@@ -121,6 +121,22 @@ class ManagerConnection : public libcomp::Manager {
    */
   std::list<std::shared_ptr<ChannelClientConnection>> GetAllConnections();
 
+  /**
+   * Get the number of client connections that currently exist.
+   * @return Number of client connections
+   */
+  size_t GetConnectionCount();
+
+  /**
+   * Get the client connections receiving the most packets per second.
+   * @param now Current server time
+   * @param count Maximum number of connections to return
+   * @return List of pointers to client connections, ordered from the
+   *  highest packet rate to the lowest
+   */
+  std::list<std::shared_ptr<ChannelClientConnection>> GetTopPacketClients(
+      uint64_t now, size_t count);
+
   /**
    * Get the client connection associated to the supplied entity ID.
    * @param id Entity ID or world ID associated to the client
@@ -403,7 +403,7 @@ bool MatchManager::UpdateUBPoints(
     auto server = mServer.lock();
     auto syncManager = server->GetChannelSyncManager();
 
-    auto dbChanges = libcomp::DatabaseChangeSet::Create();
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
 
     for (auto update : updatedResults) {
       dbChanges->Update(update);
@@ -411,7 +411,7 @@ bool MatchManager::UpdateUBPoints(
       syncManager->UpdateRecord(update, "UBResult");
     }
 
-    server->GetWorldDatabase()->ProcessChangeSet(dbChanges);
+    server->ProcessWorldChangeSet(dbChanges);
 
     syncManager->SyncOutgoing();
 
@@ -851,8 +851,7 @@ bool MatchManager::PvPInviteReply(
         expl->Add("PenaltyCount", 1);
         opChangeset->AddOperation(expl);
 
-        if (!mServer.lock()->GetWorldDatabase()->ProcessChangeSet(
-                opChangeset)) {
+        if (!mServer.lock()->ProcessWorldChangeSet(opChangeset)) {
           LogMatchManagerError([&]() {
             return libcomp::String("Failed to apply PvP penalty: %1\n")
                 .Arg(state->GetAccountUID().ToString());
@@ -899,7 +898,7 @@ std::shared_ptr<objects::PvPData> MatchManager::GetPvPData(
     dbChanges->Insert(pvpData);
     dbChanges->Update(character);
 
-    if (!mServer.lock()->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    if (!mServer.lock()->ProcessWorldChangeSet(dbChanges)) {
       // Rollback but don't kill the client
       character->SetPvPData(NULLUUID);
     }
@@ -1017,10 +1016,16 @@ bool MatchManager::EndPvPMatch(uint32_t instanceID) {
   std::unordered_map<int32_t, int32_t> matchGP;
   std::unordered_map<int32_t, int32_t> matchGPAdjust;
 
+  // Accounts of every participant, for save tracking
+  std::list<libobjgen::UUID> accountUIDs;
+
   for (idx = 0; idx < 2; idx++) {
     for (auto stats : teams[idx]) {
       auto character = stats->GetCharacter().Get();
       auto pvpData = character ? character->GetPvPData().Get(db) : nullptr;
+      if (character) {
+        accountUIDs.push_back(character->GetAccount().GetUUID());
+      }
 
       int32_t gp = pvpData ? pvpData->GetGP() : 0;
       matchGP[stats->GetEntityID()] = gp;
@@ -1265,7 +1270,7 @@ bool MatchManager::EndPvPMatch(uint32_t instanceID) {
   ChannelClientConnection::BroadcastPacket(instance->GetConnections(), p);
 
   // Save updates
-  if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+  if (!server->ProcessWorldChangeSet(dbChanges, accountUIDs)) {
     LogMatchManagerErrorMsg("Failed to save one or more PvP match results");
   }
 
@@ -3397,7 +3402,7 @@ std::shared_ptr<objects::UBResult> MatchManager::LoadUltimateBattleData(
         dbChanges->Insert(result);
       }
 
-      mServer.lock()->GetWorldDatabase()->ProcessChangeSet(dbChanges);
+      mServer.lock()->ProcessWorldChangeSet(dbChanges);
     }
   }
 
@@ -4167,7 +4172,12 @@ bool MatchManager::EndUltimateBattlePhase(const std::shared_ptr<Zone>& zone,
       dbChanges->Update(update);
     }
 
-    server->GetWorldDatabase()->ProcessChangeSet(dbChanges);
+    std::list<libobjgen::UUID> accountUIDs;
+    for (auto client : players) {
+      accountUIDs.push_back(client->GetClientState()->GetAccountUID());
+    }
+
+    server->ProcessWorldChangeSet(dbChanges, accountUIDs);
 
     for (auto update : updatedResults) {
       syncManager->UpdateRecord(update, "UBResult");
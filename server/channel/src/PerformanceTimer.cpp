@@ -26,9 +26,6 @@
 
 #include "PerformanceTimer.h"
 
-// libcomp Includes
-#include <Log.h>
-
 // object Includes
 #include <ChannelConfig.h>
 
@@ -41,21 +38,44 @@ PerformanceTimer::PerformanceTimer(ChannelServer* pServer)
     : mServer(pServer), mStart(0) {
   auto config =
       std::dynamic_pointer_cast<objects::ChannelConfig>(pServer->GetConfig());
-  mEnabled = config->GetPerfMonitorEnabled();
+  mEnabled = config->GetPerfMonitorEnabled() || config->GetMetricsPort() != 0;
+  mTiming = mEnabled || pServer->GetTickRecorder() != nullptr;
 }
 
 void PerformanceTimer::Start() {
-  if (mEnabled) {
+  if (mTiming) {
     mStart = mServer->GetServerTime();
   }
 }
 
-void PerformanceTimer::Stop(const libcomp::String& metric) {
+ServerTime PerformanceTimer::Stop(const libcomp::String& metric) {
+  if (!mTiming) {
+    return 0;
+  }
+
+  ServerTime diff = mServer->GetServerTime() - mStart;
+
   if (mEnabled) {
-    ServerTime diff = mServer->GetServerTime() - mStart;
+    mServer->GetMetrics()->RecordLatency(metric.ToUtf8(), diff);
+  }
+
+  return diff;
+}
 
-    LogGeneralDebug([&]() {
-      return libcomp::String("PERF: %1 in %2 us\n").Arg(metric).Arg(diff);
-    });
+void PerformanceTimer::Report(const libcomp::String& metric, uint64_t value) {
+  if (mEnabled) {
+    mServer->GetMetrics()->SetGauge(metric.ToUtf8(), value);
+  }
+}
+
+void PerformanceTimer::Record(const libcomp::String& metric, uint64_t value) {
+  if (mEnabled) {
+    mServer->GetMetrics()->RecordLatency(metric.ToUtf8(), value);
+  }
+}
+
+void PerformanceTimer::Count(const libcomp::String& metric, uint64_t value) {
+  if (mEnabled) {
+    mServer->GetMetrics()->AddCounter(metric.ToUtf8(), value);
   }
 }
@@ -42,7 +42,9 @@ typedef uint64_t ServerTime;
 #endif  // ServerTime
 
 /**
- * Timer to measure performance of a task.
+ * Timer to measure performance of a task. Measurements are recorded to the
+ * server's metrics registry rather than logged individually and the
+ * channel server periodically logs a summary of each metric.
  */
 class PerformanceTimer {
  protected:
@@ -52,9 +54,13 @@ class PerformanceTimer {
   /// Start time of the performance measurement.
   ServerTime mStart;
 
-  /// If the performance monitor is enabled.
+  /// If the performance monitor or metrics web server is enabled.
   bool mEnabled;
 
+  /// If measurements are timed, either to be recorded or for the tick
+  /// recorder.
+  bool mTiming;
+
  public:
   /**
    * Create the performance timer.
@@ -68,10 +74,37 @@ class PerformanceTimer {
   void Start();
 
   /**
-   * Stop a performance measurement and log it.
+   * Stop a performance measurement and record it to the latency histogram
+   * for the task.
    * @param metric Name of the task that was measured.
+   * @return Time in microseconds the task took or 0 if the performance
+   *  monitor, metrics web server and tick recorder are all disabled.
+   */
+  ServerTime Stop(const libcomp::String &metric);
+
+  /**
+   * Record a point in time measurement of a task, such as a queue depth, if
+   * the performance monitor is enabled.
+   * @param metric Name of the value that was measured.
+   * @param value Value that was measured.
+   */
+  void Report(const libcomp::String &metric, uint64_t value);
+
+  /**
+   * Record a duration measured without the timer, such as how long a
+   * message waited in a queue, if the performance monitor is enabled.
+   * @param metric Name of the task that was measured.
+   * @param value Duration that was measured in microseconds.
+   */
+  void Record(const libcomp::String &metric, uint64_t value);
+
+  /**
+   * Add to a count of events, such as missed ticks, if the performance
+   * monitor is enabled.
+   * @param metric Name of the events that were counted.
+   * @param value Number of events to add.
    */
-  void Stop(const libcomp::String &metric);
+  void Count(const libcomp::String &metric, uint64_t value = 1);
 };
 
 }  // namespace channel
@@ -0,0 +1,346 @@
+/**
+ * @file server/channel/src/PersistenceWorker.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Worker that saves queued database changes off of the tick thread.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PersistenceWorker.h"
+
+// libcomp Includes
+#include <Database.h>
+#include <DatabaseChangeSet.h>
+
+// channel Includes
+#include "ChangeSetCoalescer.h"
+#include "ChannelServer.h"
+#include "PerformanceTimer.h"
+#include "SaveTracker.h"
+
+// Standard C++11 Includes
+#include <iterator>
+#include <unordered_set>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <pthread.h>
+#endif  // !defined(_WIN32) && !defined(__APPLE__)
+
+using namespace channel;
+
+PersistenceWorker::PersistenceWorker(const std::weak_ptr<ChannelServer>& server,
+                                     uint16_t maxBatchSize, uint16_t maxLatency)
+    : mServer(server),
+      mInFlightSince(0),
+      mInFlightCount(0),
+      mMaxBatchSize(maxBatchSize ? maxBatchSize : 1),
+      mMaxLatency(maxLatency ? maxLatency : 1),
+      mRunning(false),
+      mStopped(false) {}
+
+PersistenceWorker::~PersistenceWorker() { Shutdown(); }
+
+void PersistenceWorker::Start() {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mRunning || mStopped) {
+    return;
+  }
+
+  mRunning = true;
+  mThread = std::thread([this]() { Run(); });
+}
+
+void PersistenceWorker::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mStopped) {
+      return;
+    }
+
+    mRunning = false;
+    mStopped = true;
+  }
+
+  mCondition.notify_one();
+
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+
+  // Commit anything left before stopping for good
+  Flush(true);
+}
+
+bool PersistenceWorker::QueueWorldChangeSet(
+    const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+    const std::list<std::shared_ptr<SaveTracker>>& trackers) {
+  auto server = mServer.lock();
+  return Queue(mWorldChanges, server ? server->GetWorldDatabase() : nullptr,
+               changes, trackers);
+}
+
+bool PersistenceWorker::QueueLobbyChangeSet(
+    const std::shared_ptr<libcomp::DatabaseChangeSet>& changes) {
+  auto server = mServer.lock();
+  return Queue(mLobbyChanges, server ? server->GetLobbyDatabase() : nullptr,
+               changes, {});
+}
+
+std::list<libobjgen::UUID> PersistenceWorker::TakeFailures() {
+  std::list<libobjgen::UUID> failures;
+
+  std::lock_guard<std::mutex> lock(mLock);
+  failures.swap(mFailures);
+
+  return failures;
+}
+
+size_t PersistenceWorker::GetQueueDepth() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mWorldChanges.size() + mLobbyChanges.size() + mInFlightCount;
+}
+
+uint64_t PersistenceWorker::GetQueueLag() {
+  uint64_t oldest = 0;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (uint64_t since :
+         {mInFlightSince,
+          mWorldChanges.size() > 0 ? mWorldChanges.front().Time : 0,
+          mLobbyChanges.size() > 0 ? mLobbyChanges.front().Time : 0}) {
+      if (since && (!oldest || since < oldest)) {
+        oldest = since;
+      }
+    }
+  }
+
+  if (!oldest) {
+    return 0;
+  }
+
+  uint64_t now = ChannelServer::GetServerTime();
+  return now > oldest ? (now - oldest) : 0;
+}
+
+bool PersistenceWorker::Queue(
+    std::list<StagedChangeSet>& staged,
+    const std::shared_ptr<libcomp::Database>& db,
+    const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+    const std::list<std::shared_ptr<SaveTracker>>& trackers) {
+  if (!changes) {
+    return false;
+  }
+
+  StagedChangeSet entry;
+  entry.Time = ChannelServer::GetServerTime();
+  entry.Changes = changes;
+  entry.Trackers = trackers;
+
+  bool notify = false;
+  bool stopped = false;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    stopped = mStopped;
+    if (!stopped) {
+      staged.push_back(entry);
+      notify = mRunning && staged.size() >= mMaxBatchSize;
+    } else if (!db) {
+      EndWrites({entry}, {}, {changes->GetTransactionUUID()});
+      return false;
+    }
+  }
+
+  if (notify) {
+    mCondition.notify_one();
+  } else if (stopped) {
+    // Nothing is left to commit it so save it now
+    std::unordered_map<libobjgen::UUID, uint64_t> hashes;
+    HashWrites({entry}, hashes);
+
+    bool saved = db->ProcessChangeSet(changes);
+
+    std::list<libobjgen::UUID> failures;
+    if (!saved) {
+      failures.push_back(changes->GetTransactionUUID());
+    }
+
+    EndWrites({entry}, hashes, failures);
+
+    return saved;
+  }
+
+  return true;
+}
+
+void PersistenceWorker::Run() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+  pthread_setname_np(pthread_self(), "persistence");
+#endif  // !defined(_WIN32) && !defined(__APPLE__)
+
+  while (true) {
+    {
+      // Wait for a batch to fill up or the latency limit to pass
+      std::unique_lock<std::mutex> lock(mLock);
+      mCondition.wait_for(lock, mMaxLatency, [this]() {
+        return !mRunning || mWorldChanges.size() >= mMaxBatchSize ||
+               mLobbyChanges.size() >= mMaxBatchSize;
+      });
+
+      if (!mRunning) {
+        return;
+      }
+    }
+
+    Flush(false);
+  }
+}
+
+void PersistenceWorker::Flush(bool all) {
+  std::list<StagedChangeSet> worldBatch;
+  std::list<StagedChangeSet> lobbyBatch;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto pair : {std::make_pair(&mWorldChanges, &worldBatch),
+                      std::make_pair(&mLobbyChanges, &lobbyBatch)}) {
+      auto& staged = *pair.first;
+      auto& batch = *pair.second;
+
+      auto end = staged.begin();
+      if (all || staged.size() <= mMaxBatchSize) {
+        end = staged.end();
+      } else {
+        std::advance(end, mMaxBatchSize);
+      }
+
+      batch.splice(batch.end(), staged, staged.begin(), end);
+
+      if (batch.size() > 0 &&
+          (!mInFlightSince || batch.front().Time < mInFlightSince)) {
+        mInFlightSince = batch.front().Time;
+      }
+    }
+
+    mInFlightCount = worldBatch.size() + lobbyBatch.size();
+  }
+
+  auto server = mServer.lock();
+  if (server) {
+    Commit(server->GetWorldDatabase(), worldBatch);
+    Commit(server->GetLobbyDatabase(), lobbyBatch);
+  }
+
+  std::lock_guard<std::mutex> lock(mLock);
+  mInFlightSince = 0;
+  mInFlightCount = 0;
+}
+
+void PersistenceWorker::Commit(const std::shared_ptr<libcomp::Database>& db,
+                               const std::list<StagedChangeSet>& batch) {
+  if (!db) {
+    std::list<libobjgen::UUID> failures;
+    for (auto& staged : batch) {
+      failures.push_back(staged.Changes->GetTransactionUUID());
+    }
+
+    EndWrites(batch, {}, failures);
+    return;
+  }
+
+  std::list<std::shared_ptr<libcomp::DatabaseChangeSet>> changes;
+  for (auto& staged : batch) {
+    changes.push_back(staged.Changes);
+  }
+
+  // Hash tracked objects right before they are written so each tracker
+  // ends up with the state the database holds
+  std::unordered_map<libobjgen::UUID, uint64_t> hashes;
+  HashWrites(batch, hashes);
+
+  // Collapse updates to the same object so each is only written once
+  std::list<std::shared_ptr<libcomp::DatabaseChangeSet>> coalesced;
+  auto saved = ChangeSetCoalescer::Coalesce(changes, coalesced);
+
+  for (auto& changeSet : coalesced) {
+    db->QueueChangeSet(changeSet);
+  }
+
+  if (saved.Updates) {
+    auto server = mServer.lock();
+    if (server) {
+      PerformanceTimer perf(server.get());
+      perf.Count("DatabaseWritesCoalesced", saved.Updates);
+      perf.Count("DatabaseChangeSetsCoalesced", saved.ChangeSets);
+    }
+  }
+
+  // Always process the queue as change sets can also be queued on the
+  // database directly
+  auto failures = db->ProcessTransactionQueue();
+  if (failures.size() > 0) {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto& uuid : failures) {
+      mFailures.push_back(uuid);
+    }
+  }
+
+  EndWrites(batch, hashes, failures);
+}
+
+void PersistenceWorker::HashWrites(
+    const std::list<StagedChangeSet>& batch,
+    std::unordered_map<libobjgen::UUID, uint64_t>& hashes) {
+  for (auto& staged : batch) {
+    if (staged.Trackers.empty()) {
+      continue;
+    }
+
+    for (auto& obj : SaveTracker::GetWrites(staged.Changes)) {
+      uint64_t hash = 0;
+      if (hashes.find(obj->GetUUID()) == hashes.end() &&
+          SaveTracker::Hash(obj, hash)) {
+        hashes[obj->GetUUID()] = hash;
+      }
+    }
+  }
+}
+
+void PersistenceWorker::EndWrites(
+    const std::list<StagedChangeSet>& batch,
+    const std::unordered_map<libobjgen::UUID, uint64_t>& hashes,
+    const std::list<libobjgen::UUID>& failures) {
+  std::unordered_set<libobjgen::UUID> failed(failures.begin(),
+                                             failures.end());
+  for (auto& staged : batch) {
+    if (staged.Trackers.empty()) {
+      continue;
+    }
+
+    bool committed = failed.find(staged.Changes->GetTransactionUUID()) ==
+                     failed.end();
+    for (auto& obj : SaveTracker::GetWrites(staged.Changes)) {
+      auto it = hashes.find(obj->GetUUID());
+      for (auto& tracker : staged.Trackers) {
+        tracker->EndWrite(obj->GetUUID(), committed && it != hashes.end(),
+                          it != hashes.end() ? it->second : 0);
+      }
+    }
+  }
+}
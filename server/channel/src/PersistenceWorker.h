@@ -0,0 +1,252 @@
+/**
+ * @file server/channel/src/PersistenceWorker.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Worker that saves queued database changes off of the tick thread.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_PERSISTENCEWORKER_H
+#define SERVER_CHANNEL_SRC_PERSISTENCEWORKER_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// libobjgen Includes
+#include <UUID.h>
+
+namespace libcomp {
+class Database;
+class DatabaseChangeSet;
+}  // namespace libcomp
+
+namespace channel {
+
+class ChannelServer;
+class SaveTracker;
+
+/**
+ * Asynchronous persistence stage for the world and lobby databases. Change
+ * sets queued through the channel are staged here and handed off to the
+ * database transaction queues in group commits on a dedicated thread. A
+ * commit happens once enough change sets have been staged to fill a batch
+ * or the oldest staged change set has waited the maximum latency, so a
+ * slow database never stalls the server tick. Updates to the same object
+ * within a batch are collapsed so each object is only written once.
+ * Accounts that failed to save are collected until the queue worker
+ * retrieves them. Once a change set is committed, the save tracker queued
+ * with it is updated with the state of each object that was written.
+ */
+class PersistenceWorker {
+ public:
+  /**
+   * Create the persistence worker. The thread does not start until Start
+   * is called.
+   * @param server Pointer back to the channel server this belongs to
+   * @param maxBatchSize Maximum number of change sets to commit per
+   *  database at once
+   * @param maxLatency Maximum number of milliseconds a change set can be
+   *  staged before it is committed
+   */
+  PersistenceWorker(const std::weak_ptr<ChannelServer>& server,
+                    uint16_t maxBatchSize, uint16_t maxLatency);
+
+  /**
+   * Stop the worker, committing anything still staged.
+   */
+  ~PersistenceWorker();
+
+  /**
+   * Start the dedicated database thread. The databases must be set on the
+   * server before this is called.
+   */
+  void Start();
+
+  /**
+   * Commit everything still staged and stop the database thread. Change
+   * sets queued afterwards are saved immediately instead.
+   */
+  void Shutdown();
+
+  /**
+   * Stage a change set to be committed to the world database.
+   * @param changes Pointer to the change set to stage
+   * @param trackers Save trackers of the clients the changes belong to,
+   *  if any. Writes of every object inserted or updated by the change set
+   *  must already have been started on each of them.
+   * @return true if the change set was staged or saved, false if it could
+   *  not be saved
+   */
+  bool QueueWorldChangeSet(
+      const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+      const std::list<std::shared_ptr<SaveTracker>>& trackers = {});
+
+  /**
+   * Stage a change set to be committed to the lobby database.
+   * @param changes Pointer to the change set to stage
+   * @return true if the change set was staged or saved, false if it could
+   *  not be saved
+   */
+  bool QueueLobbyChangeSet(
+      const std::shared_ptr<libcomp::DatabaseChangeSet>& changes);
+
+  /**
+   * Get and clear the UUIDs of every account with changes that failed to
+   * commit since the last time this was called.
+   * @return List of failed account UUIDs
+   */
+  std::list<libobjgen::UUID> TakeFailures();
+
+  /**
+   * Get the number of change sets that have not been committed yet.
+   * @return Number of staged and in progress change sets
+   */
+  size_t GetQueueDepth();
+
+  /**
+   * Get how long the oldest change set that has not been committed yet
+   * has been waiting.
+   * @return Queue lag in microseconds, 0 if nothing is waiting
+   */
+  uint64_t GetQueueLag();
+
+ private:
+  /// Change set staged for a database
+  struct StagedChangeSet {
+    /// Server time the change set was staged at
+    uint64_t Time;
+
+    /// Change set to commit
+    std::shared_ptr<libcomp::DatabaseChangeSet> Changes;
+
+    /// Save trackers of the clients the changes belong to, if any
+    std::list<std::shared_ptr<SaveTracker>> Trackers;
+  };
+
+  /**
+   * Stage a change set for the specified database.
+   * @param staged List of change sets staged for the database
+   * @param db Pointer to the database, used if the worker is stopped
+   * @param changes Pointer to the change set to stage
+   * @param trackers Save trackers of the clients the changes belong to,
+   *  if any
+   * @return true if the change set was staged or saved
+   */
+  bool Queue(std::list<StagedChangeSet>& staged,
+             const std::shared_ptr<libcomp::Database>& db,
+             const std::shared_ptr<libcomp::DatabaseChangeSet>& changes,
+             const std::list<std::shared_ptr<SaveTracker>>& trackers);
+
+  /**
+   * Hash every object written by change sets with a save tracker, right
+   * before they are committed.
+   * @param batch List of change sets about to be committed
+   * @param hashes Output map of each object's hash by UUID. Objects that
+   *  could not be hashed are left out.
+   */
+  static void HashWrites(const std::list<StagedChangeSet>& batch,
+                         std::unordered_map<libobjgen::UUID, uint64_t>& hashes);
+
+  /**
+   * Finish the writes started on the save trackers of each change set once
+   * the batch has been committed.
+   * @param batch List of change sets that were committed
+   * @param hashes Hash of each written object by UUID from HashWrites
+   * @param failures UUIDs of the accounts with changes that failed
+   */
+  static void EndWrites(
+      const std::list<StagedChangeSet>& batch,
+      const std::unordered_map<libobjgen::UUID, uint64_t>& hashes,
+      const std::list<libobjgen::UUID>& failures);
+
+  /**
+   * Main loop of the database thread.
+   */
+  void Run();
+
+  /**
+   * Commit one batch from each database.
+   * @param all If true every staged change set will be committed instead
+   *  of only up to a batch worth
+   */
+  void Flush(bool all);
+
+  /**
+   * Hand a batch of change sets to a database's transaction queue and
+   * process the queue, recording any failures.
+   * @param db Pointer to the database
+   * @param batch List of change sets to commit
+   */
+  void Commit(const std::shared_ptr<libcomp::Database>& db,
+              const std::list<StagedChangeSet>& batch);
+
+  /// Pointer to the channel server
+  std::weak_ptr<ChannelServer> mServer;
+
+  /// Change sets staged for the world database
+  std::list<StagedChangeSet> mWorldChanges;
+
+  /// Change sets staged for the lobby database
+  std::list<StagedChangeSet> mLobbyChanges;
+
+  /// UUIDs of accounts with changes that failed to commit
+  std::list<libobjgen::UUID> mFailures;
+
+  /// Server time the oldest change set currently being committed was
+  /// staged at, 0 if nothing is being committed
+  uint64_t mInFlightSince;
+
+  /// Number of change sets currently being committed
+  size_t mInFlightCount;
+
+  /// Maximum number of change sets to commit per database at once
+  size_t mMaxBatchSize;
+
+  /// Maximum amount of time a change set can be staged for
+  std::chrono::milliseconds mMaxLatency;
+
+  /// Dedicated database thread
+  std::thread mThread;
+
+  /// true if the database thread is running
+  bool mRunning;
+
+  /// true once the worker has been shut down
+  bool mStopped;
+
+  /// Lock for staged changes and failures
+  std::mutex mLock;
+
+  /// Signalled when a batch fills up or the worker is shutting down
+  std::condition_variable mCondition;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_PERSISTENCEWORKER_H
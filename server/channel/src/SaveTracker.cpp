@@ -0,0 +1,152 @@
+/**
+ * @file server/channel/src/SaveTracker.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Tracks the last saved state of persistent objects.
+ *
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SaveTracker.h"
+
+// libcomp Includes
+#include <DatabaseChangeSet.h>
+#include <PersistentObject.h>
+
+// Standard C++11 Includes
+#include <sstream>
+
+using namespace channel;
+
+SaveTracker::SaveTracker() {}
+
+SaveTracker::~SaveTracker() {}
+
+void SaveTracker::Mark(const std::shared_ptr<libcomp::PersistentObject>& obj) {
+  if (!obj) {
+    return;
+  }
+
+  uint64_t hash = 0;
+  bool hashed = Hash(obj, hash);
+
+  std::lock_guard<std::mutex> lock(mLock);
+  if (hashed) {
+    mHashes[obj->GetUUID()] = hash;
+  } else {
+    mHashes.erase(obj->GetUUID());
+  }
+}
+
+void SaveTracker::Mark(const libobjgen::UUID& uuid, uint64_t hash) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mHashes[uuid] = hash;
+}
+
+bool SaveTracker::IsChanged(
+    const std::shared_ptr<libcomp::PersistentObject>& obj,
+    uint64_t& hash) const {
+  hash = 0;
+
+  if (!obj || !Hash(obj, hash)) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mPending.find(obj->GetUUID()) != mPending.end()) {
+    return true;
+  }
+
+  auto it = mHashes.find(obj->GetUUID());
+  return it == mHashes.end() || it->second != hash;
+}
+
+void SaveTracker::BeginWrite(const libobjgen::UUID& uuid) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mPending[uuid]++;
+}
+
+void SaveTracker::EndWrite(const libobjgen::UUID& uuid, bool written,
+                           uint64_t hash) {
+  std::lock_guard<std::mutex> lock(mLock);
+  auto it = mPending.find(uuid);
+  if (it != mPending.end() && --it->second == 0) {
+    mPending.erase(it);
+  }
+
+  // Until the last queued write is done the database could still end up
+  // with any of the queued states
+  if (!written) {
+    mHashes.erase(uuid);
+  } else if (mPending.find(uuid) == mPending.end()) {
+    mHashes[uuid] = hash;
+  }
+}
+
+void SaveTracker::Clear() {
+  std::lock_guard<std::mutex> lock(mLock);
+  mHashes.clear();
+}
+
+size_t SaveTracker::Count() const {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mHashes.size();
+}
+
+bool SaveTracker::Hash(const std::shared_ptr<libcomp::PersistentObject>& obj,
+                       uint64_t& hash) {
+  std::stringstream ss;
+  if (!obj->Save(ss)) {
+    return false;
+  }
+
+  // 64-bit FNV-1a
+  hash = 14695981039346656037ULL;
+  for (char c : ss.str()) {
+    hash ^= (uint8_t)c;
+    hash *= 1099511628211ULL;
+  }
+
+  return true;
+}
+
+std::list<std::shared_ptr<libcomp::PersistentObject>> SaveTracker::GetWrites(
+    const std::shared_ptr<libcomp::DatabaseChangeSet>& changes) {
+  std::list<std::shared_ptr<libcomp::PersistentObject>> writes;
+
+  auto standard =
+      std::dynamic_pointer_cast<libcomp::DBStandardChangeSet>(changes);
+  if (standard) {
+    for (auto& obj : standard->GetInserts()) {
+      if (obj) {
+        writes.push_back(obj);
+      }
+    }
+
+    for (auto& obj : standard->GetUpdates()) {
+      if (obj) {
+        writes.push_back(obj);
+      }
+    }
+  }
+
+  return writes;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file server/channel/src/SaveTracker.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Tracks the last saved state of persistent objects.
+ *
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_SAVETRACKER_H
+#define SERVER_CHANNEL_SRC_SAVETRACKER_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// libobjgen Includes
+#include <UUID.h>
+
+namespace libcomp {
+class DatabaseChangeSet;
+class PersistentObject;
+}  // namespace libcomp
+
+namespace channel {
+
+/**
+ * Tracks a hash of the state each persistent object was in when it was
+ * last loaded or written to the database so bulk saves such as the one on
+ * logout can skip objects that have not changed since. The hash covers the
+ * full binary serialization of the object so a change to any member,
+ * including references to other objects, marks it as changed. Objects
+ * that have never been marked are always treated as changed. Any other
+ * save of a tracked object must go through the channel server so the
+ * tracker follows what was written: an object is treated as changed while
+ * a queued write to it is waiting to be committed and is marked with the
+ * state the commit wrote. The tracker is shared by logout, the periodic
+ * character checkpoint and the persistence worker so it is thread safe.
+ */
+class SaveTracker {
+ public:
+  /**
+   * Create an empty tracker.
+   */
+  SaveTracker();
+
+  /**
+   * Clean up the tracker.
+   */
+  ~SaveTracker();
+
+  /**
+   * Record the current state of an object as the state stored in the
+   * database.
+   * @param obj Pointer to the object to mark
+   */
+  void Mark(const std::shared_ptr<libcomp::PersistentObject>& obj);
+
+  /**
+   * Record a hash returned by IsChanged as the state stored in the
+   * database once the object has been saved.
+   * @param uuid UUID of the object that was saved
+   * @param hash Hash of the state that was saved
+   */
+  void Mark(const libobjgen::UUID& uuid, uint64_t hash);
+
+  /**
+   * Check if an object has changed since it was last marked.
+   * @param obj Pointer to the object to check
+   * @param hash Output parameter set to the hash of the object's current
+   *  state to pass to Mark once it has been saved
+   * @return true if the object has changed, has never been marked or
+   *  could not be serialized
+   */
+  bool IsChanged(const std::shared_ptr<libcomp::PersistentObject>& obj,
+                 uint64_t& hash) const;
+
+  /**
+   * Record that a write of an object has been queued. The object is
+   * treated as changed until every queued write of it has been committed.
+   * @param uuid UUID of the object being written
+   */
+  void BeginWrite(const libobjgen::UUID& uuid);
+
+  /**
+   * Record that a queued write of an object has been committed or failed.
+   * Once the last queued write is done the object is marked with the
+   * state that was written.
+   * @param uuid UUID of the object that was written
+   * @param written true if the write was committed, false if it failed
+   *  or the state written is not known
+   * @param hash Hash of the state that was written
+   */
+  void EndWrite(const libobjgen::UUID& uuid, bool written, uint64_t hash);
+
+  /**
+   * Forget every hash so all objects are treated as changed, such as when
+   * queued saves for the account have failed.
+   */
+  void Clear();
+
+  /**
+   * Get the number of objects being tracked.
+   * @return Number of objects being tracked
+   */
+  size_t Count() const;
+
+  /**
+   * Calculate the hash of an object's current state.
+   * @param obj Pointer to the object to hash
+   * @param hash Output parameter set to the hash
+   * @return true if the object was serialized, false if it failed
+   */
+  static bool Hash(const std::shared_ptr<libcomp::PersistentObject>& obj,
+                   uint64_t& hash);
+
+  /**
+   * Get every object a change set writes the full state of. Only standard
+   * change sets are supported as the explicit updates in an operational
+   * change set only write some values.
+   * @param changes Pointer to the change set
+   * @return List of objects inserted or updated by the change set
+   */
+  static std::list<std::shared_ptr<libcomp::PersistentObject>> GetWrites(
+      const std::shared_ptr<libcomp::DatabaseChangeSet>& changes);
+
+ private:
+  /// Hash of the state last marked for each object by UUID
+  std::unordered_map<libobjgen::UUID, uint64_t> mHashes;
+
+  /// Number of queued writes not committed yet for each object by UUID
+  std::unordered_map<libobjgen::UUID, uint32_t> mPending;
+
+  /// Lock for the hashes
+  mutable std::mutex mLock;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_SAVETRACKER_H
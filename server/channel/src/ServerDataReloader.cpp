@@ -0,0 +1,172 @@
+/**
+ * @file server/channel/src/ServerDataReloader.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Reloads changed server data while the channel is running.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ServerDataReloader.h"
+
+// libcomp Includes
+#include <Log.h>
+#include <ServerDataManager.h>
+
+// object Includes
+#include <ChannelConfig.h>
+
+// channel Includes
+#include "ChannelServer.h"
+#include "ClientWorkerRouter.h"
+#include "ZoneManager.h"
+
+using namespace channel;
+
+ServerDataReloader::ServerDataReloader(
+    const std::weak_ptr<ChannelServer>& server)
+    : mServer(server),
+      mRunning(false),
+      mFinished(false),
+      mSuccess(false),
+      mReloaded(0) {}
+
+ServerDataReloader::~ServerDataReloader() {
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+
+  delete mReloaded;
+}
+
+bool ServerDataReloader::Start() {
+  auto server = mServer.lock();
+  if (!server || mRunning.exchange(true)) {
+    return false;
+  }
+
+  auto conf = std::dynamic_pointer_cast<objects::ChannelConfig>(
+      server->GetConfig());
+
+  mFinished = false;
+  mThread = std::thread(&ServerDataReloader::Run, this, server->GetDataStore(),
+                        server->GetDefinitionManager(),
+                        server->GetServerDataManager(),
+                        conf->GetVerifyServerData());
+
+  return true;
+}
+
+bool ServerDataReloader::Tick() {
+  if (!mFinished) {
+    return false;
+  }
+
+  mThread.join();
+  mFinished = false;
+
+  auto reloaded = mReloaded;
+  mReloaded = nullptr;
+
+  for (auto& path : mSkippedFiles) {
+    LogGeneralWarning([&]() {
+      return libcomp::String(
+                 "Server data file changed but can only be loaded on "
+                 "restart: %1\n")
+          .Arg(path);
+    });
+  }
+
+  bool swapped = false;
+  auto server = mServer.lock();
+  if (!mSuccess) {
+    LogGeneralErrorMsg(
+        "Server data reload failed. The current server data will be kept.\n");
+  } else if (!reloaded) {
+    LogGeneralInfoMsg("Server data reload found no changes to apply.\n");
+  } else if (server) {
+    std::shared_ptr<libhack::ServerDataManager> previous(
+        server->SwapServerDataManager(reloaded));
+
+    size_t zones =
+        server->GetZoneManager()->ReconcileZoneDefinitions(previous.get());
+
+    // Workers may still be reading from the replaced data. Each one holds a
+    // reference until it has finished what it was handling at the time of
+    // the swap and the last to let go frees it. The tick thread's own
+    // reference is released once the rest of this tick is done.
+    server->GetClientWorkerRouter()->QueueAllWorkers([previous]() {});
+    server->QueueWork(
+        [](std::shared_ptr<libhack::ServerDataManager> pPrevious) {
+          (void)pPrevious;
+        },
+        previous);
+
+    LogGeneralInfo([&]() {
+      return libcomp::String(
+                 "Server data reloaded from %1 changed file(s), %2 zone(s) "
+                 "to update.\n")
+          .Arg(mChangedFiles.size())
+          .Arg(zones);
+    });
+
+    swapped = true;
+  } else {
+    delete reloaded;
+  }
+
+  mRunning = false;
+
+  return swapped;
+}
+
+void ServerDataReloader::Run(libcomp::DataStore* pDataStore,
+                             libhack::DefinitionManager* definitionManager,
+                             libhack::ServerDataManager* current,
+                             bool verify) {
+#if !defined(_WIN32) && !defined(__APPLE__)
+  pthread_setname_np(pthread_self(), "reload");
+#endif  // !defined(_WIN32) && !defined(__APPLE__)
+
+  LogGeneralInfoMsg("Reloading changed server data...\n");
+
+  mChangedFiles.clear();
+  mSkippedFiles.clear();
+
+  libhack::ServerDataManager* reloaded = nullptr;
+  mSuccess = current->Reload(pDataStore, definitionManager, reloaded,
+                             mChangedFiles, mSkippedFiles);
+
+  if (mSuccess && reloaded && verify) {
+    LogGeneralDebugMsg("Verifying reloaded server data integrity...\n");
+
+    mSuccess = reloaded->VerifyDataIntegrity(definitionManager);
+  }
+
+  if (!mSuccess) {
+    delete reloaded;
+    reloaded = nullptr;
+  }
+
+  mReloaded = reloaded;
+
+  // Publish the results to the tick thread
+  mFinished = true;
+}
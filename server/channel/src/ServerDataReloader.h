@@ -0,0 +1,126 @@
+/**
+ * @file server/channel/src/ServerDataReloader.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Reloads changed server data while the channel is running.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_SERVERDATARELOADER_H
+#define SERVER_CHANNEL_SRC_SERVERDATARELOADER_H
+
+// libcomp Includes
+#include <CString.h>
+
+// Standard C++11 Includes
+#include <atomic>
+#include <list>
+#include <memory>
+#include <thread>
+
+namespace libcomp {
+class DataStore;
+}  // namespace libcomp
+
+namespace libhack {
+class DefinitionManager;
+class ServerDataManager;
+}  // namespace libhack
+
+namespace channel {
+
+class ChannelServer;
+
+/**
+ * Incremental reload of the server data without restarting the channel.
+ * A reload is started on request and runs on its own thread, loading only
+ * the server data files that changed since the current data was loaded
+ * and verifying the result. The tick thread then swaps the new data in
+ * between ticks and updates any running zones built from data that
+ * changed. Data that was replaced is freed once every worker that may
+ * still be reading from it has moved on to later work.
+ */
+class ServerDataReloader {
+ public:
+  /**
+   * Create the reloader.
+   * @param server Pointer back to the channel server this belongs to
+   */
+  ServerDataReloader(const std::weak_ptr<ChannelServer>& server);
+
+  /**
+   * Clean up the reloader, waiting for any reload still running.
+   */
+  ~ServerDataReloader();
+
+  /**
+   * Start reloading the server data in the background.
+   * @return true if the reload started, false if one is already running
+   */
+  bool Start();
+
+  /**
+   * Swap in the server data from a reload that has finished since the
+   * last tick, if any. Only the tick thread should call this.
+   * @return true if new server data was swapped in
+   */
+  bool Tick();
+
+ private:
+  /**
+   * Reload the server data, run on the reload thread.
+   * @param pDataStore Pointer to the datastore to load files from
+   * @param definitionManager Pointer to the definition manager
+   * @param current Pointer to the server data manager currently in use
+   * @param verify true if the reloaded data should be verified
+   */
+  void Run(libcomp::DataStore* pDataStore,
+           libhack::DefinitionManager* definitionManager,
+           libhack::ServerDataManager* current, bool verify);
+
+  /// Pointer to the channel server
+  std::weak_ptr<ChannelServer> mServer;
+
+  /// Thread the current or last reload ran on
+  std::thread mThread;
+
+  /// true while a reload is running or waiting to be swapped in
+  std::atomic<bool> mRunning;
+
+  /// true once the reload thread has finished and its results can be read
+  std::atomic<bool> mFinished;
+
+  /// true if the last reload succeeded
+  bool mSuccess;
+
+  /// Server data loaded by the last reload or null if nothing changed
+  libhack::ServerDataManager* mReloaded;
+
+  /// Files loaded again by the last reload
+  std::list<libcomp::String> mChangedFiles;
+
+  /// Changed files the last reload could not load without a restart
+  std::list<libcomp::String> mSkippedFiles;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_SERVERDATARELOADER_H
@@ -40,6 +40,8 @@
 // Standard C++11 Includes
 #include <math.h>
 
+#include <algorithm>
+
 // object Includes
 #include <Account.h>
 #include <AccountLogin.h>
@@ -1242,8 +1244,8 @@ bool SkillManager::CancelSkill(const std::shared_ptr<ActiveEntityState> source,
       notify.WriteS8(activated->GetActivationID());
       notify.WriteU32Little(0);  // Nothing hit
 
-      mServer.lock()->GetZoneManager()->BroadcastPacket(source->GetZone(),
-                                                        notify);
+      mServer.lock()->GetZoneManager()->BroadcastPacket(
+          source->GetZone(), notify, {source->GetEntityID()});
 
       LogSkillManagerDebug([source, activated]() {
         return libcomp::String("%1 skill %2[%3] has been hit cancelled.\n")
@@ -1290,11 +1292,8 @@ void SkillManager::SendFailure(
   if (client) {
     client->SendPacket(p);
   } else if (source) {
-    auto zone = source->GetZone();
-    if (zone) {
-      auto zConnections = zone->GetConnectionList();
-      ChannelClientConnection::BroadcastPacket(zConnections, p);
-    }
+    mServer.lock()->GetZoneManager()->BroadcastPacket(
+        source->GetZone(), p, {source->GetEntityID()});
   }
 }
 
@@ -3440,9 +3439,17 @@ bool SkillManager::ProcessSkillResult(
           }
 
           // Gather entities in the polygon as well as ones bisected
-          // by the boundaries on their hitbox
+          // by the boundaries on their hitbox. Every corner is within
+          // the AoE range plus the line width of the source point.
+          auto candidates = zone->GetActiveEntitiesNear(
+              srcPoint.x, srcPoint.y, aoeRange + (double)lineWidth);
+          if (std::find(candidates.begin(), candidates.end(),
+                        effectiveSource) == candidates.end()) {
+            effectiveTargets.push_back(effectiveSource);
+          }
+
           uint64_t now = ChannelServer::GetServerTime();
-          for (auto t : zone->GetActiveEntities()) {
+          for (auto t : candidates) {
             if (t == effectiveSource) {
               // Do not check, just add
               effectiveTargets.push_back(t);
@@ -4359,7 +4366,6 @@ void SkillManager::ProcessSkillResultFinal(
     selfDelay = kbTime;
   }
 
-  auto zConnections = zone->GetConnectionList();
   RelativeTimeMap timeMap;
 
   // The skill report packet can easily go over the max packet size so
@@ -4404,10 +4410,15 @@ void SkillManager::ProcessSkillResultFinal(
     p.WriteU32Little(skill.SkillID);
     p.WriteS8(activated->GetActivationID());
 
+    // Only clients shown the source or a target in the batch need it
+    std::set<int32_t> reportEntityIDs = {source->GetEntityID()};
+
     p.WriteU32Little((uint32_t)it->size());
     for (SkillTargetResult* skillTarget : *it) {
       SkillTargetResult& target = *skillTarget;
 
+      reportEntityIDs.insert(target.EntityState->GetEntityID());
+
       p.WriteS32Little(target.EntityState->GetEntityID());
       p.WriteS32Little(abs(target.Damage1));
       p.WriteU8(target.Damage1Type);
@@ -4473,6 +4484,7 @@ void SkillManager::ProcessSkillResultFinal(
         }
 
         target.EntityState->SetStatusTimes(STATUS_KNOCKBACK, kbTime);
+        zone->UpdateSpatialIndex(target.EntityState->GetEntityID());
 
         p.WriteFloat(kbPoint.x);
         p.WriteFloat(kbPoint.y);
@@ -4507,6 +4519,11 @@ void SkillManager::ProcessSkillResultFinal(
                 pSource->SetDestinationX(pRushPoint.x);
                 pSource->SetDestinationY(pRushPoint.y);
                 pSource->SetDestinationTicks(endTime);
+
+                auto pZone = pSource->GetZone();
+                if (pZone) {
+                  pZone->UpdateSpatialIndex(pSource->GetEntityID());
+                }
               },
               source, rushPoint, hitTimings[1]);
         } else {
@@ -4623,6 +4640,8 @@ void SkillManager::ProcessSkillResultFinal(
       p.WriteS32Little(target.PursuitDamage);
     }
 
+    auto zConnections =
+        zoneManager->GetInterestedConnections(zone, reportEntityIDs, p.Size());
     ChannelClientConnection::SendRelativeTimePacket(zConnections, p, timeMap);
   }
 
@@ -4753,10 +4772,10 @@ void SkillManager::ProcessSkillResultFinal(
     // sitting at 0 HP behavior has been observed but to more properly
     // correct this, increase each entity's HP back to 1 via regen
     // client side since it still is server side. Only send this to
-    // the same connections sent the skill packets.
+    // the connections the entity is shown to.
     libcomp::Packet p;
     CharacterManager::GetTDamagePacket(p, entity->GetEntityID(), 1, 0);
-    ChannelClientConnection::BroadcastPacket(zConnections, p);
+    zoneManager->BroadcastPacket(zone, p, {entity->GetEntityID()});
   }
 
   if (interruptEvent.size() > 0) {
@@ -6130,7 +6149,7 @@ void SkillManager::HandleStatusEffects(
                     addStatus->GetMaxStack() == 0;
     bool isReplace = addStatus && addStatus->GetIsReplace();
 
-    auto statusDef = definitionManager->GetStatusData(effectID);
+    auto statusDef = definitionManager->FindStatusData(effectID);
     if (!statusDef) continue;
 
     uint8_t affinity = statusDef->GetCommon()->GetAffinity();
@@ -7255,7 +7274,7 @@ void SkillManager::HandleRevives(
   for (auto entity : revived) {
     libcomp::Packet p;
     if (characterManager->GetEntityRevivalPacket(p, entity, 6)) {
-      zoneManager->BroadcastPacket(zone, p);
+      zoneManager->BroadcastPacket(zone, p, {entity->GetEntityID()});
     }
 
     if (entity->GetEntityType() == EntityType_t::ENEMY) {
@@ -7449,7 +7468,7 @@ void SkillManager::UpdatePvPStats(
     for (auto& sPair : target.AddedStatuses) {
       auto& change = sPair.second;
       if (change.Stack) {
-        auto effect = definitionManager->GetStatusData(change.Type);
+        auto effect = definitionManager->FindStatusData(change.Type);
         switch (effect->GetCommon()->GetCategory()->GetMainCategory()) {
           case STATUS_CATEGORY_BAD:
             if (bStatus.find(entityID) != bStatus.end()) {
@@ -8095,12 +8114,16 @@ void SkillManager::HandleSkillLearning(
   auto server = mServer.lock();
   auto definitionManager = server->GetDefinitionManager();
   auto managerConnection = server->GetManagerConnection();
+  auto dClient =
+      managerConnection->GetEntityClient(dState->GetEntityID(), false);
 
-  auto dbChanges = libcomp::DatabaseChangeSet::Create();
+  auto dbChanges = libcomp::DatabaseChangeSet::Create(
+      dClient ? dClient->GetClientState()->GetAccountUID()
+              : libobjgen::UUID());
 
   std::list<std::pair<uint32_t, int16_t>> updateMap;
   for (auto iSkill : learningSkills) {
-    auto iSkillData = definitionManager->GetSkillData(iSkill->GetSkill());
+    auto iSkillData = definitionManager->FindSkillData(iSkill->GetSkill());
     auto iMod2 =
         iSkillData
             ? (double)iSkillData->GetAcquisition()->GetInheritanceModifier()
@@ -8137,8 +8160,6 @@ void SkillManager::HandleSkillLearning(
   }
 
   if (updateMap.size() > 0) {
-    auto dClient =
-        managerConnection->GetEntityClient(dState->GetEntityID(), false);
     if (dClient) {
       libcomp::Packet p;
       p.WritePacketCode(
@@ -8155,7 +8176,7 @@ void SkillManager::HandleSkillLearning(
 
     dState->RefreshLearningSkills(pSkill->EffectiveAffinity, definitionManager);
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   }
 }
 
@@ -10440,7 +10461,7 @@ bool SkillManager::DirectStatus(
       int8_t stackSize = 1;
       if (!limited) {
         // Add 30% of max stack
-        auto statusData = definitionManager->GetStatusData(effectID);
+        auto statusData = definitionManager->FindStatusData(effectID);
         uint8_t maxStack = statusData->GetBasic()->GetMaxStack();
         stackSize = (int8_t)ceil((float)maxStack / 30.f);
       }
@@ -11465,7 +11486,7 @@ bool SkillManager::Respec(
     dbChanges->Update(character);
     dbChanges->Update(cs);
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
 
     return true;
   } else {
@@ -12347,8 +12368,10 @@ void SkillManager::SendActivateSkill(
   auto source = std::dynamic_pointer_cast<ActiveEntityState>(
       activated->GetSourceEntity());
   auto zone = source ? source->GetZone() : nullptr;
+  // Only clients the source is shown to need the 25 byte packet
   auto zConnections =
-      zone ? zone->GetConnectionList()
+      zone ? mServer.lock()->GetZoneManager()->GetInterestedConnections(
+                 zone, {source->GetEntityID()}, 25)
            : std::list<std::shared_ptr<ChannelClientConnection>>();
   if (zConnections.size() > 0) {
     RelativeTimeMap timeMap;
@@ -12399,8 +12422,10 @@ void SkillManager::SendExecuteSkill(
   auto source = std::dynamic_pointer_cast<ActiveEntityState>(
       activated->GetSourceEntity());
   auto zone = source ? source->GetZone() : nullptr;
+  // Only clients the source is shown to need the 54 byte packet
   auto zConnections =
-      zone ? zone->GetConnectionList()
+      zone ? mServer.lock()->GetZoneManager()->GetInterestedConnections(
+                 zone, {source->GetEntityID()}, 54)
            : std::list<std::shared_ptr<ChannelClientConnection>>();
   if (zConnections.size() > 0) {
     int32_t targetedEntityID = activated->GetEntityTargeted()
@@ -12458,8 +12483,10 @@ void SkillManager::SendExecuteSkillInstant(
   auto source = std::dynamic_pointer_cast<ActiveEntityState>(
       activated->GetSourceEntity());
   auto zone = source ? source->GetZone() : nullptr;
+  // Only clients the source is shown to need the 27 byte packet
   auto zConnections =
-      zone ? zone->GetConnectionList()
+      zone ? mServer.lock()->GetZoneManager()->GetInterestedConnections(
+                 zone, {source->GetEntityID()}, 27)
            : std::list<std::shared_ptr<ChannelClientConnection>>();
   if (zConnections.size() > 0) {
     int32_t targetedEntityID = activated->GetEntityTargeted()
@@ -12503,8 +12530,10 @@ void SkillManager::SendCompleteSkill(
   auto source = std::dynamic_pointer_cast<ActiveEntityState>(
       activated->GetSourceEntity());
   auto zone = source ? source->GetZone() : nullptr;
+  // Only clients the source is shown to need the 21 byte packet
   auto zConnections =
-      zone ? zone->GetConnectionList()
+      zone ? mServer.lock()->GetZoneManager()->GetInterestedConnections(
+                 zone, {source->GetEntityID()}, 21)
            : std::list<std::shared_ptr<ChannelClientConnection>>();
   if (zConnections.size() > 0) {
     RelativeTimeMap timeMap;
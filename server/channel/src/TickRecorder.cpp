@@ -0,0 +1,268 @@
+/**
+ * @file server/channel/src/TickRecorder.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Ring buffer of recent tick timings dumped when a tick overruns.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TickRecorder.h"
+
+// libcomp Includes
+#include <Log.h>
+
+// Ignore warnings
+#include <PushIgnore.h>
+
+// tinyxml2 Includes
+#include <tinyxml2.h>
+
+// Stop ignoring warnings
+#include <PopIgnore.h>
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <pthread.h>
+#endif  // !defined(_WIN32) && !defined(__APPLE__)
+
+using namespace channel;
+
+/// Minimum time in microseconds between two dumps
+static const ServerTime DUMP_COOLDOWN = 60000000ULL;
+
+TickRecorder::TickRecorder(uint16_t tickCount, uint64_t budget,
+                           const libcomp::String& path)
+    : mTicks(tickCount ? tickCount : 1),
+      mTickCount(0),
+      mCurrent(nullptr),
+      mBudget(budget),
+      mPath(path),
+      mNextDump(0),
+      mDumpPending(false),
+      mRunning(true) {
+  mWriter = std::thread([this]() { Run(); });
+}
+
+TickRecorder::~TickRecorder() {
+  {
+    std::lock_guard<std::mutex> lock(mDumpLock);
+    mRunning = false;
+  }
+
+  mDumpCondition.notify_one();
+
+  if (mWriter.joinable()) {
+    mWriter.join();
+  }
+}
+
+TickRecorder::TickRecord* TickRecorder::BeginTick(ServerTime start) {
+  mCurrent = &mTicks[(size_t)(mTickCount % (uint64_t)mTicks.size())];
+
+  // Keep the zone vector's storage so steady state ticks do not allocate
+  mCurrent->Number = mTickCount++;
+  mCurrent->Start = start;
+  mCurrent->Duration = 0;
+  mCurrent->QueueLag = 0;
+  mCurrent->TicksPending = 0;
+  mCurrent->DatabaseQueueDepth = 0;
+  mCurrent->ScheduleWorkDepth = 0;
+  for (size_t i = 0; i < (size_t)Phase::COUNT; i++) {
+    mCurrent->Phases[i] = 0;
+  }
+  mCurrent->Zones.clear();
+
+  return mCurrent;
+}
+
+TickRecorder::TickRecord* TickRecorder::GetCurrentTick() const {
+  return mCurrent;
+}
+
+void TickRecorder::EndTick(uint64_t duration) {
+  TickRecord* current = mCurrent;
+  mCurrent = nullptr;
+
+  if (!current) {
+    return;
+  }
+
+  current->Duration = duration;
+
+  if (duration <= mBudget || current->Start < mNextDump) {
+    return;
+  }
+
+  mNextDump = current->Start + DUMP_COOLDOWN;
+
+  std::unique_lock<std::mutex> lock(mDumpLock, std::try_to_lock);
+  if (!lock.owns_lock() || mDumpPending) {
+    // Still writing the last dump, which covers most of the same ticks
+    return;
+  }
+
+  // Copy the ring oldest record first, reusing the storage of the last copy
+  size_t count = (size_t)std::min(mTickCount, (uint64_t)mTicks.size());
+  mDumpTicks.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    mDumpTicks[i] =
+        mTicks[(size_t)((mTickCount - count + i) % (uint64_t)mTicks.size())];
+  }
+
+  mDumpPending = true;
+  lock.unlock();
+
+  mDumpCondition.notify_one();
+}
+
+void TickRecorder::Run() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+  pthread_setname_np(pthread_self(), "tick_recorder");
+#endif  // !defined(_WIN32) && !defined(__APPLE__)
+
+  std::vector<TickRecord> ticks;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mDumpLock);
+      mDumpCondition.wait(lock, [this]() { return !mRunning || mDumpPending; });
+
+      if (!mDumpPending) {
+        return;
+      }
+
+      // Swap so the tick thread can copy into the old storage next time
+      ticks.swap(mDumpTicks);
+      mDumpPending = false;
+    }
+
+    auto& current = ticks.back();
+
+    auto filename = Dump(ticks);
+    if (filename.IsEmpty()) {
+      LogGeneralError([&]() {
+        return libcomp::String(
+                   "Tick %1 took %2 us but the tick recorder could not be "
+                   "written to: %3\n")
+            .Arg(current.Number)
+            .Arg(current.Duration)
+            .Arg(mPath.IsEmpty() ? libcomp::String(".") : mPath);
+      });
+    } else {
+      LogGeneralWarning([&]() {
+        return libcomp::String(
+                   "Tick %1 took %2 us which is over the %3 us budget. The "
+                   "last %4 tick(s) were written to: %5\n")
+            .Arg(current.Number)
+            .Arg(current.Duration)
+            .Arg(mBudget)
+            .Arg(ticks.size())
+            .Arg(filename);
+      });
+    }
+  }
+}
+
+libcomp::String TickRecorder::Dump(
+    const std::vector<TickRecord>& ticks) const {
+  auto& current = ticks.back();
+
+  tinyxml2::XMLDocument doc;
+
+  tinyxml2::XMLElement* pRoot = doc.NewElement("ticks");
+  pRoot->SetAttribute("budget", (int64_t)mBudget);
+  pRoot->SetAttribute("overrun", (int64_t)current.Number);
+  doc.InsertEndChild(pRoot);
+
+  for (auto& tick : ticks) {
+
+    tinyxml2::XMLElement* pTick = doc.NewElement("tick");
+    pTick->SetAttribute("number", (int64_t)tick.Number);
+    pTick->SetAttribute("start", (int64_t)tick.Start);
+    pTick->SetAttribute("duration", (int64_t)tick.Duration);
+    pTick->SetAttribute("queueLag", (int64_t)tick.QueueLag);
+    pTick->SetAttribute("ticksPending", (int)tick.TicksPending);
+    pTick->SetAttribute("databaseQueueDepth", (int64_t)tick.DatabaseQueueDepth);
+    pTick->SetAttribute("scheduleWorkDepth", (int64_t)tick.ScheduleWorkDepth);
+    pRoot->InsertEndChild(pTick);
+
+    for (size_t p = 0; p < (size_t)Phase::COUNT; p++) {
+      tinyxml2::XMLElement* pPhase = doc.NewElement("phase");
+      pPhase->SetAttribute("name", GetPhaseName((Phase)p));
+      pPhase->SetAttribute("time", (int64_t)tick.Phases[p]);
+      pTick->InsertEndChild(pPhase);
+    }
+
+    for (auto& zone : tick.Zones) {
+      tinyxml2::XMLElement* pZone = doc.NewElement("zone");
+      pZone->SetAttribute("id", zone.ID);
+      pZone->SetAttribute("definitionID", zone.DefinitionID);
+      pZone->SetAttribute("instanceID", zone.InstanceID);
+      pZone->SetAttribute("entities", zone.Entities);
+      pZone->SetAttribute("activeAI", zone.ActiveAI);
+      pZone->SetAttribute("aiTime", (int64_t)zone.AITime);
+      pZone->SetAttribute("spawnTime", (int64_t)zone.SpawnTime);
+      pZone->SetAttribute("time", (int64_t)zone.Time);
+      pTick->InsertEndChild(pZone);
+    }
+  }
+
+  libcomp::String filename =
+      libcomp::String("%1/tick-%2-%3.xml")
+          .Arg(mPath.IsEmpty() ? libcomp::String(".") : mPath)
+          .Arg((int64_t)std::time(0))
+          .Arg(current.Number);
+
+  tinyxml2::XMLPrinter printer;
+  doc.Print(&printer);
+
+  std::ofstream out(filename.C(), std::ios::out | std::ios::trunc);
+  out << printer.CStr();
+  out.close();
+
+  return out.good() ? filename : libcomp::String();
+}
+
+const char* TickRecorder::GetPhaseName(Phase phase) {
+  switch (phase) {
+    case Phase::STATUS_EFFECTS:
+      return "StatusEffects";
+    case Phase::ZONE_UPDATES:
+      return "ZoneUpdates";
+    case Phase::ZONE_MERGE:
+      return "ZoneMerge";
+    case Phase::TIME_RESTRICTED_SPAWNS:
+      return "TimeRestrictedSpawns";
+    case Phase::TRACKING:
+      return "Tracking";
+    case Phase::DATABASE_TRANSACTIONS:
+      return "DatabaseTransactions";
+    case Phase::SCHEDULE_WORK:
+      return "ScheduleWork";
+    default:
+      break;
+  }
+
+  return "Unknown";
+}
@@ -0,0 +1,230 @@
+/**
+ * @file server/channel/src/TickRecorder.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Ring buffer of recent tick timings dumped when a tick overruns.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_TICKRECORDER_H
+#define SERVER_CHANNEL_SRC_TICKRECORDER_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// libcomp Includes
+#include <CString.h>
+
+namespace channel {
+
+#ifndef ServerTime
+typedef uint64_t ServerTime;
+#endif  // ServerTime
+
+/**
+ * Flight recorder for the server tick. Phase timings, queue depths and
+ * per-zone counts for the last N ticks are kept in a fixed size ring and
+ * when a tick takes longer than the configured budget the whole ring is
+ * written to an XML file so the ticks leading up to the overrun can be
+ * looked at after the fact. Ticks are only ever started and ended by the
+ * tick thread. Zone records may be filled in by the zone update workers
+ * but each worker only ever writes to the record for its own zone. Dumps
+ * are written from a copy of the ring by a writer thread so the tick
+ * thread never waits on the disk.
+ */
+class TickRecorder {
+ public:
+  /// Phases of the tick that are timed separately
+  enum class Phase : uint8_t {
+    STATUS_EFFECTS = 0,
+    ZONE_UPDATES,
+    ZONE_MERGE,
+    TIME_RESTRICTED_SPAWNS,
+    TRACKING,
+    DATABASE_TRANSACTIONS,
+    SCHEDULE_WORK,
+    COUNT
+  };
+
+  /// Timings and counts for one zone updated during a tick
+  struct ZoneRecord {
+    /// Unique ID of the zone
+    uint32_t ID;
+
+    /// Definition ID of the zone
+    uint32_t DefinitionID;
+
+    /// Instance ID of the zone or 0 if it is not in an instance
+    uint32_t InstanceID;
+
+    /// Number of active entities in the zone
+    uint32_t Entities;
+
+    /// Number of AI controlled entities updated at full rate
+    uint32_t ActiveAI;
+
+    /// Time in microseconds spent updating AI in the zone
+    uint64_t AITime;
+
+    /// Time in microseconds spent spawning enemies in the zone
+    uint64_t SpawnTime;
+
+    /// Total time in microseconds spent updating the zone
+    uint64_t Time;
+  };
+
+  /// Timings and counts for one tick
+  struct TickRecord {
+    /// Number of ticks started before this one
+    uint64_t Number;
+
+    /// Server time the tick started at
+    ServerTime Start;
+
+    /// Time in microseconds the tick took
+    uint64_t Duration;
+
+    /// Time in microseconds the tick waited in the queue before starting
+    uint64_t QueueLag;
+
+    /// Number of ticks still queued when the tick started
+    uint8_t TicksPending;
+
+    /// Number of change sets waiting to be saved to the database
+    uint64_t DatabaseQueueDepth;
+
+    /// Number of work items still scheduled for later ticks
+    uint64_t ScheduleWorkDepth;
+
+    /// Time in microseconds spent in each phase of the tick
+    uint64_t Phases[(size_t)Phase::COUNT];
+
+    /// Records for each active zone updated during the tick
+    std::vector<ZoneRecord> Zones;
+  };
+
+  /**
+   * Create the recorder.
+   * @param tickCount Number of ticks to keep in the ring
+   * @param budget Tick duration in microseconds that triggers a dump
+   *  when exceeded
+   * @param path Directory to write dumps to or empty for the current
+   *  working directory
+   */
+  TickRecorder(uint16_t tickCount, uint64_t budget,
+               const libcomp::String& path);
+
+  /**
+   * Stop the writer thread once any dump it was given has been written.
+   */
+  ~TickRecorder();
+
+  /**
+   * Start recording a tick, reusing the oldest record in the ring.
+   * @param start Server time the tick started at
+   * @return Pointer to the record for the tick, valid until EndTick
+   */
+  TickRecord* BeginTick(ServerTime start);
+
+  /**
+   * Get the record for the tick currently being processed.
+   * @return Pointer to the record for the current tick or null if no
+   *  tick is being processed
+   */
+  TickRecord* GetCurrentTick() const;
+
+  /**
+   * Finish recording the current tick and hand a copy of the ring to the
+   * writer thread if it took longer than the budget. Dumps are limited to
+   * one a minute so a server that is constantly behind does not fill the
+   * disk.
+   * @param duration Time in microseconds the tick took
+   */
+  void EndTick(uint64_t duration);
+
+ private:
+  /**
+   * Wait for copies of the ring and write them out until the recorder is
+   * destroyed. Runs on the writer thread.
+   */
+  void Run();
+
+  /**
+   * Write recorded ticks to a new file.
+   * @param ticks Copy of the recorded ticks, oldest first, ending with the
+   *  tick that exceeded the budget
+   * @return Path of the file written or empty if it failed
+   */
+  libcomp::String Dump(const std::vector<TickRecord>& ticks) const;
+
+  /**
+   * Get the name a phase is written to dumps with.
+   * @param phase Phase to get the name of
+   * @return Name of the phase
+   */
+  static const char* GetPhaseName(Phase phase);
+
+  /// Ring of tick records
+  std::vector<TickRecord> mTicks;
+
+  /// Number of ticks started, used to find the next record in the ring
+  uint64_t mTickCount;
+
+  /// Record of the tick currently being processed
+  TickRecord* mCurrent;
+
+  /// Tick duration in microseconds that triggers a dump when exceeded
+  uint64_t mBudget;
+
+  /// Directory dumps are written to
+  libcomp::String mPath;
+
+  /// Server time before which overruns are not dumped again
+  ServerTime mNextDump;
+
+  /// Copy of the ring waiting to be written by the writer thread
+  std::vector<TickRecord> mDumpTicks;
+
+  /// true if mDumpTicks has been filled and not written yet
+  bool mDumpPending;
+
+  /// true until the recorder is destroyed
+  bool mRunning;
+
+  /// Lock for the copy waiting to be written
+  std::mutex mDumpLock;
+
+  /// Signalled when a copy is ready to be written or the recorder is
+  /// being destroyed
+  std::condition_variable mDumpCondition;
+
+  /// Thread dumps are written on
+  std::thread mWriter;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_TICKRECORDER_H
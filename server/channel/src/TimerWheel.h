@@ -0,0 +1,328 @@
+/**
+ * @file server/channel/src/TimerWheel.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Hierarchical timing wheel used to schedule timed work.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_TIMERWHEEL_H
+#define SERVER_CHANNEL_SRC_TIMERWHEEL_H
+
+// Standard C++11 Includes
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <unordered_map>
+
+namespace channel {
+
+/**
+ * Hierarchical timing wheel that stores values to be retrieved once a
+ * specified time has passed. Times are bucketed into "slots" of a fixed
+ * resolution across four levels of 256 slots each, giving O(1) insertion,
+ * cancellation and expiration. Entries that are further out than the lower
+ * levels can represent are cascaded down as the wheel advances. The wheel
+ * itself is not thread safe and must be guarded by the owner.
+ */
+template <typename T>
+class TimerWheel {
+ public:
+  /// Handle to an entry that can be used to cancel it. Zero is never
+  /// assigned and represents an invalid handle.
+  typedef uint64_t Handle;
+
+  /**
+   * Create a new timing wheel.
+   * @param start Time the wheel starts at. Nothing scheduled before this
+   *  time will be considered anything but immediately due.
+   * @param resolutionBits Number of low bits of each time that are ignored
+   *  when selecting a slot, i.e. each slot covers 2^resolutionBits time
+   *  units
+   */
+  TimerWheel(uint64_t start, uint8_t resolutionBits)
+      : mResolutionBits(resolutionBits),
+        mCurrent(start >> resolutionBits),
+        mNextHandle(0),
+        mCount(0) {
+    for (size_t level = 0; level < LEVEL_COUNT; level++) {
+      for (size_t idx = 0; idx < SLOT_COUNT; idx++) {
+        Entry& head = mSlots[level][idx];
+        head.Prev = head.Next = &head;
+      }
+    }
+  }
+
+  /**
+   * Clean up the timing wheel. Any values still scheduled are dropped
+   * without being returned so the owner must call Clear first if they
+   * require cleanup.
+   */
+  ~TimerWheel() {
+    std::list<T> dropped;
+    Clear(dropped);
+  }
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  /**
+   * Schedule a value to be returned once the specified time has passed.
+   * @param time Time that needs to pass for the value to become due
+   * @param value Value to schedule
+   * @return Handle that can be used to cancel the entry
+   */
+  Handle Schedule(uint64_t time, const T& value) {
+    Entry* entry = new Entry;
+    entry->ID = ++mNextHandle;
+    entry->Time = time;
+    entry->Value = value;
+
+    Add(entry);
+    mEntries[entry->ID] = entry;
+    mCount++;
+
+    return entry->ID;
+  }
+
+  /**
+   * Cancel a scheduled entry.
+   * @param handle Handle returned when the entry was scheduled
+   * @param value Output parameter to return the cancelled value to so the
+   *  caller can clean it up if needed
+   * @return true if the entry was still scheduled and has been cancelled,
+   *  false if it does not exist or has already been returned
+   */
+  bool Cancel(Handle handle, T& value) {
+    auto it = mEntries.find(handle);
+    if (it == mEntries.end()) {
+      return false;
+    }
+
+    Entry* entry = it->second;
+    mEntries.erase(it);
+
+    Unlink(entry);
+    value = entry->Value;
+    delete entry;
+    mCount--;
+
+    return true;
+  }
+
+  /**
+   * Move the wheel forward to the specified time and return every value
+   * scheduled for that time or before. Values are returned in the order
+   * of the slots they expire in.
+   * @param now Time to advance the wheel to
+   * @param due Output parameter to add each due value to
+   * @return Number of values that were added to the due list
+   */
+  size_t Advance(uint64_t now, std::list<T>& due) {
+    size_t count = 0;
+
+    uint64_t target = now >> mResolutionBits;
+    while (mCurrent < target) {
+      // Everything in a slot that has fully passed is due
+      count += Collect(mSlots[0][mCurrent & SLOT_MASK], UINT64_MAX, due);
+
+      mCurrent++;
+      if ((mCurrent & SLOT_MASK) == 0) {
+        Cascade();
+      }
+    }
+
+    // The current slot can still contain entries later than now
+    count += Collect(mSlots[0][mCurrent & SLOT_MASK], now, due);
+
+    return count;
+  }
+
+  /**
+   * Remove every scheduled entry from the wheel.
+   * @param values Output parameter to return each removed value to
+   */
+  void Clear(std::list<T>& values) {
+    for (size_t level = 0; level < LEVEL_COUNT; level++) {
+      for (size_t idx = 0; idx < SLOT_COUNT; idx++) {
+        Collect(mSlots[level][idx], UINT64_MAX, values);
+      }
+    }
+  }
+
+  /**
+   * Get the number of entries currently scheduled.
+   * @return Number of entries currently scheduled
+   */
+  size_t Count() const { return mCount; }
+
+ private:
+  /// Number of bits used to index the slots in a level
+  static const uint8_t SLOT_BITS = 8;
+
+  /// Number of slots in each level
+  static const size_t SLOT_COUNT = (size_t)1 << SLOT_BITS;
+
+  /// Mask used to get a slot index from a slot time
+  static const uint64_t SLOT_MASK = SLOT_COUNT - 1;
+
+  /// Number of levels in the wheel
+  static const size_t LEVEL_COUNT = 4;
+
+  /// Scheduled entry, stored in an intrusive doubly linked list per slot
+  /// so it can be unlinked in constant time when cancelled.
+  struct Entry {
+    /// Handle assigned to the entry
+    Handle ID;
+
+    /// Time the entry is scheduled for
+    uint64_t Time;
+
+    /// Value to return once the entry is due
+    T Value;
+
+    /// Previous entry in the slot
+    Entry* Prev;
+
+    /// Next entry in the slot
+    Entry* Next;
+  };
+
+  /**
+   * Add an entry to the slot matching its time relative to the current
+   * slot time.
+   * @param entry Pointer to the entry to add
+   */
+  void Add(Entry* entry) {
+    uint64_t slotTime = entry->Time >> mResolutionBits;
+    if (slotTime < mCurrent) {
+      // Already due, process with the current slot
+      slotTime = mCurrent;
+    }
+
+    uint64_t delta = slotTime - mCurrent;
+
+    size_t level = 0;
+    while (level < (LEVEL_COUNT - 1) &&
+           delta >= ((uint64_t)1 << (SLOT_BITS * (level + 1)))) {
+      level++;
+    }
+
+    uint64_t maxDelta = ((uint64_t)1 << (SLOT_BITS * LEVEL_COUNT)) - 1;
+    if (delta > maxDelta) {
+      // Beyond the range of the wheel, park it in the furthest slot and
+      // re-evaluate it when it cascades down
+      slotTime = mCurrent + maxDelta;
+    }
+
+    Entry& head = mSlots[level][(slotTime >> (SLOT_BITS * level)) & SLOT_MASK];
+    entry->Prev = head.Prev;
+    entry->Next = &head;
+    head.Prev->Next = entry;
+    head.Prev = entry;
+  }
+
+  /**
+   * Remove an entry from the slot it is in.
+   * @param entry Pointer to the entry to remove
+   */
+  void Unlink(Entry* entry) {
+    entry->Prev->Next = entry->Next;
+    entry->Next->Prev = entry->Prev;
+    entry->Prev = entry->Next = nullptr;
+  }
+
+  /**
+   * Remove and return every entry in a slot scheduled at or before the
+   * specified time.
+   * @param head Head of the slot to collect from
+   * @param time Latest time to collect
+   * @param due Output parameter to add each collected value to
+   * @return Number of entries collected
+   */
+  size_t Collect(Entry& head, uint64_t time, std::list<T>& due) {
+    size_t count = 0;
+
+    Entry* entry = head.Next;
+    while (entry != &head) {
+      Entry* next = entry->Next;
+      if (entry->Time <= time) {
+        Unlink(entry);
+        mEntries.erase(entry->ID);
+        due.push_back(entry->Value);
+        delete entry;
+        mCount--;
+        count++;
+      }
+
+      entry = next;
+    }
+
+    return count;
+  }
+
+  /**
+   * Re-add the entries of each higher level slot that the current slot
+   * time has just moved into so they spread into the lower levels.
+   */
+  void Cascade() {
+    for (size_t level = 1; level < LEVEL_COUNT; level++) {
+      size_t idx = (size_t)((mCurrent >> (SLOT_BITS * level)) & SLOT_MASK);
+
+      Entry& head = mSlots[level][idx];
+      Entry* entry = head.Next;
+      head.Prev = head.Next = &head;
+      while (entry != &head) {
+        Entry* next = entry->Next;
+        Add(entry);
+        entry = next;
+      }
+
+      if (idx != 0) {
+        // Higher levels only need to cascade when this one wraps
+        break;
+      }
+    }
+  }
+
+  /// Slot heads for each level of the wheel
+  Entry mSlots[LEVEL_COUNT][SLOT_COUNT];
+
+  /// Map of handles to their scheduled entry
+  std::unordered_map<Handle, Entry*> mEntries;
+
+  /// Number of low bits ignored from each time when selecting a slot
+  uint8_t mResolutionBits;
+
+  /// Slot time that has not yet been fully processed
+  uint64_t mCurrent;
+
+  /// Last handle assigned to an entry
+  Handle mNextHandle;
+
+  /// Number of entries currently scheduled
+  size_t mCount;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_TIMERWHEEL_H
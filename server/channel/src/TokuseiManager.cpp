@@ -149,7 +149,7 @@ bool TokuseiManager::Initialize() {
     }
 
     for (uint32_t skillID : skillIDs) {
-      auto skillData = definitionManager->GetSkillData(skillID);
+      auto skillData = definitionManager->FindSkillData(skillID);
       if (skillData) {
         for (int32_t tokuseiID : skillData->GetCharastic()->GetCharastic()) {
           auto it = skillGrantTokusei.find(tokuseiID);
@@ -1120,7 +1120,7 @@ std::list<std::shared_ptr<objects::Tokusei>> TokuseiManager::GetDirectTokusei(
   for (auto pair : eState->GetStatusEffects()) {
     auto sStatus = definitionManager->GetSStatusData(pair.first);
     if (sStatus) {
-      auto statusData = definitionManager->GetStatusData(pair.first);
+      auto statusData = definitionManager->FindStatusData(pair.first);
       uint8_t multiplier = (statusData->GetBasic()->GetStackType() == 2)
                                ? pair.second->GetStack()
                                : 1;
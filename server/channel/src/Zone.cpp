@@ -27,11 +27,14 @@
 #include "Zone.h"
 
 // libcomp Includes
+#include <Constants.h>
 #include <Log.h>
 #include <ScriptEngine.h>
 
 // C++ Standard Includes
+#include <algorithm>
 #include <cmath>
+#include <ctime>
 
 // object Includes
 #include <ActionSpawn.h>
@@ -61,6 +64,52 @@
 
 using namespace channel;
 
+/// Width and height of each cell in a zone's spatial grid. Large enough
+/// that most aggro and skill queries only touch a handful of cells.
+static const float SPATIAL_GRID_CELL_SIZE = 1000.f;
+
+/// Distance an entity filtered by interest has to move away from a client
+/// before it is removed from the client. Further than the draw distance so
+/// entities moving along its edge are not repeatedly removed and shown.
+static const float INTEREST_HIDE_DISTANCE = MAX_ENTITY_DRAW_DISTANCE * 1.25f;
+
+/**
+ * Check if a point is within draw distance of any part of an entity's
+ * current movement.
+ * @param entity Pointer to the entity to check, its current position
+ *  should already be refreshed
+ * @param x X coordinate of the point
+ * @param y Y coordinate of the point
+ * @param range Distance to check instead of the draw distance
+ * @return true if the point is within draw distance
+ */
+static bool InDrawDistance(const std::shared_ptr<ActiveEntityState>& entity,
+                           float x, float y,
+                           float range = MAX_ENTITY_DRAW_DISTANCE) {
+  float rSquared = range * range;
+  if (entity->GetDistance(x, y, true) <= rSquared) {
+    return true;
+  } else if (!entity->IsMoving()) {
+    return false;
+  }
+
+  // Check the closest point on the line the entity is moving along
+  float oX = entity->GetOriginX();
+  float oY = entity->GetOriginY();
+  float dX = entity->GetDestinationX() - oX;
+  float dY = entity->GetDestinationY() - oY;
+
+  float lenSquared = dX * dX + dY * dY;
+  float t = lenSquared > 0.f ? ((x - oX) * dX + (y - oY) * dY) / lenSquared
+                             : 0.f;
+  t = std::max(0.f, std::min(1.f, t));
+
+  float cX = oX + dX * t - x;
+  float cY = oY + dY * t - y;
+
+  return cX * cX + cY * cY <= rSquared;
+}
+
 namespace libcomp {
 template <>
 BaseScriptEngine& BaseScriptEngine::Using<DiasporaBaseState>() {
@@ -123,7 +172,15 @@ BaseScriptEngine& BaseScriptEngine::Using<Zone>() {
 }  // namespace libcomp
 
 Zone::Zone(uint32_t id, const std::shared_ptr<objects::ServerZone>& definition)
-    : mNextRentalExpiration(0),
+    : mDefinitionID(definition->GetID()),
+      mDynamicMapID(definition->GetDynamicMapID()),
+      mSpatialGrid(SPATIAL_GRID_CELL_SIZE),
+      mActiveAICount(0),
+      mReducedAICount(0),
+      mDormantAICount(0),
+      mStatusEffectWheel((uint64_t)std::time(0), 0),
+      mNextRemovalWorkID(1),
+      mNextRentalExpiration(0),
       mNextEncounterID(1),
       mDiasporaMiniBossUpdated(false) {
   SetDefinition(definition);
@@ -157,15 +214,74 @@ Zone::Zone(uint32_t id, const std::shared_ptr<objects::ServerZone>& definition)
 
 Zone::~Zone() {}
 
-uint32_t Zone::GetDefinitionID() { return GetDefinition()->GetID(); }
+uint32_t Zone::GetDefinitionID() { return mDefinitionID; }
+
+uint32_t Zone::GetDynamicMapID() { return mDynamicMapID; }
 
-uint32_t Zone::GetDynamicMapID() { return GetDefinition()->GetDynamicMapID(); }
+std::shared_ptr<objects::ServerZone> Zone::GetCurrentDefinition() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return GetDefinition();
+}
 
 uint32_t Zone::GetInstanceID() {
   auto instance = GetInstance();
   return instance ? instance->GetID() : 0;
 }
 
+bool Zone::IsCompatibleDefinition(
+    const std::shared_ptr<objects::ServerZone>& definition) {
+  auto current = GetDefinition();
+  for (auto& sPair : current->GetSpawns()) {
+    if (!definition->SpawnsKeyExists(sPair.first)) {
+      return false;
+    }
+  }
+
+  for (auto& sgPair : current->GetSpawnGroups()) {
+    if (!definition->SpawnGroupsKeyExists(sgPair.first)) {
+      return false;
+    }
+  }
+
+  for (auto& slgPair : current->GetSpawnLocationGroups()) {
+    if (!definition->SpawnLocationGroupsKeyExists(slgPair.first)) {
+      return false;
+    }
+  }
+
+  for (auto& pPair : current->GetPlasmaSpawns()) {
+    if (!definition->PlasmaSpawnsKeyExists(pPair.first)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Zone::ReconcileDefinition(
+    const std::shared_ptr<objects::ServerZone>& definition) {
+  // Players are added under the lock so none can enter while the
+  // definition is being replaced
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mConnections.size() > 0) {
+    return false;
+  }
+
+  SetDefinition(definition);
+
+  mHasRespawns = definition->PlasmaSpawnsCount() > 0;
+  if (!mHasRespawns) {
+    for (auto slgPair : definition->GetSpawnLocationGroups()) {
+      if (slgPair.second->GetRespawnTime()) {
+        mHasRespawns = true;
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+
 const std::shared_ptr<ZoneGeometry> Zone::GetGeometry() const {
   return mGeometry;
 }
@@ -216,6 +332,8 @@ bool Zone::AddConnection(
     mConnections[state->GetWorldCID()] = client;
     mActiveEntities.push_back(cState);
     mActiveEntities.push_back(dState);
+    mSpatialGrid.Update(cState);
+    mSpatialGrid.Update(dState);
 
     return true;
   } else {
@@ -248,6 +366,9 @@ void Zone::RemoveConnection(
 
   mActiveEntities.remove(cState);
   mActiveEntities.remove(dState);
+  mSpatialGrid.Remove(cState->GetEntityID());
+  mSpatialGrid.Remove(dState->GetEntityID());
+  mShownEntities.erase(worldCID);
 
   // If this zone is not part of an instance, clear the character
   // specific flags
@@ -262,10 +383,50 @@ void Zone::RemoveEntity(int32_t entityID, uint32_t spawnDelay) {
   if (state) {
     std::lock_guard<std::mutex> lock(mLock);
 
+    auto rIter = mRemovalWork.find(entityID);
+    if (rIter != mRemovalWork.end()) {
+      for (uint64_t removalID : rIter->second) {
+        auto cIter = mRemovalWorkCounts.find(removalID);
+        if (cIter != mRemovalWorkCounts.end() && --cIter->second == 0) {
+          mRemovalWorkCounts.erase(cIter);
+
+          // If the handle is not set yet, setting it will fail instead
+          auto hIter = mRemovalWorkHandles.find(removalID);
+          if (hIter != mRemovalWorkHandles.end()) {
+            mObsoleteRemovalWork.push_back(hIter->second);
+            mRemovalWorkHandles.erase(hIter);
+          }
+        }
+      }
+
+      mRemovalWork.erase(rIter);
+    }
+
+    // Drop the entity's next status effect time so it does not linger
+    auto hIter = mStatusEffectHandles.find(entityID);
+    if (hIter != mStatusEffectHandles.end()) {
+      int32_t cancelled;
+      mStatusEffectWheel.Cancel(hIter->second, cancelled);
+      mStatusEffectHandles.erase(hIter);
+    }
+
     mActiveEntities.remove_if(
         [entityID](const std::shared_ptr<ActiveEntityState>& a) {
           return a->GetEntityID() == entityID;
         });
+    mSpatialGrid.Remove(entityID);
+
+    // Keep track of who the entity was shown to so only they are sent
+    // its removal
+    auto active = std::dynamic_pointer_cast<ActiveEntityState>(state);
+    if (active && IsInterestFiltered(active)) {
+      auto& shownTo = mShownRemovals[entityID];
+      for (auto& sPair : mShownEntities) {
+        if (sPair.second.erase(entityID)) {
+          shownTo.insert(sPair.first);
+        }
+      }
+    }
 
     std::shared_ptr<ActiveEntityState> removeSpawn;
     switch (state->GetEntityType()) {
@@ -411,6 +572,79 @@ void Zone::RemoveEntity(int32_t entityID, uint32_t spawnDelay) {
   UnregisterEntityState(entityID);
 }
 
+uint64_t Zone::RegisterRemovalWork(const std::list<int32_t>& entityIDs) {
+  std::lock_guard<std::mutex> lock(mLock);
+
+  uint64_t removalID = mNextRemovalWorkID;
+
+  size_t count = 0;
+  for (int32_t entityID : entityIDs) {
+    if (mAllEntities.find(entityID) != mAllEntities.end() &&
+        mRemovalWork[entityID].insert(removalID).second) {
+      count++;
+    }
+  }
+
+  if (!count) {
+    // Nothing to remove already
+    return 0;
+  }
+
+  mRemovalWorkCounts[removalID] = count;
+  mNextRemovalWorkID++;
+
+  return removalID;
+}
+
+bool Zone::SetRemovalWorkHandle(uint64_t removalID, uint64_t handle) {
+  std::lock_guard<std::mutex> lock(mLock);
+
+  if (mRemovalWorkCounts.find(removalID) == mRemovalWorkCounts.end()) {
+    return false;
+  }
+
+  mRemovalWorkHandles[removalID] = handle;
+
+  return true;
+}
+
+void Zone::CompleteRemovalWork(uint64_t removalID,
+                               const std::list<int32_t>& entityIDs) {
+  std::lock_guard<std::mutex> lock(mLock);
+
+  mRemovalWorkCounts.erase(removalID);
+  mRemovalWorkHandles.erase(removalID);
+
+  for (int32_t entityID : entityIDs) {
+    auto rIter = mRemovalWork.find(entityID);
+    if (rIter != mRemovalWork.end()) {
+      rIter->second.erase(removalID);
+      if (rIter->second.size() == 0) {
+        mRemovalWork.erase(rIter);
+      }
+    }
+  }
+}
+
+std::list<uint64_t> Zone::TakeObsoleteRemovalWork(bool all) {
+  std::lock_guard<std::mutex> lock(mLock);
+
+  std::list<uint64_t> handles;
+  handles.swap(mObsoleteRemovalWork);
+
+  if (all) {
+    for (auto& pair : mRemovalWorkHandles) {
+      handles.push_back(pair.second);
+    }
+
+    mRemovalWork.clear();
+    mRemovalWorkCounts.clear();
+    mRemovalWorkHandles.clear();
+  }
+
+  return handles;
+}
+
 void Zone::AddAlly(const std::shared_ptr<AllyState>& ally,
                    uint64_t staggerTime) {
   {
@@ -546,6 +780,11 @@ const std::list<std::shared_ptr<ActiveEntityState>> Zone::GetActiveEntities() {
   return mActiveEntities;
 }
 
+size_t Zone::GetActiveEntityCount() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mActiveEntities.size();
+}
+
 const std::list<std::shared_ptr<ActiveEntityState>>
 Zone::GetActiveEntitiesInRadius(float x, float y, double radius,
                                 bool useHitbox) {
@@ -555,7 +794,15 @@ Zone::GetActiveEntitiesInRadius(float x, float y, double radius,
 
   float rSquared = (float)std::pow(radius, 2);
 
-  for (auto active : GetActiveEntities()) {
+  // The hitbox check below compares against the radius itself rather than
+  // its square so widen the search to cover it. Hitboxes are already part
+  // of each entity's indexed bounds.
+  double searchRadius = radius;
+  if (useHitbox && radius > 0.0) {
+    searchRadius = std::max(radius, std::sqrt(radius));
+  }
+
+  for (auto active : GetActiveEntitiesNear(x, y, searchRadius)) {
     active->RefreshCurrentPosition(now);
 
     float sqDist = active->GetDistance(x, y, true);
@@ -575,6 +822,275 @@ Zone::GetActiveEntitiesInRadius(float x, float y, double radius,
   return results;
 }
 
+const std::list<std::shared_ptr<ActiveEntityState>> Zone::GetActiveEntitiesNear(
+    float x, float y, double radius) {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mSpatialGrid.Query(x, y, (float)radius);
+}
+
+void Zone::UpdateSpatialIndex(int32_t entityID) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mSpatialGrid.Refresh(entityID);
+}
+
+size_t Zone::SyncSpatialIndex() {
+  size_t updated = 0;
+
+  std::lock_guard<std::mutex> lock(mLock);
+  for (auto& active : mActiveEntities) {
+    if (mSpatialGrid.Update(active)) {
+      updated++;
+    }
+  }
+
+  return updated;
+}
+
+std::list<std::shared_ptr<ChannelClientConnection>>
+Zone::GetInterestedConnections(const std::shared_ptr<ActiveEntityState>& entity,
+                               uint64_t now, std::list<int32_t>& skipped) {
+  std::list<std::shared_ptr<ChannelClientConnection>> connections;
+
+  entity->RefreshCurrentPosition(now);
+  for (auto connection : GetConnectionList()) {
+    auto state = connection->GetClientState();
+    auto cState = state->GetCharacterState();
+    if (cState == entity || state->GetDemonState() == entity) {
+      connections.push_back(connection);
+      continue;
+    }
+
+    cState->RefreshCurrentPosition(now);
+    if (InDrawDistance(entity, cState->GetCurrentX(), cState->GetCurrentY())) {
+      connections.push_back(connection);
+    } else {
+      skipped.push_back(state->GetWorldCID());
+    }
+  }
+
+  return connections;
+}
+
+bool Zone::IsInterestFiltered(
+    const std::shared_ptr<ActiveEntityState>& entity) {
+  switch (entity->GetEntityType()) {
+    case EntityType_t::ENEMY:
+    case EntityType_t::ALLY:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::list<std::shared_ptr<ChannelClientConnection>>
+Zone::GetInterestedConnections(const std::set<int32_t>& entityIDs,
+                               size_t& skipped) {
+  std::list<std::shared_ptr<ChannelClientConnection>> connections;
+
+  std::lock_guard<std::mutex> lock(mLock);
+
+  bool filtered = entityIDs.size() > 0;
+  for (int32_t entityID : entityIDs) {
+    auto eIter = mAllEntities.find(entityID);
+    auto active = eIter != mAllEntities.end()
+                      ? std::dynamic_pointer_cast<ActiveEntityState>(
+                            eIter->second)
+                      : nullptr;
+    if (!active || !IsInterestFiltered(active)) {
+      filtered = false;
+      break;
+    }
+  }
+
+  for (auto& cPair : mConnections) {
+    bool interested = !filtered;
+    if (!interested) {
+      auto sIter = mShownEntities.find(cPair.first);
+      if (sIter != mShownEntities.end()) {
+        for (int32_t entityID : entityIDs) {
+          if (sIter->second.find(entityID) != sIter->second.end()) {
+            interested = true;
+            break;
+          }
+        }
+      }
+    }
+
+    if (interested) {
+      connections.push_back(cPair.second);
+    } else {
+      skipped++;
+    }
+  }
+
+  return connections;
+}
+
+void Zone::SetEntityShown(int32_t entityID,
+                          const std::list<int32_t>& worldCIDs) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mAllEntities.find(entityID) == mAllEntities.end()) {
+    // Removed while being shown
+    return;
+  }
+
+  for (int32_t worldCID : worldCIDs) {
+    // Ignore anyone that left while the entity was being shown
+    if (mConnections.find(worldCID) != mConnections.end()) {
+      mShownEntities[worldCID].insert(entityID);
+    }
+  }
+}
+
+std::set<int32_t> Zone::ShowEntitiesInRange(
+    const std::shared_ptr<ChannelClientConnection>& client, uint64_t now) {
+  std::set<int32_t> entityIDs;
+
+  auto state = client->GetClientState();
+  auto cState = state->GetCharacterState();
+  cState->RefreshCurrentPosition(now);
+
+  float x = cState->GetCurrentX();
+  float y = cState->GetCurrentY();
+
+  for (auto active : GetActiveEntitiesNear(x, y, MAX_ENTITY_DRAW_DISTANCE)) {
+    if (IsInterestFiltered(active)) {
+      active->RefreshCurrentPosition(now);
+      if (InDrawDistance(active, x, y)) {
+        entityIDs.insert(active->GetEntityID());
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mConnections.find(state->GetWorldCID()) != mConnections.end()) {
+    mShownEntities[state->GetWorldCID()] = entityIDs;
+  }
+
+  return entityIDs;
+}
+
+void Zone::UpdateInterest(
+    uint64_t now, std::unordered_map<int32_t, std::list<int32_t>>& shows,
+    std::unordered_map<int32_t, std::list<int32_t>>& hides) {
+  std::unordered_map<int32_t, std::shared_ptr<ChannelClientConnection>>
+      connections;
+  std::unordered_map<int32_t, std::set<int32_t>> shown;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    connections = mConnections;
+    shown = mShownEntities;
+
+    // Removals not sent by now never will be
+    mShownRemovals.clear();
+  }
+
+  // Work out what changed for each client first so the lock is not held
+  // while positions are refreshed
+  std::unordered_map<int32_t, std::set<int32_t>> showIDs;
+  std::unordered_map<int32_t, std::set<int32_t>> hideIDs;
+  for (auto& cPair : connections) {
+    auto cState = cPair.second->GetClientState()->GetCharacterState();
+    cState->RefreshCurrentPosition(now);
+
+    float x = cState->GetCurrentX();
+    float y = cState->GetCurrentY();
+
+    auto& current = shown[cPair.first];
+    for (int32_t entityID : current) {
+      auto active = GetActiveEntity(entityID);
+      if (active) {
+        active->RefreshCurrentPosition(now);
+      }
+
+      if (!active || !InDrawDistance(active, x, y, INTEREST_HIDE_DISTANCE)) {
+        hideIDs[cPair.first].insert(entityID);
+      }
+    }
+
+    for (auto active : GetActiveEntitiesNear(x, y, MAX_ENTITY_DRAW_DISTANCE)) {
+      if (IsInterestFiltered(active) &&
+          current.find(active->GetEntityID()) == current.end() &&
+          active->GetDisplayState() == ActiveDisplayState_t::ACTIVE) {
+        active->RefreshCurrentPosition(now);
+        if (InDrawDistance(active, x, y)) {
+          showIDs[cPair.first].insert(active->GetEntityID());
+        }
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mLock);
+  for (auto& hPair : hideIDs) {
+    auto sIter = mShownEntities.find(hPair.first);
+    if (sIter == mShownEntities.end()) {
+      continue;
+    }
+
+    for (int32_t entityID : hPair.second) {
+      // Entities removed from the zone in the meantime had their removal
+      // sent already
+      if (sIter->second.erase(entityID) &&
+          mAllEntities.find(entityID) != mAllEntities.end()) {
+        hides[hPair.first].push_back(entityID);
+      }
+    }
+  }
+
+  for (auto& sPair : showIDs) {
+    if (mConnections.find(sPair.first) == mConnections.end()) {
+      continue;
+    }
+
+    auto& current = mShownEntities[sPair.first];
+    for (int32_t entityID : sPair.second) {
+      if (mAllEntities.find(entityID) != mAllEntities.end() &&
+          current.insert(entityID).second) {
+        shows[sPair.first].push_back(entityID);
+      }
+    }
+  }
+}
+
+std::unordered_map<int32_t, std::set<int32_t>> Zone::TakeShownRemovals(
+    const std::list<int32_t>& entityIDs) {
+  std::unordered_map<int32_t, std::set<int32_t>> removals;
+
+  std::lock_guard<std::mutex> lock(mLock);
+  for (int32_t entityID : entityIDs) {
+    auto rIter = mShownRemovals.find(entityID);
+    if (rIter != mShownRemovals.end()) {
+      removals[entityID] = rIter->second;
+      mShownRemovals.erase(rIter);
+    }
+  }
+
+  return removals;
+}
+
+void Zone::SetAIUpdateCounts(uint32_t active, uint32_t reduced,
+                             uint32_t dormant) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mActiveAICount = active;
+  mReducedAICount = reduced;
+  mDormantAICount = dormant;
+}
+
+uint32_t Zone::GetActiveAICount() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mActiveAICount;
+}
+
+uint32_t Zone::GetReducedAICount() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mReducedAICount;
+}
+
+uint32_t Zone::GetDormantAICount() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mDormantAICount;
+}
+
 std::shared_ptr<AllyState> Zone::GetAlly(int32_t id) {
   return std::dynamic_pointer_cast<AllyState>(GetEntity(id));
 }
@@ -965,39 +1481,47 @@ std::shared_ptr<ServerObjectState> Zone::GetServerObject(int32_t id) {
 
 void Zone::SetNextStatusEffectTime(uint32_t time, int32_t entityID) {
   std::lock_guard<std::mutex> lock(mLock);
-  if (time) {
-    mNextEntityStatusTimes[time].insert(entityID);
-  } else {
-    for (auto pair : mNextEntityStatusTimes) {
-      pair.second.erase(entityID);
+
+  // An entity only ever needs to be handled at its earliest time so any
+  // time already scheduled is replaced
+  auto it = mStatusEffectHandles.find(entityID);
+  if (it != mStatusEffectHandles.end()) {
+    int32_t cancelled;
+    mStatusEffectWheel.Cancel(it->second, cancelled);
+
+    if (!time) {
+      mStatusEffectHandles.erase(it);
+      return;
     }
   }
+
+  if (time) {
+    mStatusEffectHandles[entityID] =
+        mStatusEffectWheel.Schedule((uint64_t)time, entityID);
+  }
 }
 
 std::list<std::shared_ptr<ActiveEntityState>>
 Zone::GetUpdatedStatusEffectEntities(uint32_t now) {
   std::list<std::shared_ptr<ActiveEntityState>> result;
-  std::set<uint32_t> passed;
+  std::list<int32_t> due;
 
   std::lock_guard<std::mutex> lock(mLock);
-  for (auto pair : mNextEntityStatusTimes) {
-    if (pair.first > now) break;
-
-    passed.insert(pair.first);
-    for (auto entityID : pair.second) {
-      auto it = mAllEntities.find(entityID);
-      auto active =
-          it != mAllEntities.end()
-              ? std::dynamic_pointer_cast<ActiveEntityState>(it->second)
-              : nullptr;
-      if (active) {
-        result.push_back(active);
-      }
-    }
+  if (!mStatusEffectWheel.Advance((uint64_t)now, due)) {
+    return result;
   }
 
-  for (auto p : passed) {
-    mNextEntityStatusTimes.erase(p);
+  for (int32_t entityID : due) {
+    mStatusEffectHandles.erase(entityID);
+
+    auto it = mAllEntities.find(entityID);
+    auto active =
+        it != mAllEntities.end()
+            ? std::dynamic_pointer_cast<ActiveEntityState>(it->second)
+            : nullptr;
+    if (active) {
+      result.push_back(active);
+    }
   }
 
   return result;
@@ -1577,6 +2101,7 @@ void Zone::Cleanup() {
     }
   }
 
+  mSpatialGrid.Clear();
   mAllies.clear();
   mBases.clear();
   mBazaars.clear();
@@ -1593,6 +2118,12 @@ void Zone::Cleanup() {
   mSpawnGroups.clear();
   mSpawnLocationGroups.clear();
   mStaggeredSpawns.clear();
+  mShownEntities.clear();
+  mShownRemovals.clear();
+
+  std::list<int32_t> scheduled;
+  mStatusEffectWheel.Clear(scheduled);
+  mStatusEffectHandles.clear();
 
   mZoneInstance = nullptr;
 
@@ -1690,6 +2221,7 @@ bool Zone::TimeRestrictionActive(
 void Zone::AddSpawnedEntity(const std::shared_ptr<ActiveEntityState>& state,
                             uint32_t spotID, uint32_t sgID, uint32_t slgID) {
   mActiveEntities.push_back(state);
+  mSpatialGrid.Update(state);
 
   if (spotID != 0) {
     mSpotsSpawned.insert(spotID);
@@ -37,7 +37,9 @@
 #include "ChannelClientConnection.h"
 #include "EnemyState.h"
 #include "EntityState.h"
+#include "TimerWheel.h"
 #include "ZoneGeometry.h"
+#include "ZoneSpatialGrid.h"
 
 // object Includes
 #include <ServerZoneInstanceVariant.h>
@@ -106,6 +108,14 @@ class Zone : public objects::ZoneObject {
    */
   uint32_t GetDynamicMapID();
 
+  /**
+   * Get the zone definition under the zone lock. Use this instead of
+   * GetDefinition when no player is in the zone yet, as the definition
+   * can be replaced by a reload until then.
+   * @return Pointer to the current ServerZone definition
+   */
+  std::shared_ptr<objects::ServerZone> GetCurrentDefinition();
+
   /**
    * Get the assigned instance ID of the zone or zero if it is not part of
    * an instance
@@ -113,6 +123,31 @@ class Zone : public objects::ZoneObject {
    */
   uint32_t GetInstanceID();
 
+  /**
+   * Check if a definition reloaded from changed server data can replace
+   * the current zone definition. Entities already in the zone keep
+   * referring to the spawns, spawn groups, spawn location groups and
+   * plasma they came from so the new definition must still contain every
+   * one of them.
+   * @param definition Pointer to the new ServerZone definition
+   * @return true if the definition is compatible with the current one
+   */
+  bool IsCompatibleDefinition(
+      const std::shared_ptr<objects::ServerZone>& definition);
+
+  /**
+   * Replace the zone definition with one reloaded from changed server
+   * data if no players are in the zone. The definition is read without
+   * the zone lock by the workers handling the players in the zone so it
+   * can only be replaced once they are gone. NPCs, objects and other
+   * entities built when the zone was created are not rebuilt.
+   * @param definition Pointer to the new compatible ServerZone definition
+   * @return true if the definition was replaced, false if players are
+   *  still in the zone
+   */
+  bool ReconcileDefinition(
+      const std::shared_ptr<objects::ServerZone>& definition);
+
   /**
    * Get the geometry information bound to the zone
    * @return Geometry information bound to the zone
@@ -191,6 +226,43 @@ class Zone : public objects::ZoneObject {
    */
   void RemoveEntity(int32_t entityID, uint32_t spawnDelay = 0);
 
+  /**
+   * Register work to be scheduled to remove one or more entities from the
+   * zone. Once every entity it applies to has been removed, the handle set
+   * for the work will be returned from TakeObsoleteRemovalWork.
+   * @param entityIDs List of IDs associated to entities the work removes
+   * @return ID of the removal work in the zone or 0 if none of the entities
+   *  are in the zone
+   */
+  uint64_t RegisterRemovalWork(const std::list<int32_t>& entityIDs);
+
+  /**
+   * Set the handle of the scheduled work registered for a removal.
+   * @param removalID ID returned from RegisterRemovalWork
+   * @param handle Handle of the scheduled work
+   * @return false if the removal has already completed or has no entities
+   *  left to remove, in which case the work should be cancelled
+   */
+  bool SetRemovalWorkHandle(uint64_t removalID, uint64_t handle);
+
+  /**
+   * Clear a removal registered via RegisterRemovalWork once its work runs,
+   * regardless of which entities it actually removes.
+   * @param removalID ID returned from RegisterRemovalWork
+   * @param entityIDs List of IDs the removal was registered with
+   */
+  void CompleteRemovalWork(uint64_t removalID,
+                           const std::list<int32_t>& entityIDs);
+
+  /**
+   * Get and clear the handles of scheduled removal work that no longer
+   * has any entity left to remove so it can be cancelled.
+   * @param all If true, every registered handle will be returned instead,
+   *  such as when the zone is being cleaned up
+   * @return List of scheduled removal work handles
+   */
+  std::list<uint64_t> TakeObsoleteRemovalWork(bool all = false);
+
   /**
    * Add an ally to the zone
    * @param ally Pointer to the ally to add
@@ -281,6 +353,12 @@ class Zone : public objects::ZoneObject {
    */
   const std::list<std::shared_ptr<ActiveEntityState>> GetActiveEntities();
 
+  /**
+   * Get the number of active entities in the zone
+   * @return Number of active entities
+   */
+  size_t GetActiveEntityCount();
+
   /**
    * Get all active entities in the zone within a supplied radius
    * @param x X coordinate of the center of the radius
@@ -293,6 +371,148 @@ class Zone : public objects::ZoneObject {
   const std::list<std::shared_ptr<ActiveEntityState>> GetActiveEntitiesInRadius(
       float x, float y, double radius, bool useHitbox = false);
 
+  /**
+   * Get all active entities in the zone that could be within a supplied
+   * radius based upon the zone's spatial grid. Entities are not checked
+   * individually so positions must still be refreshed and compared by
+   * the caller. Hitboxes are accounted for in the grid so the radius does
+   * not need to be extended by them.
+   * @param x X coordinate of the center of the radius
+   * @param y Y coordinate of the center of the radius
+   * @param radius Radius to check for entities
+   * @return List of pointers to active entities that could be in the radius
+   */
+  const std::list<std::shared_ptr<ActiveEntityState>> GetActiveEntitiesNear(
+      float x, float y, double radius);
+
+  /**
+   * Update the spatial grid position of an active entity. This should be
+   * called any time an entity in the zone is given a new origin, current
+   * or destination position.
+   * @param entityID ID of the entity that moved
+   */
+  void UpdateSpatialIndex(int32_t entityID);
+
+  /**
+   * Update the spatial grid position of every active entity in the zone
+   * that has moved since it was last indexed. This is run each tick to
+   * catch any positional changes that were not explicitly updated.
+   * @return Number of entities that changed grid cells
+   */
+  size_t SyncSpatialIndex();
+
+  /**
+   * Get the client connections in the zone whose character is within draw
+   * distance of any part of an entity's current movement. A client's own
+   * character and demon are always in range of the client.
+   * @param entity Pointer to the entity being updated
+   * @param now Current server time
+   * @param skipped Output list of the world CIDs of every connection in
+   *  the zone that is not in range of the entity
+   * @return List of client connections in range of the entity
+   */
+  std::list<std::shared_ptr<ChannelClientConnection>> GetInterestedConnections(
+      const std::shared_ptr<ActiveEntityState>& entity, uint64_t now,
+      std::list<int32_t>& skipped);
+
+  /**
+   * Check if an entity is only shown to the client connections within draw
+   * distance of it when interest filtering is enabled. Only AI controlled
+   * entities are filtered since their data can be sent again in full when
+   * they come back into range.
+   * @param entity Pointer to the entity to check
+   * @return true if the entity is filtered by interest
+   */
+  static bool IsInterestFiltered(
+      const std::shared_ptr<ActiveEntityState>& entity);
+
+  /**
+   * Get the client connections in the zone that should receive an update
+   * about one or more entities. Entities filtered by interest are only
+   * updated for connections they are currently shown to, every other
+   * entity is updated for the whole zone.
+   * @param entityIDs IDs of the entities the update is about
+   * @param skipped Output parameter to return the number of connections
+   *  in the zone that will not receive the update
+   * @return List of client connections to send the update to
+   */
+  std::list<std::shared_ptr<ChannelClientConnection>> GetInterestedConnections(
+      const std::set<int32_t>& entityIDs, size_t& skipped);
+
+  /**
+   * Mark an entity filtered by interest as shown to client connections.
+   * @param entityID ID of the entity being shown
+   * @param worldCIDs World CIDs of the connections it is shown to
+   */
+  void SetEntityShown(int32_t entityID, const std::list<int32_t>& worldCIDs);
+
+  /**
+   * Mark every entity filtered by interest that is within draw distance of
+   * a client connection as shown to it, such as when the client enters the
+   * zone.
+   * @param client Pointer to the client connection
+   * @param now Current server time
+   * @return IDs of the entities now shown to the client
+   */
+  std::set<int32_t> ShowEntitiesInRange(
+      const std::shared_ptr<ChannelClientConnection>& client, uint64_t now);
+
+  /**
+   * Update which entities filtered by interest are shown to each client
+   * connection in the zone. Entities that came within draw distance of a
+   * client are marked as shown and entities that moved well out of draw
+   * distance are marked as no longer shown.
+   * @param now Current server time
+   * @param shows Output map of world CIDs to the IDs of entities that need
+   *  to be shown to the client
+   * @param hides Output map of world CIDs to the IDs of entities that need
+   *  to be removed from the client
+   */
+  void UpdateInterest(
+      uint64_t now, std::unordered_map<int32_t, std::list<int32_t>>& shows,
+      std::unordered_map<int32_t, std::list<int32_t>>& hides);
+
+  /**
+   * Get and clear the world CIDs of the client connections that removed
+   * entities filtered by interest were shown to when they were removed
+   * from the zone, so their removal is only sent to those connections.
+   * @param entityIDs IDs of the removed entities
+   * @return Map of entity IDs to the world CIDs they were shown to. Entities
+   *  that are not in the map were not filtered by interest.
+   */
+  std::unordered_map<int32_t, std::set<int32_t>> TakeShownRemovals(
+      const std::list<int32_t>& entityIDs);
+
+  /**
+   * Set the number of AI controlled entities in the zone at each level of
+   * detail as of the last AI update.
+   * @param active Number of entities updated every tick
+   * @param reduced Number of entities updated at a reduced rate
+   * @param dormant Number of entities not being updated
+   */
+  void SetAIUpdateCounts(uint32_t active, uint32_t reduced, uint32_t dormant);
+
+  /**
+   * Get the number of AI controlled entities in the zone updated every tick
+   * as of the last AI update.
+   * @return Number of active AI controlled entities
+   */
+  uint32_t GetActiveAICount();
+
+  /**
+   * Get the number of AI controlled entities in the zone updated at a
+   * reduced rate since no players are close by as of the last AI update.
+   * @return Number of reduced rate AI controlled entities
+   */
+  uint32_t GetReducedAICount();
+
+  /**
+   * Get the number of AI controlled entities in the zone sleeping until a
+   * player comes close enough as of the last AI update.
+   * @return Number of dormant AI controlled entities
+   */
+  uint32_t GetDormantAICount();
+
   /**
    * Get an entity instance by it's ID.
    * @param id Instance ID of the entity.
@@ -489,8 +709,9 @@ class Zone : public objects::ZoneObject {
 
   /**
    * Set the next status effect event time associated to an entity
-   * in the zone
-   * @param time Time of the next status effect event time
+   * in the zone, replacing any time already set for it
+   * @param time Time of the next status effect event time or 0 to
+   *  clear the entity's time
    * @param entityID ID of the entity with a status effect event
    *  at the specified time
    */
@@ -856,6 +1077,14 @@ class Zone : public objects::ZoneObject {
   bool DisableSpawnGroups(const std::set<uint32_t>& spawnGroupIDs,
                           bool initializing, bool deactivate);
 
+  /// Definition ID of the zone, which stays the same when the definition
+  /// is replaced by a reload
+  uint32_t mDefinitionID;
+
+  /// Definition dynamic map ID of the zone, which stays the same when the
+  /// definition is replaced by a reload
+  uint32_t mDynamicMapID;
+
   /// Map of world CIDs to client connections
   std::unordered_map<int32_t, std::shared_ptr<ChannelClientConnection>>
       mConnections;
@@ -863,6 +1092,27 @@ class Zone : public objects::ZoneObject {
   /// List of active entities in the zone
   std::list<std::shared_ptr<ActiveEntityState>> mActiveEntities;
 
+  /// Spatial grid of active entities in the zone by movement bounds
+  ZoneSpatialGrid mSpatialGrid;
+
+  /// Map of world CIDs to the IDs of the entities filtered by interest
+  /// that are currently shown to the client
+  std::unordered_map<int32_t, std::set<int32_t>> mShownEntities;
+
+  /// Map of IDs of entities filtered by interest that were removed from
+  /// the zone to the world CIDs they were shown to, until their removal
+  /// is sent
+  std::unordered_map<int32_t, std::set<int32_t>> mShownRemovals;
+
+  /// Number of AI controlled entities updated every tick
+  uint32_t mActiveAICount;
+
+  /// Number of AI controlled entities updated at a reduced rate
+  uint32_t mReducedAICount;
+
+  /// Number of AI controlled entities not being updated
+  uint32_t mDormantAICount;
+
   /// List of pointers to allies instantiated for the zone
   std::list<std::shared_ptr<AllyState>> mAllies;
 
@@ -931,9 +1181,14 @@ class Zone : public objects::ZoneObject {
   std::unordered_map<int32_t, std::shared_ptr<objects::EntityStateObject>>
       mActors;
 
-  /// Map of system times to active entities with status effects that need
-  /// handling at that time
-  std::map<uint32_t, std::set<int32_t>> mNextEntityStatusTimes;
+  /// Timing wheel of system times to IDs of active entities with status
+  /// effects that need handling at that time
+  TimerWheel<int32_t> mStatusEffectWheel;
+
+  /// Map of entity IDs to the handle of their next status effect time in
+  /// the timing wheel. Each entity has at most one time scheduled.
+  std::unordered_map<int32_t, TimerWheel<int32_t>::Handle>
+      mStatusEffectHandles;
 
   /// Map of server times to spawn location group IDs that need to be respawned
   /// at that time
@@ -944,6 +1199,23 @@ class Zone : public objects::ZoneObject {
   std::map<uint64_t, std::list<std::shared_ptr<ActiveEntityState>>>
       mStaggeredSpawns;
 
+  /// Map of entity IDs to IDs of removal work scheduled to remove them
+  /// from the zone
+  std::unordered_map<int32_t, std::set<uint64_t>> mRemovalWork;
+
+  /// Map of removal work IDs to the number of entities the work still
+  /// applies to
+  std::unordered_map<uint64_t, size_t> mRemovalWorkCounts;
+
+  /// Map of removal work IDs to the handle of their scheduled work
+  std::unordered_map<uint64_t, uint64_t> mRemovalWorkHandles;
+
+  /// Next removal work ID to register
+  uint64_t mNextRemovalWorkID;
+
+  /// List of scheduled removal work handles with no entities left to remove
+  std::list<uint64_t> mObsoleteRemovalWork;
+
   /// Set of entity IDs waiting to despawn. IDs are removed from this set when
   /// the entity is removed from the zone.
   std::set<int32_t> mPendingDespawnEntities;
@@ -28,14 +28,54 @@
 #include "ZoneGeometry.h"
 
 // Standard C++11 includes
+#include <algorithm>
 #include <cmath>
-#include <map>
+#include <cstring>
+#include <limits>
 
 // object includes
 #include <QmpElement.h>
 
 using namespace channel;
 
+/// Smallest width and height of a collision grid cell
+static const float MIN_COLLISION_CELL_SIZE = 200.f;
+
+/// Largest number of collision grid columns or rows
+static const uint32_t MAX_COLLISION_CELLS = 512;
+
+/**
+ * Clip one side of a parametric line against a boundary, following the
+ * Liang-Barsky algorithm.
+ * @param p Negated or positive delta of the line on the axis
+ * @param q Distance from the line start to the boundary
+ * @param t0 Current entry parameter, updated if the boundary clips it
+ * @param t1 Current exit parameter, updated if the boundary clips it
+ * @return false if the line is entirely outside of the boundary
+ */
+static bool ClipLine(float p, float q, float& t0, float& t1) {
+  if (p == 0.f) {
+    return q >= 0.f;
+  }
+
+  float r = q / p;
+  if (p < 0.f) {
+    if (r > t1) {
+      return false;
+    } else if (r > t0) {
+      t0 = r;
+    }
+  } else {
+    if (r < t0) {
+      return false;
+    } else if (r < t1) {
+      t1 = r;
+    }
+  }
+
+  return true;
+}
+
 Point::Point() : x(0.f), y(0.f) {}
 
 Point::Point(float xCoord, float yCoord) : x(xCoord), y(yCoord) {}
@@ -111,7 +151,9 @@ bool ZoneShape::Collides(const Line& path, Point& point, Line& surface) const {
   }
 
   float dist = 0.f;
-  std::map<float, std::pair<const Line*, Point>> collisions;
+  float nearestDist = 0.f;
+  const Line* nearest = nullptr;
+  Point nearestPoint;
   for (const Line& s : Lines) {
     bool intersect = s.Intersect(path, point, dist);
     bool passThrough = false;
@@ -125,17 +167,19 @@ bool ZoneShape::Collides(const Line& path, Point& point, Line& surface) const {
       }
     }
 
-    if (intersect && !passThrough) {
-      collisions[dist] = std::pair<const Line*, Point>(&s, point);
+    // Later lines win ties
+    if (intersect && !passThrough && (!nearest || dist <= nearestDist)) {
+      nearest = &s;
+      nearestDist = dist;
+      nearestPoint = point;
     }
   }
 
   // If a collision exists, retun true with the closest point and surface
   // in the output params
-  if (collisions.size() > 0) {
-    auto pair = collisions.begin()->second;
-    point = pair.second;
-    surface = *pair.first;
+  if (nearest) {
+    point = nearestPoint;
+    surface = *nearest;
     return true;
   } else {
     return false;
@@ -159,39 +203,349 @@ ZoneSpotShape::ZoneSpotShape() {}
 
 ZoneSpotShape::~ZoneSpotShape() {}
 
+ZoneGeometry::ZoneGeometry()
+    : mIndexedLines(nullptr),
+      mLineCount(0),
+      mCellOffsets(nullptr),
+      mCellLines(nullptr),
+      mCellLineCount(0),
+      mCellSize(0.f),
+      mCellsX(0),
+      mCellsY(0) {}
+
+void ZoneGeometry::BuildCollisionIndex() {
+  mIndexedShapes.clear();
+  mOwnedLines.clear();
+  mOwnedCellOffsets.clear();
+  mOwnedCellLines.clear();
+  mSharedStore = nullptr;
+  mIndexedLines = nullptr;
+  mCellOffsets = mCellLines = nullptr;
+  mLineCount = mCellLineCount = 0;
+  mCellsX = mCellsY = 0;
+
+  bool first = true;
+  for (auto& shape : Shapes) {
+    uint32_t shapeIdx = (uint32_t)mIndexedShapes.size();
+    mIndexedShapes.push_back(shape);
+
+    for (const Line& line : shape->Lines) {
+      IndexedLine indexed;
+      indexed.X1 = line.first.x;
+      indexed.Y1 = line.first.y;
+      indexed.X2 = line.second.x;
+      indexed.Y2 = line.second.y;
+      indexed.ShapeIndex = shapeIdx;
+
+      for (const Point& p : {line.first, line.second}) {
+        if (first) {
+          mGridMin = mGridMax = p;
+          first = false;
+        }
+
+        mGridMin.x = std::min(mGridMin.x, p.x);
+        mGridMin.y = std::min(mGridMin.y, p.y);
+        mGridMax.x = std::max(mGridMax.x, p.x);
+        mGridMax.y = std::max(mGridMax.y, p.y);
+      }
+
+      mOwnedLines.push_back(indexed);
+    }
+  }
+
+  if (mOwnedLines.size() == 0) {
+    return;
+  }
+
+  // Aim for roughly one cell per line
+  float width = mGridMax.x - mGridMin.x;
+  float height = mGridMax.y - mGridMin.y;
+  float side = (float)std::ceil(std::sqrt((double)mOwnedLines.size()));
+
+  mCellSize = std::max(std::max(width, height) / side, MIN_COLLISION_CELL_SIZE);
+  mCellsX = std::min((uint32_t)(width / mCellSize) + 1, MAX_COLLISION_CELLS);
+  mCellsY = std::min((uint32_t)(height / mCellSize) + 1, MAX_COLLISION_CELLS);
+  mCellSize = std::max(mCellSize, std::max(width / (float)mCellsX,
+                                           height / (float)mCellsY));
+
+  // Count the lines in each cell first so they can be stored contiguously
+  std::vector<uint32_t> counts((size_t)(mCellsX * mCellsY), 0);
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      mOwnedCellOffsets.resize(counts.size() + 1, 0);
+      for (size_t i = 0; i < counts.size(); i++) {
+        mOwnedCellOffsets[i + 1] = mOwnedCellOffsets[i] + counts[i];
+        counts[i] = mOwnedCellOffsets[i];
+      }
+
+      mOwnedCellLines.resize(mOwnedCellOffsets.back());
+    }
+
+    for (size_t i = 0; i < mOwnedLines.size(); i++) {
+      const IndexedLine& indexed = mOwnedLines[i];
+      Line line(indexed.X1, indexed.Y1, indexed.X2, indexed.Y2);
+
+      uint32_t rowStart = GetCell(std::min(line.first.y, line.second.y),
+                                  mGridMin.y, mCellsY);
+      uint32_t rowEnd = GetCell(std::max(line.first.y, line.second.y),
+                                mGridMin.y, mCellsY);
+      for (uint32_t row = rowStart; row <= rowEnd; row++) {
+        uint32_t colStart, colEnd;
+        float exitT;
+        if (!GetRowSpan(line, 0.f, 1.f, row, colStart, colEnd, exitT)) {
+          continue;
+        }
+
+        for (uint32_t col = colStart; col <= colEnd; col++) {
+          size_t cellIdx = (size_t)(row * mCellsX + col);
+          if (pass == 0) {
+            counts[cellIdx]++;
+          } else {
+            mOwnedCellLines[counts[cellIdx]++] = (uint32_t)i;
+          }
+        }
+      }
+    }
+  }
+
+  mIndexedLines = mOwnedLines.data();
+  mLineCount = (uint32_t)mOwnedLines.size();
+  mCellOffsets = mOwnedCellOffsets.data();
+  mCellLines = mOwnedCellLines.data();
+  mCellLineCount = (uint32_t)mOwnedCellLines.size();
+}
+
+bool ZoneGeometry::SaveCollisionIndex(std::string& data) const {
+  if (!mCellOffsets) {
+    return false;
+  }
+
+  CollisionIndexHeader header;
+  header.MinX = mGridMin.x;
+  header.MinY = mGridMin.y;
+  header.MaxX = mGridMax.x;
+  header.MaxY = mGridMax.y;
+  header.CellSize = mCellSize;
+  header.CellsX = mCellsX;
+  header.CellsY = mCellsY;
+  header.LineCount = mLineCount;
+  header.CellLineCount = mCellLineCount;
+  header.ShapeCount = (uint32_t)mIndexedShapes.size();
+
+  size_t offsetCount = (size_t)(mCellsX * mCellsY) + 1;
+
+  data.clear();
+  data.append((const char*)&header, sizeof(header));
+  data.append((const char*)mIndexedLines, mLineCount * sizeof(IndexedLine));
+  data.append((const char*)mCellOffsets, offsetCount * sizeof(uint32_t));
+  data.append((const char*)mCellLines, mCellLineCount * sizeof(uint32_t));
+
+  return true;
+}
+
+bool ZoneGeometry::AttachCollisionIndex(
+    const std::shared_ptr<libhack::SharedDataStore>& store, const char* pData,
+    size_t size) {
+  CollisionIndexHeader header;
+  if (!store || size < sizeof(header) ||
+      (uintptr_t)pData % alignof(IndexedLine) != 0) {
+    return false;
+  }
+
+  memcpy(&header, pData, sizeof(header));
+
+  // The grid must have been built from the same shapes
+  if (header.ShapeCount != (uint32_t)mIndexedShapes.size() ||
+      header.LineCount != mLineCount || header.CellsX != mCellsX ||
+      header.CellsY != mCellsY || header.CellLineCount != mCellLineCount) {
+    return false;
+  }
+
+  size_t offsetCount = (size_t)(header.CellsX * header.CellsY) + 1;
+  size_t linesSize = header.LineCount * sizeof(IndexedLine);
+  size_t offsetsSize = offsetCount * sizeof(uint32_t);
+  size_t cellLinesSize = header.CellLineCount * sizeof(uint32_t);
+  if (size != sizeof(header) + linesSize + offsetsSize + cellLinesSize) {
+    return false;
+  }
+
+  const char* pLines = pData + sizeof(header);
+  const char* pOffsets = pLines + linesSize;
+  const char* pCellLines = pOffsets + offsetsSize;
+  if (memcmp(pLines, mIndexedLines, linesSize) != 0 ||
+      memcmp(pOffsets, mCellOffsets, offsetsSize) != 0 ||
+      memcmp(pCellLines, mCellLines, cellLinesSize) != 0) {
+    return false;
+  }
+
+  mIndexedLines = reinterpret_cast<const IndexedLine*>(pLines);
+  mCellOffsets = reinterpret_cast<const uint32_t*>(pOffsets);
+  mCellLines = reinterpret_cast<const uint32_t*>(pCellLines);
+  mSharedStore = store;
+
+  // Free the grid built by this server
+  std::vector<IndexedLine>().swap(mOwnedLines);
+  std::vector<uint32_t>().swap(mOwnedCellOffsets);
+  std::vector<uint32_t>().swap(mOwnedCellLines);
+
+  return true;
+}
+
 bool ZoneGeometry::Collides(const Line& path, Point& point, Line& surface,
                             std::shared_ptr<ZoneShape>& shape,
-                            const std::set<uint32_t> disabledBarriers) const {
-  std::map<float,
-           std::pair<std::shared_ptr<ZoneShape>, std::pair<const Line*, Point>>>
-      collisions;
-  for (auto s : Shapes) {
-    bool disabled = s->Element ? disabledBarriers.find(s->Element->GetID()) !=
-                                     disabledBarriers.end()
-                               : false;
-    if (!disabled && s->Collides(path, point, surface)) {
-      float dSquared = (float)(std::pow((path.first.x - point.x), 2) +
-                               std::pow((path.first.y - point.y), 2));
-      std::pair<const Line*, Point> p(&surface, point);
-      collisions[dSquared] =
-          std::pair<std::shared_ptr<ZoneShape>, std::pair<const Line*, Point>>(
-              shape, p);
+                            const std::set<uint32_t>& disabledBarriers) const {
+  float dx = path.second.x - path.first.x;
+  float dy = path.second.y - path.first.y;
+  if (!mCellOffsets || (dx == 0.f && dy == 0.f)) {
+    // Nothing to collide with or nothing to collide
+    return false;
+  }
+
+  // Clip the path to the area covered by the grid
+  float t0 = 0.f;
+  float t1 = 1.f;
+  if (!ClipLine(-dx, path.first.x - mGridMin.x, t0, t1) ||
+      !ClipLine(dx, mGridMax.x - path.first.x, t0, t1) ||
+      !ClipLine(-dy, path.first.y - mGridMin.y, t0, t1) ||
+      !ClipLine(dy, mGridMax.y - path.first.y, t0, t1)) {
+    return false;
+  }
+
+  uint32_t rowStart = GetCell(path.first.y + dy * t0, mGridMin.y, mCellsY);
+  uint32_t rowEnd = GetCell(path.first.y + dy * t1, mGridMin.y, mCellsY);
+  int32_t rowStep = rowEnd >= rowStart ? 1 : -1;
+
+  float lengthSquared = dx * dx + dy * dy;
+
+  // Visit each row the path passes through in order, stopping once the
+  // nearest collision so far is closer than anything left to check
+  const IndexedLine* nearest = nullptr;
+  uint32_t nearestIdx = 0;
+  float nearestDist = 0.f;
+  Point nearestPoint;
+  for (uint32_t row = rowStart;; row = (uint32_t)((int32_t)row + rowStep)) {
+    uint32_t colStart, colEnd;
+    float exitT;
+    if (GetRowSpan(path, t0, t1, row, colStart, colEnd, exitT)) {
+      for (uint32_t col = colStart; col <= colEnd; col++) {
+        size_t cellIdx = (size_t)(row * mCellsX + col);
+        for (uint32_t i = mCellOffsets[cellIdx]; i < mCellOffsets[cellIdx + 1];
+             i++) {
+          uint32_t lineIdx = mCellLines[i];
+          const IndexedLine& indexed = mIndexedLines[lineIdx];
+          const ZoneQmpShape* s = mIndexedShapes[indexed.ShapeIndex].get();
+          if (!s->Active ||
+              (s->Element && disabledBarriers.size() > 0 &&
+               disabledBarriers.find(s->Element->GetID()) !=
+                   disabledBarriers.end())) {
+            continue;
+          }
+
+          Line l(indexed.X1, indexed.Y1, indexed.X2, indexed.Y2);
+
+          Point p;
+          float dist = 0.f;
+          if (!l.Intersect(path, p, dist)) {
+            continue;
+          }
+
+          // If the first point of the line being drawn is to the right of
+          // the direction of the path, allow pass through
+          if (s->OneWay && (dx * (l.first.y - path.first.y) -
+                            dy * (l.first.x - path.first.x)) < 0) {
+            continue;
+          }
+
+          // Lines indexed later win ties, matching shape order
+          if (!nearest || dist < nearestDist ||
+              (dist == nearestDist && lineIdx > nearestIdx)) {
+            nearest = &indexed;
+            nearestIdx = lineIdx;
+            nearestDist = dist;
+            nearestPoint = p;
+          }
+        }
+      }
+
+      if (nearest && nearestDist < exitT * exitT * lengthSquared) {
+        break;
+      }
+    }
+
+    if (row == rowEnd) {
+      break;
     }
   }
 
   // If a collision exists, return true with the closest point, surface
   // and shape in the output params
-  if (collisions.size() > 0) {
-    auto pair = collisions.begin()->second;
-    point = pair.second.second;
-    surface = *pair.second.first;
-    shape = pair.first;
+  if (nearest) {
+    point = nearestPoint;
+    surface = Line(nearest->X1, nearest->Y1, nearest->X2, nearest->Y2);
+    shape = mIndexedShapes[nearest->ShapeIndex];
     return true;
   } else {
     return false;
   }
 }
 
+uint32_t ZoneGeometry::GetCell(float coord, float min, uint32_t count) const {
+  float cell = std::floor((coord - min) / mCellSize);
+  if (!(cell > 0.f)) {
+    // Also catches NaN
+    return 0;
+  } else if (cell >= (float)count) {
+    return count - 1;
+  }
+
+  return (uint32_t)cell;
+}
+
+bool ZoneGeometry::GetRowSpan(const Line& path, float t0, float t1,
+                              uint32_t row, uint32_t& colStart,
+                              uint32_t& colEnd, float& exitT) const {
+  float dx = path.second.x - path.first.x;
+  float dy = path.second.y - path.first.y;
+
+  // Find the part of the path inside the row
+  float rowMin = mGridMin.y + (float)row * mCellSize;
+  float rowMax = rowMin + mCellSize;
+  if (row == 0) {
+    rowMin = -std::numeric_limits<float>::max();
+  }
+
+  if (row + 1 == mCellsY) {
+    rowMax = std::numeric_limits<float>::max();
+  }
+
+  float tMin = t0;
+  float tMax = t1;
+  if (dy != 0.f) {
+    float ta = (rowMin - path.first.y) / dy;
+    float tb = (rowMax - path.first.y) / dy;
+    if (ta > tb) {
+      std::swap(ta, tb);
+    }
+
+    tMin = std::max(tMin, ta);
+    tMax = std::min(tMax, tb);
+    if (tMin > tMax) {
+      return false;
+    }
+  }
+
+  exitT = tMax;
+
+  // Include a small margin so lines touching a cell edge are never missed
+  float margin = mCellSize * 0.001f;
+  float xa = path.first.x + dx * tMin;
+  float xb = path.first.x + dx * tMax;
+  colStart = GetCell(std::min(xa, xb) - margin, mGridMin.x, mCellsX);
+  colEnd = GetCell(std::max(xa, xb) + margin, mGridMin.x, mCellsX);
+
+  return true;
+}
+
 bool ZoneGeometry::Collides(const Line& path, Point& point) const {
   Line surface;
   std::shared_ptr<ZoneShape> shape;
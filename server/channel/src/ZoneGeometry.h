@@ -34,8 +34,15 @@
 // Standard C++11 includes
 #include <array>
 #include <list>
+#include <memory>
 #include <set>
+#include <string>
 #include <unordered_map>
+#include <vector>
+
+namespace libhack {
+class SharedDataStore;
+}  // namespace libhack
 
 namespace objects {
 class MiSpotData;
@@ -45,6 +52,8 @@ class QmpNavPoint;
 
 namespace channel {
 
+class ZoneNavGraph;
+
 /**
  * Simple X, Y coordinate point.
  */
@@ -236,6 +245,41 @@ class ZoneSpotShape : public ZoneShape {
  */
 class ZoneGeometry {
  public:
+  /**
+   * Create a new empty zone geometry
+   */
+  ZoneGeometry();
+
+  /**
+   * Build the grid used to quickly find the shape lines a path could
+   * collide with. This must be called after all shapes have been added
+   * and before any collisions are checked. Shapes can still be enabled or
+   * disabled afterwards without rebuilding the grid.
+   */
+  void BuildCollisionIndex();
+
+  /**
+   * Save the collision grid so another server can use it in place of
+   * building its own.
+   * @param data Output parameter to return the saved grid
+   * @return true if the grid was saved, false if it has not been built
+   */
+  bool SaveCollisionIndex(std::string& data) const;
+
+  /**
+   * Replace the collision grid with one saved by SaveCollisionIndex that
+   * is read in place from a shared data store, freeing the grid built by
+   * this server.
+   * @param store Store the saved grid is in, kept open by the geometry
+   * @param pData Pointer to the saved grid in the store
+   * @param size Size of the saved grid in bytes
+   * @return true if the grid was attached, false if it does not match the
+   *  shapes of this geometry
+   */
+  bool AttachCollisionIndex(
+      const std::shared_ptr<libhack::SharedDataStore>& store,
+      const char* pData, size_t size);
+
   /**
    * Determines if the supplied path collides with any shape
    * @param path Line representing a path
@@ -251,7 +295,7 @@ class ZoneGeometry {
    */
   bool Collides(const Line& path, Point& point, Line& surface,
                 std::shared_ptr<ZoneShape>& shape,
-                const std::set<uint32_t> disabledBarriers = {}) const;
+                const std::set<uint32_t>& disabledBarriers = {}) const;
 
   /**
    * Determines if the supplied path collides with any shape
@@ -274,6 +318,128 @@ class ZoneGeometry {
   /// contain player zone-in spots, these are filtered to the active play
   /// area only.
   std::unordered_map<uint32_t, std::shared_ptr<objects::QmpNavPoint>> NavPoints;
+
+  /// Navigation graph built from the nav points for path and nearest
+  /// point calculations
+  std::shared_ptr<ZoneNavGraph> NavGraph;
+
+ private:
+  /// Shape line registered in the collision grid. Only holds plain
+  /// values so the grid can be shared between servers.
+  struct IndexedLine {
+    /// X coordinate of the first point of the line
+    float X1;
+
+    /// Y coordinate of the first point of the line
+    float Y1;
+
+    /// X coordinate of the second point of the line
+    float X2;
+
+    /// Y coordinate of the second point of the line
+    float Y2;
+
+    /// Index of the shape the line belongs to in mIndexedShapes
+    uint32_t ShapeIndex;
+  };
+
+  /// Header of a saved collision grid, followed by the indexed lines, the
+  /// cell offsets and the cell lines
+  struct CollisionIndexHeader {
+    /// Minimum point covered by the grid
+    float MinX, MinY;
+
+    /// Maximum point covered by the grid
+    float MaxX, MaxY;
+
+    /// Width and height of each grid cell
+    float CellSize;
+
+    /// Number of grid columns and rows
+    uint32_t CellsX, CellsY;
+
+    /// Number of indexed lines
+    uint32_t LineCount;
+
+    /// Number of entries in the cell lines
+    uint32_t CellLineCount;
+
+    /// Number of shapes indexed
+    uint32_t ShapeCount;
+  };
+
+  /**
+   * Get the grid column or row containing a coordinate, clamped to the
+   * bounds of the grid.
+   * @param coord X or Y coordinate
+   * @param min Minimum X or Y coordinate of the grid
+   * @param count Number of columns or rows in the grid
+   * @return Column or row index
+   */
+  uint32_t GetCell(float coord, float min, uint32_t count) const;
+
+  /**
+   * Get the range of grid columns a section of a path covers within a
+   * grid row.
+   * @param path Line representing a path
+   * @param t0 Start of the section of the path, from 0 to 1
+   * @param t1 End of the section of the path, from 0 to 1
+   * @param row Grid row to check
+   * @param colStart Output parameter to return the first column to
+   * @param colEnd Output parameter to return the last column to
+   * @param exitT Output parameter to return the furthest point along the
+   *  path that is within the row, from 0 to 1
+   * @return false if the section of the path does not enter the row
+   */
+  bool GetRowSpan(const Line& path, float t0, float t1, uint32_t row,
+                  uint32_t& colStart, uint32_t& colEnd, float& exitT) const;
+
+  /// Shapes in the order they were indexed
+  std::vector<std::shared_ptr<ZoneQmpShape>> mIndexedShapes;
+
+  /// Every line of every shape in the order they were indexed
+  const IndexedLine* mIndexedLines;
+
+  /// Number of entries in mIndexedLines
+  uint32_t mLineCount;
+
+  /// Offset of each cell's first entry in mCellLines, with one extra
+  /// entry marking the end of the last cell. Null if there is no grid.
+  const uint32_t* mCellOffsets;
+
+  /// Indexes into mIndexedLines of the lines that overlap each cell,
+  /// grouped by cell
+  const uint32_t* mCellLines;
+
+  /// Number of entries in mCellLines
+  uint32_t mCellLineCount;
+
+  /// Indexed lines built by this server, empty if the grid is shared
+  std::vector<IndexedLine> mOwnedLines;
+
+  /// Cell offsets built by this server, empty if the grid is shared
+  std::vector<uint32_t> mOwnedCellOffsets;
+
+  /// Cell lines built by this server, empty if the grid is shared
+  std::vector<uint32_t> mOwnedCellLines;
+
+  /// Store the shared grid is read from, null if the grid is not shared
+  std::shared_ptr<libhack::SharedDataStore> mSharedStore;
+
+  /// Minimum point covered by the grid
+  Point mGridMin;
+
+  /// Maximum point covered by the grid
+  Point mGridMax;
+
+  /// Width and height of each grid cell
+  float mCellSize;
+
+  /// Number of grid columns
+  uint32_t mCellsX;
+
+  /// Number of grid rows
+  uint32_t mCellsY;
 };
 
 /**
@@ -29,8 +29,10 @@
 // libcomp Includes
 #include <DefinitionManager.h>
 #include <Log.h>
+#include <SharedDataStore.h>
 
 // objects Include
+#include <ChannelConfig.h>
 #include <MiSpotData.h>
 #include <MiZoneData.h>
 #include <MiZoneFileData.h>
@@ -40,11 +42,38 @@
 #include <QmpFile.h>
 #include <QmpNavPoint.h>
 
+// channel Includes
+#include "ZoneNavGraph.h"
+
 // Standard C++11 Includes
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
 #include <thread>
 
 using namespace channel;
 
+/// ID of the table holding the geometry in the shared geometry store
+static const uint32_t GEOMETRY_TABLE = 1;
+
+/// Format version of the geometry records, part of the store hash so
+/// stores built by older servers are replaced
+static const uint32_t GEOMETRY_RECORD_VERSION = 1;
+
+/// Alignment of the route table within a geometry record
+static const size_t GEOMETRY_RECORD_ALIGNMENT = 8;
+
+/// Header of a geometry record in the shared geometry store, followed by
+/// the saved collision grid and then the saved route table
+struct GeometryRecordHeader {
+  /// Size of the saved collision grid in bytes, 0 if there is none
+  uint32_t IndexSize;
+
+  /// Size of the saved route table in bytes, 0 if there is none
+  uint32_t RouteSize;
+};
+
 std::unordered_map<std::string, std::shared_ptr<ZoneGeometry>>
 ZoneGeometryLoader::LoadQMP(
     std::unordered_map<uint32_t, std::set<uint32_t>> localZoneIDs,
@@ -70,6 +99,12 @@ ZoneGeometryLoader::LoadQMP(
     delete thread;
   }
 
+  auto conf =
+      std::dynamic_pointer_cast<objects::ChannelConfig>(server->GetConfig());
+  if (!conf->GetSharedDataStoreName().IsEmpty()) {
+    ShareGeometry(server);
+  }
+
   return mZoneGeometry;
 }
 
@@ -236,6 +271,9 @@ bool ZoneGeometryLoader::LoadZoneQMP(
     }
   }
 
+  // All shapes are loaded, index them for collision checks
+  geometry->BuildCollisionIndex();
+
   // If any zone-in spots exist, remove all navpoints that are outside
   // of all play areas by checking if the center point of zone-in spot
   // connects to the points (in large zones this often times cuts the
@@ -323,6 +361,17 @@ bool ZoneGeometryLoader::LoadZoneQMP(
   }
 
   geometry->NavPoints = navPoints;
+  geometry->NavGraph = std::make_shared<ZoneNavGraph>(navPoints);
+
+  auto conf =
+      std::dynamic_pointer_cast<objects::ChannelConfig>(server->GetConfig());
+  if (conf->GetNavRoutePrecompute() && navPoints.size() > 1 &&
+      navPoints.size() <= (size_t)conf->GetNavRouteMaxPoints() &&
+      conf->GetSharedDataStoreName().IsEmpty()) {
+    // With a shared data store the route table is only built if it is not
+    // already in the shared geometry store
+    LoadRouteTable(geometry, conf->GetNavRouteCachePath());
+  }
 
   libcomp::String filterString;
   if (navPoints.size() != navTotal) {
@@ -343,3 +392,232 @@ bool ZoneGeometryLoader::LoadZoneQMP(
 
   return true;
 }
+
+void ZoneGeometryLoader::LoadRouteTable(
+    const std::shared_ptr<ZoneGeometry>& geometry,
+    const libcomp::String& cachePath) {
+  auto navGraph = geometry->NavGraph;
+
+  libcomp::String cacheFile;
+  if (!cachePath.IsEmpty()) {
+    cacheFile = libcomp::String("%1/%2.nav")
+                    .Arg(cachePath)
+                    .Arg(geometry->QmpFilename.Replace("/", "_")
+                             .Replace("\\", "_"));
+
+    std::ifstream in(cacheFile.C(), std::ios::in | std::ios::binary);
+    if (in.good() && navGraph->LoadRouteTable(in)) {
+      LogZoneManagerDebug([&]() {
+        return libcomp::String("Loaded cached nav route table: %1\n")
+            .Arg(cacheFile);
+      });
+
+      return;
+    }
+  }
+
+  if (!navGraph->BuildRouteTable()) {
+    return;
+  }
+
+  LogZoneManagerDebug([&]() {
+    return libcomp::String("Built nav route table for %1 with %2 points\n")
+        .Arg(geometry->QmpFilename)
+        .Arg(navGraph->Count());
+  });
+
+  if (!cacheFile.IsEmpty()) {
+    std::ofstream out(cacheFile.C(),
+                      std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.good() || !navGraph->SaveRouteTable(out)) {
+      LogZoneManagerWarning([&]() {
+        return libcomp::String("Failed to cache nav route table: %1\n")
+            .Arg(cacheFile);
+      });
+    }
+  }
+}
+
+void ZoneGeometryLoader::LoadQueuedRouteTables(
+    const libcomp::String& cachePath) {
+  while (true) {
+    mDataLock.lock();
+
+    if (mRouteQueue.empty()) {
+      mDataLock.unlock();
+
+      return;
+    }
+
+    auto geometry = mRouteQueue.front();
+    mRouteQueue.pop_front();
+
+    mDataLock.unlock();
+
+    LoadRouteTable(geometry, cachePath);
+  }
+}
+
+void ZoneGeometryLoader::ShareGeometry(
+    const std::shared_ptr<ChannelServer>& server) {
+  auto conf =
+      std::dynamic_pointer_cast<objects::ChannelConfig>(server->GetConfig());
+  auto storeName =
+      libcomp::String("%1.geometry").Arg(conf->GetSharedDataStoreName());
+
+  // Lay out the geometry by filename so every server loading the same
+  // zones builds the same store
+  std::map<std::string, std::shared_ptr<ZoneGeometry>> sorted(
+      mZoneGeometry.begin(), mZoneGeometry.end());
+
+  std::vector<std::shared_ptr<ZoneGeometry>> geometries;
+  std::vector<std::string> indexes;
+  std::vector<bool> routed;
+
+  uint64_t hash = libhack::SharedDataStore::Hash(
+      (const char*)&GEOMETRY_RECORD_VERSION, sizeof(GEOMETRY_RECORD_VERSION));
+  for (auto& pair : sorted) {
+    auto geometry = pair.second;
+    auto navGraph = geometry->NavGraph;
+
+    std::string index;
+    geometry->SaveCollisionIndex(index);
+
+    uint8_t routes = conf->GetNavRoutePrecompute() && navGraph->Count() > 1 &&
+                     navGraph->Count() <= (size_t)conf->GetNavRouteMaxPoints();
+    uint64_t navHash = navGraph->GetContentHash();
+
+    hash = libhack::SharedDataStore::Hash(pair.first.data(), pair.first.size(),
+                                          hash);
+    hash = libhack::SharedDataStore::Hash(index.data(), index.size(), hash);
+    hash = libhack::SharedDataStore::Hash((const char*)&navHash,
+                                          sizeof(navHash), hash);
+    hash = libhack::SharedDataStore::Hash((const char*)&routes,
+                                          sizeof(routes), hash);
+
+    geometries.push_back(geometry);
+    indexes.push_back(index);
+    routed.push_back(routes != 0);
+  }
+
+  auto store = std::make_shared<libhack::SharedDataStore>();
+
+  bool created = false;
+  if (!store->Open(storeName, hash)) {
+    // Build the route tables the store needs, spread across threads
+    for (size_t i = 0; i < geometries.size(); i++) {
+      if (routed[i]) {
+        mRouteQueue.push_back(geometries[i]);
+      }
+    }
+
+    std::list<std::thread*> threads;
+
+    for (uint32_t i = 0; i < std::thread::hardware_concurrency(); ++i) {
+      threads.push_back(new std::thread(
+          [&](const libcomp::String& _cachePath) {
+            LoadQueuedRouteTables(_cachePath);
+          },
+          conf->GetNavRouteCachePath()));
+    }
+
+    for (auto thread : threads) {
+      thread->join();
+
+      delete thread;
+    }
+
+    libhack::SharedDataStore::Tables tables;
+    auto& records = tables[GEOMETRY_TABLE];
+    for (size_t i = 0; i < geometries.size(); i++) {
+      std::string route;
+
+      auto navGraph = geometries[i]->NavGraph;
+      if (routed[i] && navGraph->HasRouteTable()) {
+        std::ostringstream out;
+        if (navGraph->SaveRouteTable(out)) {
+          route = out.str();
+        }
+      }
+
+      GeometryRecordHeader header;
+      header.IndexSize = (uint32_t)indexes[i].size();
+      header.RouteSize = (uint32_t)route.size();
+
+      std::string& record = records[(uint32_t)i];
+      record.append((const char*)&header, sizeof(header));
+      record.append(indexes[i]);
+      record.resize((record.size() + GEOMETRY_RECORD_ALIGNMENT - 1) &
+                    ~(GEOMETRY_RECORD_ALIGNMENT - 1));
+      record.append(route);
+    }
+
+    // If another server built the store at the same time, use its copy
+    created = store->Create(storeName, hash, tables);
+    if (!created && !store->Open(storeName, hash)) {
+      LogZoneManagerWarning([&]() {
+        return libcomp::String(
+                   "Failed to create shared geometry store %1, zone "
+                   "geometry will not be shared\n")
+            .Arg(storeName);
+      });
+
+      return;
+    }
+  }
+
+  libhack::SharedDataStore::Table table;
+  store->GetTable(GEOMETRY_TABLE, table);
+
+  size_t shared = 0;
+  for (size_t i = 0; i < geometries.size(); i++) {
+    auto geometry = geometries[i];
+    auto navGraph = geometry->NavGraph;
+
+    size_t idx;
+    const char* pData = nullptr;
+    size_t size = 0;
+    GeometryRecordHeader header;
+    if (!table.Find((uint32_t)i, idx) || !table.Get(idx, pData, size) ||
+        size < sizeof(header)) {
+      continue;
+    }
+
+    memcpy(&header, pData, sizeof(header));
+
+    size_t routeOffset =
+        (sizeof(header) + header.IndexSize + GEOMETRY_RECORD_ALIGNMENT - 1) &
+        ~(GEOMETRY_RECORD_ALIGNMENT - 1);
+    if (routeOffset + header.RouteSize > size) {
+      continue;
+    }
+
+    bool attached = header.IndexSize == 0 ||
+                    geometry->AttachCollisionIndex(
+                        store, pData + sizeof(header), header.IndexSize);
+    if (routed[i]) {
+      if (header.RouteSize == 0 ||
+          !navGraph->AttachRouteTable(store, pData + routeOffset,
+                                      header.RouteSize)) {
+        // Fall back to a table held by this server
+        attached = false;
+        if (!navGraph->HasRouteTable()) {
+          LoadRouteTable(geometry, conf->GetNavRouteCachePath());
+        }
+      }
+    }
+
+    if (attached) {
+      shared++;
+    }
+  }
+
+  LogZoneManagerInfo([&]() {
+    return libcomp::String("%1 shared geometry store %2 with %3/%4 zone "
+                           "geometry files\n")
+        .Arg(created ? "Created" : "Opened")
+        .Arg(storeName)
+        .Arg(shared)
+        .Arg(geometries.size());
+  });
+}
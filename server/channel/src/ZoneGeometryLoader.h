@@ -58,12 +58,41 @@ class ZoneGeometryLoader {
    */
   bool LoadZoneQMP(const std::shared_ptr<ChannelServer>& server);
 
+  /**
+   * Load the precomputed nav point route table for a geometry from the
+   * cache or build it if it is not cached yet (or outdated).
+   * @param geometry Pointer to the geometry to load the route table for
+   * @param cachePath Directory route tables are cached in, if empty the
+   *  route table will be built but not cached
+   */
+  void LoadRouteTable(const std::shared_ptr<ZoneGeometry>& geometry,
+                      const libcomp::String& cachePath);
+
+  /**
+   * Load the route tables of the geometry in mRouteQueue until none are
+   * left.
+   * @param cachePath Directory route tables are cached in
+   */
+  void LoadQueuedRouteTables(const libcomp::String& cachePath);
+
+  /**
+   * Replace the collision grids and route tables of all loaded geometry
+   * with the ones in the shared geometry store, building the store first
+   * if no other server has built it from the same geometry yet.
+   * @param server Pointer to the channel server.
+   */
+  void ShareGeometry(const std::shared_ptr<ChannelServer>& server);
+
   /// Mutex to lock access to the input and output data by threads.
   std::mutex mDataLock;
 
   /// List of zone pairs for the QMP loading process.
   std::list<std::pair<uint32_t, std::set<uint32_t>>> mZonePairs;
 
+  /// List of geometry to load route tables for once it is known they are
+  /// not in the shared geometry store
+  std::list<std::shared_ptr<ZoneGeometry>> mRouteQueue;
+
   /// Map of QMP filenames to the geometry structures built from them
   std::unordered_map<std::string, std::shared_ptr<ZoneGeometry>> mZoneGeometry;
 };
@@ -44,6 +44,7 @@
 #include <ActionStartEvent.h>
 #include <ActivatedAbility.h>
 #include <Ally.h>
+#include <ChannelConfig.h>
 #include <ChannelLogin.h>
 #include <CharacterLogin.h>
 #include <CharacterProgress.h>
@@ -106,6 +107,7 @@
 #include "ChannelServer.h"
 #include "ChannelSyncManager.h"
 #include "CharacterManager.h"
+#include "ClientWorkerRouter.h"
 #include "CultureMachineState.h"
 #include "EventManager.h"
 #include "ManagerConnection.h"
@@ -117,8 +119,11 @@
 #include "Zone.h"
 #include "ZoneGeometryLoader.h"
 #include "ZoneInstance.h"
+#include "ZoneNavGraph.h"
+#include "ZoneWorkerPool.h"
 
 // C++ Standard Includes
+#include <array>
 #include <cmath>
 
 using namespace channel;
@@ -160,9 +165,27 @@ ZoneManager::ZoneManager(const std::weak_ptr<ChannelServer>& server)
     : mTrackingRefresh(0),
       mNextZoneID(1),
       mNextZoneInstanceID(1),
-      mServer(server) {}
+      mZoneWorkers(nullptr),
+      mFilteredPackets(0),
+      mFilteredBytes(0),
+      mServer(server) {
+  auto conf = std::dynamic_pointer_cast<objects::ChannelConfig>(
+      server.lock()->GetConfig());
+  mInterestFiltering = conf->GetInterestFiltering();
+
+  if (conf->GetZoneUpdateThreads() > 0) {
+    mZoneWorkers = new ZoneWorkerPool(conf->GetZoneUpdateThreads());
+
+    LogZoneManagerInfo([&]() {
+      return libcomp::String("Updating active zones across %1 thread(s)\n")
+          .Arg(mZoneWorkers->GetThreadCount());
+    });
+  }
+}
 
 ZoneManager::~ZoneManager() {
+  delete mZoneWorkers;
+
   for (auto zPair : mZones) {
     zPair.second->Cleanup();
   }
@@ -458,14 +481,16 @@ bool ZoneManager::EnterZone(
                        currentInstance ? currentInstance->GetID() : 0);
     if (nextZone == nullptr) {
       return false;
-    } else {
-      if (nextZone->GetDefinition()->GetRestricted() &&
-          !CanEnterRestrictedZone(client, nextZone)) {
-        return false;
-      }
     }
 
-    zoneDef = nextZone->GetDefinition();
+    // Until the player is added to the zone its definition can still be
+    // replaced by a reload so read it under the zone lock
+    zoneDef = nextZone->GetCurrentDefinition();
+    if (zoneDef->GetRestricted() &&
+        !CanEnterRestrictedZone(client, nextZone)) {
+      return false;
+    }
+
     nextInstance = nextZone->GetInstance();
     variantDef = nextInstance ? nextInstance->GetVariant() : nullptr;
   }
@@ -631,6 +656,9 @@ bool ZoneManager::EnterZone(
   cState->SetZone(nextZone);
   dState->SetZone(nextZone);
 
+  // Handle the client's packets on the worker that owns the zone
+  server->GetClientWorkerRouter()->AssignToZone(client, uniqueID);
+
   // Reset state values that do not persist between zones
   state->SetAcceptRevival(false);
   cState->SetDeathTimeOut(0);
@@ -1689,10 +1717,20 @@ bool ZoneManager::SendPopulateZoneData(
 
   TriggerZoneActions(zone, {cState, dState}, ZoneTrigger_t::ON_ZONE_IN, client);
 
+  // Only AI controlled entities in range are shown if interest filtering
+  // is enabled, the rest are shown when they come into range
+  std::set<int32_t> inRange;
+  if (mInterestFiltering) {
+    inRange = zone->ShowEntitiesInRange(client, state->GetZoneInTime());
+  }
+
   // All zone information is queued and sent together to minimize excess
   // communication
   for (auto enemyState : zone->GetEnemies()) {
-    SendEnemyData(enemyState, client, zone, false, true);
+    if (!mInterestFiltering ||
+        inRange.find(enemyState->GetEntityID()) != inRange.end()) {
+      SendEnemyData(enemyState, client, zone, false, true);
+    }
   }
 
   for (auto npcState : zone->GetNPCs()) {
@@ -1799,7 +1837,10 @@ bool ZoneManager::SendPopulateZoneData(
   }
 
   for (auto allyState : zone->GetAllies()) {
-    SendAllyData(allyState, client, zone, true);
+    if (!mInterestFiltering ||
+        inRange.find(allyState->GetEntityID()) != inRange.end()) {
+      SendAllyData(allyState, client, zone, true);
+    }
   }
 
   // Send all the queued NPC packets
@@ -1842,11 +1883,19 @@ void ZoneManager::ShowEntity(
 
 void ZoneManager::ShowEntityToZone(const std::shared_ptr<Zone>& zone,
                                    int32_t entityID) {
-  auto clients = zone->GetConnectionList();
+  // Entities filtered by interest are only shown to clients in range, the
+  // rest will have it shown when it comes into range
+  auto activeState = zone->GetActiveEntity(entityID);
+  bool filtered = activeState && Zone::IsInterestFiltered(activeState);
+
+  // Packet code, entity ID
+  const uint32_t packetSize = 6;
+
+  auto clients = filtered ? GetShowConnections(zone, activeState, packetSize)
+                          : zone->GetConnectionList();
   ShowEntity(clients, entityID, false);
 
   // If its an active entity, set it as displayed
-  auto activeState = zone->GetActiveEntity(entityID);
   if (activeState &&
       activeState->GetDisplayState() < ActiveDisplayState_t::ACTIVE) {
     activeState->SetDisplayState(ActiveDisplayState_t::ACTIVE);
@@ -1894,7 +1943,8 @@ void ZoneManager::PopEntityForProduction(
 
 void ZoneManager::PopEntityForZoneProduction(const std::shared_ptr<Zone>& zone,
                                              int32_t entityID, int32_t type) {
-  auto clients = zone->GetConnectionList();
+  // Packet code, entity ID, type
+  auto clients = GetInterestedConnections(zone, {entityID}, 10);
   PopEntityForProduction(clients, entityID, type, false);
 }
 
@@ -1914,7 +1964,50 @@ void ZoneManager::RemoveEntitiesFromZone(const std::shared_ptr<Zone>& zone,
                                          const std::list<int32_t>& entityIDs,
                                          int32_t removalMode, bool queue) {
   auto clients = zone->GetConnectionList();
-  RemoveEntities(clients, entityIDs, removalMode, queue);
+
+  // Entities filtered by interest are only removed from the clients they
+  // were shown to
+  std::unordered_map<int32_t, std::set<int32_t>> shownRemovals;
+  if (mInterestFiltering) {
+    shownRemovals = zone->TakeShownRemovals(entityIDs);
+  }
+
+  if (shownRemovals.size() == 0) {
+    RemoveEntities(clients, entityIDs, removalMode, queue);
+  } else {
+    for (int32_t entityID : entityIDs) {
+      auto entityClients = clients;
+
+      auto rIter = shownRemovals.find(entityID);
+      if (rIter != shownRemovals.end()) {
+        auto& shownTo = rIter->second;
+        entityClients.remove_if(
+            [shownTo](const std::shared_ptr<ChannelClientConnection>& c) {
+              return shownTo.find(c->GetClientState()->GetWorldCID()) ==
+                     shownTo.end();
+            });
+
+        // Remove entity and remove object packets
+        RecordFilteredPackets(clients.size() - entityClients.size(), 10);
+        RecordFilteredPackets(clients.size() - entityClients.size(), 6);
+      }
+
+      RemoveEntities(entityClients, {entityID}, removalMode, true);
+    }
+
+    if (!queue) {
+      ChannelClientConnection::FlushAllOutgoing(clients);
+    }
+  }
+
+  // Drop any scheduled removals that have nothing left to remove
+  auto removalWork = zone->TakeObsoleteRemovalWork();
+  if (removalWork.size() > 0) {
+    auto server = mServer.lock();
+    for (uint64_t handle : removalWork) {
+      server->CancelScheduledWork(handle);
+    }
+  }
 }
 
 void ZoneManager::RemoveEntities(
@@ -2036,11 +2129,23 @@ void ZoneManager::ScheduleEntityRemoval(uint64_t time,
                                         const std::shared_ptr<Zone>& zone,
                                         const std::list<int32_t>& entityIDs,
                                         int32_t removeMode) {
-  mServer.lock()->ScheduleWork(
+  // Register the removal with the zone first so the work can be cancelled
+  // if the entities are removed some other way before it runs
+  uint64_t removalID = zone->RegisterRemovalWork(entityIDs);
+  if (!removalID) {
+    return;
+  }
+
+  auto server = mServer.lock();
+  uint64_t handle = server->ScheduleCancellableWork(
       time,
       [](ZoneManager* zoneManager, uint64_t pTime,
          const std::shared_ptr<Zone> pZone, std::list<int32_t> pEntityIDs,
-         int32_t pRemoveMode) {
+         int32_t pRemoveMode, uint64_t pRemovalID) {
+        // The work has fired so it is no longer cancellable, even if some
+        // of the entities are not removed yet
+        pZone->CompleteRemovalWork(pRemovalID, pEntityIDs);
+
         std::list<int32_t> finalList;
         for (int32_t lootEntityID : pEntityIDs) {
           auto state = pZone->GetEntity(lootEntityID);
@@ -2055,7 +2160,12 @@ void ZoneManager::ScheduleEntityRemoval(uint64_t time,
           zoneManager->RemoveEntitiesFromZone(pZone, finalList, pRemoveMode);
         }
       },
-      this, time, zone, entityIDs, removeMode);
+      this, time, zone, entityIDs, removeMode, removalID);
+
+  if (!zone->SetRemovalWorkHandle(removalID, handle)) {
+    // Every entity was removed already
+    server->CancelScheduledWork(handle);
+  }
 }
 
 void ZoneManager::SendLootBoxData(
@@ -2184,6 +2294,9 @@ void ZoneManager::ExpireRentals(const std::shared_ptr<Zone>& zone,
   auto machines = zone->GetCultureMachines();
   auto bazaars = zone->GetBazaars();
 
+  // Accounts whose rentals expired, for save tracking
+  std::list<libobjgen::UUID> accountUIDs;
+
   std::list<std::shared_ptr<objects::BazaarData>> rMarkets;
   for (auto bState : bazaars) {
     for (uint32_t marketID : bState->GetEntity()->GetMarketIDs()) {
@@ -2210,6 +2323,7 @@ void ZoneManager::ExpireRentals(const std::shared_ptr<Zone>& zone,
         SendBazaarMarketData(zone, bState, marketID);
 
         rMarkets.push_back(market);
+        accountUIDs.push_back(market->GetAccount().GetUUID());
       }
     }
   }
@@ -2239,6 +2353,8 @@ void ZoneManager::ExpireRentals(const std::shared_ptr<Zone>& zone,
         p.WriteS32Little((int32_t)(cItem ? cItem->GetType() : 0));
 
         managerConnection->GetWorldConnection()->SendPacket(p);
+
+        accountUIDs.push_back(renter->GetAccount().GetUUID());
       }
 
       SendCultureMachineData(zone, cmState);
@@ -2275,7 +2391,7 @@ void ZoneManager::ExpireRentals(const std::shared_ptr<Zone>& zone,
       dbChanges->Update(market);
     }
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges, accountUIDs);
   }
 
   uint32_t nextExpiration = zone->SetNextRentalExpiration();
@@ -2347,6 +2463,11 @@ void ZoneManager::SendEnemyData(
 
   p.WriteU32Little(eBase->GetVariantType());
 
+  if (!client) {
+    // Data, pop for production and show packets
+    clients = GetShowConnections(zone, enemyState, (uint32_t)p.Size() + 16);
+  }
+
   for (auto zClient : clients) {
     zClient->QueuePacketCopy(p);
     PopEntityForProduction(zClient, enemyState->GetEntityID(),
@@ -2414,6 +2535,11 @@ void ZoneManager::SendAllyData(
 
   p.WriteU32Little(allyState->GetEntity()->GetVariantType());
 
+  if (!client) {
+    // Data, pop for production and show packets
+    clients = GetShowConnections(zone, allyState, (uint32_t)p.Size() + 16);
+  }
+
   // Ally NPCs have a unique distinction from enemies that allows them to
   // contextually be treated as enemies to player entities with non-default
   // faction groups (ex: in PvP)
@@ -2490,7 +2616,9 @@ void ZoneManager::HandleDespawns(const std::shared_ptr<Zone>& zone) {
     }
 
     if (zone->DiasporaMiniBossUpdated()) {
-      server->GetTokuseiManager()->UpdateDiasporaMinibossCount(zone);
+      DeferZoneMerge([server, zone]() {
+        server->GetTokuseiManager()->UpdateDiasporaMinibossCount(zone);
+      });
     }
   }
 }
@@ -2513,7 +2641,7 @@ void ZoneManager::UpdateStatusEffectStates(
   const static std::set<uint32_t> dgStatusEffectIDs = {
       SVR_CONST.STATUS_DIGITALIZE[0], SVR_CONST.STATUS_DIGITALIZE[1]};
 
-  std::list<libcomp::Packet> zonePackets;
+  std::list<std::pair<int32_t, libcomp::Packet>> zonePackets;
   std::set<uint32_t> added, updated, removed;
   std::set<std::shared_ptr<ActiveEntityState>> displayStateModified;
   std::set<std::shared_ptr<ActiveEntityState>> recalc;
@@ -2529,7 +2657,7 @@ void ZoneManager::UpdateStatusEffectStates(
       libcomp::Packet p;
       if (characterManager->GetRemovedStatusesPacket(p, entity->GetEntityID(),
                                                      removed)) {
-        zonePackets.push_back(p);
+        zonePackets.push_back(std::make_pair(entity->GetEntityID(), p));
       }
 
       recalc.insert(entity);
@@ -2568,7 +2696,7 @@ void ZoneManager::UpdateStatusEffectStates(
       libcomp::Packet p;
       if (characterManager->GetActiveStatusesPacket(p, entity->GetEntityID(),
                                                     active)) {
-        zonePackets.push_back(p);
+        zonePackets.push_back(std::make_pair(entity->GetEntityID(), p));
       }
 
       recalc.insert(entity);
@@ -2590,7 +2718,7 @@ void ZoneManager::UpdateStatusEffectStates(
         libcomp::Packet p;
         CharacterManager::GetTDamagePacket(p, entity->GetEntityID(), hpAdjusted,
                                            mpAdjusted);
-        zonePackets.push_back(p);
+        zonePackets.push_back(std::make_pair(entity->GetEntityID(), p));
 
         hpMpRecalc = true;
       }
@@ -2608,7 +2736,7 @@ void ZoneManager::UpdateStatusEffectStates(
             ChannelToClientPacketCode_t::PACKET_SKILL_UPKEEP_COST);
         p.WriteS32Little(entity->GetEntityID());
         p.WriteU32Little((uint32_t)(-mpAdjusted));
-        zonePackets.push_back(p);
+        zonePackets.push_back(std::make_pair(entity->GetEntityID(), p));
 
         hpMpRecalc = true;
       }
@@ -2628,8 +2756,7 @@ void ZoneManager::UpdateStatusEffectStates(
   }
 
   if (zonePackets.size() > 0) {
-    auto zConnections = zone->GetConnectionList();
-    ChannelClientConnection::BroadcastPackets(zConnections, zonePackets);
+    BroadcastEntityPackets(zone, zonePackets);
   }
 
   for (auto eState : recalc) {
@@ -2777,6 +2904,15 @@ void ZoneManager::BroadcastPacket(const std::shared_ptr<Zone>& zone,
   }
 }
 
+void ZoneManager::BroadcastPacket(const std::shared_ptr<Zone>& zone,
+                                  libcomp::Packet& p,
+                                  const std::set<int32_t>& entityIDs) {
+  if (nullptr != zone) {
+    auto connections = GetInterestedConnections(zone, entityIDs, p.Size());
+    ChannelClientConnection::BroadcastPacket(connections, p);
+  }
+}
+
 void ZoneManager::SendToRange(
     const std::shared_ptr<ChannelClientConnection>& client, libcomp::Packet& p,
     bool includeSelf) {
@@ -2784,23 +2920,20 @@ void ZoneManager::SendToRange(
 
   auto state = client->GetClientState();
   auto cState = state->GetCharacterState();
-
-  cState->RefreshCurrentPosition(now);
-
-  std::list<std::shared_ptr<libcomp::TcpConnection>> zConnections;
-  if (includeSelf) {
-    zConnections.push_back(client);
+  auto zone = cState->GetZone();
+  if (!zone) {
+    return;
   }
 
-  float rSquared = (float)std::pow(MAX_ENTITY_DRAW_DISTANCE, 2);
-  for (auto zConnection : GetZoneConnections(client, false)) {
-    auto otherCState = zConnection->GetClientState()->GetCharacterState();
-    otherCState->RefreshCurrentPosition(now);
-
-    if (rSquared >= cState->GetDistance(otherCState, true)) {
+  std::list<int32_t> skipped;
+  std::list<std::shared_ptr<libcomp::TcpConnection>> zConnections;
+  for (auto zConnection :
+       zone->GetInterestedConnections(cState, now, skipped)) {
+    if (includeSelf || zConnection != client) {
       zConnections.push_back(zConnection);
     }
   }
+
   libcomp::TcpConnection::BroadcastPacket(zConnections, p);
 }
 
@@ -2830,6 +2963,83 @@ ZoneManager::GetZoneConnections(
   return connections;
 }
 
+std::list<std::shared_ptr<ChannelClientConnection>>
+ZoneManager::GetShowConnections(
+    const std::shared_ptr<Zone>& zone,
+    const std::shared_ptr<ActiveEntityState>& entity, uint32_t packetSize) {
+  if (!mInterestFiltering || !Zone::IsInterestFiltered(entity)) {
+    return zone->GetConnectionList();
+  }
+
+  std::list<int32_t> skipped;
+  auto connections = zone->GetInterestedConnections(
+      entity, ChannelServer::GetServerTime(), skipped);
+
+  std::list<int32_t> worldCIDs;
+  for (auto connection : connections) {
+    worldCIDs.push_back(connection->GetClientState()->GetWorldCID());
+  }
+
+  zone->SetEntityShown(entity->GetEntityID(), worldCIDs);
+
+  if (skipped.size() > 0) {
+    RecordFilteredPackets(skipped.size(), packetSize);
+  }
+
+  return connections;
+}
+
+std::list<std::shared_ptr<ChannelClientConnection>>
+ZoneManager::GetInterestedConnections(const std::shared_ptr<Zone>& zone,
+                                      const std::set<int32_t>& entityIDs,
+                                      uint32_t packetSize) {
+  if (!mInterestFiltering) {
+    return zone->GetConnectionList();
+  }
+
+  size_t skipped = 0;
+  auto connections = zone->GetInterestedConnections(entityIDs, skipped);
+  if (skipped > 0) {
+    RecordFilteredPackets(skipped, packetSize);
+  }
+
+  return connections;
+}
+
+void ZoneManager::BroadcastEntityPackets(
+    const std::shared_ptr<Zone>& zone,
+    std::list<std::pair<int32_t, libcomp::Packet>>& packets) {
+  if (!mInterestFiltering) {
+    std::list<libcomp::Packet> zonePackets;
+    for (auto& pPair : packets) {
+      zonePackets.push_back(pPair.second);
+    }
+
+    auto zConnections = zone->GetConnectionList();
+    ChannelClientConnection::BroadcastPackets(zConnections, zonePackets);
+    return;
+  }
+
+  std::set<std::shared_ptr<ChannelClientConnection>> sent;
+  for (auto& pPair : packets) {
+    for (auto client : GetInterestedConnections(
+             zone, {pPair.first}, pPair.second.Size())) {
+      client->QueuePacketCopy(pPair.second);
+      sent.insert(client);
+    }
+  }
+
+  ChannelClientConnection::FlushAllOutgoing(
+      std::list<std::shared_ptr<ChannelClientConnection>>(sent.begin(),
+                                                          sent.end()));
+}
+
+uint64_t ZoneManager::GetFilteredPacketCount() const {
+  return mFilteredPackets;
+}
+
+uint64_t ZoneManager::GetFilteredByteCount() const { return mFilteredBytes; }
+
 bool ZoneManager::SpawnEnemy(const std::shared_ptr<Zone>& zone,
                              uint32_t demonID, float x, float y, float rot,
                              const libcomp::String& aiType) {
@@ -3200,6 +3410,8 @@ bool ZoneManager::LinearReposition(
   eState->SetDestinationX(newPoint.x);
   eState->SetDestinationY(newPoint.y);
 
+  zone->UpdateSpatialIndex(eState->GetEntityID());
+
   return newPoint == dest;
 }
 
@@ -3590,11 +3802,13 @@ bool ZoneManager::UpdateSpawnGroups(
 
     // Fire spawn group actions
     for (auto sg : spawnActionGroups) {
-      ActionOptions options;
-      options.GroupID = sg->GetID();
+      DeferZoneMerge([server, zone, sg]() {
+        ActionOptions options;
+        options.GroupID = sg->GetID();
 
-      server->GetActionManager()->PerformActions(nullptr, sg->GetSpawnActions(),
-                                                 0, zone, options);
+        server->GetActionManager()->PerformActions(
+            nullptr, sg->GetSpawnActions(), 0, zone, options);
+      });
     }
 
     return true;
@@ -4075,11 +4289,18 @@ std::shared_ptr<ActiveEntityState> ZoneManager::CreateEnemy(
   return state;
 }
 
+void ZoneManager::DeferZoneMerge(const std::function<void()>& work) {
+  if (!ZoneWorkerPool::Defer(work)) {
+    work();
+  }
+}
+
 void ZoneManager::UpdateActiveZoneStates() {
   auto serverTime = ChannelServer::GetServerTime();
 
   bool refreshTracking = false;
   std::list<std::shared_ptr<Zone>> zones;
+  size_t instanceCount = 0;
   {
     std::lock_guard<libcomp::Mutex> lock(mLock);
     if (mTrackingRefresh && serverTime >= mTrackingRefresh) {
@@ -4091,13 +4312,45 @@ void ZoneManager::UpdateActiveZoneStates() {
     for (auto uniqueID : mActiveZones) {
       zones.push_back(mZones[uniqueID]);
     }
+
+    instanceCount = mZoneInstances.size();
   }
 
   auto server = mServer.lock();
 
   // Performance timer to measure tasks.
   PerformanceTimer perf(server.get());
-  PerformanceTimer perf2(server.get());
+
+  auto tickRecorder = server->GetTickRecorder();
+  auto tickRecord = tickRecorder ? tickRecorder->GetCurrentTick() : nullptr;
+  if (tickRecord) {
+    // Size the zone records up front so each zone update only ever
+    // touches its own record
+    tickRecord->Zones.resize(zones.size());
+  }
+
+  size_t entityCount = 0;
+  size_t zoneIdx = 0;
+  for (auto zone : zones) {
+    size_t zoneEntities = zone->GetActiveEntityCount();
+    entityCount += zoneEntities;
+
+    if (tickRecord) {
+      auto& zoneRecord = tickRecord->Zones[zoneIdx++];
+      zoneRecord.ID = zone->GetID();
+      zoneRecord.DefinitionID = zone->GetDefinitionID();
+      zoneRecord.InstanceID = zone->GetInstanceID();
+      zoneRecord.Entities = (uint32_t)zoneEntities;
+      zoneRecord.ActiveAI = 0;
+      zoneRecord.AITime = 0;
+      zoneRecord.SpawnTime = 0;
+      zoneRecord.Time = 0;
+    }
+  }
+
+  perf.Report("ActiveZones", (uint64_t)zones.size());
+  perf.Report("ZoneInstances", (uint64_t)instanceCount);
+  perf.Report("ActiveEntities", (uint64_t)entityCount);
 
   // Spin through entities with updated status effects
   perf.Start();
@@ -4105,48 +4358,76 @@ void ZoneManager::UpdateActiveZoneStates() {
   for (auto zone : zones) {
     UpdateStatusEffectStates(zone, worldClock.SystemTime);
   }
-  perf.Stop("UpdateStatusEffectStates");
-
-  auto aiManager = server->GetAIManager();
+  ServerTime statusTime = perf.Stop("UpdateStatusEffectStates");
 
   bool isNight = worldClock.IsNight();
 
-  for (auto zone : zones) {
-    perf.Start();
+  ServerTime zoneTime = 0;
+  ServerTime mergeTime = 0;
+  zoneIdx = 0;
+  if (mZoneWorkers && zones.size() > 1) {
+    // Shard the zones across the workers, keeping each zone on the same
+    // thread every tick, then run everything deferred from the zones
+    // serially once they are all done
+    for (auto zone : zones) {
+      auto zoneRecord = tickRecord ? &tickRecord->Zones[zoneIdx++] : nullptr;
+      mZoneWorkers->Queue(
+          zone->GetID(), [this, zone, serverTime, isNight, zoneRecord]() {
+            UpdateActiveZoneState(zone, serverTime, isNight, zoneRecord);
+          });
+    }
 
-    // Despawn first
-    HandleDespawns(zone);
+    perf.Start();
+    auto deferred = mZoneWorkers->Wait();
+    zoneTime = perf.Stop("ParallelZoneUpdates");
 
-    // Stop combat next
-    for (int32_t combatantID : zone->GetCombatantIDs()) {
-      auto entity = zone->StartStopCombat(combatantID, serverTime, true);
-      if (entity) {
-        server->GetCharacterManager()->AddRemoveOpponent(false, entity,
-                                                         nullptr);
-      }
+    perf.Start();
+    for (auto& work : deferred) {
+      work();
+    }
+    mergeTime = perf.Stop("ZoneMerge");
+  } else {
+    perf.Start();
+    for (auto zone : zones) {
+      auto zoneRecord = tickRecord ? &tickRecord->Zones[zoneIdx++] : nullptr;
+      UpdateActiveZoneState(zone, serverTime, isNight, zoneRecord);
     }
+    zoneTime = perf.Stop("SerialZoneUpdates");
+  }
 
-    // Update active AI controlled entities
-    perf2.Start();
-    aiManager->UpdateActiveStates(zone, serverTime, isNight);
-    perf2.Stop("Zone AI");
+  // Report AI level of detail counts for the whole channel and labelled
+  // by zone definition. Instances of the same zone are summed together so
+  // the number of metrics does not grow with every instance created.
+  uint64_t activeAI = 0, reducedAI = 0, dormantAI = 0;
+  std::map<uint32_t, std::array<uint64_t, 3>> zoneAI;
+  for (auto zone : zones) {
+    auto& counts = zoneAI[zone->GetDefinitionID()];
+    counts[0] += zone->GetActiveAICount();
+    counts[1] += zone->GetReducedAICount();
+    counts[2] += zone->GetDormantAICount();
 
-    // Update staggered spawns before doing any normal spawns
-    if (zone->HasStaggeredSpawns(serverTime)) {
-      UpdateStaggeredSpawns(zone, serverTime);
-    }
+    activeAI += zone->GetActiveAICount();
+    reducedAI += zone->GetReducedAICount();
+    dormantAI += zone->GetDormantAICount();
+  }
 
-    if (zone->HasRespawns()) {
-      // Spawn new enemies next (since they should not immediately act)
-      UpdateSpawnGroups(zone, false, serverTime);
+  perf.Report("AIActive", activeAI);
+  perf.Report("AIReduced", reducedAI);
+  perf.Report("AIDormant", dormantAI);
 
-      // Now update plasma spawns
-      UpdatePlasma(zone, serverTime);
-    }
+  // Zones that are no longer active report zero rather than their last
+  // counts until they are active again
+  for (uint32_t zoneID : mAICountZones) {
+    zoneAI[zoneID];
+  }
 
-    mTimeRestrictUpdatedZones.erase(zone->GetID());
+  for (auto& pair : zoneAI) {
+    auto label = libcomp::String("{zone=\"%1\"}").Arg(pair.first);
+    perf.Report(libcomp::String("AIActive%1").Arg(label), pair.second[0]);
+    perf.Report(libcomp::String("AIReduced%1").Arg(label), pair.second[1]);
+    perf.Report(libcomp::String("AIDormant%1").Arg(label), pair.second[2]);
 
-    perf.Stop(libcomp::String("Zone %1").Arg(zone->GetDefinitionID()));
+    mAICountZones.insert(pair.first);
   }
 
   // Get any updated time restricted zones and clear the list
@@ -4175,7 +4456,9 @@ void ZoneManager::UpdateActiveZoneStates() {
       UpdateSpawnGroups(zone, false, serverTime);
     }
   }
-  perf.Stop("TimeRestrictedSpawns");
+  ServerTime spawnTime = perf.Stop("TimeRestrictedSpawns");
+
+  ServerTime trackingTime = 0;
 
   if (refreshTracking) {
     perf.Start();
@@ -4223,8 +4506,258 @@ void ZoneManager::UpdateActiveZoneStates() {
       SendMultiZoneBossStatus(groupID);
     }
 
-    perf.Stop("refreshTracking");
+    trackingTime = perf.Stop("refreshTracking");
+  }
+
+  if (tickRecord) {
+    tickRecord->Phases[(size_t)TickRecorder::Phase::STATUS_EFFECTS] =
+        statusTime;
+    tickRecord->Phases[(size_t)TickRecorder::Phase::ZONE_UPDATES] = zoneTime;
+    tickRecord->Phases[(size_t)TickRecorder::Phase::ZONE_MERGE] = mergeTime;
+    tickRecord->Phases[(size_t)TickRecorder::Phase::TIME_RESTRICTED_SPAWNS] =
+        spawnTime;
+    tickRecord->Phases[(size_t)TickRecorder::Phase::TRACKING] = trackingTime;
+  }
+}
+
+size_t ZoneManager::ReconcileZoneDefinitions(
+    libhack::ServerDataManager* previous) {
+  std::list<std::shared_ptr<Zone>> zones;
+  {
+    std::lock_guard<libcomp::Mutex> lock(mLock);
+    for (auto& zPair : mZones) {
+      zones.push_back(zPair.second);
+    }
+  }
+
+  auto serverDataManager = mServer.lock()->GetServerDataManager();
+
+  size_t updated = 0;
+  for (auto zone : zones) {
+    uint32_t zoneID = zone->GetDefinitionID();
+    uint32_t dynamicMapID = zone->GetDynamicMapID();
+
+    std::set<uint32_t> partialIDs;
+    auto instance = zone->GetInstance();
+    auto variant = instance ? instance->GetVariant() : nullptr;
+    if (variant) {
+      partialIDs = variant->GetZonePartialIDs();
+    }
+
+    if (!serverDataManager->ZoneDataChanged(previous, zoneID, dynamicMapID,
+                                            partialIDs)) {
+      continue;
+    }
+
+    auto definition = serverDataManager->GetZoneData(zoneID, dynamicMapID,
+                                                     true, partialIDs);
+    if (definition && zone->IsCompatibleDefinition(definition)) {
+      mPendingDefinitions[zone->GetID()] = std::make_pair(
+          std::weak_ptr<Zone>(zone), definition);
+      updated++;
+    } else {
+      LogZoneManagerWarning([&]() {
+        return libcomp::String(
+                   "Zone %1 (%2) changed in a way that cannot be applied "
+                   "while it is running and will keep its current "
+                   "definition.\n")
+            .Arg(zoneID)
+            .Arg(dynamicMapID);
+      });
+    }
+  }
+
+  ApplyPendingZoneDefinitions();
+
+  if (mPendingDefinitions.size() > 0) {
+    LogZoneManagerInfo([&]() {
+      return libcomp::String(
+                 "%1 reloaded zone(s) will be updated once no players are "
+                 "in them.\n")
+          .Arg(mPendingDefinitions.size());
+    });
   }
+
+  return updated;
+}
+
+void ZoneManager::ApplyPendingZoneDefinitions() {
+  for (auto it = mPendingDefinitions.begin();
+       it != mPendingDefinitions.end();) {
+    auto zone = it->second.first.lock();
+    if (!zone || zone->GetInvalid() ||
+        zone->ReconcileDefinition(it->second.second)) {
+      it = mPendingDefinitions.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void ZoneManager::UpdateActiveZoneState(const std::shared_ptr<Zone>& zone,
+                                        ServerTime serverTime, bool isNight,
+                                        TickRecorder::ZoneRecord* record) {
+  auto server = mServer.lock();
+  auto aiManager = server->GetAIManager();
+
+  // Performance timer to measure tasks.
+  PerformanceTimer perf(server.get());
+  PerformanceTimer perf2(server.get());
+
+  perf.Start();
+
+  // Catch any movement that was not already reflected in the zone's
+  // spatial grid
+  zone->SyncSpatialIndex();
+
+  // Despawn first
+  HandleDespawns(zone);
+
+  // Stop combat next
+  for (int32_t combatantID : zone->GetCombatantIDs()) {
+    auto entity = zone->StartStopCombat(combatantID, serverTime, true);
+    if (entity) {
+      DeferZoneMerge([server, entity]() {
+        server->GetCharacterManager()->AddRemoveOpponent(false, entity,
+                                                         nullptr);
+      });
+    }
+  }
+
+  // Update active AI controlled entities
+  perf2.Start();
+  aiManager->UpdateActiveStates(zone, serverTime, isNight);
+  ServerTime aiTime = perf2.Stop("Zone AI");
+
+  // Show and remove anything that came into or left range of each client
+  if (mInterestFiltering) {
+    UpdateInterest(zone, serverTime);
+  }
+
+  perf2.Start();
+
+  // Update staggered spawns before doing any normal spawns
+  if (zone->HasStaggeredSpawns(serverTime)) {
+    UpdateStaggeredSpawns(zone, serverTime);
+  }
+
+  if (zone->HasRespawns()) {
+    // Spawn new enemies next (since they should not immediately act)
+    UpdateSpawnGroups(zone, false, serverTime);
+
+    // Now update plasma spawns
+    UpdatePlasma(zone, serverTime);
+  }
+
+  ServerTime spawnTime = perf2.Stop("Zone Spawns");
+
+  uint32_t zoneID = zone->GetID();
+  DeferZoneMerge([this, zoneID]() {
+    std::lock_guard<libcomp::Mutex> lock(mLock);
+    mTimeRestrictUpdatedZones.erase(zoneID);
+  });
+
+  ServerTime zoneTime =
+      perf.Stop(libcomp::String("Zone %1").Arg(zone->GetDefinitionID()));
+
+  if (record) {
+    record->ActiveAI = zone->GetActiveAICount();
+    record->AITime = aiTime;
+    record->SpawnTime = spawnTime;
+    record->Time = zoneTime;
+  }
+}
+
+void ZoneManager::UpdateInterest(const std::shared_ptr<Zone>& zone,
+                                 ServerTime now) {
+  std::unordered_map<int32_t, std::list<int32_t>> shows;
+  std::unordered_map<int32_t, std::list<int32_t>> hides;
+  zone->UpdateInterest(now, shows, hides);
+  if (shows.size() == 0 && hides.size() == 0) {
+    return;
+  }
+
+  std::list<std::shared_ptr<ChannelClientConnection>> updated;
+  for (auto client : zone->GetConnectionList()) {
+    int32_t worldCID = client->GetClientState()->GetWorldCID();
+
+    std::list<std::shared_ptr<ChannelClientConnection>> clients;
+    clients.push_back(client);
+
+    bool queued = false;
+
+    auto hIter = hides.find(worldCID);
+    if (hIter != hides.end()) {
+      RemoveEntities(clients, hIter->second, 0, true);
+      queued = true;
+    }
+
+    auto sIter = shows.find(worldCID);
+    if (sIter != shows.end()) {
+      for (int32_t entityID : sIter->second) {
+        auto entity = zone->GetActiveEntity(entityID);
+        if (!entity) {
+          continue;
+        }
+
+        // Send the full entity since nothing about it was received while
+        // it was out of range
+        switch (entity->GetEntityType()) {
+          case EntityType_t::ENEMY:
+            SendEnemyData(std::dynamic_pointer_cast<EnemyState>(entity),
+                          client, zone, false, true);
+            break;
+          case EntityType_t::ALLY:
+            SendAllyData(std::dynamic_pointer_cast<AllyState>(entity), client,
+                         zone, true);
+            break;
+          default:
+            continue;
+        }
+
+        // Send where the entity is now instead of replaying everything
+        // that was missed
+        entity->RefreshCurrentPosition(now);
+
+        libcomp::Packet p;
+        RelativeTimeMap timeMap;
+        if (entity->IsMoving()) {
+          p.WritePacketCode(ChannelToClientPacketCode_t::PACKET_MOVE);
+          p.WriteS32Little(entityID);
+          p.WriteFloat(entity->GetDestinationX());
+          p.WriteFloat(entity->GetDestinationY());
+          p.WriteFloat(entity->GetCurrentX());
+          p.WriteFloat(entity->GetCurrentY());
+          p.WriteFloat(entity->GetMovementSpeed());
+
+          timeMap[p.Size()] = now;
+          timeMap[p.Size() + 4] = entity->GetDestinationTicks();
+        } else {
+          p.WritePacketCode(ChannelToClientPacketCode_t::PACKET_STOP_MOVEMENT);
+          p.WriteS32Little(entityID);
+          p.WriteFloat(entity->GetCurrentX());
+          p.WriteFloat(entity->GetCurrentY());
+
+          timeMap[p.Size()] = now;
+        }
+
+        ChannelClientConnection::SendRelativeTimePacket(clients, p, timeMap,
+                                                        true);
+        queued = true;
+      }
+    }
+
+    if (queued) {
+      updated.push_back(client);
+    }
+  }
+
+  ChannelClientConnection::FlushAllOutgoing(updated);
+}
+
+void ZoneManager::RecordFilteredPackets(size_t count, uint32_t packetSize) {
+  mFilteredPackets += (uint64_t)count;
+  mFilteredBytes += (uint64_t)count * (uint64_t)packetSize;
 }
 
 void ZoneManager::Warp(const std::shared_ptr<ChannelClientConnection>& client,
@@ -4241,6 +4774,11 @@ void ZoneManager::Warp(const std::shared_ptr<ChannelClientConnection>& client,
   eState->SetCurrentX(xPos);
   eState->SetCurrentY(yPos);
 
+  auto zone = eState->GetZone();
+  if (zone) {
+    zone->UpdateSpatialIndex(eState->GetEntityID());
+  }
+
   libcomp::Packet p;
   p.WritePacketCode(ChannelToClientPacketCode_t::PACKET_WARP);
   p.WriteS32Little(eState->GetEntityID());
@@ -5936,6 +6474,11 @@ Point ZoneManager::MoveRelative(
     eState->SetDestinationX(point.x);
     eState->SetDestinationY(point.y);
     eState->SetDestinationTicks(endTime);
+
+    auto zone = eState->GetZone();
+    if (zone) {
+      zone->UpdateSpatialIndex(eState->GetEntityID());
+    }
   }
 
   return point;
@@ -6088,32 +6631,17 @@ std::list<Point> ZoneManager::GetShortestPath(const std::shared_ptr<Zone>& zone,
 
     Point collidePoint;
     if (zone->Collides(path, collidePoint)) {
-      // Grab the closest points to the source and the target, determine
-      // shortest path(s) between them and simplify
+      // Grab the closest visible points to the source and the target,
+      // determine shortest path(s) between them and simplify
       std::array<std::shared_ptr<objects::QmpNavPoint>, 2> startPoints;
 
       size_t idx = 0;
       for (const Point& p : {source, dest}) {
-        std::list<std::pair<float, std::shared_ptr<objects::QmpNavPoint>>>
-            points;
-        for (auto& pair : geometry->NavPoints) {
-          float dist = (float)(std::pow(((float)pair.second->GetX() - p.x), 2) +
-                               std::pow(((float)pair.second->GetY() - p.y), 2));
-          points.push_back(std::make_pair(dist, pair.second));
-        }
-
-        points.sort(
-            [](const std::pair<float, std::shared_ptr<objects::QmpNavPoint>>& a,
-               const std::pair<float, std::shared_ptr<objects::QmpNavPoint>>&
-                   b) { return a.first < b.first; });
-
-        for (auto& pair : points) {
-          Line l(p,
-                 Point((float)pair.second->GetX(), (float)pair.second->GetY()));
-          if (!zone->Collides(l, collidePoint)) {
-            startPoints[idx] = pair.second;
-            break;
-          }
+        if (geometry->NavGraph) {
+          startPoints[idx] = geometry->NavGraph->GetNearestPoint(
+              p, [zone, p, &collidePoint](const Point& navPoint) {
+                return !zone->Collides(Line(p, navPoint), collidePoint);
+              });
         }
 
         idx++;
@@ -6135,7 +6663,7 @@ std::list<Point> ZoneManager::GetShortestPath(const std::shared_ptr<Zone>& zone,
         }
 
         for (uint32_t pointID : pointIDs) {
-          auto n = geometry->NavPoints[pointID];
+          auto n = geometry->NavPoints.at(pointID);
           result.push_back(Point((float)n->GetX(), (float)n->GetY()));
         }
       }
@@ -6218,92 +6746,11 @@ std::list<Point> ZoneManager::GetShortestPath(const std::shared_ptr<Zone>& zone,
 std::list<uint32_t> ZoneManager::GetShortestPath(
     const std::shared_ptr<ZoneGeometry>& geometry, uint32_t sourceID,
     uint32_t destID) {
-  std::list<uint32_t> result;
-
-  std::set<uint32_t> check;
-  std::unordered_map<uint32_t, std::shared_ptr<objects::QmpNavPoint>> points;
-  std::unordered_map<uint32_t, uint32_t> paths;
-  std::unordered_map<uint32_t, float> distances;
-
-  auto it = geometry->NavPoints.find(sourceID);
-  if (it == geometry->NavPoints.end()) {
-    // Error
-    return result;
-  }
-
-  check.insert(sourceID);
-  points[sourceID] = it->second;
-  distances[sourceID] = 0.f;
-
-  // Not found yet
-  distances[destID] = -1.f;
-
-  while (check.size() > 0) {
-    uint32_t pointID = *check.begin();
-    float dist = distances[pointID];
-    check.erase(pointID);
-
-    auto point = geometry->NavPoints[pointID];
-    for (auto& pair : point->GetDistances()) {
-      float dist2 = dist + pair.second;
-
-      // Once we find a full path, ignore nodes that go further out
-      // than what we've already found
-      if (distances[destID] != -1.f && dist2 > distances[destID]) continue;
-
-      if (points.find(pair.first) == points.end()) {
-        // New point reached
-        it = geometry->NavPoints.find(pair.first);
-        if (it != geometry->NavPoints.end()) {
-          points[pair.first] = it->second;
-          check.insert(pair.first);
-          paths[pair.first] = point->GetPointID();
-          distances[pair.first] = dist2;
-        }
-      } else if (distances[pair.first] > dist2) {
-        // Closer path found, update the chain
-        float delta = dist2 - distances[pair.first];
-        distances[pair.first] = dist2;
-
-        paths[pair.first] = point->GetPointID();
-
-        std::set<uint32_t> affected;
-        affected.insert(pair.first);
-
-        bool repeat = true;
-        while (repeat) {
-          repeat = false;
-          for (auto& pair2 : paths) {
-            if (affected.find(pair2.first) == affected.end() &&
-                affected.find(pair2.second) != affected.end()) {
-              affected.insert(pair2.first);
-              distances[pair2.first] += delta;
-              repeat = true;
-            }
-          }
-        }
-      }
-    }
+  if (!geometry->NavGraph) {
+    return std::list<uint32_t>();
   }
 
-  if (distances[destID] != -1.f) {
-    // End point was found, backtrack to get the path
-    result.push_back(destID);
-
-    uint32_t current = paths[destID];
-    while (current) {
-      result.push_front(current);
-
-      auto pIter = paths.find(current);
-      if (pIter != paths.end()) {
-        current = pIter->second;
-      } else {
-        current = 0;
-      }
-    }
-  }
-
-  return result;
+  return geometry->NavGraph->GetShortestPath(sourceID, destID);
 }
 
 float ZoneManager::GetPointToLineDistance(const Line& line,
@@ -7431,7 +7878,7 @@ bool ZoneManager::CanEnterRestrictedZone(
   }
 
   auto state = client->GetClientState();
-  auto def = zone->GetDefinition();
+  auto def = zone->GetCurrentDefinition();
   if (!def->GetRestricted()) {
     // Not actually restricted
     return true;
@@ -7505,6 +7952,12 @@ void ZoneManager::SendAccessMessage(
 void ZoneManager::RemoveZone(const std::shared_ptr<Zone>& zone,
                              bool freezeOnly) {
   if (!freezeOnly) {
+    // Scheduled removals hold the zone so cancel them first
+    auto server = mServer.lock();
+    for (uint64_t handle : zone->TakeObsoleteRemovalWork(true)) {
+      server->CancelScheduledWork(handle);
+    }
+
     mZones.erase(zone->GetID());
     zone->Cleanup();
     mTimeRestrictUpdatedZones.erase(zone->GetID());
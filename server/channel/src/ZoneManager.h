@@ -27,6 +27,9 @@
 #ifndef SERVER_CHANNEL_SRC_ZONEMANAGER_H
 #define SERVER_CHANNEL_SRC_ZONEMANAGER_H
 
+// Standard C++11 Includes
+#include <atomic>
+
 // object Includes
 #include <ServerZoneTrigger.h>
 
@@ -38,6 +41,7 @@
 
 // channel Includes
 #include "ChannelClientConnection.h"
+#include "TickRecorder.h"
 #include "Zone.h"
 #include "ZoneGeometry.h"
 #include "ZoneInstance.h"
@@ -46,6 +50,10 @@ namespace libcomp {
 class Packet;
 }
 
+namespace libhack {
+class ServerDataManager;
+}  // namespace libhack
+
 namespace objects {
 class ActionSpawn;
 class MiZoneData;
@@ -58,6 +66,7 @@ namespace channel {
 class ChannelServer;
 class WorldClock;
 class WorldClockTime;
+class ZoneWorkerPool;
 
 typedef objects::ServerZoneTrigger::Trigger_t ZoneTrigger_t;
 
@@ -523,6 +532,16 @@ class ZoneManager {
    */
   void BroadcastPacket(const std::shared_ptr<Zone>& zone, libcomp::Packet& p);
 
+  /**
+   * Send a packet about one or more entities to every connection in the
+   * specified zone that is interested in them
+   * @param zone Pointer to the zone to send the packet to
+   * @param p Packet to send to the zone
+   * @param entityIDs IDs of the entities the packet is about
+   */
+  void BroadcastPacket(const std::shared_ptr<Zone>& zone, libcomp::Packet& p,
+                       const std::set<int32_t>& entityIDs);
+
   /**
    * sends a packet to a specified range
    * @param client Client connection to use as the "source" connection
@@ -544,6 +563,61 @@ class ZoneManager {
       const std::shared_ptr<ChannelClientConnection>& client,
       bool includeSelf = true);
 
+  /**
+   * Get the client connections in a zone that an entity should be shown
+   * to. If interest filtering is enabled and the entity is filtered, only
+   * connections within draw distance of the entity are returned and they
+   * are marked as having the entity shown. Everyone else will have it
+   * shown when it comes into range.
+   * @param zone Pointer to the zone the entity is in
+   * @param entity Pointer to the entity being shown
+   * @param packetSize Size of the packets showing the entity, used to
+   *  track how much was saved by filtering
+   * @return List of client connections to show the entity to
+   */
+  std::list<std::shared_ptr<ChannelClientConnection>> GetShowConnections(
+      const std::shared_ptr<Zone>& zone,
+      const std::shared_ptr<ActiveEntityState>& entity, uint32_t packetSize);
+
+  /**
+   * Get the client connections in a zone that should be sent an update
+   * about one or more entities. If interest filtering is enabled, updates
+   * about filtered entities are only sent to the connections they are
+   * currently shown to.
+   * @param zone Pointer to the zone the entities are in
+   * @param entityIDs IDs of the entities the update is about
+   * @param packetSize Size of the update packet, used to track how much
+   *  was saved by filtering
+   * @return List of client connections to send the update to
+   */
+  std::list<std::shared_ptr<ChannelClientConnection>> GetInterestedConnections(
+      const std::shared_ptr<Zone>& zone, const std::set<int32_t>& entityIDs,
+      uint32_t packetSize);
+
+  /**
+   * Send packets about entities in a zone to every client connection that
+   * is interested in the entity each one is about.
+   * @param zone Pointer to the zone the entities are in
+   * @param packets List of entity IDs paired with the packet about them
+   */
+  void BroadcastEntityPackets(
+      const std::shared_ptr<Zone>& zone,
+      std::list<std::pair<int32_t, libcomp::Packet>>& packets);
+
+  /**
+   * Get the number of packets that were not sent because the client was
+   * out of range of the entity they were about.
+   * @return Total number of packets filtered since the server started
+   */
+  uint64_t GetFilteredPacketCount() const;
+
+  /**
+   * Get the number of bytes that were not sent because the client was out
+   * of range of the entity they were about.
+   * @return Total number of bytes filtered since the server started
+   */
+  uint64_t GetFilteredByteCount() const;
+
   /**
    * Spawn an enemy in the specified zone at set coordinates
    * @param zone Pointer to the zone where the enemy should be spawned
@@ -725,6 +799,33 @@ class ZoneManager {
    */
   void UpdateActiveZoneStates();
 
+  /**
+   * Update the definitions of every zone built from data that changed
+   * between the supplied server data manager and the current one. Zones
+   * whose new definition is missing spawn data their entities still refer
+   * to keep the definition they were built with until they are recreated.
+   * Zones with players in them are updated once the last player leaves.
+   * Only the tick thread should call this.
+   * @param previous Pointer to the server data manager that was replaced
+   * @return Number of zones that were updated or will be once empty
+   */
+  size_t ReconcileZoneDefinitions(libhack::ServerDataManager* previous);
+
+  /**
+   * Apply reloaded definitions to the zones waiting for their players to
+   * leave. Only the tick thread should call this.
+   */
+  void ApplyPendingZoneDefinitions();
+
+  /**
+   * Run work with side effects outside of the zone currently being updated
+   * once every active zone has finished updating. If zones are not being
+   * updated in parallel (or the calling thread is not updating a zone) the
+   * work is run immediately.
+   * @param work Work to run
+   */
+  void DeferZoneMerge(const std::function<void()>& work);
+
   /**
    * Update the state of status effects in the supplied zone, adding
    * and updating existing effects, expiring old effects and applying
@@ -1295,6 +1396,38 @@ class ZoneManager {
    */
   void HandleDespawns(const std::shared_ptr<Zone>& zone);
 
+  /**
+   * Perform the per-tick updates for a single active zone including
+   * despawns, combat, AI, spawns and plasma. Anything affecting more than
+   * the zone itself is deferred via DeferZoneMerge so this can safely be
+   * run in parallel with other zones.
+   * @param zone Pointer to the zone to update
+   * @param serverTime Current server time
+   * @param isNight true if the world clock is currently at night
+   * @param record Optional pointer to the tick recorder entry for the zone
+   *  to fill in with how long the update took
+   */
+  void UpdateActiveZoneState(const std::shared_ptr<Zone>& zone,
+                             ServerTime serverTime, bool isNight,
+                             TickRecorder::ZoneRecord* record);
+
+  /**
+   * Show the entities filtered by interest in a zone to the clients they
+   * came into range of and remove the ones that moved out of range. Shown
+   * entities have their full data and current movement sent since no
+   * updates about them were received while they were out of range.
+   * @param zone Pointer to the zone to update
+   * @param now Current server time
+   */
+  void UpdateInterest(const std::shared_ptr<Zone>& zone, ServerTime now);
+
+  /**
+   * Track packets that were not sent due to interest filtering.
+   * @param count Number of packets that were not sent
+   * @param packetSize Size of each packet
+   */
+  void RecordFilteredPackets(size_t count, uint32_t packetSize);
+
   /**
    * Update the state of status effects in the supplied zone, adding
    * and updating existing effects, expiring old effects and applying
@@ -1455,6 +1588,14 @@ class ZoneManager {
   /// Map of global boss group IDs to zones in that group on the server
   std::unordered_map<uint32_t, std::set<uint32_t>> mGlobalBossZones;
 
+  /// Map of unique zone IDs to the zone and the reloaded definition it
+  /// will be given once no players are in it. Only used by the tick
+  /// thread.
+  std::unordered_map<uint32_t,
+                     std::pair<std::weak_ptr<Zone>,
+                               std::shared_ptr<objects::ServerZone>>>
+      mPendingDefinitions;
+
   /// Set of all zones that should be considered active when
   /// updating states. When a zone is removed from this set but
   /// not removed entirely, its AI etc will be frozen until a player
@@ -1492,6 +1633,23 @@ class ZoneManager {
   /// Next available zone instance unique ID
   uint32_t mNextZoneInstanceID;
 
+  /// Optional pool of threads active zones are updated across
+  ZoneWorkerPool* mZoneWorkers;
+
+  /// Definition IDs of zones AI level of detail counts have been reported
+  /// for, only accessed from the tick thread
+  std::set<uint32_t> mAICountZones;
+
+  /// true if enemies and allies are only shown to clients in range of
+  /// them and their updates are only sent to the clients they are shown to
+  bool mInterestFiltering;
+
+  /// Number of packets not sent due to interest filtering
+  std::atomic<uint64_t> mFilteredPackets;
+
+  /// Number of bytes not sent due to interest filtering
+  std::atomic<uint64_t> mFilteredBytes;
+
   /// Server lock for shared resources
   libcomp::Mutex mLock;
 
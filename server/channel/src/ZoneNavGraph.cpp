@@ -0,0 +1,507 @@
+/**
+ * @file server/channel/src/ZoneNavGraph.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Compact navigation graph built from the nav points of a QMP file.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ZoneNavGraph.h"
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <queue>
+
+// object Includes
+#include <QmpNavPoint.h>
+
+using namespace channel;
+
+/// Index used to mark that no point has been set
+static const uint32_t NO_POINT = std::numeric_limits<uint32_t>::max();
+
+/// Route table entry used to mark that no path exists
+static const uint16_t NO_ROUTE = 0xFFFF;
+
+/// Identifies a saved route table ("NAVR")
+static const uint32_t ROUTE_TABLE_MAGIC = 0x5256414E;
+
+/// Saved route table format version, increment if the format or hash
+/// calculation ever changes
+static const uint32_t ROUTE_TABLE_VERSION = 1;
+
+namespace {
+
+/// Entry in the nearest point search queue, either a single point or a
+/// range of the KD-tree that has not been expanded yet
+struct NavSearchEntry {
+  /// Squared distance to the point or the minimum possible squared
+  /// distance to anything in the range
+  float Distance;
+
+  /// Index of the point or first index of the range in the tree
+  uint32_t Lo;
+
+  /// NO_POINT for a single point or the index after the last index of the
+  /// range in the tree
+  uint32_t Hi;
+
+  /// Depth of the range in the tree
+  uint8_t Depth;
+
+  bool operator>(const NavSearchEntry& other) const {
+    return Distance > other.Distance;
+  }
+};
+
+}  // namespace
+
+ZoneNavGraph::ZoneNavGraph(
+    const std::unordered_map<uint32_t, std::shared_ptr<objects::QmpNavPoint>>&
+        navPoints)
+    : mRouteTable(nullptr), mEstimateScale(1.f) {
+  // Order by ID so indexes are the same every time the graph is built
+  std::vector<uint32_t> pointIDs;
+  for (auto& pair : navPoints) {
+    if (pair.second) {
+      pointIDs.push_back(pair.first);
+    }
+  }
+
+  std::sort(pointIDs.begin(), pointIDs.end());
+
+  for (uint32_t pointID : pointIDs) {
+    auto navPoint = navPoints.at(pointID);
+
+    mIndexes[pointID] = (uint32_t)mPoints.size();
+    mPoints.push_back(navPoint);
+    mPositions.push_back(
+        Point((float)navPoint->GetX(), (float)navPoint->GetY()));
+  }
+
+  mEdgeOffsets.push_back(0);
+  for (uint32_t idx = 0; idx < (uint32_t)mPoints.size(); idx++) {
+    for (auto& pair : mPoints[idx]->GetDistances()) {
+      auto it = mIndexes.find(pair.first);
+      if (it == mIndexes.end() || pair.second < 0.f) {
+        // Filtered out or invalid
+        continue;
+      }
+
+      Edge edge;
+      edge.Target = it->second;
+      edge.Distance = pair.second;
+      mEdges.push_back(edge);
+
+      // Never let the estimate exceed a stored distance, regardless of
+      // how the file calculated them
+      float straight = mPositions[idx].GetDistance(mPositions[edge.Target]);
+      if (straight > 0.f && edge.Distance < straight * mEstimateScale) {
+        mEstimateScale = edge.Distance / straight;
+      }
+    }
+
+    mEdgeOffsets.push_back((uint32_t)mEdges.size());
+  }
+
+  for (uint32_t idx = 0; idx < (uint32_t)mPoints.size(); idx++) {
+    mTree.push_back(idx);
+  }
+
+  BuildTree(0, mTree.size(), 0);
+}
+
+size_t ZoneNavGraph::Count() const { return mPoints.size(); }
+
+std::shared_ptr<objects::QmpNavPoint> ZoneNavGraph::GetNearestPoint(
+    const Point& point,
+    const std::function<bool(const Point&)>& accept) const {
+  if (mTree.size() == 0) {
+    return nullptr;
+  }
+
+  std::priority_queue<NavSearchEntry, std::vector<NavSearchEntry>,
+                      std::greater<NavSearchEntry>>
+      queue;
+
+  NavSearchEntry root;
+  root.Distance = 0.f;
+  root.Lo = 0;
+  root.Hi = (uint32_t)mTree.size();
+  root.Depth = 0;
+  queue.push(root);
+
+  while (!queue.empty()) {
+    NavSearchEntry entry = queue.top();
+    queue.pop();
+
+    if (entry.Hi == NO_POINT) {
+      // Nothing left in the queue can be closer than this point
+      if (accept(mPositions[entry.Lo])) {
+        return mPoints[entry.Lo];
+      }
+
+      continue;
+    }
+
+    uint32_t mid = entry.Lo + (entry.Hi - entry.Lo) / 2;
+    const Point& p = mPositions[mTree[mid]];
+
+    NavSearchEntry pointEntry;
+    pointEntry.Distance = (p.x - point.x) * (p.x - point.x) +
+                          (p.y - point.y) * (p.y - point.y);
+    pointEntry.Lo = mTree[mid];
+    pointEntry.Hi = NO_POINT;
+    pointEntry.Depth = 0;
+    queue.push(pointEntry);
+
+    // Anything on the far side of the split is at least as far as the
+    // split itself
+    float diff = (entry.Depth % 2) == 0 ? point.x - p.x : point.y - p.y;
+    float farDist = std::max(entry.Distance, diff * diff);
+
+    for (uint8_t side = 0; side < 2; side++) {
+      NavSearchEntry child;
+      child.Lo = side == 0 ? entry.Lo : mid + 1;
+      child.Hi = side == 0 ? mid : entry.Hi;
+      child.Depth = (uint8_t)(entry.Depth + 1);
+      if (child.Lo >= child.Hi) {
+        continue;
+      }
+
+      // The lower side holds values less than or equal to the split
+      bool nearSide = (side == 0) == (diff <= 0.f);
+      child.Distance = nearSide ? entry.Distance : farDist;
+      queue.push(child);
+    }
+  }
+
+  return nullptr;
+}
+
+std::list<uint32_t> ZoneNavGraph::GetShortestPath(uint32_t sourceID,
+                                                  uint32_t destID) const {
+  std::list<uint32_t> result;
+
+  auto sourceIter = mIndexes.find(sourceID);
+  auto destIter = mIndexes.find(destID);
+  if (sourceIter == mIndexes.end() || destIter == mIndexes.end()) {
+    // Error
+    return result;
+  }
+
+  uint32_t source = sourceIter->second;
+  uint32_t dest = destIter->second;
+
+  if (mRouteTable) {
+    // Walk the precomputed routes
+    size_t count = mPoints.size();
+    for (uint32_t current = source; current != NO_POINT;) {
+      result.push_back(mPoints[current]->GetPointID());
+      if (current == dest) {
+        return result;
+      }
+
+      uint16_t next = mRouteTable[(size_t)current * count + dest];
+      if (next == NO_ROUTE || result.size() > count) {
+        // No path (or a corrupt table)
+        break;
+      }
+
+      current = next;
+    }
+
+    result.clear();
+    return result;
+  }
+
+  std::vector<float> distances(mPoints.size(),
+                               std::numeric_limits<float>::infinity());
+  std::vector<uint32_t> previous(mPoints.size(), NO_POINT);
+  std::vector<bool> closed(mPoints.size(), false);
+
+  // Open set ordered by distance travelled plus estimated distance left
+  typedef std::pair<float, uint32_t> OpenEntry;
+  std::priority_queue<OpenEntry, std::vector<OpenEntry>,
+                      std::greater<OpenEntry>>
+      open;
+
+  distances[source] = 0.f;
+  open.push(OpenEntry(Estimate(source, dest), source));
+
+  while (!open.empty()) {
+    uint32_t current = open.top().second;
+    open.pop();
+
+    if (closed[current]) {
+      // Stale entry from before a shorter path was found
+      continue;
+    }
+
+    if (current == dest) {
+      break;
+    }
+
+    closed[current] = true;
+
+    float dist = distances[current];
+    for (uint32_t i = mEdgeOffsets[current]; i < mEdgeOffsets[current + 1];
+         i++) {
+      const Edge& edge = mEdges[i];
+
+      float dist2 = dist + edge.Distance;
+      if (!closed[edge.Target] && dist2 < distances[edge.Target]) {
+        distances[edge.Target] = dist2;
+        previous[edge.Target] = current;
+        open.push(OpenEntry(dist2 + Estimate(edge.Target, dest), edge.Target));
+      }
+    }
+  }
+
+  if (source == dest || previous[dest] != NO_POINT) {
+    // End point was found, backtrack to get the path
+    for (uint32_t current = dest; current != NO_POINT;
+         current = previous[current]) {
+      result.push_front(mPoints[current]->GetPointID());
+    }
+  }
+
+  return result;
+}
+
+uint64_t ZoneNavGraph::GetContentHash() const {
+  // 64-bit FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  auto add = [&hash](const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+
+  uint32_t count = (uint32_t)mPoints.size();
+  add(&count, sizeof(count));
+
+  for (uint32_t idx = 0; idx < count; idx++) {
+    uint32_t pointID = mPoints[idx]->GetPointID();
+    add(&pointID, sizeof(pointID));
+    add(&mPositions[idx].x, sizeof(float));
+    add(&mPositions[idx].y, sizeof(float));
+
+    for (uint32_t i = mEdgeOffsets[idx]; i < mEdgeOffsets[idx + 1]; i++) {
+      add(&mEdges[i].Target, sizeof(uint32_t));
+      add(&mEdges[i].Distance, sizeof(float));
+    }
+  }
+
+  return hash;
+}
+
+bool ZoneNavGraph::HasRouteTable() const { return mRouteTable != nullptr; }
+
+bool ZoneNavGraph::BuildRouteTable() {
+  size_t count = mPoints.size();
+  if (count == 0 || count >= (size_t)NO_ROUTE) {
+    return false;
+  }
+
+  std::vector<uint16_t> routes(count * count, NO_ROUTE);
+
+  std::vector<float> distances(count);
+  std::vector<uint32_t> firstHop(count);
+
+  typedef std::pair<float, uint32_t> OpenEntry;
+
+  // Dijkstra from every point, recording the first point moved to on the
+  // way to each point reached
+  for (uint32_t source = 0; source < (uint32_t)count; source++) {
+    std::fill(distances.begin(), distances.end(),
+              std::numeric_limits<float>::infinity());
+    std::fill(firstHop.begin(), firstHop.end(), NO_POINT);
+
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>,
+                        std::greater<OpenEntry>>
+        open;
+
+    distances[source] = 0.f;
+    firstHop[source] = source;
+    open.push(OpenEntry(0.f, source));
+
+    while (!open.empty()) {
+      OpenEntry entry = open.top();
+      open.pop();
+
+      uint32_t current = entry.second;
+      if (entry.first > distances[current]) {
+        // Stale entry from before a shorter path was found
+        continue;
+      }
+
+      for (uint32_t i = mEdgeOffsets[current]; i < mEdgeOffsets[current + 1];
+           i++) {
+        const Edge& edge = mEdges[i];
+
+        float dist2 = entry.first + edge.Distance;
+        if (dist2 < distances[edge.Target]) {
+          distances[edge.Target] = dist2;
+          firstHop[edge.Target] =
+              current == source ? edge.Target : firstHop[current];
+          open.push(OpenEntry(dist2, edge.Target));
+        }
+      }
+    }
+
+    uint16_t* row = &routes[(size_t)source * count];
+    for (size_t dest = 0; dest < count; dest++) {
+      if (firstHop[dest] != NO_POINT) {
+        row[dest] = (uint16_t)firstHop[dest];
+      }
+    }
+  }
+
+  mRoutes.swap(routes);
+  mRouteTable = mRoutes.data();
+  mSharedStore = nullptr;
+
+  return true;
+}
+
+bool ZoneNavGraph::LoadRouteTable(std::istream& in) {
+  uint32_t magic = 0, version = 0, count = 0;
+  uint64_t hash = 0;
+
+  in.read((char*)&magic, sizeof(magic));
+  in.read((char*)&version, sizeof(version));
+  in.read((char*)&hash, sizeof(hash));
+  in.read((char*)&count, sizeof(count));
+  if (!in.good() || magic != ROUTE_TABLE_MAGIC ||
+      version != ROUTE_TABLE_VERSION || count != (uint32_t)mPoints.size() ||
+      count == 0 || hash != GetContentHash()) {
+    return false;
+  }
+
+  std::vector<uint16_t> routes((size_t)count * (size_t)count);
+  in.read((char*)routes.data(),
+          (std::streamsize)(routes.size() * sizeof(uint16_t)));
+  if (!in.good()) {
+    return false;
+  }
+
+  for (uint16_t route : routes) {
+    if (route != NO_ROUTE && route >= count) {
+      return false;
+    }
+  }
+
+  mRoutes.swap(routes);
+  mRouteTable = mRoutes.data();
+  mSharedStore = nullptr;
+
+  return true;
+}
+
+bool ZoneNavGraph::SaveRouteTable(std::ostream& out) const {
+  if (!mRouteTable) {
+    return false;
+  }
+
+  uint32_t magic = ROUTE_TABLE_MAGIC;
+  uint32_t version = ROUTE_TABLE_VERSION;
+  uint64_t hash = GetContentHash();
+  uint32_t count = (uint32_t)mPoints.size();
+
+  out.write((const char*)&magic, sizeof(magic));
+  out.write((const char*)&version, sizeof(version));
+  out.write((const char*)&hash, sizeof(hash));
+  out.write((const char*)&count, sizeof(count));
+  out.write((const char*)mRouteTable,
+            (std::streamsize)((size_t)count * count * sizeof(uint16_t)));
+
+  return out.good();
+}
+
+bool ZoneNavGraph::AttachRouteTable(
+    const std::shared_ptr<libhack::SharedDataStore>& store, const char* pData,
+    size_t size) {
+  uint32_t magic = 0, version = 0, count = 0;
+  uint64_t hash = 0;
+
+  size_t headerSize =
+      sizeof(magic) + sizeof(version) + sizeof(hash) + sizeof(count);
+  if (!store || size < headerSize ||
+      (uintptr_t)(pData + headerSize) % alignof(uint16_t) != 0) {
+    return false;
+  }
+
+  memcpy(&magic, pData, sizeof(magic));
+  memcpy(&version, pData + 4, sizeof(version));
+  memcpy(&hash, pData + 8, sizeof(hash));
+  memcpy(&count, pData + 16, sizeof(count));
+  if (magic != ROUTE_TABLE_MAGIC || version != ROUTE_TABLE_VERSION ||
+      count != (uint32_t)mPoints.size() || count == 0 ||
+      hash != GetContentHash() ||
+      size != headerSize + (size_t)count * count * sizeof(uint16_t)) {
+    return false;
+  }
+
+  auto routes = reinterpret_cast<const uint16_t*>(pData + headerSize);
+  for (size_t i = 0; i < (size_t)count * count; i++) {
+    if (routes[i] != NO_ROUTE && routes[i] >= count) {
+      return false;
+    }
+  }
+
+  mRouteTable = routes;
+  mSharedStore = store;
+
+  // Free the table held by this server, if any
+  std::vector<uint16_t>().swap(mRoutes);
+
+  return true;
+}
+
+void ZoneNavGraph::BuildTree(size_t lo, size_t hi, uint8_t depth) {
+  if (hi - lo < 2) {
+    return;
+  }
+
+  size_t mid = lo + (hi - lo) / 2;
+
+  bool xAxis = (depth % 2) == 0;
+  std::nth_element(mTree.begin() + (ptrdiff_t)lo, mTree.begin() + (ptrdiff_t)mid,
+                   mTree.begin() + (ptrdiff_t)hi,
+                   [this, xAxis](uint32_t a, uint32_t b) {
+                     return xAxis ? mPositions[a].x < mPositions[b].x
+                                  : mPositions[a].y < mPositions[b].y;
+                   });
+
+  BuildTree(lo, mid, (uint8_t)(depth + 1));
+  BuildTree(mid + 1, hi, (uint8_t)(depth + 1));
+}
+
+float ZoneNavGraph::Estimate(uint32_t from, uint32_t to) const {
+  return mPositions[from].GetDistance(mPositions[to]) * mEstimateScale;
+}
@@ -0,0 +1,219 @@
+/**
+ * @file server/channel/src/ZoneNavGraph.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Compact navigation graph built from the nav points of a QMP file.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_ZONENAVGRAPH_H
+#define SERVER_CHANNEL_SRC_ZONENAVGRAPH_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// channel Includes
+#include "ZoneGeometry.h"
+
+namespace libhack {
+class SharedDataStore;
+}  // namespace libhack
+
+namespace objects {
+class QmpNavPoint;
+}  // namespace objects
+
+namespace channel {
+
+/**
+ * Read-only navigation graph built from the nav points of a zone geometry.
+ * Nav point IDs are remapped to contiguous indexes so the adjacency can be
+ * stored in flat arrays, shortest paths are calculated using A* and points
+ * are stored in a KD-tree so they can be searched in order of distance.
+ * Shortest paths can optionally be precomputed into a table of the next
+ * point to move to for every pair of points, turning path requests into
+ * a walk of the table. Once built (and any route table is set), the graph
+ * is never modified so it can be safely used from multiple threads at once.
+ */
+class ZoneNavGraph {
+ public:
+  /**
+   * Build a navigation graph. Connections to points that are not in the
+   * supplied set are dropped.
+   * @param navPoints Map of nav points by point ID
+   */
+  ZoneNavGraph(const std::unordered_map<
+               uint32_t, std::shared_ptr<objects::QmpNavPoint>>& navPoints);
+
+  /**
+   * Get the number of nav points in the graph.
+   * @return Number of nav points in the graph
+   */
+  size_t Count() const;
+
+  /**
+   * Get the nav point nearest to the supplied point that is accepted by
+   * the supplied filter. Points are checked in order of distance so the
+   * filter is only called as many times as needed.
+   * @param point Point to search from
+   * @param accept Function that returns true if a nav point's position
+   *  is usable, such as when it is visible from the point
+   * @return Pointer to the nearest accepted nav point or null if none
+   *  were accepted
+   */
+  std::shared_ptr<objects::QmpNavPoint> GetNearestPoint(
+      const Point& point,
+      const std::function<bool(const Point&)>& accept) const;
+
+  /**
+   * Calculate the shortest path between two nav points.
+   * @param sourceID Source point ID
+   * @param destID Destination point ID
+   * @return List of point IDs starting with the source and ending with the
+   *  destination or empty if no path exists
+   */
+  std::list<uint32_t> GetShortestPath(uint32_t sourceID,
+                                      uint32_t destID) const;
+
+  /**
+   * Get a hash of the points and connections in the graph, used to make
+   * sure a cached route table matches the graph it was built from.
+   * @return 64-bit hash of the graph contents
+   */
+  uint64_t GetContentHash() const;
+
+  /**
+   * Check if shortest paths have been precomputed for the graph.
+   * @return true if a route table is loaded
+   */
+  bool HasRouteTable() const;
+
+  /**
+   * Precompute the shortest path between every pair of points. The table
+   * needs two bytes for every pair so large graphs should be skipped.
+   * @return true if the table was built, false if the graph has too many
+   *  points to index with a route table
+   */
+  bool BuildRouteTable();
+
+  /**
+   * Load a route table previously saved by SaveRouteTable.
+   * @param in Stream to read the table from
+   * @return true if the table was loaded, false if it is invalid or was
+   *  built from a graph with different contents
+   */
+  bool LoadRouteTable(std::istream& in);
+
+  /**
+   * Save the route table so it can be loaded later instead of being
+   * built again.
+   * @param out Stream to write the table to
+   * @return true if the table was written
+   */
+  bool SaveRouteTable(std::ostream& out) const;
+
+  /**
+   * Use a route table saved by SaveRouteTable that is read in place from
+   * a shared data store instead of one held by this server.
+   * @param store Store the saved table is in, kept open by the graph
+   * @param pData Pointer to the saved table in the store
+   * @param size Size of the saved table in bytes
+   * @return true if the table was attached, false if it is invalid or was
+   *  built from a graph with different contents
+   */
+  bool AttachRouteTable(const std::shared_ptr<libhack::SharedDataStore>& store,
+                        const char* pData, size_t size);
+
+ private:
+  /// Connection from one nav point to another
+  struct Edge {
+    /// Index of the point connected to
+    uint32_t Target;
+
+    /// Cost of travelling the connection
+    float Distance;
+  };
+
+  /**
+   * Sort a range of the KD-tree so the median point on the split axis for
+   * the depth is in the middle, then sort each side the same way.
+   * @param lo First index of the range in mTree
+   * @param hi Index after the last in the range in mTree
+   * @param depth Depth of the range in the tree
+   */
+  void BuildTree(size_t lo, size_t hi, uint8_t depth);
+
+  /**
+   * Get the estimated remaining distance between two points for A*.
+   * @param from Index of the point to estimate from
+   * @param to Index of the point to estimate to
+   * @return Estimated distance that never exceeds the real distance
+   */
+  float Estimate(uint32_t from, uint32_t to) const;
+
+  /// Nav points by index
+  std::vector<std::shared_ptr<objects::QmpNavPoint>> mPoints;
+
+  /// Nav point positions by index
+  std::vector<Point> mPositions;
+
+  /// Map of nav point IDs to indexes
+  std::unordered_map<uint32_t, uint32_t> mIndexes;
+
+  /// Offset of each point's first connection in mEdges, with one extra
+  /// entry marking the end of the last point's connections
+  std::vector<uint32_t> mEdgeOffsets;
+
+  /// Connections of every point, grouped by point
+  std::vector<Edge> mEdges;
+
+  /// Point indexes arranged as an implicit KD-tree, where the middle of
+  /// each range is the node splitting the rest of the range
+  std::vector<uint32_t> mTree;
+
+  /// Index of the next point to move to for every source and destination
+  /// point pair, stored as [source * count + destination]. Null if no
+  /// route table has been built, loaded or attached.
+  const uint16_t* mRouteTable;
+
+  /// Route table built or loaded by this server, empty if there is none
+  /// or it is shared
+  std::vector<uint16_t> mRoutes;
+
+  /// Store the shared route table is read from, null if the route table
+  /// is not shared
+  std::shared_ptr<libhack::SharedDataStore> mSharedStore;
+
+  /// Multiplier applied to straight line distances when estimating the
+  /// remaining distance so estimates never exceed the stored distances
+  float mEstimateScale;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_ZONENAVGRAPH_H
@@ -0,0 +1,245 @@
+/**
+ * @file server/channel/src/ZoneSpatialGrid.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Uniform grid used to look up active entities in a zone by position.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ZoneSpatialGrid.h"
+
+// C++ Standard Includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+// channel Includes
+#include "ActiveEntityState.h"
+
+using namespace channel;
+
+/// Maximum number of cells a single entity will be indexed in before it is
+/// treated as oversized and returned from every query instead
+static const int64_t MAX_ENTITY_CELLS = 64;
+
+/// Cell indexes are clamped to this range to keep bad coordinates from
+/// overflowing
+static const float MAX_CELL_INDEX = 1048576.f;
+
+ZoneSpatialGrid::ZoneSpatialGrid(float cellSize)
+    : mCellSize(cellSize > 0.f ? cellSize : 1.f), mNextSequence(0) {}
+
+bool ZoneSpatialGrid::Update(const std::shared_ptr<ActiveEntityState>& entity) {
+  int32_t entityID = entity->GetEntityID();
+
+  auto it = mRecords.find(entityID);
+  if (it != mRecords.end()) {
+    if (it->second.Entity != entity) {
+      // Same ID re-used by a new entity, start over
+      Unlink(entityID, it->second);
+      mRecords.erase(it);
+    } else {
+      return Refresh(entityID, it->second);
+    }
+  }
+
+  Record& record = mRecords[entityID];
+  record.Entity = entity;
+  record.Sequence = mNextSequence++;
+  Capture(entity, record.Position);
+  Link(entityID, record);
+
+  return true;
+}
+
+bool ZoneSpatialGrid::Refresh(int32_t entityID) {
+  auto it = mRecords.find(entityID);
+  return it != mRecords.end() && Refresh(entityID, it->second);
+}
+
+void ZoneSpatialGrid::Remove(int32_t entityID) {
+  auto it = mRecords.find(entityID);
+  if (it != mRecords.end()) {
+    Unlink(entityID, it->second);
+    mRecords.erase(it);
+  }
+}
+
+void ZoneSpatialGrid::Clear() {
+  mRecords.clear();
+  mCells.clear();
+  mOversized.clear();
+}
+
+std::list<std::shared_ptr<ActiveEntityState>> ZoneSpatialGrid::Query(
+    float x, float y, float radius) const {
+  // Order by sequence to match the order the entities were added in
+  std::map<uint64_t, std::shared_ptr<ActiveEntityState>> found;
+
+  for (int32_t entityID : mOversized) {
+    auto& record = mRecords.at(entityID);
+    found[record.Sequence] = record.Entity;
+  }
+
+  radius = std::fabs(radius);
+
+  int32_t minX = GetCell(x - radius);
+  int32_t maxX = GetCell(x + radius);
+  int32_t minY = GetCell(y - radius);
+  int32_t maxY = GetCell(y + radius);
+
+  int64_t cellCount = (int64_t)(maxX - minX + 1) * (int64_t)(maxY - minY + 1);
+  if (cellCount > (int64_t)mCells.size()) {
+    // Faster to check every populated cell than every cell in range
+    for (auto& pair : mCells) {
+      int32_t cX = (int32_t)(uint32_t)(pair.first >> 32);
+      int32_t cY = (int32_t)(uint32_t)(pair.first & 0xFFFFFFFF);
+      if (cX >= minX && cX <= maxX && cY >= minY && cY <= maxY) {
+        for (int32_t entityID : pair.second) {
+          auto& record = mRecords.at(entityID);
+          found[record.Sequence] = record.Entity;
+        }
+      }
+    }
+  } else {
+    for (int32_t cX = minX; cX <= maxX; cX++) {
+      for (int32_t cY = minY; cY <= maxY; cY++) {
+        auto cIter = mCells.find(GetCellKey(cX, cY));
+        if (cIter != mCells.end()) {
+          for (int32_t entityID : cIter->second) {
+            auto& record = mRecords.at(entityID);
+            found[record.Sequence] = record.Entity;
+          }
+        }
+      }
+    }
+  }
+
+  std::list<std::shared_ptr<ActiveEntityState>> results;
+  for (auto& pair : found) {
+    results.push_back(pair.second);
+  }
+
+  return results;
+}
+
+size_t ZoneSpatialGrid::Count() const { return mRecords.size(); }
+
+void ZoneSpatialGrid::Capture(const std::shared_ptr<ActiveEntityState>& entity,
+                              float (&position)[7]) {
+  position[0] = entity->GetOriginX();
+  position[1] = entity->GetOriginY();
+  position[2] = entity->GetCurrentX();
+  position[3] = entity->GetCurrentY();
+  position[4] = entity->GetDestinationX();
+  position[5] = entity->GetDestinationY();
+  position[6] = (float)entity->GetHitboxSize() * 10.f;
+}
+
+int32_t ZoneSpatialGrid::GetCell(float coord) const {
+  float cell = std::floor(coord / mCellSize);
+  if (!(cell > -MAX_CELL_INDEX)) {
+    // Also catches NaN
+    return -(int32_t)MAX_CELL_INDEX;
+  } else if (cell > MAX_CELL_INDEX) {
+    return (int32_t)MAX_CELL_INDEX;
+  }
+
+  return (int32_t)cell;
+}
+
+void ZoneSpatialGrid::Link(int32_t entityID, Record& record) {
+  const float* p = record.Position;
+  float extent = p[6];
+
+  // The origin is not always updated when an entity is warped so the
+  // current point is included as well
+  float minX = std::min(std::min(p[0], p[2]), p[4]) - extent;
+  float maxX = std::max(std::max(p[0], p[2]), p[4]) + extent;
+  float minY = std::min(std::min(p[1], p[3]), p[5]) - extent;
+  float maxY = std::max(std::max(p[1], p[3]), p[5]) + extent;
+
+  CellBounds& cells = record.Cells;
+  cells.MinX = GetCell(minX);
+  cells.MaxX = GetCell(maxX);
+  cells.MinY = GetCell(minY);
+  cells.MaxY = GetCell(maxY);
+
+  int64_t cellCount = (int64_t)(cells.MaxX - cells.MinX + 1) *
+                      (int64_t)(cells.MaxY - cells.MinY + 1);
+  record.Oversized = cellCount > MAX_ENTITY_CELLS;
+  if (record.Oversized) {
+    mOversized.insert(entityID);
+    return;
+  }
+
+  for (int32_t cX = cells.MinX; cX <= cells.MaxX; cX++) {
+    for (int32_t cY = cells.MinY; cY <= cells.MaxY; cY++) {
+      mCells[GetCellKey(cX, cY)].insert(entityID);
+    }
+  }
+}
+
+void ZoneSpatialGrid::Unlink(int32_t entityID, const Record& record) {
+  if (record.Oversized) {
+    mOversized.erase(entityID);
+    return;
+  }
+
+  const CellBounds& cells = record.Cells;
+  for (int32_t cX = cells.MinX; cX <= cells.MaxX; cX++) {
+    for (int32_t cY = cells.MinY; cY <= cells.MaxY; cY++) {
+      auto cIter = mCells.find(GetCellKey(cX, cY));
+      if (cIter != mCells.end()) {
+        cIter->second.erase(entityID);
+        if (cIter->second.size() == 0) {
+          mCells.erase(cIter);
+        }
+      }
+    }
+  }
+}
+
+bool ZoneSpatialGrid::Refresh(int32_t entityID, Record& record) {
+  float position[7];
+  Capture(record.Entity, position);
+  if (std::equal(position, position + 7, record.Position)) {
+    // Nothing has moved that could change the bounds
+    return false;
+  }
+
+  CellBounds previous = record.Cells;
+  bool wasOversized = record.Oversized;
+
+  Unlink(entityID, record);
+  std::copy(position, position + 7, record.Position);
+  Link(entityID, record);
+
+  return wasOversized != record.Oversized ||
+         previous.MinX != record.Cells.MinX ||
+         previous.MaxX != record.Cells.MaxX ||
+         previous.MinY != record.Cells.MinY ||
+         previous.MaxY != record.Cells.MaxY;
+}
+
+uint64_t ZoneSpatialGrid::GetCellKey(int32_t x, int32_t y) {
+  return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file server/channel/src/ZoneSpatialGrid.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Uniform grid used to look up active entities in a zone by position.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_ZONESPATIALGRID_H
+#define SERVER_CHANNEL_SRC_ZONESPATIALGRID_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
+
+namespace channel {
+
+class ActiveEntityState;
+
+/**
+ * Spatial hash of the active entities in a zone. Each entity is indexed by
+ * the bounding box of its current movement: the origin, current and
+ * destination points extended by its hitbox. Since an entity's interpolated
+ * position always falls between its origin and destination, the index stays
+ * valid for the entire movement and only needs to be updated when a new
+ * movement (or warp) is set. Queries return candidates only; callers must
+ * still refresh positions and perform their exact checks. The grid itself
+ * is not thread safe and must be guarded by the owner.
+ */
+class ZoneSpatialGrid {
+ public:
+  /**
+   * Create a new empty grid.
+   * @param cellSize Width and height of each grid cell in world units
+   */
+  ZoneSpatialGrid(float cellSize);
+
+  /**
+   * Add an entity to the grid or re-index it if its movement bounds have
+   * changed since it was last indexed.
+   * @param entity Pointer to the entity to index
+   * @return true if the entity was added or moved to different cells
+   */
+  bool Update(const std::shared_ptr<ActiveEntityState>& entity);
+
+  /**
+   * Re-index an entity already in the grid if its movement bounds have
+   * changed since it was last indexed.
+   * @param entityID ID of the entity to refresh
+   * @return true if the entity was moved to different cells
+   */
+  bool Refresh(int32_t entityID);
+
+  /**
+   * Remove an entity from the grid.
+   * @param entityID ID of the entity to remove
+   */
+  void Remove(int32_t entityID);
+
+  /**
+   * Remove every entity from the grid.
+   */
+  void Clear();
+
+  /**
+   * Get every entity whose movement bounds overlap the square containing
+   * the supplied circle.
+   * @param x X coordinate of the center of the circle
+   * @param y Y coordinate of the center of the circle
+   * @param radius Radius of the circle
+   * @return List of candidate entities, in the order they were first added
+   */
+  std::list<std::shared_ptr<ActiveEntityState>> Query(float x, float y,
+                                                      float radius) const;
+
+  /**
+   * Get the number of entities in the grid.
+   * @return Number of entities in the grid
+   */
+  size_t Count() const;
+
+ private:
+  /// Inclusive range of cells an entity is indexed in
+  struct CellBounds {
+    /// Minimum X cell
+    int32_t MinX;
+
+    /// Minimum Y cell
+    int32_t MinY;
+
+    /// Maximum X cell
+    int32_t MaxX;
+
+    /// Maximum Y cell
+    int32_t MaxY;
+  };
+
+  /// Indexed entity along with the position information it was indexed by
+  struct Record {
+    /// Pointer to the indexed entity
+    std::shared_ptr<ActiveEntityState> Entity;
+
+    /// Order the entity was added to the grid in
+    uint64_t Sequence;
+
+    /// Origin, current and destination X/Y coordinates and hitbox extent
+    /// the entity was indexed with
+    float Position[7];
+
+    /// Cells the entity is indexed in
+    CellBounds Cells;
+
+    /// true if the bounds spanned too many cells and the entity is stored
+    /// in mOversized instead
+    bool Oversized;
+  };
+
+  /**
+   * Capture the current position information of an entity.
+   * @param entity Pointer to the entity
+   * @param position Output array to write the position information to
+   */
+  static void Capture(const std::shared_ptr<ActiveEntityState>& entity,
+                      float (&position)[7]);
+
+  /**
+   * Get the cell index containing a coordinate.
+   * @param coord X or Y coordinate
+   * @return Cell index
+   */
+  int32_t GetCell(float coord) const;
+
+  /**
+   * Add a record to the cells its position information covers.
+   * @param entityID ID of the entity the record belongs to
+   * @param record Record to add, updated with the cells it was added to
+   */
+  void Link(int32_t entityID, Record& record);
+
+  /**
+   * Remove a record from the cells it was added to.
+   * @param entityID ID of the entity the record belongs to
+   * @param record Record to remove
+   */
+  void Unlink(int32_t entityID, const Record& record);
+
+  /**
+   * Re-index a record if the entity's position information has changed.
+   * @param entityID ID of the entity the record belongs to
+   * @param record Record to refresh
+   * @return true if the entity was moved to different cells
+   */
+  bool Refresh(int32_t entityID, Record& record);
+
+  /**
+   * Get the key of a cell in mCells.
+   * @param x X cell index
+   * @param y Y cell index
+   * @return Key of the cell
+   */
+  static uint64_t GetCellKey(int32_t x, int32_t y);
+
+  /// Width and height of each cell
+  float mCellSize;
+
+  /// Next sequence number to assign to a new record
+  uint64_t mNextSequence;
+
+  /// Map of entity IDs to their records
+  std::unordered_map<int32_t, Record> mRecords;
+
+  /// Map of cell keys to the IDs of the entities indexed in them
+  std::unordered_map<uint64_t, std::set<int32_t>> mCells;
+
+  /// IDs of entities whose movement bounds cover too many cells to index
+  /// individually, these are returned from every query
+  std::set<int32_t> mOversized;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_ZONESPATIALGRID_H
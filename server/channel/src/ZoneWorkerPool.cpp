@@ -0,0 +1,149 @@
+/**
+ * @file server/channel/src/ZoneWorkerPool.cpp
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Pool of threads used to update zones in parallel.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ZoneWorkerPool.h"
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <pthread.h>
+#endif  // !defined(_WIN32) && !defined(__APPLE__)
+
+using namespace channel;
+
+thread_local std::list<std::function<void()>>* ZoneWorkerPool::sDeferred =
+    nullptr;
+
+ZoneWorkerPool::ZoneWorkerPool(uint8_t threadCount)
+    : mPending(0), mBatchID(0), mRunning(true) {
+  if (threadCount == 0) {
+    threadCount = 1;
+  }
+
+  mJobs.resize(threadCount);
+  for (size_t i = 0; i < (size_t)threadCount; i++) {
+    mThreads.push_back(std::thread([this, i]() { Run(i); }));
+  }
+}
+
+ZoneWorkerPool::~ZoneWorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    mRunning = false;
+  }
+
+  mBatchStarted.notify_all();
+
+  for (auto& thread : mThreads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+size_t ZoneWorkerPool::GetThreadCount() const { return mThreads.size(); }
+
+void ZoneWorkerPool::Queue(uint32_t affinity,
+                           const std::function<void()>& work) {
+  std::lock_guard<std::mutex> lock(mLock);
+
+  mBatch.push_back(Job());
+
+  Job* job = &mBatch.back();
+  job->Work = work;
+
+  mJobs[(size_t)affinity % mJobs.size()].push_back(job);
+}
+
+std::list<std::function<void()>> ZoneWorkerPool::Wait() {
+  std::list<std::function<void()>> deferred;
+
+  {
+    std::unique_lock<std::mutex> lock(mLock);
+    if (mBatch.size() == 0) {
+      return deferred;
+    }
+
+    mPending = mThreads.size();
+    mBatchID++;
+
+    mBatchStarted.notify_all();
+    mBatchFinished.wait(lock, [this]() { return mPending == 0; });
+
+    for (auto& job : mBatch) {
+      deferred.splice(deferred.end(), job.Deferred);
+    }
+
+    mBatch.clear();
+  }
+
+  return deferred;
+}
+
+bool ZoneWorkerPool::Defer(const std::function<void()>& work) {
+  if (sDeferred) {
+    sDeferred->push_back(work);
+    return true;
+  }
+
+  return false;
+}
+
+void ZoneWorkerPool::Run(size_t idx) {
+#if !defined(_WIN32) && !defined(__APPLE__)
+  pthread_setname_np(pthread_self(), "zone_worker");
+#endif  // !defined(_WIN32) && !defined(__APPLE__)
+
+  uint64_t lastBatch = 0;
+  while (true) {
+    std::list<Job*> jobs;
+    {
+      std::unique_lock<std::mutex> lock(mLock);
+      mBatchStarted.wait(lock, [this, lastBatch]() {
+        return !mRunning || mBatchID != lastBatch;
+      });
+
+      if (!mRunning) {
+        return;
+      }
+
+      lastBatch = mBatchID;
+      jobs.swap(mJobs[idx]);
+    }
+
+    // Jobs are only touched by this thread until the batch finishes
+    for (Job* job : jobs) {
+      sDeferred = &job->Deferred;
+      job->Work();
+      sDeferred = nullptr;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      mPending--;
+    }
+
+    mBatchFinished.notify_one();
+  }
+}
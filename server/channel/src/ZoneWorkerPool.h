@@ -0,0 +1,144 @@
+/**
+ * @file server/channel/src/ZoneWorkerPool.h
+ * @ingroup channel
+ *
+ * @author HACKfrost
+ *
+ * @brief Pool of threads used to update zones in parallel.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_ZONEWORKERPOOL_H
+#define SERVER_CHANNEL_SRC_ZONEWORKERPOOL_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace channel {
+
+/**
+ * Fixed size pool of threads that zone updates are sharded across. Work is
+ * queued with an affinity key (the zone's unique ID) so the same zone is
+ * always processed by the same thread. Work that has side effects outside
+ * of the zone being processed can be deferred with Defer and will be
+ * returned from Wait in the order the work was queued so it can be run
+ * serially once every shard has finished.
+ */
+class ZoneWorkerPool {
+ public:
+  /**
+   * Create the pool and start its threads.
+   * @param threadCount Number of threads to create, must be at least one
+   */
+  ZoneWorkerPool(uint8_t threadCount);
+
+  /**
+   * Stop and join every thread in the pool.
+   */
+  ~ZoneWorkerPool();
+
+  /**
+   * Get the number of threads in the pool.
+   * @return Number of threads in the pool
+   */
+  size_t GetThreadCount() const;
+
+  /**
+   * Queue work to be processed by the thread assigned to the supplied
+   * affinity key. Work does not start until Wait is called.
+   * @param affinity Key used to pick the thread, such as a zone ID
+   * @param work Work to process
+   */
+  void Queue(uint32_t affinity, const std::function<void()>& work);
+
+  /**
+   * Start all queued work and block until every thread has finished it.
+   * @return List of work deferred while processing, ordered by the work
+   *  it was deferred from then by the order it was deferred in
+   */
+  std::list<std::function<void()>> Wait();
+
+  /**
+   * Defer work until the current batch of pool work has finished if the
+   * calling thread belongs to a pool.
+   * @param work Work to defer
+   * @return true if the work was deferred, false if the calling thread
+   *  is not processing pool work and should run it itself
+   */
+  static bool Defer(const std::function<void()>& work);
+
+ private:
+  /// Work queued for a specific thread along with any work deferred
+  /// while processing it
+  struct Job {
+    /// Work to process
+    std::function<void()> Work;
+
+    /// Work deferred until the batch finishes
+    std::list<std::function<void()>> Deferred;
+  };
+
+  /**
+   * Main loop of each thread in the pool.
+   * @param idx Index of the thread's job list
+   */
+  void Run(size_t idx);
+
+  /// Threads belonging to the pool
+  std::vector<std::thread> mThreads;
+
+  /// Queued jobs for each thread, indexed the same as mThreads
+  std::vector<std::list<Job*>> mJobs;
+
+  /// All jobs for the current batch in the order they were queued
+  std::list<Job> mBatch;
+
+  /// Number of threads still processing the current batch
+  size_t mPending;
+
+  /// Incremented each time a batch is started so threads can tell a new
+  /// batch apart from a spurious wake up
+  uint64_t mBatchID;
+
+  /// If the pool threads should keep running
+  bool mRunning;
+
+  /// Lock for the batch state
+  std::mutex mLock;
+
+  /// Signalled when a new batch starts or the pool stops
+  std::condition_variable mBatchStarted;
+
+  /// Signalled when a thread finishes its part of a batch
+  std::condition_variable mBatchFinished;
+
+  /// Deferred work list for the job the current thread is processing
+  static thread_local std::list<std::function<void()>>* sDeferred;
+};
+
+}  // namespace channel
+
+#endif  // SERVER_CHANNEL_SRC_ZONEWORKERPOOL_H
@@ -107,7 +107,7 @@ void AllocatePoint(const std::shared_ptr<ChannelServer> server,
   expl->SubtractFrom<int32_t>("Points", pointCost, points);
   opChangeset->AddOperation(expl);
 
-  if (!server->GetWorldDatabase()->ProcessChangeSet(opChangeset)) {
+  if (!server->ProcessWorldChangeSet(opChangeset)) {
     LogGeneralError([&]() {
       return libcomp::String(
                  "AllocateSkillPoint failed to process operational changeset "
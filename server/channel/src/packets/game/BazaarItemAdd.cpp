@@ -95,14 +95,14 @@ bool Parsers::BazaarItemAdd::Parse(
       item ? server->GetDefinitionManager()->GetItemData(item->GetType())
            : nullptr;
 
-  auto dbChanges = libcomp::DatabaseChangeSet::Create();
+  auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
   auto bState = state->GetBazaarState();
   if (itemDef && (itemDef->GetBasic()->GetFlags() & ITEM_FLAG_BAZAAR) != 0 &&
       bState && bState->AddItem(state, slot, itemID, price, dbChanges)) {
     // Unequip if its equipped
     server->GetCharacterManager()->UnequipItem(client, item);
 
-    if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges)) {
       LogBazaarError([&]() {
         return libcomp::String("BazaarItemAdd failed to save: %1\n")
             .Arg(state->GetAccountUID().ToString());
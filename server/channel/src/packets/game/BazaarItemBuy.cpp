@@ -152,7 +152,8 @@ bool Parsers::BazaarItemBuy::Parse(
           }
         }
 
-        auto dbChanges = libcomp::DatabaseChangeSet::Create();
+        auto dbChanges =
+            libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
 
         if (inventory->GetItems((size_t)destSlot).IsNull()) {
           inventory->SetItems((size_t)destSlot, item);
@@ -165,7 +166,9 @@ bool Parsers::BazaarItemBuy::Parse(
         dbChanges->Update(bItem);
         dbChanges->Update(item);
 
-        if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+        // The sold bazaar item belongs to the seller's account
+        if (!server->ProcessWorldChangeSet(
+                dbChanges, {market->GetAccount().GetUUID()})) {
           auto accountUID = state->GetAccountUID();
           LogBazaarError([accountUID]() {
             return libcomp::String("BazaarItemBuy failed to save: %1\n")
@@ -69,10 +69,10 @@ bool Parsers::BazaarItemDrop::Parse(
   reply.WriteS64Little(itemID);
   reply.WriteS8(destSlot);
 
-  auto dbChanges = libcomp::DatabaseChangeSet::Create();
+  auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
   if (channel::BazaarState::DropItemFromMarket(state, srcSlot, itemID, destSlot,
                                                dbChanges)) {
-    if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges)) {
       LogBazaarError([&]() {
         return libcomp::String("BazaarItemDrop failed to save: %1\n")
             .Arg(state->GetAccountUID().ToString());
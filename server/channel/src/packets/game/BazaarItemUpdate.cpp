@@ -75,10 +75,10 @@ bool Parsers::BazaarItemUpdate::Parse(
   } else {
     bItem->SetCost((uint32_t)price);
 
-    auto dbChanges = libcomp::DatabaseChangeSet::Create();
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
     dbChanges->Update(bItem);
 
-    if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges)) {
       LogBazaarError([&]() {
         return libcomp::String("BazaarItemUpdate failed to save: %1\n")
             .Arg(state->GetAccountUID().ToString());
@@ -152,7 +152,7 @@ bool Parsers::BazaarMarketOpen::Parse(
 
     bazaarData->SetExpiration(expirationTime);
 
-    auto dbChanges = libcomp::DatabaseChangeSet::Create();
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
     if (isNew) {
       auto worldData = state->GetAccountWorldData().Get();
       worldData->SetBazaarData(bazaarData);
@@ -163,7 +163,7 @@ bool Parsers::BazaarMarketOpen::Parse(
       dbChanges->Update(bazaarData);
     }
 
-    if (!worldDB->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges)) {
       LogBazaarError([&]() {
         return libcomp::String("BazaarData failed to save: %1\n")
             .Arg(state->GetAccountUID().ToString());
@@ -97,7 +97,8 @@ bool Parsers::BazaarMarketSales::Parse(
 
     if (success) {
       // Decrease the cost paid still on the item, remove if 0
-      auto dbChanges = libcomp::DatabaseChangeSet::Create();
+      auto dbChanges =
+          libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
 
       bItem->SetCost((uint32_t)newCostPaid);
       if (newCostPaid == 0) {
@@ -109,7 +110,7 @@ bool Parsers::BazaarMarketSales::Parse(
         dbChanges->Update(bItem);
       }
 
-      if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+      if (!server->ProcessWorldChangeSet(dbChanges)) {
         LogBazaarError([&]() {
           return libcomp::String("BazaarMarketSales failed to save: %1\n")
               .Arg(state->GetAccountUID().ToString());
@@ -104,8 +104,6 @@ bool Parsers::CultureStart::Parse(
     uint32_t timestamp = (uint32_t)time(0);
     uint32_t expirationTime = (uint32_t)(timestamp + (uint32_t)timeLeft);
 
-    auto worldDB = server->GetWorldDatabase();
-
     bool isNew = cData == nullptr;
     if (isNew) {
       cData = libcomp::PersistentObject::New<objects::CultureData>(true);
@@ -130,7 +128,7 @@ bool Parsers::CultureStart::Parse(
     cData->SetExpiration(expirationTime);
     cData->SetActive(true);
 
-    auto dbChanges = libcomp::DatabaseChangeSet::Create();
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
     if (isNew) {
       character->SetCultureData(cData);
 
@@ -154,7 +152,7 @@ bool Parsers::CultureStart::Parse(
 
     dbChanges->Update(item);
 
-    if (!worldDB->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges)) {
       auto accountUID = state->GetAccountUID();
       LogGeneralError([accountUID]() {
         return libcomp::String("CultureData failed to save: %1\n")
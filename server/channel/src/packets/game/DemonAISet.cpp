@@ -65,7 +65,9 @@ bool Parsers::DemonAISet::Parse(
 
   demon->SetAttackSettings(attackSettings);
 
-  server->GetWorldDatabase()->QueueUpdate(demon, state->GetAccountUID());
+  auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+  dbChanges->Update(demon);
+  server->QueueWorldChangeSet(dbChanges);
 
   return true;
 }
@@ -177,7 +177,7 @@ bool Parsers::DemonBoxMove::Parse(
     characterManager->SendDemonBoxData(client, srcBoxID, {srcSlot, destSlot});
   }
 
-  server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+  server->QueueWorldChangeSet(dbChanges);
 
   return true;
 }
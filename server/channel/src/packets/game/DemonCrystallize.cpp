@@ -272,7 +272,7 @@ bool Parsers::DemonCrystallize::Parse(
     notify.WriteS32Little(targetCState->GetEntityID());
     notify.WriteS32Little(targetDState->GetEntityID());
 
-    auto dbChanges = libcomp::DatabaseChangeSet::Create();
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
 
     if (success) {
       int8_t slot = targetDemon->GetBoxSlot();
@@ -387,7 +387,8 @@ bool Parsers::DemonCrystallize::Parse(
                                         targetSlots);
     }
 
-    if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges,
+                                       {targetState->GetAccountUID()})) {
       LogDemonErrorMsg(
           "Crystallize result failed to save, disconnecting player(s)\n");
 
@@ -72,7 +72,7 @@ void DismissDemon(const std::shared_ptr<ChannelServer> server,
       characterManager->SendDemonBoxData(client, box->GetBoxID(), {slot});
     }
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   } else {
     LogDemonDebug([&]() {
       return libcomp::String(
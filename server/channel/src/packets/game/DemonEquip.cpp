@@ -369,7 +369,7 @@ bool Parsers::DemonEquip::Parse(
       characterManager->SendItemBoxData(client, inventory, updatedSlots);
     }
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
 
     // Always recalc
     server->GetTokuseiManager()->Recalculate(
@@ -240,7 +240,8 @@ bool Parsers::DemonForce::Parse(
         }
       }
 
-      server->GetWorldDatabase()->QueueUpdate(demon, state->GetAccountUID());
+      dbChanges->Update(demon);
+      server->QueueWorldChangeSet(dbChanges);
     } else {
       success = false;
     }
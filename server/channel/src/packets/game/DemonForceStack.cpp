@@ -85,7 +85,9 @@ bool Parsers::DemonForceStack::Parse(
 
     demon->SetForceStackPending(0);
 
-    server->GetWorldDatabase()->QueueUpdate(demon, state->GetAccountUID());
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+    dbChanges->Update(demon);
+    server->QueueWorldChangeSet(dbChanges);
   }
 
   libcomp::Packet reply;
@@ -105,7 +105,7 @@ bool Parsers::DemonQuestAccept::Parse(
 
     dbChanges->Update(progress);
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   } else {
     reply.WriteS8(-1);  // Failed
   }
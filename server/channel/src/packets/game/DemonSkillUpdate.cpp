@@ -143,7 +143,7 @@ void UpdateDemonSkill(const std::shared_ptr<ChannelServer> server,
 
   client->SendPacket(reply);
 
-  server->GetWorldDatabase()->QueueChangeSet(changes);
+  server->QueueWorldChangeSet(changes);
 
   if (recalc) {
     server->GetTokuseiManager()->Recalculate(
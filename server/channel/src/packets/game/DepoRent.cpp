@@ -171,7 +171,7 @@ bool Parsers::DepoRent::Parse(
       }
       dbChanges->Delete(item);
 
-      server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+      server->QueueWorldChangeSet(dbChanges);
     }
   }
 
@@ -229,7 +229,7 @@ bool Parsers::Enchant::Parse(
 
     ChannelClientConnection::BroadcastPacket(clients, notify);
 
-    auto dbChanges = libcomp::DatabaseChangeSet::Create();
+    auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
 
     std::list<uint16_t> targetSlots;
     if (rewards.size() > 0) {
@@ -337,7 +337,8 @@ bool Parsers::Enchant::Parse(
                                         targetSlots);
     }
 
-    if (!server->GetWorldDatabase()->ProcessChangeSet(dbChanges)) {
+    if (!server->ProcessWorldChangeSet(dbChanges,
+                                       {targetState->GetAccountUID()})) {
       LogGeneralErrorMsg(
           "Enchant result failed to save, disconnecting player(s)\n");
 
@@ -355,8 +355,10 @@ bool Parsers::EquipmentMod::Parse(
 
         success = true;
 
-        server->GetWorldDatabase()->QueueUpdate(equipmentItem,
-                                                state->GetAccountUID());
+        auto dbChanges =
+            libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+        dbChanges->Update(equipmentItem);
+        server->QueueWorldChangeSet(dbChanges);
       }
       break;
     case RESULT_CODE_FAIL:
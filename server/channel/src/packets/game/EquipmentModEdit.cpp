@@ -232,7 +232,10 @@ bool Parsers::EquipmentModEdit::Parse(
             client, itemBox, {(uint16_t)item->GetBoxSlot()});
       }
 
-      server->GetWorldDatabase()->QueueUpdate(item, state->GetAccountUID());
+      auto dbChanges =
+          libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
+      dbChanges->Update(item);
+      server->QueueWorldChangeSet(dbChanges);
     } else {
       server->GetCharacterManager()->UpdateDurability(client, item, -5000);
     }
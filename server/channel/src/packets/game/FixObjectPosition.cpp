@@ -88,6 +88,11 @@ bool Parsers::FixObjectPosition::Parse(
 
   eState->SetDestinationTicks(stopTime);
 
+  auto eZone = eState->GetZone();
+  if (eZone) {
+    eZone->UpdateSpatialIndex(entityID);
+  }
+
   libcomp::Packet reply;
   reply.WritePacketCode(
       ChannelToClientPacketCode_t::PACKET_FIX_OBJECT_POSITION);
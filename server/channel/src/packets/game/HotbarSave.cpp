@@ -93,7 +93,7 @@ void SaveHotbarItems(const std::shared_ptr<ChannelServer> server,
 
   client->SendPacket(reply);
 
-  server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+  server->QueueWorldChangeSet(dbChanges);
 }
 
 bool Parsers::HotbarSave::Parse(
@@ -95,7 +95,7 @@ void DropItem(const std::shared_ptr<ChannelServer> server,
     auto dbChanges = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
     dbChanges->Update(itemBox);
     dbChanges->Delete(item);
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   } else {
     LogItemDebug([&]() {
       return libcomp::String(
@@ -168,7 +168,7 @@ bool Parsers::ItemMove::Parse(
     dbChanges->Update(otherItem);
   }
 
-  server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+  server->QueueWorldChangeSet(dbChanges);
 
   // The client will handle moves just fine on its own for the most part but
   // certain simultaneous actions will cause some weirdness without sending
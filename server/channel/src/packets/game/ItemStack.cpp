@@ -121,7 +121,7 @@ void SplitStack(const std::shared_ptr<ChannelServer> server,
       dbChanges->Insert(destItem);
       dbChanges->Update(srcItem);
       dbChanges->Update(itemBox);
-      server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+      server->QueueWorldChangeSet(dbChanges);
     }
   }
 
@@ -243,7 +243,7 @@ void CombineStacks(const std::shared_ptr<ChannelServer> server,
     }
 
     // Save anything that processed correctly
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   }
 
   if (!valid) {
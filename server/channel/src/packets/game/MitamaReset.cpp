@@ -86,7 +86,7 @@ void HandleMitamaReset(const std::shared_ptr<ChannelServer> server,
           libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
       dbChanges->Update(demon);
 
-      server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+      server->QueueWorldChangeSet(dbChanges);
 
       dState->UpdateDemonState(definitionManager);
       server->GetTokuseiManager()->Recalculate(
@@ -99,7 +99,7 @@ void HandleMitamaReunion(const std::shared_ptr<ChannelServer> server,
         characterManager->SendDemonBoxData(client, box->GetBoxID(), {slot});
       }
 
-      server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+      server->QueueWorldChangeSet(dbChanges);
     }
   }
 
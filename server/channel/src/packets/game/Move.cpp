@@ -168,6 +168,8 @@ bool Parsers::Move::Parse(
   eState->SetDestinationY(destY);
   eState->SetDestinationTicks(stopTime);
 
+  zone->UpdateSpatialIndex(eState->GetEntityID());
+
   // Calculate rotation from origin and destination
   float originRot = eState->GetCurrentRotation();
   float destRot = (float)atan2(destY - originY, destX - originX);
@@ -118,6 +118,8 @@ bool Parsers::Pivot::Parse(
     eState->SetDestinationRotation(rot);
     eState->SetDestinationTicks(now);
 
+    zone->UpdateSpatialIndex(eState->GetEntityID());
+
     ServerTime stopConverted = state->ToServerTime(stopTime);
     uint64_t immobileTime = eState->GetStatusTimes(STATUS_IMMOBILE);
     if (stopConverted > immobileTime) {
@@ -269,7 +269,7 @@ void ExtractReunionPoints(
     dbChanges->Update(awd);
     dbChanges->Update(demon);
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   }
 
   client->FlushOutgoing();
@@ -181,7 +181,7 @@ void InjectReunionPoints(const std::shared_ptr<ChannelServer> server,
     dbChanges->Update(awd);
     dbChanges->Update(demon);
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
   }
 
   client->FlushOutgoing();
@@ -231,7 +231,7 @@ void HandleShopSale(const std::shared_ptr<ChannelServer> server,
     return;
   }
 
-  auto changes = libcomp::DatabaseChangeSet::Create();
+  auto changes = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
   std::list<uint16_t> updatedSlots;
 
   // Delete the full stacks of items sold
@@ -268,7 +268,7 @@ void HandleShopSale(const std::shared_ptr<ChannelServer> server,
   changes->Update(inventory);
 
   // Queue the changes up and notify the client of the changes
-  server->GetWorldDatabase()->QueueChangeSet(changes);
+  server->QueueWorldChangeSet(changes);
 
   SendShopSaleReply(client, shopID, 0, true);
 
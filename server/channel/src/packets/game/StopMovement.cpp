@@ -124,6 +124,8 @@ bool Parsers::StopMovement::Parse(
   eState->SetOriginTicks(stopTime);
   eState->SetDestinationTicks(stopTime);
 
+  zone->UpdateSpatialIndex(eState->GetEntityID());
+
   // If the entity is still visible to others or the position was corrected,
   // relay info
   if (positionCorrected || eState->IsClientVisible()) {
@@ -281,7 +281,7 @@ bool Parsers::Synthesize::Parse(
 
     dbChanges->Update(character);
 
-    server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+    server->QueueWorldChangeSet(dbChanges);
 
     libcomp::Packet notify;
     notify.WritePacketCode(ChannelToClientPacketCode_t::PACKET_SYNTHESIZED);
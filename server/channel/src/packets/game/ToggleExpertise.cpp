@@ -86,7 +86,7 @@ bool Parsers::ToggleExpertise::Parse(
 
   expertise->SetDisabled(disabled != 0);
 
-  server->GetWorldDatabase()->QueueChangeSet(dbChanges);
+  server->QueueWorldChangeSet(dbChanges);
 
   libcomp::Packet reply;
   reply.WritePacketCode(ChannelToClientPacketCode_t::PACKET_TOGGLE_EXPERTISE);
@@ -194,7 +194,7 @@ bool Parsers::TradeFinish::Parse(
   }
 
   // Step 2: Transfer items and prepare changes
-  auto changes = libcomp::DatabaseChangeSet::Create();
+  auto changes = libcomp::DatabaseChangeSet::Create(state->GetAccountUID());
 
   changes->Update(inventory);
 
@@ -231,8 +231,7 @@ bool Parsers::TradeFinish::Parse(
   }
 
   // Step 3: Handle transaction
-  auto db = server->GetWorldDatabase();
-  if (!db->ProcessChangeSet(changes)) {
+  if (!server->ProcessWorldChangeSet(changes, {otherState->GetAccountUID()})) {
     LogTradeErrorMsg("Trade failed to save.\n");
 
     client->Close();
@@ -917,6 +917,11 @@ bool AccountManager::IsLoggedIn(const libcomp::String& username,
   return result;
 }
 
+size_t AccountManager::GetLoginCount() {
+  std::lock_guard<std::mutex> lock(mAccountLock);
+  return mAccountMap.size();
+}
+
 std::shared_ptr<objects::AccountLogin> AccountManager::GetUserLogin(
     const libcomp::String& username) {
   libcomp::String lookup = username.ToLower();
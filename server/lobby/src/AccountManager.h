@@ -250,6 +250,12 @@ class AccountManager {
    */
   bool IsLoggedIn(const libcomp::String& username, int8_t& world);
 
+  /**
+   * Get the number of users currently logged in.
+   * @return Number of users logged in to the lobby or a world
+   */
+  size_t GetLoginCount();
+
   /**
    * Get the current user login state independent of world.
    * @param username Username for the account to login.
@@ -156,7 +156,14 @@ bool LobbyServer::Initialize() {
     worker->AddManager(mManagerConnection);
   }
 
-  return true;
+  return StartMetricsServer(conf->GetMetricsPort(), "comphack_lobby");
+}
+
+void LobbyServer::UpdateMetrics() {
+  auto metrics = GetMetrics();
+  metrics->SetGauge("AccountsLoggedIn",
+                    (uint64_t)mAccountManager->GetLoginCount());
+  metrics->SetGauge("Worlds", (uint64_t)mManagerConnection->GetWorlds().size());
 }
 
 LobbyServer::~LobbyServer() {
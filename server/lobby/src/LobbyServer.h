@@ -78,6 +78,11 @@ class LobbyServer : public libhack::Server {
    */
   virtual bool Initialize();
 
+  /**
+   * Record the number of users logged in and connected worlds to the metrics registry.
+   */
+  virtual void UpdateMetrics();
+
   /**
    * Get a list of pointers to the connected worlds.
    * @return List of pointers to the connected worlds
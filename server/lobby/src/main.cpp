@@ -173,9 +173,10 @@ int main(int argc, const char *argv[])
   // Start the main server loop (blocks until done).
   int returnCode = server->Start();
 
-  // Shut down the web server.
+  // Shut down the web servers.
   delete pWebServer;
   pWebServer = nullptr;
+  server->StopMetricsServer();
 
   // Complete the shutdown process.
   libcomp::Shutdown::Complete();
@@ -87,6 +87,11 @@ bool AccountManager::IsLoggedIn(const libcomp::String& username,
   return result;
 }
 
+size_t AccountManager::GetLoginCount() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mAccountMap.size();
+}
+
 bool AccountManager::LobbyLogin(std::shared_ptr<objects::AccountLogin> login) {
   bool result = false;
 
@@ -69,6 +69,12 @@ class AccountManager {
    */
   bool IsLoggedIn(const libcomp::String& username, int8_t& channel);
 
+  /**
+   * Get the number of users currently logged in.
+   * @return Number of users logged in to the world
+   */
+  size_t GetLoginCount();
+
   /**
    * Register the supplied login with the world if it has not been already.
    * @param login Login information associated to the account.
@@ -81,7 +81,7 @@ bool WorldServer::Initialize() {
   mCharacterManager = new CharacterManager(self);
   mSyncManager = new WorldSyncManager(self);
 
-  return true;
+  return StartMetricsServer(conf->GetMetricsPort(), "comphack_world");
 }
 
 void WorldServer::FinishInitialize() {
@@ -190,6 +190,19 @@ void WorldServer::FinishInitialize() {
   messageQueue.reset();
 }
 
+void WorldServer::UpdateMetrics() {
+  size_t channelCount = 0;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    channelCount = mRegisteredChannels.size();
+  }
+
+  auto metrics = GetMetrics();
+  metrics->SetGauge("AccountsLoggedIn",
+                    (uint64_t)mAccountManager->GetLoginCount());
+  metrics->SetGauge("Channels", (uint64_t)channelCount);
+}
+
 WorldServer::~WorldServer() {
   delete mAccountManager;
   delete mCharacterManager;
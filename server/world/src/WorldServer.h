@@ -81,6 +81,11 @@ class WorldServer : public libhack::Server {
    */
   virtual void FinishInitialize();
 
+  /**
+   * Record the number of users logged in and connected channels to the metrics registry.
+   */
+  virtual void UpdateMetrics();
+
   /**
    * Get the RegisteredWorld.
    * @return Pointer to the RegisteredWorld
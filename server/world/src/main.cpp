@@ -103,6 +103,9 @@ int main(int argc, const char *argv[])
   // Start the main server loop (blocks until done).
   int returnCode = server->Start();
 
+  // Shut down the metrics web server.
+  server->StopMetricsServer();
+
   // Complete the shutdown process.
   libcomp::Shutdown::Complete();
 
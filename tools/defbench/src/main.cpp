@@ -0,0 +1,275 @@
+/**
+ * @file tools/defbench/src/main.cpp
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Tool to measure the speed of definition lookups.
+ *
+ * This tool loads the definitions from a datastore and times random
+ * lookups of the devil, item, skill and status definitions through the
+ * map they are loaded into, the flat index built over it and optionally
+ * the shared data store.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Standard C++11 Includes
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// libcomp Includes
+#include <DataStore.h>
+#include <DefinitionManager.h>
+#include <Log.h>
+
+/// Highest ID probed for when finding the IDs in each table
+static const uint32_t MAX_PROBE_ID = 0x1000000;
+
+/// Number of lookups timed for each table and lookup method
+static const size_t LOOKUP_COUNT = 10000000;
+
+/// Seed for the order of the lookups so runs can be compared
+static const uint32_t LOOKUP_SEED = 5489;
+
+int Usage(const char *szAppName) {
+  std::cerr << "USAGE: " << szAppName << " [--shared NAME] STORE..."
+            << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "STORE indicates a list of paths to use when loading the "
+               "datastore."
+            << std::endl;
+  std::cerr << "NAME indicates a shared data store to also time lookups "
+               "through. It is built if no server has built it already."
+            << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "Random lookups of every devil, item, skill and status "
+               "definition are timed through the map each table is loaded "
+               "into and the flat index built over it. Results are in "
+               "millions of lookups per second."
+            << std::endl;
+
+  return EXIT_FAILURE;
+}
+
+/**
+ * Get a random sequence of IDs that exist in a table.
+ * @param find Function to find a definition by ID
+ * @return IDs to look up in the order to look them up, empty if the table
+ *  has no definitions
+ */
+template <class Fn>
+static std::vector<uint32_t> GetLookupIDs(Fn find) {
+  std::vector<uint32_t> ids;
+  for (uint32_t id = 0; id < MAX_PROBE_ID; id++) {
+    if (find(id)) {
+      ids.push_back(id);
+    }
+  }
+
+  std::vector<uint32_t> lookups;
+  if (ids.empty()) {
+    return lookups;
+  }
+
+  std::mt19937 rng(LOOKUP_SEED);
+  std::uniform_int_distribution<size_t> dist(0, ids.size() - 1);
+
+  lookups.reserve(LOOKUP_COUNT);
+  for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+    lookups.push_back(ids[dist(rng)]);
+  }
+
+  return lookups;
+}
+
+/**
+ * Time a lookup of every ID in a sequence.
+ * @param ids IDs to look up
+ * @param lookup Function to look up a definition by ID
+ * @param check Sum of every definition found, printed so the lookups are
+ *  not optimized away
+ * @return Millions of lookups per second
+ */
+template <class Fn>
+static double TimeLookups(const std::vector<uint32_t> &ids, Fn lookup,
+                          uintptr_t &check) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t id : ids) {
+    check += reinterpret_cast<uintptr_t>(lookup(id));
+  }
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  return elapsed.count() > 0.0
+             ? (double)ids.size() / elapsed.count() / 1000000.0
+             : 0.0;
+}
+
+/**
+ * Print the timing of one table.
+ * @param table Name of the table
+ * @param mapRate Lookups per second through the map
+ * @param indexRate Lookups per second through the flat index
+ * @param sharedRate Lookups per second through the shared data store,
+ *  negative if not timed
+ */
+static void PrintResult(const char *table, double mapRate, double indexRate,
+                        double sharedRate) {
+  std::cout << std::left << std::setw(8) << table << std::right
+            << std::fixed << std::setprecision(1) << std::setw(10)
+            << mapRate << std::setw(10) << indexRate << std::setw(9)
+            << (mapRate > 0.0 ? indexRate / mapRate : 0.0) << "x";
+
+  if (sharedRate >= 0.0) {
+    std::cout << std::setw(10) << sharedRate;
+  }
+
+  std::cout << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  int firstStore = 1;
+  libcomp::String sharedName;
+  if (argc > 2 && argv[1] == std::string("--shared")) {
+    sharedName = argv[2];
+    firstStore = 3;
+  }
+
+  if (argc <= firstStore) {
+    return Usage(argv[0]);
+  }
+
+  auto log = libhack::Log::GetSingletonPtr();
+  log->SetLogLevel(to_underlying(libcomp::BaseLogComponent_t::General),
+                   libcomp::BaseLog::LOG_LEVEL_WARNING);
+  log->SetLogLevel(to_underlying(libhack::LogComponent_t::DefinitionManager),
+                   libcomp::BaseLog::LOG_LEVEL_WARNING);
+  log->AddStandardOutputHook();
+
+  libcomp::DataStore datastore(argv[0]);
+
+  bool fail = false;
+  for (int i = firstStore; i < argc; i++) {
+    if (!datastore.AddSearchPath(argv[i])) {
+      fail = true;
+    }
+  }
+
+  libhack::DefinitionManager definitionManager;
+  libhack::DefinitionManager sharedManager;
+  if (!fail && !definitionManager.LoadAllData(&datastore)) {
+    fail = true;
+  }
+
+  if (!fail && !sharedName.IsEmpty()) {
+    sharedManager.SetSharedStoreName(sharedName);
+    if (!sharedManager.LoadAllData(&datastore)) {
+      fail = true;
+    }
+  }
+
+  if (!fail) {
+    auto &dm = definitionManager;
+    auto &sm = sharedManager;
+    bool shared = !sharedName.IsEmpty();
+
+    uintptr_t check = 0;
+
+    std::cout << std::left << std::setw(8) << "Table" << std::right
+              << std::setw(10) << "Map" << std::setw(10) << "Index"
+              << std::setw(10) << "Speedup";
+    if (shared) {
+      std::cout << std::setw(10) << "Shared";
+    }
+
+    std::cout << std::endl;
+
+    auto devilIDs =
+        GetLookupIDs([&dm](uint32_t id) { return dm.FindDevilData(id); });
+    PrintResult(
+        "Devil",
+        TimeLookups(devilIDs,
+                    [&dm](uint32_t id) { return dm.GetDevilData(id).get(); },
+                    check),
+        TimeLookups(devilIDs,
+                    [&dm](uint32_t id) { return dm.FindDevilData(id); },
+                    check),
+        shared ? TimeLookups(
+                     devilIDs,
+                     [&sm](uint32_t id) { return sm.FindDevilData(id); },
+                     check)
+               : -1.0);
+
+    auto itemIDs =
+        GetLookupIDs([&dm](uint32_t id) { return dm.FindItemData(id); });
+    PrintResult(
+        "Item",
+        TimeLookups(itemIDs,
+                    [&dm](uint32_t id) { return dm.GetItemData(id).get(); },
+                    check),
+        TimeLookups(itemIDs,
+                    [&dm](uint32_t id) { return dm.FindItemData(id); },
+                    check),
+        shared ? TimeLookups(
+                     itemIDs,
+                     [&sm](uint32_t id) { return sm.FindItemData(id); },
+                     check)
+               : -1.0);
+
+    auto skillIDs =
+        GetLookupIDs([&dm](uint32_t id) { return dm.FindSkillData(id); });
+    PrintResult(
+        "Skill",
+        TimeLookups(skillIDs,
+                    [&dm](uint32_t id) { return dm.GetSkillData(id).get(); },
+                    check),
+        TimeLookups(skillIDs,
+                    [&dm](uint32_t id) { return dm.FindSkillData(id); },
+                    check),
+        shared ? TimeLookups(
+                     skillIDs,
+                     [&sm](uint32_t id) { return sm.FindSkillData(id); },
+                     check)
+               : -1.0);
+
+    // Status definitions are not held in the shared data store
+    auto statusIDs =
+        GetLookupIDs([&dm](uint32_t id) { return dm.FindStatusData(id); });
+    PrintResult(
+        "Status",
+        TimeLookups(statusIDs,
+                    [&dm](uint32_t id) { return dm.GetStatusData(id).get(); },
+                    check),
+        TimeLookups(statusIDs,
+                    [&dm](uint32_t id) { return dm.FindStatusData(id); },
+                    check),
+        -1.0);
+
+    std::cout << "Check: " << std::hex << check << std::endl;
+  }
+
+#ifndef EXOTIC_PLATFORM
+  // Stop the logger
+  delete libcomp::BaseLog::GetBaseSingletonPtr();
+#endif  // !EXOTIC_PLATFORM
+
+  return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}